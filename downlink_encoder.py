@@ -0,0 +1,131 @@
+"""
+Encoder of the downlink requests of the sensor (see src/downlink.h and src/config_codec.h).
+
+Prints the LoRaWAN port and the payload in hex and base64, to schedule with the network server
+(the frm_payload of a TTN downlink is base64), or to type as "downlink <hex>" on the RTT
+console of a node on the bench. The node answers with a WINDOW or CONFIG uplink record,
+decoded by payload_decoder.js.
+
+  python downlink_encoder.py set --sampling-rate-ms 20 --detectors er,mer --votes 2
+  python downlink_encoder.py set --ratio-on 4 --anomaly-delay-ms 60000
+  python downlink_encoder.py get
+  python downlink_encoder.py reset
+  python downlink_encoder.py window 1741773600 120
+
+The ranges that depend on each other (a window in ms against the sampling period) are only
+checked by the node, a refused request names the parameter in the CONFIG answer.
+"""
+
+
+import argparse
+import base64
+import struct
+
+DOWNLINK_PORT = 3
+
+DOWNLINK_WINDOW = 0x01
+DOWNLINK_CONFIG_SET = 0x02
+DOWNLINK_CONFIG_GET = 0x03
+DOWNLINK_CONFIG_RESET = 0x04
+
+# largest downlink the node keeps (DOWNLINK_MAX_SIZE)
+DOWNLINK_MAX_SIZE = 51
+
+# enum config_param: option, id, struct format of the value, scale of the option value
+PARAMS = [
+    ("sampling_rate_ms", 0x01, "<H", 1),
+    ("sta_ms", 0x02, "<H", 1),
+    ("lta_ms", 0x03, "<H", 1),
+    ("ratio_on", 0x04, "<H", 100),
+    ("ratio_off", 0x05, "<H", 100),
+    ("anomaly_delay_ms", 0x06, "<I", 1),
+    ("bth_period_s", 0x07, "<I", 1),
+    ("send_samples", 0x08, "<B", 1),
+    ("detectors", 0x09, "<B", 1),
+    ("votes", 0x0a, "<B", 1),
+]
+
+# PARAM_DETECTOR_* bits, the STA/LTA always runs
+DETECTORS = {"er": 0x01, "mer": 0x02, "threshold": 0x04}
+
+
+def detectors_mask(text: str) -> int:
+    """'er,mer' to the detector mask, 'none' for the STA/LTA alone."""
+    mask = 0
+    for name in filter(None, text.lower().split(",")):
+        if name == "none":
+            continue
+        if name not in DETECTORS:
+            raise argparse.ArgumentTypeError(f"unknown detector {name}, one of {', '.join(DETECTORS)} or none")
+        mask |= DETECTORS[name]
+    return mask
+
+
+def encode_set(values: dict) -> bytes:
+    """DOWNLINK_CONFIG_SET with the parameters given, in the order of PARAMS."""
+    out = bytearray([DOWNLINK_CONFIG_SET])
+    for name, param, fmt, scale in PARAMS:
+        value = values.get(name)
+        if value is None:
+            continue
+        raw = round(value * scale)
+        try:
+            out += bytes([param]) + struct.pack(fmt, raw)
+        except struct.error:
+            raise ValueError(f"--{name.replace('_', '-')} {value} out of range")
+    if len(out) == 1:
+        raise ValueError("no parameter to set")
+    return bytes(out)
+
+
+def encode_window(start: int, duration: int) -> bytes:
+    """DOWNLINK_WINDOW: unix start in s, duration in s."""
+    return struct.pack("<BIH", DOWNLINK_WINDOW, start, duration)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Encode a downlink request for the SASTRESS sensor')
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    window = sub.add_parser("window", help="Ask which parts of the recordings cover a time window")
+    window.add_argument("start", type=int, help="Start of the window, unix s")
+    window.add_argument("duration", type=int, help="Duration in s")
+
+    config = sub.add_parser("set", help="Change the configuration, applied and saved as a whole")
+    config.add_argument("--sampling-rate-ms", type=int, help="Sampling period (1 to 100 ms)")
+    config.add_argument("--sta-ms", type=int, help="STA window (at most 256 samples)")
+    config.add_argument("--lta-ms", type=int, help="LTA window (longer than the STA, at most 2048 samples)")
+    config.add_argument("--ratio-on", type=float, help="STA/LTA ratio reporting an anomaly")
+    config.add_argument("--ratio-off", type=float, help="STA/LTA ratio re-arming the detector")
+    config.add_argument("--anomaly-delay-ms", type=int, help="Minimal time between two anomalies")
+    config.add_argument("--bth-period-s", type=int, help="Period of the BTH record (60 s to 7 days)")
+    config.add_argument("--send-samples", type=int, choices=[0, 1], help="Send the samples of each anomaly")
+    config.add_argument("--detectors", type=detectors_mask,
+                        help="Detectors next to the STA/LTA: er, mer, threshold, comma separated, or none")
+    config.add_argument("--votes", type=int, help="Detectors that must be on together")
+
+    sub.add_parser("get", help="Ask for the configuration in effect")
+    sub.add_parser("reset", help="Go back to the compile-time configuration")
+
+    args = parser.parse_args()
+    if args.command == "window":
+        payload = encode_window(args.start, args.duration)
+    elif args.command == "set":
+        try:
+            payload = encode_set(vars(args))
+        except ValueError as e:
+            parser.error(str(e))
+    elif args.command == "get":
+        payload = bytes([DOWNLINK_CONFIG_GET])
+    else:
+        payload = bytes([DOWNLINK_CONFIG_RESET])
+
+    if len(payload) > DOWNLINK_MAX_SIZE:
+        parser.error(f"payload of {len(payload)} bytes, the node keeps {DOWNLINK_MAX_SIZE}")
+    print(f"port    {DOWNLINK_PORT}")
+    print(f"hex     {payload.hex()}")
+    print(f"base64  {base64.b64encode(payload).decode()}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,47 +1,57 @@
 """
 This script provides allow to connect via a J-Link RTT console to the SASTRESS board, to download vibration data
-Requirements : 
+Requirements :
 - pip install pylink-square rich
+
+The files are pulled with the binary bulk transfer of the firmware (see src/bulk_dump.h): the
+script types "bulk list" and "bulk get <file> <offset> <length>" on the RTT console (down
+channel 0) and reads the frames on RTT up-channel 1. Each frame carries a CRC-32, a file is
+written to <file>.part until it is complete, so an interrupted download resumes where it stopped.
+
+--window FROM:TO only pulls the parts of the geophone files recorded between two unix times in ms,
+found with "bulk find" in the time index of the node (see src/wave_index.h).
+
+--bench runs the same downloader against a loopback stand-in of the firmware instead of a board.
 """
 
 
-import pylink
 import argparse
-import time
-import base64
-from rich.progress import Progress
 import os
+import random
+import shutil
+import struct
+import tempfile
+import time
+import zlib
+
+# frame: u16 magic, u8 type, u8 reserved, u16 body length, body, u32 CRC-32 of header and body
+BULK_MAGIC = 0x4253
+BULK_HEADER = struct.Struct("<HBBH")
+BULK_FILE = 1
+BULK_DATA = 2
+BULK_END = 3
+BULK_RANGE = 4
+BULK_RANGE_BODY = struct.Struct("<IIQQ")    # offset, size, first sample ms, end ms, then the name
+BULK_CHANNEL = 1
+BULK_CHUNK_SIZE = 2048          # BULK_CHUNK_SIZE of the firmware
+RTT_READ_SIZE = 8192            # BULK_RTT_BUFFER_SIZE of the firmware
+
+# a request without any frame for this long is sent again
+REQUEST_TIMEOUT_S = 10
+# requests of a file without progress before giving up on it
+MAX_RETRIES = 5
+
+# entry of a geophone_NNN.idx file: first sample ms, offset, samples, sampling period ms
+INDEX_ENTRY = struct.Struct("<QIHH")
+
+# legacy dump: 100 bytes per base64 line, then K_MSEC(15)
+LEGACY_LINE_BYTES = 100
+LEGACY_LINE_SLEEP_S = 0.015
 
-# def connect(jlink_serial: int):
-#     """
-#     Establish a connection to the SASTRESS board.
-
-#     Args:
-#         jlink_serial (int): The serial number of the JLINK debugger to connect to.
-#     Returns:
-#         pylink.JLink: An initialized and connected JLink object.
-#     Raises:
-#         SystemExit: If the JLINK debugger cannot be opened or if the target device
-#                     cannot be connected to.
-#     """
-#     print(pylink.JLink().connected_emulators())
-#     print("Connecting to JLINK serial = {}".format(jlink_serial))
-#     jlink = pylink.JLink()
-#     jlink.open(serial_no=jlink_serial)
-#     #jlink.open(serial_no=682809515)
-#     if not jlink.connected():
-#         print("ERROR : JLink is not connected. Maybe the serial number is wrong ?")
-#         exit(1)
-    
-#     print("Connecting to sastress board ")
-#     jlink.connect("NRF52840_XXAA")
-#     if not jlink.target_connected():
-#         print("ERROR : Could connect to JLINK debugger but not to the SASTRESS board.")
-#         exit(1)
-        
-#     return jlink
 
 def connect(jlink_serial: int | None):
+    import pylink
+
     if jlink_serial is None:
         jlink_serial = autodetect_jlink_serial()
 
@@ -65,87 +75,432 @@ def connect(jlink_serial: int | None):
 
     return jlink
 
-def fs_downloader(jlink: pylink.JLink, export_folder: str):
+
+def encode_frame(kind: int, body: bytes) -> bytes:
+    """Build a bulk frame, as send_frame() does on the node."""
+    header = BULK_HEADER.pack(BULK_MAGIC, kind, 0, len(body))
+    return header + body + struct.pack("<I", zlib.crc32(header + body))
+
+
+class FrameParser:
+    """
+    Cut the byte stream of the bulk channel into (type, body) frames.
+    A frame with a wrong CRC is dropped and the parser resynchronises on the next magic.
+    """
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.errors = 0
+
+    def feed(self, data: bytes):
+        self.pending += data
+        frames = []
+        magic = struct.pack("<H", BULK_MAGIC)
+        while True:
+            start = self.pending.find(magic)
+            if start < 0:
+                # keep a last byte, it may be the first half of a magic
+                del self.pending[:max(len(self.pending) - 1, 0)]
+                return frames
+            if start > 0:
+                self.errors += 1
+                del self.pending[:start]
+            if len(self.pending) < BULK_HEADER.size:
+                return frames
+            _, kind, _, length = BULK_HEADER.unpack_from(self.pending)
+            end = BULK_HEADER.size + length
+            if len(self.pending) < end + 4:
+                return frames
+            (crc,) = struct.unpack_from("<I", self.pending, end)
+            if crc != zlib.crc32(self.pending[:end]):
+                self.errors += 1
+                del self.pending[:1]
+                continue
+            frames.append((kind, bytes(self.pending[BULK_HEADER.size:end])))
+            del self.pending[:end + 4]
+
+
+class RttLink:
+    """Bulk channel of a board behind a J-Link, commands are typed on the RTT console."""
+
+    def __init__(self, jlink):
+        self.jlink = jlink
+        self.console = ""
+        jlink.rtt_start()
+        print("Waiting for RTT to settle", end="")
+        while jlink.rtt_get_status() == 0:
+            time.sleep(1)
+        print("OK")
+
+    def command(self, line: str):
+        self.jlink.rtt_write(0, list((line + "\n").encode()))
+
+    def now(self) -> float:
+        return time.monotonic()
+
+    def read(self) -> bytes:
+        data = bytes(self.jlink.rtt_read(BULK_CHANNEL, RTT_READ_SIZE))
+        # the logs keep coming on the console, print them by line
+        self.console += bytes(self.jlink.rtt_read(0, 1024)).decode(errors="replace")
+        *lines, self.console = self.console.split("\n")
+        for line in lines:
+            print(line)
+        if not data:
+            time.sleep(0.001)
+        return data
+
+
+class LoopbackLink:
     """
-    Reads data from J-Link RTT (Real-Time Transfer) interface and saves files received via base64-encoded chunks.
-    This function establishes an RTT connection, monitors incoming data, and reconstructs files that are
-    transmitted as base64-encoded segments.
+    Stand-in of the node for --bench: serves the files of a folder with the bulk protocol.
+
+    The transfer runs on a simulated clock: the debugger drains the channel at `rate` bytes
+    per second and each command waits for a console poll, as on the node. `drop_rate` is
+    the probability of corrupting a read, to exercise the resume path.
+    """
+
+    # CONSOLE_POLL_MS, CONSOLE_FAST_POLL_MS and CONSOLE_FAST_WINDOW_MS of the firmware
+    CONSOLE_POLL_S = 0.25
+    CONSOLE_FAST_POLL_S = 0.005
+    CONSOLE_FAST_WINDOW_S = 2.0
+
+    def __init__(self, folder: str, rate: float, drop_rate: float = 0.0, seed: int = 1):
+        self.folder = folder
+        self.rate = rate
+        self.drop_rate = drop_rate
+        self.random = random.Random(seed)
+        self.output = bytearray()
+        self.clock = 0.0
+        self.commands = 0
+        self.last_command = -self.CONSOLE_FAST_WINDOW_S
+
+    def command(self, line: str):
+        fast = self.clock - self.last_command < self.CONSOLE_FAST_WINDOW_S
+        self.clock += self.CONSOLE_FAST_POLL_S if fast else self.CONSOLE_POLL_S
+        self.last_command = self.clock
+        self.commands += 1
+        words = line.split()
+        if words[:2] == ["bulk", "list"]:
+            names = sorted(os.listdir(self.folder))
+            for name in names:
+                size = os.path.getsize(os.path.join(self.folder, name))
+                self.output += encode_frame(BULK_FILE, struct.pack("<I", size) + name.encode())
+            self.output += encode_frame(BULK_END, struct.pack("<iI", 0, len(names)))
+        elif words[:2] == ["bulk", "get"]:
+            name = words[2]
+            offset = int(words[3]) if len(words) > 3 else 0
+            length = int(words[4]) if len(words) > 4 else 0xFFFFFFFF
+            with open(os.path.join(self.folder, name), "rb") as f:
+                f.seek(offset)
+                data = f.read(length)
+            for pos in range(0, len(data), BULK_CHUNK_SIZE):
+                chunk = data[pos:pos + BULK_CHUNK_SIZE]
+                self.output += encode_frame(BULK_DATA, struct.pack("<I", offset + pos) + chunk)
+            self.output += encode_frame(BULK_END, struct.pack("<iI", 0, len(data)))
+        elif words[:2] == ["bulk", "find"]:
+            ranges = find_in_folder(self.folder, int(words[2]), int(words[3]))
+            for name, offset, size, start_ms, end_ms in ranges:
+                body = BULK_RANGE_BODY.pack(offset, size, start_ms, end_ms) + name.encode()
+                self.output += encode_frame(BULK_RANGE, body)
+            self.output += encode_frame(BULK_END, struct.pack("<iI", 0, len(ranges)))
+
+    def now(self) -> float:
+        return self.clock
+
+    def read(self) -> bytes:
+        data = bytes(self.output[:RTT_READ_SIZE])
+        del self.output[:RTT_READ_SIZE]
+        # an empty poll of the debugger still takes some time
+        self.clock += max(len(data) / self.rate, 0.001)
+        if data and self.random.random() < self.drop_rate:
+            pos = self.random.randrange(len(data))
+            data = data[:pos] + bytes([data[pos] ^ 0xFF]) + data[pos + 1:]
+        return data
+
+
+def find_in_folder(folder: str, from_ms: int, to_ms: int):
+    """wave_index_query() of the firmware on a copy of the flash: (name, offset, size, start_ms, end_ms) per range."""
+    ranges = []
+    for index_name in sorted(n for n in os.listdir(folder) if n.endswith(".idx")):
+        name = index_name[:-4] + ".dat"
+        if not os.path.exists(os.path.join(folder, name)):
+            continue
+        data_size = os.path.getsize(os.path.join(folder, name))
+        with open(os.path.join(folder, index_name), "rb") as f:
+            entries = [INDEX_ENTRY.unpack(chunk) for chunk in iter(lambda: f.read(INDEX_ENTRY.size), b"")
+                       if len(chunk) == INDEX_ENTRY.size]
+        for i, (start_ms, offset, samples, period_ms) in enumerate(entries):
+            end = min(entries[i + 1][1], data_size) if i + 1 < len(entries) else data_size
+            end_ms = start_ms + samples * period_ms
+            if offset >= data_size or end <= offset or start_ms >= to_ms or end_ms <= from_ms:
+                continue
+            last = ranges[-1] if ranges else None
+            if last and last[0] == name and last[1] + last[2] == offset:
+                ranges[-1] = (name, last[1], end - last[1], last[3], end_ms)
+            else:
+                ranges.append((name, offset, end - offset, start_ms, end_ms))
+    return ranges
+
+
+def wait_end(link, parser: FrameParser, on_frame):
+    """Read frames until BULK_END, return its (status, count) or None after REQUEST_TIMEOUT_S without data."""
+    last = link.now()
+    while True:
+        data = link.read()
+        if data:
+            last = link.now()
+        elif link.now() - last > REQUEST_TIMEOUT_S:
+            return None
+        for kind, body in parser.feed(data):
+            if kind == BULK_END:
+                return struct.unpack_from("<iI", body)
+            on_frame(kind, body)
+
+
+def list_files(link, parser: FrameParser):
+    """Names and sizes of the files of the node."""
+    for _ in range(MAX_RETRIES):
+        files = []
+
+        def on_frame(kind, body):
+            if kind == BULK_FILE:
+                (size,) = struct.unpack_from("<I", body)
+                files.append((body[4:].decode(), size))
+
+        link.command("bulk list")
+        end = wait_end(link, parser, on_frame)
+        if end is not None and end[0] == 0 and end[1] == len(files):
+            return files
+    raise IOError("could not list the files of the node")
+
+
+def find_ranges(link, parser: FrameParser, from_ms: int, to_ms: int):
+    """(name, offset, size, start_ms, end_ms) of the parts of the geophone files recorded in [from_ms, to_ms)."""
+    for _ in range(MAX_RETRIES):
+        ranges = []
+
+        def on_frame(kind, body):
+            if kind == BULK_RANGE:
+                offset, size, start_ms, end_ms = BULK_RANGE_BODY.unpack_from(body)
+                ranges.append((body[BULK_RANGE_BODY.size:].decode(), offset, size, start_ms, end_ms))
+
+        link.command("bulk find {} {}".format(from_ms, to_ms))
+        end = wait_end(link, parser, on_frame)
+        if end is not None and end[0] == 0 and end[1] == len(ranges):
+            return ranges
+    raise IOError("could not query the time index of the node")
+
+
+def download_range(link, parser: FrameParser, name: str, out, offset: int, length: int, progress=None):
+    """
+    Write `length` bytes of `name` from `offset` to the open file `out`, which is at `offset`.
+    Only a continuous prefix is written: after a lost or corrupt frame, the rest is asked again.
+    Returns the number of bytes written.
+    """
+    expected = offset
+    end = offset + length
+    retries = 0
+
+    def on_frame(kind, body):
+        nonlocal expected
+        if kind != BULK_DATA:
+            return
+        (at,) = struct.unpack_from("<I", body)
+        if at == expected:
+            out.write(body[4:])
+            expected += len(body) - 4
+            if progress is not None:
+                progress(len(body) - 4)
+
+    while expected < end and retries < MAX_RETRIES:
+        before = expected
+        link.command("bulk get {} {} {}".format(name, expected, end - expected))
+        status = wait_end(link, parser, on_frame)
+        if status is not None and status[0] < 0:
+            raise IOError("{}: error {} on the node".format(name, status[0]))
+        if status is not None and status[1] < end - before and expected == before + status[1]:
+            # the file is shorter than asked
+            break
+        retries = 0 if expected > before else retries + 1
+    return expected - offset
+
+
+def fs_downloader(link, export_folder: str, decode: bool = False, names=None, quiet: bool = False):
+    """
+    Download the files of the node to `export_folder`, resuming the partial ones.
+
     Args:
-        jlink (pylink.JLink): An initialized J-Link object used for RTT communication.
+        link: RttLink of a board, or LoopbackLink
         export_folder (str): The folder in which files will be exported
+        decode (bool): Also write compressed geophone files as raw int16 samples (<file>.raw)
+        names (list): Only download these files
+        quiet (bool): No progress output
     Returns:
-        None
-    Raises:
-        IOError: If file operations (open/close/write) fail during data saving.
-        base64.binascii.Error: If base64 decoding fails for a data chunk (caught and logged).
-    Note:
-        Expected RTT message format:
-        - FILE:<filename> - Signals the start of a new file transfer
-        - D:<base64_data> - Contains base64-encoded file data chunks
-        - TOTAL_ENCODED: - Signals the end of file transmission
-        - DUMP_END: - Signals the end of file system dump
-        - Other lines are printed as log output
+        The number of bytes received
     """
-    jlink.rtt_start()
-    print("Waiting for RTT to settle", end="")
-    while jlink.rtt_get_status() == 0:
-        time.sleep(1)
-    print("OK")
-
-    # Initialize progress bar
-    p = Progress()
-    p.start()
-    t = None
-    
-    current_file = None
-    data = ""
-    while True:
-        # Append characters to data until a new line is found
-        logs = jlink.rtt_read(0,200)
-        data += ''.join([chr(i) for i in logs])
-        if "\n" not in data:
+    parser = FrameParser()
+    files = list_files(link, parser)
+    received = 0
+
+    progress = None
+    if not quiet:
+        try:
+            from rich.progress import Progress
+            progress = Progress()
+            progress.start()
+        except ImportError:
+            pass
+
+    for name, size in files:
+        if names and name not in names:
+            continue
+        path = os.path.join(export_folder, name)
+        part = path + ".part"
+        if os.path.exists(path) and os.path.getsize(path) == size:
             continue
-        else:
-            # When a new line character `\n` is found, parse the lines
-            lines = data.split("\n")
-            data = lines.pop()
-            for line in lines:
-                # FILE: <filename>
-                if line.startswith("FILE:"):
-                    filename = line.split(":")[1]
-                    print("Found new file :", filename)
-                    current_file = open(os.path.join(export_folder,filename), "wb")
-                    t = p.add_task(filename, total=64*1024)
-                # D: <base64 encoded data>
-                elif line.startswith("D:") and current_file:
-                    b64 = line.split(":")[1].replace("\n","").replace("\t","")
-                    try: 
-                        decoded = base64.b64decode(b64)
-                        current_file.write(decoded)
-                        p.update(t, advance=100)
-                    except base64.binascii.Error as e:
-                        print("Error trying to decode {} : {}".format(b64, e))
-                # TOTAL_ENCODED : <int> -> Marks the end of the current file
-                elif line.startswith("TOTAL_ENCODED:"):
-                    print("End of file")
-                    if current_file:
-                        current_file.close()
-                        p.remove_task(t)
-                elif line.startswith("DUMP_END"):
-                    break
-                else:
-                    print(line)
+        offset = os.path.getsize(part) if os.path.exists(part) else 0
+        offset = min(offset, size)
+        if not quiet:
+            print("{}: {} bytes{}".format(name, size, ", resuming at {}".format(offset) if offset else ""))
+
+        task = None
+        if progress is not None:
+            task = progress.add_task(name, total=size, completed=offset)
+        with open(part, "ab") as out:
+            out.truncate(offset)
+            got = download_range(link, parser, name, out, offset, size - offset,
+                                 (lambda n: progress.update(task, advance=n)) if task is not None else None)
+        received += got
+        if task is not None:
+            progress.remove_task(task)
+        if offset + got < size:
+            print("{}: incomplete, {} of {} bytes kept in {}".format(name, offset + got, size, part))
+            continue
+        os.replace(part, path)
+        if decode:
+            decode_file(path)
+
+    if progress is not None:
+        progress.stop()
+    if parser.errors and not quiet:
+        print("{} corrupt frames were asked again".format(parser.errors))
+    return received
+
+
+def download_selection(link, export_folder: str, selection: str):
+    """Download FILE:OFFSET:LENGTH to <FILE>.<OFFSET>-<END>."""
+    name, offset, length = selection.split(":")
+    offset, length = int(offset), int(length)
+    path = os.path.join(export_folder, "{}.{}-{}".format(name, offset, offset + length))
+    with open(path, "wb") as out:
+        got = download_range(link, FrameParser(), name, out, offset, length)
+    print("{}: {} bytes".format(path, got))
+
+
+def download_window(link, export_folder: str, window: str, decode: bool = False):
+    """Download the parts of the geophone files recorded in FROM:TO (unix ms), to <FILE>.<OFFSET>-<END>."""
+    from_ms, to_ms = (int(v) for v in window.split(":"))
+    parser = FrameParser()
+    ranges = find_ranges(link, parser, from_ms, to_ms)
+    if not ranges:
+        print("nothing recorded between {} and {} on the node".format(from_ms, to_ms))
+    paths = []
+    for name, offset, size, start_ms, end_ms in ranges:
+        path = os.path.join(export_folder, "{}.{}-{}".format(name, offset, offset + size))
+        with open(path, "wb") as out:
+            got = download_range(link, parser, name, out, offset, size)
+        print("{}: {} bytes, {} to {} ms".format(path, got, start_ms, end_ms))
+        if decode:
+            decode_file(path)
+        paths.append(path)
+    return paths
+
+
+def decode_file(path: str):
+    """Write a compressed geophone file as raw int16 samples (<file>.raw)."""
+    from wave_codec import is_compressed, read_samples
+
+    with open(path, "rb") as f:
+        if not is_compressed(f.read(2)):
+            return
+    read_samples(path).astype("<i2").tofile(path + ".raw")
+
+
+def bench(source: str | None, size_mb: float, rate: float, drop_rate: float):
+    """Download through the loopback stand-in, and compare with the legacy base64 dump."""
+    work = tempfile.mkdtemp(prefix="bulk_bench_")
+    try:
+        if source is None:
+            source = os.path.join(work, "node")
+            os.makedirs(source)
+            rnd = random.Random(0)
+            remaining = int(size_mb * 1024 * 1024)
+            number = 0
+            while remaining > 0:
+                size = min(remaining, 64 * 1024)
+                with open(os.path.join(source, "geophone_{:03d}.dat".format(number)), "wb") as f:
+                    f.write(rnd.randbytes(size))
+                remaining -= size
+                number += 1
+        out = os.path.join(work, "out")
+        os.makedirs(out)
+
+        link = LoopbackLink(source, rate, drop_rate)
+        start = time.perf_counter()
+        received = fs_downloader(link, out, quiet=True)
+        host_s = time.perf_counter() - start
+        commands = link.commands
+
+        total = 0
+        for name in os.listdir(source):
+            with open(os.path.join(source, name), "rb") as a, open(os.path.join(out, name), "rb") as b:
+                if a.read() != b.read():
+                    raise AssertionError("{} differs".format(name))
+            total += os.path.getsize(os.path.join(source, name))
+
+        # one base64 line of 100 bytes ("D:" + 136 characters), then the sleep
+        lines = sum(-(-os.path.getsize(os.path.join(source, n)) // LEGACY_LINE_BYTES) for n in os.listdir(source))
+        legacy_s = lines * (LEGACY_LINE_SLEEP_S + 139 / rate)
+
+        print("{} files, {} bytes, all identical, {} commands".format(len(os.listdir(source)), total, commands))
+        print("bulk:   {:8.1f} s at {:.0f} kB/s on the channel, {:.0f} kB/s".format(
+            link.clock, rate / 1000, total / link.clock / 1000))
+        print("legacy: {:8.1f} s, {:.1f} kB/s".format(legacy_s, total / legacy_s / 1000))
+        print("speedup x{:.1f}, host parsing {:.0f} MB/s".format(legacy_s / link.clock, received / host_s / 1e6))
+    finally:
+        shutil.rmtree(work)
+
 
 def main():
     parser = argparse.ArgumentParser(description='Read flash memory from SASTRESS board using JLink RTT')
     parser.add_argument('--serial', type=int, default=1050342163,
                       help='JLink debugger serial number (written on the board, under board revision)')
     parser.add_argument('-o', '--outputfolder', type=str, help='The folder in which the target filesystem should be dumped', default='lfs')
+    parser.add_argument('--decode', action='store_true', help='Also decode compressed geophone files to raw int16 (<file>.raw)')
+    parser.add_argument('--file', action='append', help='Only download this file (repeatable)')
+    parser.add_argument('--range', type=str, help='Only download FILE:OFFSET:LENGTH, to <FILE>.<OFFSET>-<END>')
+    parser.add_argument('--window', type=str,
+                        help='Only download what was recorded from FROM to TO (unix ms), to <FILE>.<OFFSET>-<END>')
+    parser.add_argument('--bench', action='store_true', help='Benchmark against a loopback stand-in of the node, no board needed')
+    parser.add_argument('--bench-dir', type=str, help='Files served by the loopback (default: random data)')
+    parser.add_argument('--bench-mb', type=float, default=8, help='Size of the random data in MB')
+    parser.add_argument('--bench-rate', type=float, default=500e3, help='Bytes per second the debugger drains from RTT')
+    parser.add_argument('--bench-drop', type=float, default=0.0, help='Probability of a corrupt RTT read')
     args = parser.parse_args()
-    jlink = connect(args.serial)
+
+    if args.bench:
+        bench(args.bench_dir, args.bench_mb, args.bench_rate, args.bench_drop)
+        return
+
+    link = RttLink(connect(args.serial))
     export_folder = args.outputfolder
     os.makedirs(export_folder, exist_ok=True)
-    fs_downloader(jlink, export_folder)
+    if args.range:
+        download_selection(link, export_folder, args.range)
+    elif args.window:
+        download_window(link, export_folder, args.window, args.decode)
+    else:
+        fs_downloader(link, export_folder, args.decode, args.file)
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    main()
@@ -18,6 +18,196 @@ function decodeTimestamp(b, offset) {
     return v;
   }
 
+  function uint16(lo, hi) {
+    return lo | (hi << 8);
+  }
+
+  // Spectral features: dominant frequency (0.1 Hz) and 4 band RMS (10 uV)
+  function decodeSpectral(b, off) {
+    return {
+      DominantHz : uint16(b[off], b[off + 1]) / 10,
+      BandsMV    : [0, 1, 2, 3].map(function (i) {
+        return uint16(b[off + 2 + 2 * i], b[off + 3 + 2 * i]) / 100;
+      }),
+    };
+  }
+
+  // Payload of one record, shared by v1 and v2 frames
+  function decodePayload(id, b, off, len) {
+    switch (id) {
+      case 1:
+        return {
+          Battery     : int16(b[off], b[off + 1]),
+          Temperature : int16(b[off + 2], b[off + 3]) / 100,
+          Humidity    : int16(b[off + 4], b[off + 5]) / 100,
+        };
+      case 2: {
+        var anomaly = {
+          MinSTA  : int16(b[off], b[off + 1]),
+          MaxSTA  : int16(b[off + 2], b[off + 3]),
+          STALTA  : int16(b[off + 4], b[off + 5]) / 100,
+          Mean    : int16(b[off + 6], b[off + 7]),
+          EventID : uint16(b[off + 8], b[off + 9]),
+        };
+        if (len >= 20) {
+          anomaly.Spectral = decodeSpectral(b, off + 10);
+        }
+        // time of the trigger sample below the ms, and sampling period deviation
+        if (len >= 24) {
+          anomaly.TimeUs  = uint16(b[off + 20], b[off + 21]);
+          anomaly.RatePpm = int16(b[off + 22], b[off + 23]);
+        }
+        // nominal sampling period at the trigger, the RatePpm is relative to it
+        if (len >= 26) {
+          anomaly.PeriodMs = uint16(b[off + 24], b[off + 25]);
+        }
+        return anomaly;
+      }
+      case 3: {
+        var s = [];
+        for (var k = off; k + 1 < off + len; k += 2) {
+          s.push(int16(b[k], b[k + 1]));
+        }
+        return { Samples : s };
+      }
+      case 4: {
+        var stats = {
+          MinSTA  : int16(b[off], b[off + 1]),
+          MaxSTA  : int16(b[off + 2], b[off + 3]),
+          MeanSTA : int16(b[off + 4], b[off + 5]),
+        };
+        // whole period statistics, percentiles of the absolute amplitude
+        if (len >= 14) {
+          stats.RMS = uint16(b[off + 6], b[off + 7]);
+          stats.P50 = uint16(b[off + 8], b[off + 9]);
+          stats.P90 = uint16(b[off + 10], b[off + 11]);
+          stats.P99 = uint16(b[off + 12], b[off + 13]);
+        }
+        if (len >= 24) {
+          stats.Spectral = decodeSpectral(b, off + 14);
+        }
+        return stats;
+      }
+      case 6: {
+        // node health: threads and queues in the order of health.h
+        var THREADS = ["adc", "detect", "events", "uplink", "storage", "spectral", "periodic", "bth", "rtc"];
+        var QUEUES = ["events", "storage", "anomaly", "bth", "periodic", "waveform"];
+        var health = {
+          Uptime       : b[off] + b[off + 1] * 0x100 + b[off + 2] * 0x10000 + b[off + 3] * 0x1000000,
+          CpuLoad      : uint16(b[off + 4], b[off + 5]) / 10,
+          AdcOverruns  : uint16(b[off + 6], b[off + 7]),
+          LostSamples  : uint16(b[off + 8], b[off + 9]),
+          Dropped      : uint16(b[off + 10], b[off + 11]),
+          LockWaitMaxMs: uint16(b[off + 12], b[off + 13]) / 100,
+          LatencyP99Ms : uint16(b[off + 14], b[off + 15]) / 100,
+          LatencyMaxMs : uint16(b[off + 16], b[off + 17]) / 100,
+          QueuePeak    : {},
+          Threads      : {},
+        };
+        QUEUES.forEach(function (name, i) {
+          health.QueuePeak[name] = b[off + 18 + i];
+        });
+        THREADS.forEach(function (name, i) {
+          health.Threads[name] = {
+            Cpu   : b[off + 24 + i] / 2,
+            Stack : b[off + 33 + i],
+          };
+        });
+        return health;
+      }
+      case 7: {
+        // parts of the geophone files recorded in the window asked by a downlink
+        var u32 = function (o) {
+          return b[o] + b[o + 1] * 0x100 + b[o + 2] * 0x10000 + b[o + 3] * 0x1000000;
+        };
+        var win = {
+          From     : u32(off),
+          Duration : uint16(b[off + 4], b[off + 5]),
+          Ranges   : uint16(b[off + 6], b[off + 7]),
+          Blocks   : uint16(b[off + 8], b[off + 9]),
+          Samples  : u32(off + 10),
+          Files    : [],
+        };
+        for (var i = 0; i < Math.min(win.Ranges, 2); i++) {
+          var at = off + 14 + 10 * i;
+          win.Files.push({
+            File   : "geophone_" + ("00" + uint16(b[at], b[at + 1])).slice(-3) + ".dat",
+            Offset : u32(at + 2),
+            Size   : u32(at + 6),
+          });
+        }
+        return win;
+      }
+      case 8: {
+        // configuration in effect after a request on port 3, see config_codec.h
+        var u32 = function (o) {
+          return b[o] + b[o + 1] * 0x100 + b[o + 2] * 0x10000 + b[o + 3] * 0x1000000;
+        };
+        var c = off + 2;
+        var mask = b[c + 19];
+        return {
+          Status         : b[off] > 127 ? b[off] - 256 : b[off],
+          Param          : b[off + 1],
+          SamplingRateMs : uint16(b[c], b[c + 1]),
+          StaWindowMs    : uint16(b[c + 2], b[c + 3]),
+          LtaWindowMs    : uint16(b[c + 4], b[c + 5]),
+          RatioOn        : uint16(b[c + 6], b[c + 7]) / 100,
+          RatioOff       : uint16(b[c + 8], b[c + 9]) / 100,
+          AnomalyDelayMs : u32(c + 10),
+          BthPeriodS     : u32(c + 14),
+          SendSamples    : b[c + 18] !== 0,
+          Detectors      : ["sta_lta"].concat(["er", "mer", "threshold"].filter(function (name, i) {
+            return (mask >> i) & 1;
+          })),
+          Votes          : b[c + 20],
+        };
+      }
+    }
+    return null;
+  }
+
+  // ── Frame v2 ──────────────────────────────────────────────────────────────
+  // Byte 0    : 0x20 | number of records
+  // Bytes 1–4 : uint32 base time, Unix seconds (little-endian)
+  // Records   : type << 4, zigzag varint ms delta from the previous record
+  //             (the first one from the base), then the payload of the type.
+  //             Samples (3) are only the last record and run to the end.
+  var RECORD_SIZE = { 1: 6, 2: 26, 4: 24, 6: 42, 7: 34, 8: 23 };
+
+  if ((bytes[0] >> 4) === 2) {
+    var count = bytes[0] & 0x0f;
+    if (bytes.length < 5 || count === 0) {
+      return { errors: ["v2 frame too short or empty"] };
+    }
+    var timeMs = (bytes[1] + bytes[2] * 0x100 + bytes[3] * 0x10000 + bytes[4] * 0x1000000) * 1000;
+    var records = [];
+    var pos = 5;
+    for (var r = 0; r < count; r++) {
+      if (pos >= bytes.length) {
+        return { errors: ["v2 frame truncated at record " + r] };
+      }
+      var type = bytes[pos++] >> 4;
+      var v = 0, shift = 0, byte;
+      do {
+        byte = bytes[pos++];
+        v += (byte & 0x7f) * Math.pow(2, shift);
+        shift += 7;
+      } while (byte & 0x80);
+      timeMs += (v % 2) ? -(v + 1) / 2 : v / 2;
+
+      var len = (type === 3) ? bytes.length - pos : RECORD_SIZE[type];
+      if (len === undefined || pos + len > bytes.length) {
+        return { errors: ["v2 record " + r + " of type " + type + " is invalid"] };
+      }
+      var record = decodePayload(type, bytes, pos, len);
+      record.ID = type;
+      record.Timestamp = timeMs;
+      records.push(record);
+      pos += len;
+    }
+    return { data: { Version : 2, Records : records } };
+  }
+
   // ── Frame structure ───────────────────────────────────────────────────────
   // Byte 0    : ID
   // Bytes 1–8 : uint32 Unix timestamp (little-endian)
@@ -29,6 +219,33 @@ function decodeTimestamp(b, offset) {
   }
 
   var id     = bytes[0];
+
+  // ── ID 5 : Event fragment, no timestamp ──────────────────────────────────
+  // Byte 0    : ID
+  // Bytes 1–2 : uint16 event ID, matches the EventID of the ID 2 message
+  // Byte 3    : fragment sequence number, bit 7 set on the last fragment
+  // Bytes 4–5 : int16 offset of the first sample from the trigger sample
+  // Bytes 6+  : int16 samples, one every PeriodMs corrected by the RatePpm of the ID 2 message
+  if (id === 5) {
+    if (bytes.length < 8 || (bytes.length - 6) % 2 !== 0) {
+      return { errors: ["ID 5 expects a 6 bytes header and int16 samples, got " + bytes.length + " bytes"] };
+    }
+    var fragmentSamples = [];
+    for (var j = 6; j < bytes.length; j += 2) {
+      fragmentSamples.push(int16(bytes[j], bytes[j + 1]));
+    }
+    return {
+      data: {
+        ID       : id,
+        EventID  : bytes[1] | (bytes[2] << 8),
+        Sequence : bytes[3] & 0x7f,
+        Last     : (bytes[3] & 0x80) !== 0,
+        Offset   : int16(bytes[4], bytes[5]),
+        Samples  : fragmentSamples
+      }
+    };
+  }
+
   var unixTs = decodeTimestamp(bytes, 1);  // bytes 1-4
 
   // ── Dispatch on ID (length is no longer used to distinguish cases) ─────────
@@ -52,19 +269,37 @@ function decodeTimestamp(b, offset) {
 
     // ── ID 2 : Velocity sample — amp(2) + ratio(2) = 4 bytes → total 9 ───────
     // ── ID 2 : Velocity sample — min(2) + max(2) + ratio(2) → total 11 bytes ─
+    // ── ID 2 : + mean(2) → 17 bytes, + event ID(2) → 19 bytes, the event ID links the ID 5 fragments,
+    //           + spectral features(10) → 29 bytes, + sub-ms time(2) and rate(2) → 33 bytes,
+    //           + sampling period(2) → 35 bytes
     case 2: {
-      if (bytes.length !== 15) {
-        return { errors: ["ID 2 expects exactly 11 bytes, got " + bytes.length] };
+      if ([15, 17, 19, 29, 33, 35].indexOf(bytes.length) < 0) {
+        return { errors: ["ID 2 expects 15, 17, 19, 29, 33 or 35 bytes, got " + bytes.length] };
       }
-      return {
-        data: {
-          ID        : id,
-          Timestamp : unixTs,
-          MinSTA       : int16(bytes[9], bytes[10]),
-          MaxSTA       : int16(bytes[11], bytes[12]),
-          STALTA    : (int16(bytes[13], bytes[14]))/100,
-        }
+      var anomaly = {
+        ID        : id,
+        Timestamp : unixTs,
+        MinSTA       : int16(bytes[9], bytes[10]),
+        MaxSTA       : int16(bytes[11], bytes[12]),
+        STALTA    : (int16(bytes[13], bytes[14]))/100,
       };
+      if (bytes.length >= 17) {
+        anomaly.Mean    = int16(bytes[15], bytes[16]);
+      }
+      if (bytes.length >= 19) {
+        anomaly.EventID = bytes[17] | (bytes[18] << 8);
+      }
+      if (bytes.length >= 29) {
+        anomaly.Spectral = decodeSpectral(bytes, 19);
+      }
+      if (bytes.length >= 33) {
+        anomaly.TimeUs  = uint16(bytes[29], bytes[30]);
+        anomaly.RatePpm = int16(bytes[31], bytes[32]);
+      }
+      if (bytes.length === 35) {
+        anomaly.PeriodMs = uint16(bytes[33], bytes[34]);
+      }
+      return { data: anomaly };
     }
 
        // ── ID 3 : Samples ─────────────────────────────────────────────────
@@ -91,20 +326,48 @@ function decodeTimestamp(b, offset) {
       };
     }
 
-    // ── ID 4 : Periodic Sample ─────────────────────────────────────────────────
+    // ── ID 4 : Periodic Sample — min, max, mean (+ rms, p50, p90, p99) (+ spectral)
     case 4: {
-      if (bytes.length !== 15) {            // 1 + 4 + 4 = 9
-        return { errors: ["ID 2 payload too short (need 9 bytes)"] };
+      if (bytes.length !== 15 && bytes.length !== 23 && bytes.length !== 33) {
+        return { errors: ["ID 4 expects 15, 23 or 33 bytes, got " + bytes.length] };
       }
-      return {
-        data: {
-          ID        : id,
-          Timestamp : unixTs,
-          MinSTA : int16(bytes[9], bytes[10]), 
-          MaxSTA : int16(bytes[11], bytes[12]),
-          MeanSTA: int16(bytes[13], bytes[14]),
-        }
-      };
+      var periodic = decodePayload(4, bytes, 9, bytes.length - 9);
+      periodic.ID = id;
+      periodic.Timestamp = unixTs;
+      return { data: periodic };
+    }
+
+    // ── ID 6 : Node health — counters, latencies, queue peaks, per-thread CPU and stack (42 bytes)
+    case 6: {
+      if (bytes.length !== 51) {
+        return { errors: ["ID 6 expects 51 bytes, got " + bytes.length] };
+      }
+      var health = decodePayload(6, bytes, 9, 42);
+      health.ID = id;
+      health.Timestamp = unixTs;
+      return { data: health };
+    }
+
+    // ── ID 7 : Window — answer to a downlink request on port 3 (34 bytes)
+    case 7: {
+      if (bytes.length !== 43) {
+        return { errors: ["ID 7 expects 43 bytes, got " + bytes.length] };
+      }
+      var win = decodePayload(7, bytes, 9, 34);
+      win.ID = id;
+      win.Timestamp = unixTs;
+      return { data: win };
+    }
+
+    // ── ID 8 : Config — answer to a configuration request on port 3 (23 bytes)
+    case 8: {
+      if (bytes.length !== 32) {
+        return { errors: ["ID 8 expects 32 bytes, got " + bytes.length] };
+      }
+      var config = decodePayload(8, bytes, 9, 23);
+      config.ID = id;
+      config.Timestamp = unixTs;
+      return { data: config };
     }
 
     default:
@@ -4,6 +4,7 @@ from scipy.signal import spectrogram
 import matplotlib.pyplot as plt
 import glob
 import argparse
+from wave_codec import read_samples
 
 file_folder = "lfs"
 fs = 100  # sampling rate (Hz)
@@ -12,7 +13,7 @@ def show_spectrogram(data_folder: str, show_raw_signal: bool):
     # Concatenate data from all file in the data folder
     all_data = []
     for fpath in sorted(glob.glob(data_folder + "/geophone_*.dat")):
-        data = np.fromfile(fpath, dtype=np.int16)
+        data = read_samples(fpath)
         all_data.append(data)
     data = np.array(np.concatenate(all_data), dtype=np.float64)
     print(len(data))
@@ -8,6 +8,12 @@
  //  ========== includes ===================================================================
 #include "app_adc.h"
 #include "app_sta_lta_tx.h"
+#include "config_codec.h"
+#include "app_ds3231.h"
+#include "sample_ring.h"
+#include "dc_filter.h"
+#include "health.h"
+#include "power_stats.h"
 
 #include <zephyr/kernel.h>
 
@@ -17,9 +23,35 @@ LOG_MODULE_REGISTER(adc);
 
 //  ========== globals =====================================================================
 // ADC buffer to store raw ADC readings
-static uint16_t ring_buffer[ADC_BUFFER_SIZE];
+BUILD_ASSERT((ADC_BUFFER_SIZE & (ADC_BUFFER_SIZE - 1)) == 0, "ADC_BUFFER_SIZE must be a power of two");
+BUILD_ASSERT(ADC_BUFFER_SIZE >= 2 * PARAM_LTA_MAX_SAMPLES, "ADC_BUFFER_SIZE must hold two LTA windows");
+BUILD_ASSERT(ADC_BLOCK_SIZE >= 1 && ADC_BLOCK_SIZE <= MSEC_PER_SEC / SAMPLING_RATE_MS,
+             "ADC_BLOCK_SIZE goes from 1 sample to 1 s");
+static int16_t ring_buffer[ADC_BUFFER_SIZE];
+
+// lock-free view of ring_buffer: the ADC thread publishes, every consumer reads
+static struct sample_ring adc_ring = SAMPLE_RING_INITIALIZER(ring_buffer, ADC_BUFFER_SIZE);
 static uint32_t sampling_rate_ms = SAMPLING_RATE_MS;
 static uint16_t sample_buffer;
+
+// cycle counter when the last samples were published, for the detector latency
+static atomic_t push_cycles = ATOMIC_INIT(0);
+
+// RTC2 tick of one sample every ADC_TAG_SPACING, enough tags to cover the whole ring
+#define ADC_TAGS                    (2 * ADC_BUFFER_SIZE / ADC_TAG_SPACING)
+
+struct adc_tag {
+    uint32_t index;                 // absolute sample index
+    uint64_t ticks;                 // app_get_ticks() when it was converted
+};
+
+static struct k_spinlock tags_lock;
+static struct adc_tag tags[ADC_TAGS];
+static uint32_t tag_count;          // tags written so far
+static uint32_t rate_first_tag;     // first tag acquired at the current rate
+
+// removes the geophone DC level before the samples reach any consumer
+static struct dc_filter dc_filter;
 static bool stop_sampling = false;
 
 // ADC channel configuration obtained from the device tree
@@ -37,20 +69,40 @@ K_THREAD_STACK_DEFINE(adc_stack, 1024);
 // structure to hold ADC thread data
 struct k_thread adc_thread_data;
 
-// mutex to manage concurrent access to the ADC ring buffer
-K_MUTEX_DEFINE(buffer_lock);
-
-// mutex to manage access to buffers when retrieving ADC data
-K_MUTEX_DEFINE(get_buffer_lock);
-
 // semaphore to signal when new ADC data is available
 K_SEM_DEFINE(data_ready_sem, 0, 1);
 
 // semaphore to signal sampling rate change
 K_SEM_DEFINE(rate_change_sem, 0, 1);
 
-// index to track the head of the ring buffer
-int ring_head = 0;
+#if ADC_CONTINUOUS_ENABLE
+// one scan of the sequence: geophone (AIN0) then battery (AIN1), in channel order
+static uint16_t scan_buffer[2];
+
+// double buffer filled sample by sample from the SAADC callback
+static uint16_t block_buffer[2][ADC_BLOCK_SIZE];
+static uint8_t fill_index;
+static size_t fill_count;
+static volatile uint8_t ready_index;
+
+// app_get_ticks() when the last sample of each block was converted, so far
+static uint64_t block_ticks[2];
+
+// last battery reading of the continuous sequence, -1 until the first scan
+static atomic_t bat_raw = ATOMIC_INIT(-1);
+
+// set to ask the callback to end the running sequence (stop or rate change)
+static atomic_t restart_request = ATOMIC_INIT(0);
+
+// number of blocks that were not consumed before the next one was ready
+static atomic_t block_overruns = ATOMIC_INIT(0);
+
+// semaphore given from the callback when a block is full
+K_SEM_DEFINE(block_ready_sem, 0, 1);
+
+// signal raised by the driver when the sequence ends
+static struct k_poll_signal sequence_done;
+#endif
 
 // nonlinear mapping via lookup table
 // source: https://www.jackery.com/blogs/knowledge/battery-voltage-chart
@@ -140,11 +192,32 @@ uint8_t mv_to_batlevel(int v_bat) {
 //  ========== app_adc_get_bat =============================================================
 int16_t app_adc_get_bat()
 {
+    uint16_t raw = 0;
+
+#if ADC_CONTINUOUS_ENABLE
+    // the battery channel is part of the continuous sequence: the SAADC belongs to it, a
+    // synchronous read would collide with it. Wait for its first scan after a start.
+    atomic_val_t scan = atomic_get(&bat_raw);
+    for (int waited = 0; scan < 0 && waited < ADC_BAT_WAIT_MS; waited += sampling_rate_ms) {
+        k_sleep(K_MSEC(sampling_rate_ms));
+        scan = atomic_get(&bat_raw);
+    }
+    if (scan < 0) {
+        LOG_WRN("no battery reading, the acquisition is not running");
+        return -ENODATA;
+    }
+    raw = (uint16_t)scan;
+#else
     // read sample from the ADC
-    app_adc_read_ch(1);
+    int err = app_adc_read_ch(1);
+    if (err < 0) {
+        return err;
+    }
+    raw = sample_buffer;
+#endif
 
     // convert raw ADC reading to voltage
-    int32_t v_adc = (sample_buffer * ADC_FULL_SCALE_MV) / ADC_RESOLUTION;
+    int32_t v_adc = (raw * ADC_FULL_SCALE_MV) / ADC_RESOLUTION;
     LOG_INF("convert voltage AIN1: %d mV", v_adc);
 
     // scale back to actual battery voltage using voltage divider
@@ -154,32 +227,211 @@ int16_t app_adc_get_bat()
     return v_bat;
 }
 
-// //  ========== adc_thread ===============================================================
+//  ========== adc_update_filter ===========================================================
+// match the DC tracker to the current sampling rate
+static void adc_update_filter(void)
+{
+    dc_filter_set_corner(&dc_filter, DC_FILTER_CORNER_MHZ,
+                         (MSEC_PER_SEC * MSEC_PER_SEC) / sampling_rate_ms);
+}
+
+//  ========== adc_add_tag ==================================================================
+// keep the conversion time of the newest sample, at most one tag every ADC_TAG_SPACING samples
+static void adc_add_tag(uint32_t index, uint64_t ticks)
+{
+    k_spinlock_key_t key = k_spin_lock(&tags_lock);
+    const struct adc_tag *newest = &tags[(tag_count - 1) % ADC_TAGS];
+
+    if (tag_count == 0 || index / ADC_TAG_SPACING != newest->index / ADC_TAG_SPACING) {
+        tags[tag_count % ADC_TAGS] = (struct adc_tag){ .index = index, .ticks = ticks };
+        tag_count++;
+    }
+    k_spin_unlock(&tags_lock, key);
+}
+
+//  ========== adc_push_samples =============================================================
+// convert raw readings to mV, remove the DC level and append them to the ring buffer.
+// ticks is the conversion time of the last sample
+static void adc_push_samples(const uint16_t *raw, size_t count, uint64_t ticks)
+{
+    int16_t mv[ADC_BLOCK_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        mv[i] = dc_filter_update(&dc_filter, (raw[i] * ADC_FULL_SCALE_MV) / ADC_RESOLUTION);
+    }
+    sample_ring_write(&adc_ring, mv, count);
+    adc_add_tag(sample_ring_head(&adc_ring) - 1, ticks);
+    atomic_set(&push_cycles, k_cycle_get_32());
+    k_sem_give(&data_ready_sem);
+}
+
+#if ADC_CONTINUOUS_ENABLE
+//  ========== adc_sampling_cb =============================================================
+// called by the driver (ISR context) after each timer-triggered scan.
+// the sequence buffer is never advanced (ADC_ACTION_REPEAT): samples are moved into the
+// block double buffer, so the sequence runs until a restart is requested
+static enum adc_action adc_sampling_cb(const struct device *dev,
+                                       const struct adc_sequence *sequence,
+                                       uint16_t sampling_index)
+{
+    const uint16_t *scan = sequence->buffer;
+
+    block_buffer[fill_index][fill_count++] = scan[0];
+    atomic_set(&bat_raw, scan[1]);
+
+    // the callback follows the end of the conversion by a few us. Taken on every sample,
+    // a block cut short by the end of the sequence is dated by its own last sample.
+    block_ticks[fill_index] = app_get_ticks();
+
+    if (fill_count == ADC_BLOCK_SIZE) {
+        if (k_sem_count_get(&block_ready_sem) != 0) {
+            atomic_inc(&block_overruns);
+        }
+        ready_index = fill_index;
+        fill_index ^= 1;
+        fill_count = 0;
+        k_sem_give(&block_ready_sem);
+    }
+
+    return atomic_get(&restart_request) ? ADC_ACTION_FINISH : ADC_ACTION_REPEAT;
+}
+
+//  ========== adc_continuous_run ==========================================================
+// set up both channels once and run the timer-driven sequence until it is finished
+static int adc_continuous_run(void)
+{
+    const struct adc_dt_spec *geo = &adc_channels[0];
+    const struct adc_dt_spec *bat = &adc_channels[1];
+    int err;
+
+    if (!device_is_ready(geo->dev)) {
+        LOG_ERR("ADC device not ready");
+        return -ENODEV;
+    }
+
+    err = adc_channel_setup_dt(geo);
+    if (err == 0) {
+        err = adc_channel_setup_dt(bat);
+    }
+    if (err < 0) {
+        LOG_ERR("channel setup failed. error: %d", err);
+        return err;
+    }
+
+    struct adc_sequence_options options = {
+        .interval_us = sampling_rate_ms * USEC_PER_MSEC,
+        .callback = adc_sampling_cb,
+        .extra_samplings = 0,
+    };
+
+    struct adc_sequence sequence = {
+        .options = &options,
+        .buffer = scan_buffer,
+        .buffer_size = sizeof(scan_buffer),
+    };
+
+    err = adc_sequence_init_dt(geo, &sequence);
+    if (err < 0) {
+        LOG_ERR("sequence init failed. error: %d", err);
+        return err;
+    }
+    // geophone has the lowest channel id, so it lands first in scan_buffer
+    sequence.channels |= BIT(bat->channel_id);
+
+    fill_index = 0;
+    fill_count = 0;
+    atomic_clear(&restart_request);
+    k_sem_reset(&block_ready_sem);
+    k_poll_signal_reset(&sequence_done);
+
+    err = adc_read_async(geo->dev, &sequence, &sequence_done);
+    if (err < 0) {
+        LOG_ERR("ADC async read failed. error: %d", err);
+        return err;
+    }
+    LOG_INF("continuous sampling started every %d us", options.interval_us);
+
+    struct k_poll_event events[] = {
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SEM_AVAILABLE,
+                                 K_POLL_MODE_NOTIFY_ONLY, &block_ready_sem),
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL,
+                                 K_POLL_MODE_NOTIFY_ONLY, &sequence_done),
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SEM_AVAILABLE,
+                                 K_POLL_MODE_NOTIFY_ONLY, &rate_change_sem),
+    };
+
+    while (true) {
+        k_poll(events, ARRAY_SIZE(events), K_FOREVER);
+        power_stats_wakeup(POWER_WAKEUP_ADC);
+
+        if (k_sem_take(&block_ready_sem, K_NO_WAIT) == 0) {
+            adc_push_samples(block_buffer[ready_index], ADC_BLOCK_SIZE, block_ticks[ready_index]);
+        }
+        if (events[1].state == K_POLL_STATE_SIGNALED) {
+            // the sequence is over, the callback is no longer called: the samples of the
+            // block it was filling go to the consumers now, the next sequence starts a new one
+            if (fill_count > 0) {
+                adc_push_samples(block_buffer[fill_index], fill_count, block_ticks[fill_index]);
+                fill_count = 0;
+            }
+            // the caller decides whether to restart it
+            return 0;
+        }
+        if (k_sem_take(&rate_change_sem, K_NO_WAIT) == 0) {
+            // the interval is fixed for the whole sequence, end it to apply the new rate
+            atomic_set(&restart_request, 1);
+        }
+
+        for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+            events[i].state = K_POLL_STATE_NOT_READY;
+        }
+    }
+}
+#endif
+
+//  ========== adc_thread ==================================================================
 void app_adc_thread(void *arg1, void *arg2, void *arg3)
 {
+    adc_update_filter();
+
+#if ADC_CONTINUOUS_ENABLE
+    k_poll_signal_init(&sequence_done);
+
+    while (!stop_sampling) {
+        if (adc_continuous_run() < 0) {
+            // setup failure, retry later rather than spinning
+            k_sleep(K_MSEC(sampling_rate_ms * ADC_BLOCK_SIZE));
+        } else if (!stop_sampling) {
+            adc_update_filter();
+            LOG_INF("sampling rate updated to %d ms", sampling_rate_ms);
+        }
+    }
+#else
+    // the samples are read one by one, the consumers only see full blocks
+    uint16_t block[ADC_BLOCK_SIZE];
+    size_t count = 0;
+
     while (!stop_sampling) {
-         if (app_adc_read_ch(0) == 0) {
-            
-            k_mutex_lock(&buffer_lock, K_FOREVER);
-
-            int32_t v_adc = (sample_buffer * ADC_FULL_SCALE_MV) / ADC_RESOLUTION;
-            //printk("convert voltage AIN0: %d mV\n", v_adc);
-            
-            ring_buffer[ring_head] = v_adc;
-            ring_head = (ring_head + 1) % ADC_BUFFER_SIZE;
-            k_mutex_unlock(&buffer_lock);
-            k_sem_give(&data_ready_sem);
+        power_stats_wakeup(POWER_WAKEUP_ADC);
+        if (app_adc_read_ch(0) == 0) {
+            block[count++] = sample_buffer;
+            if (count == ADC_BLOCK_SIZE) {
+                adc_push_samples(block, count, app_get_ticks());
+                count = 0;
+            }
         } else {
             LOG_ERR("failed to read ADC sequence");
         }
 
         // check for a rate change signals
         if (k_sem_take(&rate_change_sem, K_NO_WAIT) == 0) {
+            adc_update_filter();
             LOG_INF("sampling rate updated to %d ms", sampling_rate_ms);
             k_sem_reset(&rate_change_sem);  // reset semaphore count
         }
         k_sleep(K_MSEC(sampling_rate_ms));
     }
+#endif
 }
 
 //  ========== app_adc_sampling_start ======================================================
@@ -191,6 +443,7 @@ void app_adc_sampling_start(void)
     k_thread_create(&adc_thread_data, adc_stack, K_THREAD_STACK_SIZEOF(adc_stack),
                     app_adc_thread, NULL, NULL, NULL,
                     PRIORITY_ADC, 0, K_NO_WAIT); // priority 2 (higher than LTA)
+    health_register_thread(HEALTH_THREAD_ADC, &adc_thread_data);
 }
 
 //  ========== app_adc_sampling_stop =======================================================
@@ -202,34 +455,135 @@ void app_adc_sampling_stop(void)
     k_thread_join(&adc_thread_data, K_FOREVER);
 }
 
+//  ========== app_adc_get_overruns ========================================================
+// number of continuous-mode blocks overwritten before the thread could consume them
+uint32_t app_adc_get_overruns(void)
+{
+#if ADC_CONTINUOUS_ENABLE
+    return (uint32_t)atomic_get(&block_overruns);
+#else
+    return 0;
+#endif
+}
+
+//  ========== app_adc_get_push_cycles =====================================================
+// k_cycle_get_32() when the newest samples were written to the ring
+uint32_t app_adc_get_push_cycles(void)
+{
+    return (uint32_t)atomic_get(&push_cycles);
+}
+
 //  ========== app_adc_get_buffer ==========================================================
 // copie a portion of the ADC ring buffer to a user-supplied buffer.
-// use a mutex to ensure thread-safe access
-void app_adc_get_buffer(uint16_t *dest, size_t size, int32_t offset)
+// offset is relative to the current head (negative to get the latest samples)
+int app_adc_get_buffer(int16_t *dest, size_t size, int32_t offset)
+{
+    return app_adc_read(dest, size, app_adc_get_head() + offset);
+}
+
+//  ========== app_adc_read ================================================================
+// copie `size` samples starting at the absolute sample index `start`.
+// never blocks the ADC thread: the copy is retried if it was overwritten meanwhile
+int app_adc_read(int16_t *dest, size_t size, uint32_t start)
 {
     if (!dest || size == 0 || size > ADC_BUFFER_SIZE) {
-        LOG_ERR("adc_get_buffer: invalid params (size=%zu)", size);
-        return;
+        LOG_ERR("adc_read: invalid params (size=%zu)", size);
+        return -EINVAL;
     }
 
-    // handle negative offsets by wrapping them around the buffer
-    int start_index = (ring_head + offset + ADC_BUFFER_SIZE) % ADC_BUFFER_SIZE;
+    int err = sample_ring_read(&adc_ring, dest, size, start);
+    if (err == -EAGAIN) {
+        LOG_WRN("adc_read: reader overrun at sample %u", start);
+    }
+    return err;
+}
 
-    k_mutex_lock(&buffer_lock, K_FOREVER);
+//  ========== app_adc_get_baseline ========================================================
+// current geophone DC level in mV, removed from the samples of the ring
+int16_t app_adc_get_baseline(void)
+{
+    return dc_filter_baseline(&dc_filter);
+}
 
-    for (size_t i = 0; i < size; i++) {
-        dest[i] = ring_buffer[(start_index + i) % ADC_BUFFER_SIZE];
-        // printk("dest[%zu] = ring_buffer[%d] = %d\n", i, (start_index + i) % ADC_BUFFER_SIZE, dest[i]);
-    }
-    k_mutex_unlock(&buffer_lock);
+//  ========== app_adc_get_head ============================================================
+// absolute index of the next sample to be acquired
+uint32_t app_adc_get_head(void)
+{
+    return sample_ring_head(&adc_ring);
 }
 
 //  ========== app_adc_set_sampling_rate ===================================================
 void app_adc_set_sampling_rate(uint32_t rate_ms)
 {
+    k_spinlock_key_t key = k_spin_lock(&tags_lock);
+    // the tags around the change still date the older samples, but not the new rate
+    rate_first_tag = tag_count;
+    k_spin_unlock(&tags_lock, key);
+
     sampling_rate_ms = rate_ms;
-    k_sem_give(&rate_change_sem);
     // signal the thread about the rate change
     k_sem_give(&rate_change_sem);
     LOG_INF("sampling rate set to %d ms", rate_ms);
 }
+
+//  ========== app_adc_get_sampling_rate ===================================================
+uint32_t app_adc_get_sampling_rate(void)
+{
+    return sampling_rate_ms;
+}
+
+//  ========== app_adc_get_sample_time =====================================================
+int app_adc_get_sample_time(uint32_t index, uint64_t *timestamp_us)
+{
+    struct adc_tag before, after;
+    bool found = false;
+
+    k_spinlock_key_t key = k_spin_lock(&tags_lock);
+    uint32_t oldest = tag_count - MIN(tag_count, ADC_TAGS);
+    // newest tag at or before the sample, and the one following it
+    for (uint32_t n = tag_count; n-- > oldest;) {
+        const struct adc_tag *tag = &tags[n % ADC_TAGS];
+        if ((int32_t)(index - tag->index) >= 0) {
+            before = *tag;
+            after = (n + 1 < tag_count) ? tags[(n + 1) % ADC_TAGS] : *tag;
+            found = true;
+            break;
+        }
+    }
+    k_spin_unlock(&tags_lock, key);
+
+    if (!found) {
+        return -ENOENT;
+    }
+
+    uint64_t clock_us = app_ticks_to_us(before.ticks);
+    if (after.index != before.index) {
+        uint64_t span_us = app_ticks_to_us(after.ticks) - clock_us;
+        clock_us += span_us * (index - before.index) / (after.index - before.index);
+    } else if (index != before.index) {
+        // newer than the newest tag, only possible while a block is being pushed
+        clock_us += (uint64_t)(index - before.index) * sampling_rate_ms * USEC_PER_MSEC;
+    }
+
+    *timestamp_us = app_timestamp_us(clock_us);
+    return 0;
+}
+
+//  ========== app_adc_get_rate_ppm ========================================================
+int32_t app_adc_get_rate_ppm(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&tags_lock);
+    uint32_t first = MAX(rate_first_tag, tag_count - MIN(tag_count, ADC_TAGS));
+    struct adc_tag oldest = tags[first % ADC_TAGS];
+    struct adc_tag newest = tags[(tag_count - 1) % ADC_TAGS];
+    bool valid = tag_count >= first + 2;
+    k_spin_unlock(&tags_lock, key);
+
+    if (!valid || newest.index == oldest.index) {
+        return 0;
+    }
+
+    int64_t nominal_us = (int64_t)(newest.index - oldest.index) * sampling_rate_ms * USEC_PER_MSEC;
+    int64_t measured_us = (int64_t)(app_ticks_to_us(newest.ticks) - app_ticks_to_us(oldest.ticks));
+    return (int32_t)((measured_us - nominal_us) * 1000000 / nominal_us);
+}
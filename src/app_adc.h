@@ -17,6 +17,8 @@
 #include <stdio.h>
 #include <stddef.h>
 
+#include "config.h" // for ADC_BLOCK_SIZE
+
 //  ========== defines =====================================================================
 // ADC characteristics (nRF52 SAADC)
 #define ADC_REF_INTERNAL_MV         600     // 0.6 V internal reference
@@ -30,17 +32,25 @@
 #define DIVIDER_RATIO_NUM           4600    // (R4 + R5)
 #define DIVIDER_RATIO_DEN           3600    // R5
 
-// duration between 2 samples
+// duration between 2 samples, at boot (see node_config.h)
 #define SAMPLING_RATE_MS            10
 
+// one acquired sample in ADC_TAG_SPACING is tagged with the RTC2 tick of its conversion,
+// the time of the others is interpolated between the tags
+#define ADC_TAG_SPACING             64
+
+// longest wait of app_adc_get_bat() for the first scan of the continuous acquisition
+#define ADC_BAT_WAIT_MS             1000
+
 // priority of the different threads involved
 #define PRIORITY_ADC                2
 
 // ========== globals ======================================================================
 extern struct k_sem data_ready_sem;
-extern int32_t ring_head;
 
 //  ========== prototypes ==================================================================
+// battery voltage in mV, or a negative error code (-ENODATA before the first scan of the
+// continuous acquisition)
 int16_t app_adc_get_bat();
 int8_t app_adc_read_ch(size_t ch);
 
@@ -49,7 +59,27 @@ void app_adc_thread(void *arg1, void *arg2, void *arg3);
 void app_adc_sampling_start(void);
 void app_adc_sampling_stop(void);
 
-void app_adc_get_buffer(uint16_t *dest, size_t size, int32_t offset);
+int app_adc_get_buffer(int16_t *dest, size_t size, int32_t offset);
+int app_adc_read(int16_t *dest, size_t size, uint32_t start);
+uint32_t app_adc_get_head(void);
+int16_t app_adc_get_baseline(void);
 void app_adc_set_sampling_rate(uint32_t rate_ms);
+uint32_t app_adc_get_sampling_rate(void);
+uint32_t app_adc_get_overruns(void);
+uint32_t app_adc_get_push_cycles(void);
+
+/**
+ * @brief unix time in us at which a sample still in the ring was converted,
+ * interpolated between the RTC2 tags of the acquired blocks
+ *
+ * @return 0 on success, -ENOENT if the sample is older than the oldest tag
+ */
+int app_adc_get_sample_time(uint32_t index, uint64_t *timestamp_us);
+
+/**
+ * @brief deviation of the measured sampling period from the nominal one, in ppm,
+ * over the tags acquired since the last rate change
+ */
+int32_t app_adc_get_rate_ppm(void);
 
 #endif /* APP_ADC_H */
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "app_console.h"
+#include "health.h"
+#include "clock_discipline.h"
+#include "app_ds3231.h"
+#include "power_stats.h"
+#include "fs_utils.h"
+#include "bulk_dump.h"
+#include "uplink.h"
+#include "uplink_log.h"
+#include "wave_index.h"
+#include "node_config.h"
+#include "downlink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CONFIG_USE_SEGGER_RTT)
+#include <SEGGER_RTT.h>
+#elif defined(CONFIG_CONSOLE_GETLINE) && defined(CONFIG_UART_CONSOLE)
+#include <zephyr/console/console.h>
+#endif
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(console);
+
+//  ========== globals =====================================================================
+K_THREAD_STACK_DEFINE(console_stack, 2048);
+struct k_thread console_thread_data;
+
+struct console_command {
+    const char *name;
+    void (*handler)(const char *args);
+};
+
+static void cmd_help(const char *args);
+
+//  ========== commands ====================================================================
+static void cmd_health(const char *args)
+{
+    health_dump();
+}
+
+static void cmd_dump(const char *args)
+{
+    dump_fs(false);
+}
+
+// "<from ms> <to ms>", unix time
+static int parse_window(const char *args, uint64_t *from_ms, uint64_t *to_ms)
+{
+    char *end;
+
+    *from_ms = strtoull(args, &end, 10);
+    if (end == args) {
+        return -EINVAL;
+    }
+    args = end;
+    *to_ms = strtoull(args, &end, 10);
+    return (end == args || *to_ms <= *from_ms) ? -EINVAL : 0;
+}
+
+static void cmd_bulk(const char *args)
+{
+    char name[CONSOLE_LINE_SIZE];
+    uint32_t offset = 0, length = UINT32_MAX;
+    uint64_t from_ms, to_ms;
+
+    // answered on the bulk RTT channel, see bulk_dump.h
+    if (strcmp(args, "list") == 0) {
+        bulk_dump_list();
+    } else if (sscanf(args, "get %63s %u %u", name, &offset, &length) >= 1) {
+        bulk_dump_get(name, offset, length);
+    } else if (strncmp(args, "find ", 5) == 0 && parse_window(&args[5], &from_ms, &to_ms) == 0) {
+        bulk_dump_find(from_ms, to_ms);
+    } else {
+        printk("usage: bulk list | bulk get <file> [offset] [length] | bulk find <from ms> <to ms>\n");
+    }
+}
+
+static int print_range(const struct wave_index_range *range, void *user)
+{
+    printk("%s_%03u%s offset %u size %u, %llu to %llu ms, %u blocks, %u samples\n",
+           FILE_PREFIX, range->file, FILE_EXT, range->offset, range->size, range->start_ms,
+           range->end_ms, range->blocks, range->samples);
+    return 0;
+}
+
+static void cmd_find(const char *args)
+{
+    uint64_t from_ms, to_ms;
+
+    if (parse_window(args, &from_ms, &to_ms) < 0) {
+        printk("usage: find <from ms> <to ms>\n");
+        return;
+    }
+    int count = wave_index_query(from_ms, to_ms, print_range, NULL);
+    printk("%d ranges\n", count);
+}
+
+static void cmd_clock(const char *args)
+{
+    uint32_t interval_s;
+    int32_t error_us, freq_ppb;
+
+    clock_discipline_get_state(&interval_s, &error_us, &freq_ppb);
+    printk("time %llu ms, last error %d us, frequency %d ppb, DS3231 every %u s\n",
+           app_get_timestamp(), error_us, freq_ppb, interval_s);
+}
+
+static void cmd_power(const char *args)
+{
+    // figures since the previous "power", which starts a new window
+    power_stats_print(true);
+}
+
+static void cmd_uplink(const char *args)
+{
+    uint32_t records, acked, bytes;
+
+    uplink_log_get_state(&records, &acked, &bytes);
+    printk("uplink log %u records, %u sent, %u bytes, dropped %u\n", records, acked, bytes,
+           uplink_get_dropped());
+}
+
+static void cmd_config(const char *args)
+{
+    node_config_dump();
+}
+
+static void cmd_downlink(const char *args)
+{
+    uint8_t data[DOWNLINK_MAX_SIZE];
+
+    // the same path as a downlink received on DOWNLINK_PORT, answered by an uplink
+    size_t len = hex2bin(args, strlen(args), data, sizeof(data));
+    if (len == 0) {
+        printk("usage: downlink <hex payload>\n");
+        return;
+    }
+    downlink_receive(DOWNLINK_PORT, data, (uint8_t)len);
+}
+
+static const struct console_command commands[] = {
+    { "help", cmd_help },
+    { "health", cmd_health },
+    { "dump", cmd_dump },
+    { "bulk", cmd_bulk },
+    { "find", cmd_find },
+    { "clock", cmd_clock },
+    { "power", cmd_power },
+    { "uplink", cmd_uplink },
+    { "config", cmd_config },
+    { "downlink", cmd_downlink },
+};
+
+static void cmd_help(const char *args)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+        printk("%s\n", commands[i].name);
+    }
+}
+
+//  ========== console_execute =============================================================
+static void console_execute(char *line)
+{
+    // trim the line ending, the arguments follow the first space
+    line[strcspn(line, "\r\n")] = '\0';
+    char *args = strchr(line, ' ');
+    if (args != NULL) {
+        *args++ = '\0';
+    } else {
+        args = "";
+    }
+    if (line[0] == '\0') {
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+        if (strcmp(line, commands[i].name) == 0) {
+            commands[i].handler(args);
+            return;
+        }
+    }
+    printk("unknown command: %s\n", line);
+}
+
+//  ========== console_thread ==============================================================
+static void console_thread(void *arg1, void *arg2, void *arg3)
+{
+#if defined(CONFIG_USE_SEGGER_RTT)
+    char line[CONSOLE_LINE_SIZE];
+    size_t len = 0;
+    int64_t last_command_ms = INT64_MIN / 2;
+
+    while (1) {
+        char c;
+        if (SEGGER_RTT_Read(0, &c, 1) == 0) {
+            // a script sends its commands back to back, answer them without the poll delay
+            bool busy = k_uptime_get() - last_command_ms < CONSOLE_FAST_WINDOW_MS;
+            k_sleep(K_MSEC(busy ? CONSOLE_FAST_POLL_MS : CONSOLE_POLL_MS));
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            line[len] = '\0';
+            console_execute(line);
+            last_command_ms = k_uptime_get();
+            len = 0;
+        } else if (len < sizeof(line) - 1) {
+            line[len++] = c;
+        }
+    }
+#elif defined(CONFIG_CONSOLE_GETLINE) && defined(CONFIG_UART_CONSOLE)
+    char line[CONSOLE_LINE_SIZE];
+
+    console_getline_init();
+    while (1) {
+        strncpy(line, console_getline(), sizeof(line) - 1);
+        line[sizeof(line) - 1] = '\0';
+        console_execute(line);
+    }
+#else
+    LOG_WRN("no console input on this board, commands disabled");
+#endif
+}
+
+//  ========== app_console_start ===========================================================
+void app_console_start(void)
+{
+    k_thread_create(&console_thread_data, console_stack,
+                    K_THREAD_STACK_SIZEOF(console_stack),
+                    console_thread, NULL, NULL, NULL,
+                    PRIORITY_CONSOLE, 0, K_NO_WAIT);
+    k_thread_name_set(&console_thread_data, "console");
+}
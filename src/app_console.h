@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_CONSOLE_H
+#define APP_CONSOLE_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+
+//  ========== defines =====================================================================
+// longest command line, arguments included
+#define CONSOLE_LINE_SIZE           64
+
+// RTT has no input interrupt, the down buffer is polled at this period, and faster for a
+// while after each command
+#define CONSOLE_POLL_MS             250
+#define CONSOLE_FAST_POLL_MS        5
+#define CONSOLE_FAST_WINDOW_MS      2000
+
+#define PRIORITY_CONSOLE            7
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start the thread reading commands from the RTT down channel (or the UART console
+ *        on boards without RTT)
+ *
+ * Commands, one per line:
+ *   help      list the commands
+ *   health    print the instrumentation figures (see health.h)
+ *   dump      send every file of the flash (see dump_fs() and download_data.py)
+ *   bulk      "bulk list", "bulk get <file> [offset] [length]" or "bulk find <from ms> <to ms>":
+ *             binary transfer of the flash files on RTT channel 1 (see bulk_dump.h and
+ *             download_data.py)
+ *   find      "find <from ms> <to ms>": print the parts of the geophone files recorded in
+ *             that window (see wave_index.h)
+ *   clock     print the state of the clock discipline (see clock_discipline.h)
+ *   power     print the wakeup rates and CPU active time since the last call (see power_stats.h)
+ *   uplink    print the state of the uplink log (see uplink_log.h)
+ *   config    print the configuration in effect (see node_config.h)
+ *   downlink  "downlink <hex>": handle a payload as a downlink received on DOWNLINK_PORT,
+ *             as printed by downlink_encoder.py (see downlink.h)
+ */
+void app_console_start(void);
+
+#endif /* APP_CONSOLE_H */
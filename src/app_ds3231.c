@@ -7,6 +7,7 @@
 
 //  ========== includes ===================================================================
 #include "app_ds3231.h"
+#include "clock_discipline.h"
 #include <zephyr/sys/timeutil.h>
 
 #include "config.h" // for log level
@@ -14,8 +15,10 @@
 LOG_MODULE_REGISTER(ds3231);
 
 //  ========== globals ====================================================================
-static int64_t  rtc_offset_ms = 0;   // anchors nRF ticks to DS3231 unix time
-static struct k_mutex offset_mutex;
+// RTC2 counter extended to 64 bits, app_get_ticks() must run at least once per wrap
+static struct k_spinlock ticks_lock;
+static uint32_t ticks_last;
+static uint64_t ticks_high;
 
 //  ========== bcd_to_bin ==================================================================
 static uint8_t bcd_to_bin(uint8_t val)
@@ -29,9 +32,9 @@ static uint8_t bin_to_bcd(uint8_t val)
     return ((val / 10) << 4) | (val % 10);
 }
 
-//  ========== ds3231_read_unix ============================================================
+//  ========== app_ds3231_read_unix ========================================================
 // reads DS3231 registers directly via I2C, bypassing counter_get_value
-static int ds3231_read_unix(uint32_t *unix_secs)
+int app_ds3231_read_unix(uint32_t *unix_secs)
 {
     const struct device *i2c = DEVICE_DT_GET(DT_NODELABEL(i2c0));
     if (!device_is_ready(i2c)) {
@@ -60,7 +63,7 @@ static int ds3231_read_unix(uint32_t *unix_secs)
     // convert to unix seconds
     *unix_secs = (uint32_t)timeutil_timegm64(&utc);
 
-    LOG_INF("DS3231 direct read: %02d:%02d:%02d %02d/%02d/%04d -> unix=%u",
+    LOG_DBG("DS3231 direct read: %02d:%02d:%02d %02d/%02d/%04d -> unix=%u",
            utc.tm_hour, utc.tm_min, utc.tm_sec,
            utc.tm_mday, utc.tm_mon + 1, utc.tm_year + 1900,
            *unix_secs);
@@ -78,7 +81,6 @@ const struct device *app_ds3231_init(void)
         return NULL;
     }
 
-    k_mutex_init(&offset_mutex);
     LOG_INF("DS3231 ready");
     return dev;
 }
@@ -116,71 +118,54 @@ int8_t app_ds3231_set_time(const struct device *ds3231_dev, uint32_t unix_secs)
         return ret;
     }
 
-    k_sleep(K_MSEC(1100));
-
-    // read back directly via I2C, NOT counter_get_value
-    uint32_t readback;
-    ret = ds3231_read_unix(&readback);
-    if (ret < 0) {
-        return ret;
-    }
-
-    int64_t uptime_ms = k_uptime_get();
-    int64_t target_ms = (int64_t)readback * 1000;
-
-    k_mutex_lock(&offset_mutex, K_FOREVER);
-    rtc_offset_ms = target_ms - uptime_ms;
-    k_mutex_unlock(&offset_mutex);
-    LOG_INF("DS3231 time set to unix=%u, offset=%lld ms",
-           readback, rtc_offset_ms);
+    // writing the seconds restarts the countdown of the chip, its next edge is one second later
+    LOG_INF("DS3231 time set to unix=%u", unix_secs);
     return 0;
 }
 
-//  ========== app_ds3231_periodic_sync ====================================================
-int8_t app_ds3231_periodic_sync(const struct device *ds3231_dev)
+//  ========== app_get_ticks ===============================================================
+// nRF RTC2 ticks since the counter was started, extended to 64 bits. The hardware
+// counter is only 24 bits wide: a wrap is detected as the value going backwards,
+// which holds as long as this runs at least once per wrap (the ADC does, every block).
+// callable from an ISR
+uint64_t app_get_ticks(void)
 {
-    uint32_t unix_secs;
-    int ret = ds3231_read_unix(&unix_secs);   // direct I2C, not counter_get_value
-    if (ret < 0) {
-        LOG_ERR("DS3231 periodic sync failed: %d", ret);
-        return ret;
-    }
-
     const struct device *nrf_rtc = DEVICE_DT_GET(DT_NODELABEL(rtc2));
     uint32_t ticks;
+
+    k_spinlock_key_t key = k_spin_lock(&ticks_lock);
     counter_get_value(nrf_rtc, &ticks);
-    uint32_t freq   = counter_get_frequency(nrf_rtc);
-    int64_t tick_ms = ((int64_t)ticks * 1000) / freq;
+    if (ticks < ticks_last) {
+        ticks_high += (uint64_t)counter_get_top_value(nrf_rtc) + 1;
+    }
+    ticks_last = ticks;
+    uint64_t result = ticks_high + ticks;
+    k_spin_unlock(&ticks_lock, key);
+
+    return result;
+}
 
-    int64_t new_offset = (int64_t)unix_secs * 1000 - tick_ms;
+//  ========== app_ticks_to_us =============================================================
+// converts RTC2 ticks to us of the local clock
+uint64_t app_ticks_to_us(uint64_t ticks)
+{
+    const struct device *nrf_rtc = DEVICE_DT_GET(DT_NODELABEL(rtc2));
+    uint32_t freq = counter_get_frequency(nrf_rtc);
 
-    k_mutex_lock(&offset_mutex, K_FOREVER);
-    rtc_offset_ms = new_offset;
-    k_mutex_unlock(&offset_mutex);
+    // split to keep the product within 64 bits
+    return (ticks / freq) * USEC_PER_SEC + ((ticks % freq) * USEC_PER_SEC) / freq;
+}
 
-    LOG_INF("sync: DS3231=%u s, tick_ms=%lld ms, offset=%lld ms",
-           unix_secs, tick_ms, new_offset);
-    return 0;
+//  ========== app_timestamp_us ============================================================
+// unix time in us of a local clock reading, as returned by app_ticks_to_us()
+uint64_t app_timestamp_us(uint64_t clock_us)
+{
+    return clock_discipline_unix_us(clock_us);
 }
 
 //  ========== app_get_timestamp ===========================================================
 // returns unix timestamp in ms with sub-second precision from nRF RTC ticks
 uint64_t app_get_timestamp(void)
 {
-    const struct device *nrf_rtc = DEVICE_DT_GET(DT_NODELABEL(rtc2));
-    uint32_t ticks;
-    counter_get_value(nrf_rtc, &ticks);
-    uint32_t freq   = counter_get_frequency(nrf_rtc);
-    int64_t tick_ms = ((int64_t)ticks * 1000) / freq;
-
-    int64_t offset;
-    k_mutex_lock(&offset_mutex, K_FOREVER);
-    offset = rtc_offset_ms;
-    k_mutex_unlock(&offset_mutex);
-
-    int64_t result = tick_ms + offset;
-    if (result < 0) {
-        return 0;
-    }
-    return (uint64_t)result;
-}
\ No newline at end of file
+    return app_timestamp_us(app_ticks_to_us(app_get_ticks())) / USEC_PER_MSEC;
+}
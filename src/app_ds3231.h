@@ -23,7 +23,10 @@
 //  ========== prototypes ============================================================================
 const struct device *app_ds3231_init(void);
 int8_t app_ds3231_set_time(const struct device *ds3231_dev, uint32_t unix_secs);
-int8_t app_ds3231_periodic_sync(const struct device *ds3231_dev);
+int app_ds3231_read_unix(uint32_t *unix_secs);
+uint64_t app_get_ticks(void);
+uint64_t app_ticks_to_us(uint64_t ticks);
+uint64_t app_timestamp_us(uint64_t clock_us);
 uint64_t app_get_timestamp(void);
 
 #endif /* APP_DS3231_H */
\ No newline at end of file
@@ -8,6 +8,8 @@
 //  ========== includes ====================================================================
 #include "app_sensors.h"
 #include "data_types.h"
+#include "app_ds3231.h"
+#include "uplink.h"
 
 #include "config.h" // for log level
 #include <zephyr/logging/log.h>
@@ -18,6 +20,9 @@ int8_t app_sensors_handler()
 {
     int8_t ret;
     
+    struct bth_payload_t payload;
+
+#if DT_HAS_COMPAT_STATUS_OKAY(sensirion_sht3xd)
     // get sensor device
     const struct device *dev = DEVICE_DT_GET_ONE(sensirion_sht3xd);
     if (!device_is_ready(dev)) {
@@ -26,14 +31,22 @@ int8_t app_sensors_handler()
     }
 
     // collect sensor data and add to byte payloa
-    struct bth_payload_t payload;
-    payload.battery = app_adc_get_bat();
+    payload.battery = MAX(app_adc_get_bat(), 0);   // 0 when there is no reading
     payload.temperature = app_sht_get_temp(dev);
     k_sleep(K_SECONDS(5));		// small delay between reading the temperature and humidity values
     payload.humidity = app_sht_get_hum(dev);
+#else
+    // no SHT3x on this board (native_sim), only the battery is measured
+    payload.battery = MAX(app_adc_get_bat(), 0);   // 0 when there is no reading
+    payload.temperature = 0;
+    payload.humidity = 0;
+#endif
 
-    ret = lora_send_packet(BTH, (uint8_t *) &payload, sizeof(struct bth_payload_t));
+    ret = uplink_enqueue(BTH, app_get_timestamp(), &payload, sizeof(struct bth_payload_t), K_NO_WAIT);
+    if (ret != 0) {
+        return ret;
+    }
 
-    LOG_INF("BTH data sent!");
+    LOG_INF("BTH data queued");
     return 0;
 }
\ No newline at end of file
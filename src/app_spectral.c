@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "app_spectral.h"
+#include "app_adc.h"
+#include "app_sta_lta_tx.h"
+#include "spectral.h"
+#include "health.h"
+#include "node_config.h"
+
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(spectral);
+
+//  ========== globals =====================================================================
+K_THREAD_STACK_DEFINE(spectral_stack, 1024);
+struct k_thread spectral_thread_data;
+
+// FFT state and the average spectrum, ~3 KB
+static struct spectral spectral;
+
+// current frame, shifted by SPECTRAL_HOP samples for each new one
+static int16_t frame[SPECTRAL_FFT_SIZE];
+
+// a mutex and not a spinlock: a frame takes a few hundred microseconds and must not
+// mask the ADC interrupt
+K_MUTEX_DEFINE(spectral_lock);
+static struct spectral_payload_t last_features;
+
+static uint32_t last_cycles;
+static uint32_t max_cycles;
+
+//  ========== app_spectral_thread =========================================================
+static void app_spectral_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct spectral_payload_t features;
+    struct node_config_t config;
+    uint32_t generation = node_config_get(&config);
+    uint32_t rate = config.sampling_rate_ms;
+    size_t filled = 0;
+
+    spectral_init(&spectral, rate);
+    uint32_t next = app_adc_get_head();
+
+    LOG_INF("spectral thread started");
+
+    while (1) {
+        // sleep until the missing samples are expected, or the configuration changes
+        size_t missing = (filled < SPECTRAL_FFT_SIZE) ? SPECTRAL_FFT_SIZE - filled : SPECTRAL_HOP;
+        if (node_config_wait(generation, K_MSEC(missing * rate))) {
+            generation = node_config_get(&config);
+        }
+        if (config.sampling_rate_ms != rate) {
+            // the bins move with the sampling period, the frame and the average start over
+            rate = config.sampling_rate_ms;
+            health_mutex_lock(&spectral_lock, HEALTH_LOCK_SPECTRAL, K_FOREVER);
+            spectral_init(&spectral, rate);
+            k_mutex_unlock(&spectral_lock);
+            next = app_adc_get_head();
+            filled = 0;
+            LOG_INF("spectral analysis restarted at %u ms", rate);
+            continue;
+        }
+
+        uint32_t head = app_adc_get_head();
+        if (head - next > ADC_BUFFER_SIZE - ADC_BLOCK_SIZE) {
+            // fell behind the ring, start a new frame on the newest samples
+            LOG_WRN("spectral thread lost %u samples", head - next);
+            next = head;
+            filled = 0;
+            continue;
+        }
+
+        while (head - next >= SPECTRAL_HOP) {
+            if (filled == SPECTRAL_FFT_SIZE) {
+                // 50 % overlap: keep the second half of the previous frame
+                memmove(frame, &frame[SPECTRAL_HOP], SPECTRAL_HOP * sizeof(int16_t));
+                filled -= SPECTRAL_HOP;
+            }
+            if (app_adc_read(&frame[filled], SPECTRAL_HOP, next) != 0) {
+                next = app_adc_get_head();
+                filled = 0;
+                break;
+            }
+            next += SPECTRAL_HOP;
+            filled += SPECTRAL_HOP;
+            if (filled < SPECTRAL_FFT_SIZE) {
+                continue;
+            }
+
+            health_mutex_lock(&spectral_lock, HEALTH_LOCK_SPECTRAL, K_FOREVER);
+            uint32_t start = k_cycle_get_32();
+            spectral_process(&spectral, frame, &features);
+            last_cycles = k_cycle_get_32() - start;
+            max_cycles = MAX(max_cycles, last_cycles);
+            last_features = features;
+            k_mutex_unlock(&spectral_lock);
+
+            LOG_DBG("frame: %u cycles, dominant %u.%u Hz", last_cycles,
+                    features.dominant / 10, features.dominant % 10);
+        }
+    }
+}
+
+//  ========== app_spectral_start ==========================================================
+void app_spectral_start(void)
+{
+    k_thread_create(&spectral_thread_data, spectral_stack,
+                    K_THREAD_STACK_SIZEOF(spectral_stack),
+                    app_spectral_thread, NULL, NULL, NULL,
+                    PRIORITY_SPECTRAL, 0, K_NO_WAIT);
+    health_register_thread(HEALTH_THREAD_SPECTRAL, &spectral_thread_data);
+}
+
+//  ========== app_spectral_get_last =======================================================
+void app_spectral_get_last(struct spectral_payload_t *out)
+{
+    health_mutex_lock(&spectral_lock, HEALTH_LOCK_SPECTRAL, K_FOREVER);
+    *out = last_features;
+    k_mutex_unlock(&spectral_lock);
+}
+
+//  ========== app_spectral_take_average ===================================================
+void app_spectral_take_average(struct spectral_payload_t *out)
+{
+    health_mutex_lock(&spectral_lock, HEALTH_LOCK_SPECTRAL, K_FOREVER);
+    spectral_take_average(&spectral, out);
+    k_mutex_unlock(&spectral_lock);
+}
+
+//  ========== app_spectral_get_cycles =====================================================
+void app_spectral_get_cycles(uint32_t *last, uint32_t *max)
+{
+    health_mutex_lock(&spectral_lock, HEALTH_LOCK_SPECTRAL, K_FOREVER);
+    *last = last_cycles;
+    *max = max_cycles;
+    k_mutex_unlock(&spectral_lock);
+}
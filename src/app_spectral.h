@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_SPECTRAL_H
+#define APP_SPECTRAL_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#include "data_types.h"
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start the spectral thread
+ *
+ * Below every other processing thread, it follows the ADC ring with its own cursor and
+ * analyses one SPECTRAL_FFT_SIZE frame every SPECTRAL_HOP samples. Being preemptible
+ * and reading a copy of the samples, it never delays acquisition or detection.
+ */
+void app_spectral_start(void);
+
+/**
+ * @brief features of the last analysed frame, zeros before the first one
+ */
+void app_spectral_get_last(struct spectral_payload_t *out);
+
+/**
+ * @brief features of the mean spectrum since the last call, for the periodic summary
+ */
+void app_spectral_take_average(struct spectral_payload_t *out);
+
+/**
+ * @brief CPU cycles spent on the last frame and the worst frame so far
+ */
+void app_spectral_get_cycles(uint32_t *last, uint32_t *max);
+
+#endif /* APP_SPECTRAL_H */
@@ -11,7 +11,17 @@
 #include "app_ds3231.h"
 #include "data_types.h"
 #include "lorawan.h"
+#include "uplink.h"
 #include "fs_utils.h"
+#include "sta_lta.h"
+#include "detectors.h"
+#include "event_capture.h"
+#include "node_config.h"
+#include "config_codec.h"
+#include "app_spectral.h"
+#include "dsp_kernels.h"
+#include "health.h"
+#include "power_stats.h"
 #include "config.h"
 
 #include <zephyr/logging/log.h>
@@ -27,85 +37,69 @@ struct k_thread lorawan_thread_data;
 struct k_thread lorawan_thread_data;
 
 // buffer to hold the Short-Term Average (STA) and Long-Term Average (LTA) samples
-static uint16_t sta_buffer[STA_WINDOW_SIZE];
-static uint16_t lta_buffer[LTA_WINDOW_SIZE];
-
-// buffer to hold a signal sample of 1 second, to send via LoRaWAN - TODO : Make it so we can handle multiple 1s samples at a time
-static uint16_t send_buffer[STA_WINDOW_SIZE];
+// in streaming modes, lta_buffer is the history of the running sums. They are sized for
+// the largest windows of a downlink configuration, sta_size and lta_size are in use.
+BUILD_ASSERT(STA_WINDOW_SIZE <= PARAM_STA_MAX_SAMPLES && LTA_WINDOW_SIZE <= PARAM_LTA_MAX_SAMPLES,
+             "the default windows must fit the detector buffers");
+static int16_t sta_buffer[PARAM_STA_MAX_SAMPLES];
+static int16_t lta_buffer[PARAM_LTA_MAX_SAMPLES];
+static size_t sta_size;
+static size_t lta_size;
+
+// detection parameters in effect (see node_config.h), only used by the detector thread
+static struct node_config_t config;
+static uint32_t config_generation;
+
+// STA window size for the LoRaWAN thread, which sends it with each event
+static atomic_t sent_size = ATOMIC_INIT(STA_WINDOW_SIZE);
+
+#if STA_LTA_MODE != STA_LTA_MODE_WINDOWED
+// streaming detectors, the STA/LTA first then the ones of config.detectors, combined by voting
+static struct detector detectors[4];
+static struct detector_bank bank;
+static int16_t er_history[2 * PARAM_STA_MAX_SAMPLES];
+static int16_t mer_history[2 * PARAM_STA_MAX_SAMPLES];
+#endif
 
 // Timer to check when the last LTA/STA ratio exceed the threshold
 uint64_t last_anomaly_time;
 
-// message structure to pass detection results to LoRaWAN sender
-typedef struct
-{
-    uint64_t timestamp_ms;
-    int16_t max_ampl;
-    int16_t min_ampl;
-    int16_t mean_ampl;
-    float ratio;
-} lta_event_t;
-
-// message structure for sample storage
-typedef struct
-{
-    int32_t head_snapshot; // value of ring_head when the event was enqueued
-} storage_event_t;
+// events dropped on a full lorawan_msgq, samples skipped by a late detector
+static atomic_t dropped_events = ATOMIC_INIT(0);
+static atomic_t lost_samples = ATOMIC_INIT(0);
 
 // message queues (4 slots each — tune as needed)
 K_MSGQ_DEFINE(lorawan_msgq, sizeof(lta_event_t), 4, 4);
 K_MSGQ_DEFINE(storage_msgq, sizeof(storage_event_t), 4, 4);
 
 //  ========== calculate_squared_avg ===============================================================
-// function to calculate the average of a given buffer
-float calculate_squared_avg(const uint16_t *buffer, size_t size)
+// function to calculate the mean energy of a given buffer (samples are DC-free)
+float calculate_squared_avg(const int16_t *buffer, size_t size)
 {
-    float sum = 0.0;
-    for (size_t i = 0; i < size; i++)
-    {
-        float x = (float)(buffer[i] - 1770);
-        sum += x * x;
-    }
-    return sum / size;
+    uint64_t sum = dsp_sum_sq_q15(buffer, size, 0);
+    return (float)sum / size;
 }
 
 //  ========== calculate_avg ===============================================================
 // function to calculate the average of a given buffer
-float calculate_avg(const uint16_t *buffer, size_t size)
+float calculate_avg(const int16_t *buffer, size_t size)
 {
-    float sum = 0.0;
-    for (size_t i = 0; i < size; i++)
-    {
-        sum += (float)(buffer[i]);
-    }
-    return sum / size;
+    return (float)dsp_sum_q15(buffer, size) / size;
 }
 
 //  ========== find_max_amplitude ==========================================================
-uint16_t find_max_amplitude(const uint16_t *buffer, size_t size)
+int16_t find_max_amplitude(const int16_t *buffer, size_t size)
 {
-    uint16_t max_val = 0;
-    for (size_t i = 0; i < size; i++)
-    {
-        if (buffer[i] > max_val)
-        {
-            max_val = buffer[i];
-        }
-    }
+    int16_t min_val, max_val;
+    dsp_min_max_q15(buffer, size, &min_val, &max_val);
     return max_val;
 }
 
-uint16_t find_min_amplitude(const uint16_t *buffer, size_t size)
+int16_t find_min_amplitude(const int16_t *buffer, size_t size)
 {
-    uint16_t max_val = 5000;
-    for (size_t i = 0; i < size; i++)
-    {
-        if (buffer[i] < max_val)
-        {
-            max_val = buffer[i];
-        }
-    }
-    return max_val;
+    int16_t min_val, max_val;
+    dsp_min_max_q15(buffer, size, &min_val, &max_val);
+    return min_val;
 }
 
 //  ======== float_to_int16 ================================================================
@@ -118,116 +112,258 @@ int16_t float_to_int16(float val)
     return (int16_t)val;
 }
 
-// ========== NEW: LoRaWAN send thread ====================================================
+// ========== LoRaWAN event thread ========================================================
+// turn the detection events into uplinks, the uplink scheduler does the sending
 void app_lorawan_thread(void *arg1, void *arg2, void *arg3)
 {
     LOG_INF("LoRaWAN thread started");
 
     lta_event_t event;
-    int ret;
 
     while (1)
     {
         // block until a detection event is enqueued
         k_msgq_get(&lorawan_msgq, &event, K_FOREVER);
 
-        if (ANOMALY_SEND != 0)
+        if (ANOMALY_SEND != 0 && event.kind == LTA_EVENT_SUMMARY)
         {
             struct anomaly_payload_t payload;
             payload.max = event.max_ampl;
             payload.min = event.min_ampl;
             payload.mean = event.mean_ampl;
             payload.stalta = float_to_int16(event.ratio * 100);
-            lora_send_timestamp(ANOMALY, event.timestamp_ms, (uint8_t *)&payload, sizeof(struct anomaly_payload_t));
+            payload.event_id = event.event_id;
+            payload.time_us = (uint16_t)(event.timestamp_us % USEC_PER_MSEC);
+            payload.rate_ppm = event.rate_ppm;
+            payload.period_ms = event.period_ms;
+            payload.spectral = event.spectral;
+            uplink_enqueue(ANOMALY, event.timestamp_us / USEC_PER_MSEC, &payload, sizeof(payload), K_NO_WAIT);
         }
 
-        // If configuration is set ANOMALY_SEND_SAMPLES to 0, skip the part where we send samples,
-        if (ANOMALY_SEND_SAMPLES == 0)
+        if (event.kind != LTA_EVENT_WAVEFORM)
         {
             continue;
         }
 
-        int sent = 0;
-        int64_t elapsed_time = 0;
-        int16_t *p = send_buffer;
-
-        while (sent < STA_WINDOW_SIZE)
+        // the captured event stays in its slot until the uplink scheduler releases it,
+        // a newer event cannot overwrite it
+        struct event_slot *slot = event_capture_get(event.slot);
+        if (slot == NULL)
         {
-            size_t nb_to_send = STA_WINDOW_SIZE - sent;
-            // Ceil to MAX_SAMPLES
-            if (nb_to_send > MAX_SAMPLES)
-            {
-                nb_to_send = MAX_SAMPLES;
-            }
-            ret = lora_send_timestamp(SAMPLES, event.timestamp_ms + elapsed_time, (uint8_t *)p, nb_to_send * 2);
-            if (ret == 0)
-            {
-                p += nb_to_send;
-                sent += nb_to_send;
-                elapsed_time += nb_to_send * SAMPLING_RATE_MS;
-                k_sleep(K_MINUTES(1));
-            }
-            else
-            {
-                LOG_WRN("Could not send signal with anomaly, retrying in 30s");
-                k_msleep(30000);
-            }
+            continue;
         }
+
+        // STA window ending on the triggering sample
+        size_t size = (size_t)atomic_get(&sent_size);
+        uplink_enqueue_waveform(slot, slot->pre_samples + 1 - size, size);
+    }
+}
+
+//  ========== report_anomaly ==============================================================
+// summarize the STA window held in sta_buffer, hand it to the LoRaWAN thread and
+// start capturing the signal around the trigger sample
+static void report_anomaly(float ratio, uint32_t index, uint32_t head)
+{
+    last_anomaly_time = k_uptime_get();
+    // conversion time of the trigger sample, from the time tags of the acquisition
+    uint64_t timestamp;
+    if (app_adc_get_sample_time(index, &timestamp) != 0) {
+        // untagged, the trigger sample is older than the newest one by (head - 1 - index) samples
+        timestamp = (app_get_timestamp() - (uint64_t)(head - 1 - index) * app_adc_get_sampling_rate()) *
+                    USEC_PER_MSEC;
+    }
+    struct event_slot *slot = event_capture_start(index, timestamp);
+    int16_t max_amp = find_max_amplitude(sta_buffer, sta_size);
+    int16_t min_amp = find_min_amplitude(sta_buffer, sta_size);
+    // samples are relative to the baseline, report the absolute DC level as the mean
+    int16_t mean = app_adc_get_baseline() + (int16_t)calculate_avg(sta_buffer, sta_size);
+
+    lta_event_t l_evt = {
+        .kind = LTA_EVENT_SUMMARY,
+        .event_id = (slot != NULL) ? slot->id : 0,
+        .index = index,
+        .timestamp_us = timestamp,
+        .rate_ppm = (int16_t)CLAMP(app_adc_get_rate_ppm(), INT16_MIN, INT16_MAX),
+        .period_ms = (uint16_t)app_adc_get_sampling_rate(),
+        .max_ampl = max_amp,
+        .min_ampl = min_amp,
+        .mean_ampl = mean,
+        .ratio = ratio,
+    };
+
+    if (SPECTRAL_ENABLE != 0)
+    {
+        app_spectral_get_last(&l_evt.spectral);
+    }
+
+    if (k_msgq_put(&lorawan_msgq, &l_evt, K_NO_WAIT) != 0)
+    {
+        atomic_inc(&dropped_events);
+        LOG_ERR("warning: LoRaWAN queue full, event dropped");
+    }
+    else
+    {
+        health_queue_level(HEALTH_QUEUE_EVENTS, &lorawan_msgq);
     }
+
+    LOG_INF("event detected at sample %u (%llu us): max amplitude: %d, ratio: %.2f", index,
+            timestamp, max_amp, (double)ratio);
 }
 
+//  ========== load_config =================================================================
+// window sizes of a new configuration, false if it did not change
+static bool load_config(void)
+{
+    uint32_t generation = node_config_get(&config);
+
+    if (generation == config_generation) {
+        return false;
+    }
+    config_generation = generation;
+    sta_size = config.sta_window_ms / config.sampling_rate_ms;
+    lta_size = config.lta_window_ms / config.sampling_rate_ms;
+    atomic_set(&sent_size, (atomic_val_t)sta_size);
+    LOG_INF("detection windows: STA %u, LTA %u samples", (unsigned int)sta_size,
+            (unsigned int)lta_size);
+    return true;
+}
+
+#if STA_LTA_MODE == STA_LTA_MODE_WINDOWED
 //  ========== app_lta_thread ==============================================================
+// legacy detector: both windows are copied and recomputed on every wake-up
 void app_sta_lta_thread(void *arg1, void *arg2, void *arg3)
 {
-    LOG_INF("STA/LTA thread started");
-    // threshold above which we consider an event detected
-    const float DETECTION_RATIO = 3.f;
+    LOG_INF("STA/LTA thread started (windowed)");
 
     last_anomaly_time = k_uptime_get() + 100000;
     while (1)
     {
         k_sem_take(&data_ready_sem, K_FOREVER);
+        power_stats_wakeup(POWER_WAKEUP_DETECT);
+        load_config();
 
-        app_adc_get_buffer(sta_buffer, STA_WINDOW_SIZE, -STA_WINDOW_SIZE);
-        app_adc_get_buffer(lta_buffer, LTA_WINDOW_SIZE, -LTA_WINDOW_SIZE);
+        // skip until the ring holds a full LTA window
+        if (app_adc_get_buffer(lta_buffer, lta_size, -(int32_t)lta_size) != 0)
+        {
+            continue;
+        }
+        memcpy(sta_buffer, &lta_buffer[lta_size - sta_size], sta_size * sizeof(sta_buffer[0]));
 
-        float sta = calculate_squared_avg(sta_buffer, STA_WINDOW_SIZE);
-        float lta = calculate_squared_avg(lta_buffer, LTA_WINDOW_SIZE);
+        float sta = calculate_squared_avg(sta_buffer, sta_size);
+        float lta = calculate_squared_avg(lta_buffer, lta_size);
         float ratio = (lta > 0.0f) ? (sta / lta) : 0.0f; // guard divide-by-zero
 
-        if (k_uptime_get() - last_anomaly_time < MINIMAL_DELAY_ANOMALY_MS)
+        uint32_t head = app_adc_get_head();
+        event_capture_poll(head);
+
+        if (k_uptime_get() - last_anomaly_time < config.anomaly_delay_ms)
         {
-            // printk("Detected anomaly %lld ms ago, skipping\n", k_uptime_get() - last_anomaly_time);
             continue;
         }
         // only send LoRaWAN when a seismic event is detected
-        if (ratio >= DETECTION_RATIO)
+        if (ratio >= config.ratio_on / 100.f)
+        {
+            report_anomaly(ratio, head - 1, head);
+        }
+    }
+}
+#else
+//  ========== init_detectors ==============================================================
+// from the configuration in effect, every detector starts over
+static void init_detectors(void)
+{
+    size_t n = 0;
+
+    detector_init_sta_lta(&detectors[n++], STA_LTA_MODE, lta_buffer, sta_size, lta_size,
+                          config.ratio_on / 100.f, config.ratio_off / 100.f);
+    if (config.detectors & PARAM_DETECTOR_ER)
+    {
+        detector_init_energy_ratio(&detectors[n++], er_history, sta_size, ER_ON, ER_OFF);
+    }
+    if (config.detectors & PARAM_DETECTOR_MER)
+    {
+        detector_init_mer(&detectors[n++], mer_history, sta_size, MER_ON, MER_OFF);
+    }
+    if (config.detectors & PARAM_DETECTOR_THRESHOLD)
+    {
+        detector_init_threshold(&detectors[n++], THRESHOLD_ON_MV, THRESHOLD_OFF_MV);
+    }
+
+    // the other detectors use the STA window, and keep voting for this long after they
+    // turned off. config_check() refused any other number of votes before it applied
+    int rc = detector_bank_init(&bank, detectors, n, config.votes, sta_size);
+
+    __ASSERT(rc == 0, "invalid voting: %u of %zu detectors", config.votes, n);
+    ARG_UNUSED(rc);
+}
+
+//  ========== app_lta_thread ==============================================================
+// streaming detectors: every new sample updates each detector in O(1)
+void app_sta_lta_thread(void *arg1, void *arg2, void *arg3)
+{
+    LOG_INF("STA/LTA thread started (mode %d)", STA_LTA_MODE);
+
+    int16_t chunk[STA_LTA_CHUNK_SIZE];
+    uint32_t next = app_adc_get_head();
+
+    load_config();
+    init_detectors();
+
+    last_anomaly_time = k_uptime_get() + 100000;
+    while (1)
+    {
+        k_sem_take(&data_ready_sem, K_FOREVER);
+        power_stats_wakeup(POWER_WAKEUP_DETECT);
+
+        // a new configuration from a downlink, the windows fill again from the next sample
+        if (load_config())
+        {
+            init_detectors();
+        }
+
+        int64_t now = k_uptime_get();
+        uint32_t head = app_adc_get_head();
+        if (head - next > ADC_BUFFER_SIZE)
+        {
+            // fell behind the ring, the windows restart from the oldest sample still there
+            LOG_WRN("detector lost %u samples", head - next - ADC_BUFFER_SIZE);
+            atomic_add(&lost_samples, head - next - ADC_BUFFER_SIZE);
+            next = head - ADC_BUFFER_SIZE;
+        }
+
+        while (next != head)
         {
-            last_anomaly_time = k_uptime_get();
-            uint64_t timestamp = app_get_timestamp();
-            uint16_t max_amp = find_max_amplitude(sta_buffer, STA_WINDOW_SIZE);
-            uint16_t min_amp = find_min_amplitude(sta_buffer, STA_WINDOW_SIZE);
-            uint16_t mean = (uint16_t)calculate_avg(sta_buffer, STA_WINDOW_SIZE);
-
-            lta_event_t l_evt = {
-                .timestamp_ms = timestamp,
-                .max_ampl = max_amp,
-                .min_ampl = min_amp,
-                .mean_ampl = mean,
-                .ratio = ratio,
-            };
-
-            memcpy(send_buffer, sta_buffer, STA_WINDOW_SIZE * 2);
-
-            if (k_msgq_put(&lorawan_msgq, &l_evt, K_NO_WAIT) != 0)
+            size_t count = MIN(head - next, STA_LTA_CHUNK_SIZE);
+            if (app_adc_read(chunk, count, next) != 0)
             {
-                LOG_ERR("warning: LoRaWAN queue full, event dropped");
+                next = app_adc_get_head();
+                break;
             }
 
-            LOG_INF("event detected: max amplitude: %u, ratio: %.2f", max_amp, (double)ratio);
+            for (size_t i = 0; i < count; i++)
+            {
+                bool triggered = detector_bank_update(&bank, chunk[i]);
+                uint32_t index = next + i;
+
+                if (!triggered || now - (int64_t)last_anomaly_time < config.anomaly_delay_ms)
+                {
+                    continue;
+                }
+                float ratio = detectors[0].value;
+                // STA window ending on the triggering sample
+                if (app_adc_read(sta_buffer, sta_size, index + 1 - sta_size) == 0)
+                {
+                    report_anomaly(ratio, index, head);
+                }
+            }
+            next += count;
         }
+        // from the newest block being published to the detectors being up to date
+        health_detect_latency(k_cyc_to_us_floor32(k_cycle_get_32() - app_adc_get_push_cycles()));
+        event_capture_poll(head);
     }
 }
+#endif
 
 // ========== app_sta_lta_start ===========================================================
 void app_sta_lta_start_tx(void)
@@ -237,10 +373,24 @@ void app_sta_lta_start_tx(void)
                     K_THREAD_STACK_SIZEOF(sta_lta_stack),
                     app_sta_lta_thread, NULL, NULL, NULL,
                     PRIORITY_LTA, 0, K_NO_WAIT);
+    health_register_thread(HEALTH_THREAD_DETECT, &sta_lta_thread_data);
 
     // LoRaWAN sender thread (lower priority — network I/O can wait)
     k_thread_create(&lorawan_thread_data, lorawan_stack,
                     K_THREAD_STACK_SIZEOF(lorawan_stack),
                     app_lorawan_thread, NULL, NULL, NULL,
                     PRIORITY_TTN + 1, 0, K_NO_WAIT);
-}
\ No newline at end of file
+    health_register_thread(HEALTH_THREAD_EVENTS, &lorawan_thread_data);
+}
+
+//  ========== app_sta_lta_get_dropped =====================================================
+uint32_t app_sta_lta_get_dropped(void)
+{
+    return (uint32_t)atomic_get(&dropped_events);
+}
+
+//  ========== app_sta_lta_get_lost ========================================================
+uint32_t app_sta_lta_get_lost(void)
+{
+    return (uint32_t)atomic_get(&lost_samples);
+}
@@ -10,6 +10,7 @@
 
 //  ========== includes ====================================================================
 #include "app_adc.h"
+#include "data_types.h"
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
@@ -19,28 +20,68 @@
 #include <zephyr/sys/ring_buffer.h>
 
 //  ========== defines =====================================================================
-// STA and LTA window durations in milliseconds
-#define STA_WINDOW_DURATION_MS      1024     // 1 seconds
-#define LTA_WINDOW_DURATION_MS      16384    // 10 seconds
+// detection parameters, shared with the host replay tool
+#include "detection_params.h"
 
-// Minimal time between two anomalies
-#define MINIMAL_DELAY_ANOMALY_MS 10000
+// number of samples copied from the ADC ring at once by the streaming detector,
+// a whole block is processed in one pass
+#define STA_LTA_CHUNK_SIZE          MAX(64, ADC_BLOCK_SIZE)
 
-// ADC buffer size in bytes
-#define ADC_BUFFER_SIZE             (LTA_WINDOW_SIZE * 2) 
+// ADC ring size in samples, power of two holding at least two LTA windows
+#define ADC_BUFFER_SIZE             4096
 
-// derived buffer sizes
+// derived window sizes at boot, the buffers take up to PARAM_STA_MAX_SAMPLES and
+// PARAM_LTA_MAX_SAMPLES for the sizes set by a downlink (see config_codec.h)
 #define STA_WINDOW_SIZE (STA_WINDOW_DURATION_MS / SAMPLING_RATE_MS)
 #define LTA_WINDOW_SIZE (LTA_WINDOW_DURATION_MS / SAMPLING_RATE_MS)
 
+//  ========== types =======================================================================
+// kind of message passed to the LoRaWAN sender
+enum lta_event_kind {
+    LTA_EVENT_SUMMARY = 0,      // anomaly summary, sent as soon as the trigger fires
+    LTA_EVENT_WAVEFORM,         // captured event samples, see event_capture.h
+};
+
+// message structure to pass detection results to LoRaWAN sender
+typedef struct
+{
+    uint8_t kind;
+    uint8_t slot;               // event slot of a LTA_EVENT_WAVEFORM
+    uint16_t event_id;
+    uint32_t index;             // absolute ADC sample index of the trigger
+    uint64_t timestamp_us;      // time of the trigger sample
+    int16_t rate_ppm;           // sampling period deviation, see app_adc_get_rate_ppm()
+    uint16_t period_ms;         // nominal sampling period, see app_adc_get_sampling_rate()
+    int16_t max_ampl;
+    int16_t min_ampl;
+    int16_t mean_ampl;
+    float ratio;
+    struct spectral_payload_t spectral;
+} lta_event_t;
+
+// message structure for event storage
+typedef struct
+{
+    uint8_t slot;               // captured event slot to write to the flash
+} storage_event_t;
+
+extern struct k_msgq lorawan_msgq;
+extern struct k_msgq storage_msgq;
+
 //  ========== prototypes ==================================================================
 void app_lta_thread(void *arg1, void *arg2, void *arg3);
 void app_sta_lta_start_tx(void);
 
+// events dropped because lorawan_msgq was full
+uint32_t app_sta_lta_get_dropped(void);
+// samples the streaming detector skipped after falling behind the ADC ring
+uint32_t app_sta_lta_get_lost(void);
+
 //  ========== defines =====================================================================
 // priority of the different threads involved
 #define PRIORITY_ADC                2
-#define PRIORITY_STORAGE            3
+#define PRIORITY_STORAGE            5   // below the detector, flash writes must not delay it
 #define PRIORITY_LTA                4
+#define PRIORITY_SPECTRAL           6   // lowest, FFT frames can wait
 
 #endif /* APP_STA_LTA_TX_H */
\ No newline at end of file
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2025
+ * Hugo Reymond, Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "app_storage.h"
+#include "app_adc.h"
+#include "app_sta_lta_tx.h"
+#include "app_ds3231.h"
+#include "wave_codec.h"
+#include "wave_index.h"
+#include "event_capture.h"
+#include "health.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(storage);
+
+//  ========== globals =====================================================================
+K_THREAD_STACK_DEFINE(storage_stack, 2048);
+struct k_thread storage_thread_data;
+
+// the only RAM used by the recorder: one frame of samples and a staging buffer holding
+// a flash sector plus the largest frame that can overflow it
+static int16_t frame[STORAGE_FRAME_SAMPLES];
+#if STORAGE_COMPRESS_ENABLE
+static uint8_t staging[STORAGE_BUFFER_SIZE + WAVE_CODEC_MAX_FRAME(STORAGE_FRAME_SAMPLES)] __aligned(4);
+#else
+static uint8_t staging[STORAGE_BUFFER_SIZE + sizeof(frame)] __aligned(4);
+#endif
+
+// one encoded frame of a captured event, written straight from the event slot
+static uint8_t event_frame[WAVE_CODEC_MAX_FRAME(STORAGE_FRAME_SAMPLES)] __aligned(4);
+
+// state of the file being recorded
+struct recorder {
+    struct fs_file_t file;
+    bool opened;
+    size_t file_size;
+    size_t fill;            // bytes waiting in staging
+    int unsynced;           // sectors written since the last fs_sync()
+    uint64_t last_ms;       // start of the last block, a file never goes back in time
+};
+
+// range of file numbers present on the partition, [oldest_file, next_file)
+static uint32_t oldest_file;
+static uint32_t next_file;
+
+// samples dropped because the recorder fell behind the ADC ring
+static atomic_t lost_samples = ATOMIC_INIT(0);
+
+//  ========== file_path ===================================================================
+static void file_path(char *path, size_t size, uint32_t number)
+{
+    snprintf(path, size, "%s_%03u%s", FILE_PREFIX, number, FILE_EXT);
+}
+
+//  ========== scan_files ==================================================================
+// find the oldest and newest geophone files left by a previous run
+static void scan_files(void)
+{
+    struct fs_dir_t dir;
+    struct fs_dirent entry;
+    const char *prefix = FILE_PREFIX + sizeof(LFS_MOUNT_POINT);   // "geophone"
+    size_t prefix_len = strlen(prefix);
+    bool found = false;
+
+    oldest_file = 0;
+    next_file = 0;
+
+    fs_dir_t_init(&dir);
+    if (fs_opendir(&dir, LFS_MOUNT_POINT) < 0) {
+        return;
+    }
+
+    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+        if (strncmp(entry.name, prefix, prefix_len) != 0 || entry.name[prefix_len] != '_') {
+            continue;
+        }
+        uint32_t number = strtoul(&entry.name[prefix_len + 1], NULL, 10);
+        if (!found || number < oldest_file) {
+            oldest_file = number;
+        }
+        if (!found || number >= next_file) {
+            next_file = number + 1;
+        }
+        found = true;
+    }
+    fs_closedir(&dir);
+
+    wave_index_set_files(oldest_file, next_file);
+    LOG_INF("recorder found files %u to %u", oldest_file, next_file);
+}
+
+//  ========== event_path ==================================================================
+static void event_path(char *path, size_t size, uint16_t id)
+{
+    snprintf(path, size, "%s_%05u%s", EVENT_FILE_PREFIX, id, FILE_EXT);
+}
+
+//  ========== scan_events =================================================================
+// continue the event numbering after the newest event file left by a previous run
+static void scan_events(void)
+{
+    struct fs_dir_t dir;
+    struct fs_dirent entry;
+    const char *prefix = EVENT_FILE_PREFIX + sizeof(LFS_MOUNT_POINT);   // "event"
+    size_t prefix_len = strlen(prefix);
+    uint32_t next_id = 0;
+
+    fs_dir_t_init(&dir);
+    if (fs_opendir(&dir, LFS_MOUNT_POINT) < 0) {
+        return;
+    }
+
+    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+        if (strncmp(entry.name, prefix, prefix_len) != 0 || entry.name[prefix_len] != '_') {
+            continue;
+        }
+        uint32_t id = strtoul(&entry.name[prefix_len + 1], NULL, 10);
+        if (id >= next_id) {
+            next_id = id + 1;
+        }
+    }
+    fs_closedir(&dir);
+
+    event_capture_set_next_id((uint16_t)next_id);
+    LOG_INF("next event id: %u", (uint16_t)next_id);
+}
+
+//  ========== store_event =================================================================
+// write a captured event to its own file, as compressed frames, and delete the event
+// file that falls out of the EVENT_FILES_KEPT most recent ones
+static void store_event(struct event_slot *slot)
+{
+    struct fs_file_t file;
+    char path[32];
+    int rc;
+
+    event_path(path, sizeof(path), (uint16_t)(slot->id - EVENT_FILES_KEPT));
+    rc = fs_unlink(path);
+    if (rc < 0 && rc != -ENOENT) {
+        LOG_ERR("could not delete %s. error: %d", path, rc);
+    }
+
+    event_path(path, sizeof(path), slot->id);
+    fs_file_t_init(&file);
+    rc = fs_open(&file, path, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (rc < 0) {
+        LOG_ERR("could not open %s. error: %d", path, rc);
+        return;
+    }
+
+    size_t samples = slot->pre_samples + slot->post_samples;
+
+    for (size_t i = 0; i < samples; i += STORAGE_FRAME_SAMPLES) {
+        size_t count = MIN(samples - i, STORAGE_FRAME_SAMPLES);
+#if STORAGE_COMPRESS_ENABLE
+        // first sample of the frame, at the measured sampling period from the trigger
+        int64_t offset_ns = ((int64_t)i - slot->pre_samples) * slot->period_ns;
+        uint64_t timestamp = (uint64_t)((int64_t)slot->timestamp_us + offset_ns / NSEC_PER_USEC) /
+                             USEC_PER_MSEC;
+        size_t size = wave_codec_encode(&slot->samples[i], count, timestamp, event_frame);
+        ssize_t written = fs_write(&file, event_frame, size);
+#else
+        size_t size = count * sizeof(int16_t);
+        ssize_t written = fs_write(&file, &slot->samples[i], size);
+#endif
+        if (written != (ssize_t)size) {
+            LOG_ERR("%s write failed. error: %d", path, (int)written);
+            break;
+        }
+    }
+
+    rc = fs_close(&file);
+    if (rc < 0) {
+        LOG_ERR("%s close failed. error: %d", path, rc);
+        return;
+    }
+    LOG_INF("event %u stored to %s", slot->id, path);
+}
+
+//  ========== evict_files =================================================================
+// delete the oldest files until STORAGE_MIN_FREE bytes are available
+static void evict_files(void)
+{
+    struct fs_statvfs stat;
+    char path[32];
+
+    while (oldest_file + 1 < next_file) {
+        if (fs_statvfs(LFS_MOUNT_POINT, &stat) < 0) {
+            return;
+        }
+        if ((uint64_t)stat.f_bfree * stat.f_frsize >= STORAGE_MIN_FREE) {
+            return;
+        }
+
+        file_path(path, sizeof(path), oldest_file);
+        int rc = fs_unlink(path);
+        if (rc < 0 && rc != -ENOENT) {
+            LOG_ERR("could not delete %s. error: %d", path, rc);
+            return;
+        }
+        wave_index_remove(oldest_file);
+        LOG_INF("partition full, deleted %s", path);
+        oldest_file++;
+        wave_index_set_files(oldest_file, next_file);
+    }
+}
+
+//  ========== open_next_file ==============================================================
+static int open_next_file(struct fs_file_t *file)
+{
+    char path[32];
+
+    evict_files();
+
+    file_path(path, sizeof(path), next_file);
+    fs_file_t_init(file);
+    int rc = fs_open(file, path, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (rc < 0) {
+        LOG_ERR("could not open %s. error: %d", path, rc);
+        return rc;
+    }
+    // without its index, the file is only found by a full dump
+    wave_index_begin(next_file);
+    next_file++;
+    wave_index_set_files(oldest_file, next_file);
+    LOG_INF("recording to %s", path);
+    return 0;
+}
+
+//  ========== close_file ==================================================================
+static void close_file(struct recorder *rec)
+{
+    // fs_close() also syncs the file
+    int rc = fs_close(&rec->file);
+    if (rc < 0) {
+        LOG_ERR("file close failed. error: %d", rc);
+    }
+    wave_index_end();
+    rec->opened = false;
+}
+
+//  ========== start_file ==================================================================
+static int start_file(struct recorder *rec)
+{
+    if (rec->opened) {
+        return 0;
+    }
+    int rc = open_next_file(&rec->file);
+    if (rc < 0) {
+        return rc;
+    }
+    rec->opened = true;
+    rec->file_size = 0;
+    rec->unsynced = 0;
+    return 0;
+}
+
+//  ========== flush_staging ===============================================================
+// write `size` bytes from the staging buffer, opening a new file when needed
+static int flush_staging(struct recorder *rec, size_t size)
+{
+    int rc = start_file(rec);
+    if (rc < 0) {
+        return rc;
+    }
+
+    ssize_t written = fs_write(&rec->file, staging, size);
+    if (written != (ssize_t)size) {
+        LOG_ERR("write failed. error: %d", (int)written);
+        // the blocks waiting in the index may be in the lost sector
+        wave_index_discard();
+        close_file(rec);
+        return -EIO;
+    }
+    rec->file_size += written;
+    rec->fill -= size;
+    memmove(staging, &staging[size], rec->fill);
+
+    if (++rec->unsynced >= STORAGE_SYNC_BLOCKS) {
+        // the index is synced after the data, a reset can only leave it ahead of the data
+        fs_sync(&rec->file);
+        wave_index_sync();
+        rec->unsynced = 0;
+    }
+    return 0;
+}
+
+//  ========== end_file ====================================================================
+// write what is left in the staging buffer and close the current file
+static void end_file(struct recorder *rec)
+{
+    if (rec->fill > 0 && flush_staging(rec, rec->fill) < 0) {
+        rec->fill = 0;
+    }
+    if (rec->opened) {
+        close_file(rec);
+    }
+}
+
+//  ========== append_frame ================================================================
+// add one frame of samples to the staging buffer, writing full sectors as they fill
+static void append_frame(struct recorder *rec, uint64_t timestamp_ms)
+{
+    // the time went back (clock set): a new file keeps the blocks of each file in order
+    if (rec->opened && timestamp_ms < rec->last_ms) {
+        LOG_WRN("time went back %llu ms, new file", rec->last_ms - timestamp_ms);
+        end_file(rec);
+    }
+    // the file, and its index, are opened with its first frame
+    if (start_file(rec) == 0) {
+        wave_index_add(rec->file_size + rec->fill, timestamp_ms, STORAGE_FRAME_SAMPLES,
+                       (uint16_t)app_adc_get_sampling_rate());
+    }
+    rec->last_ms = timestamp_ms;
+
+#if STORAGE_COMPRESS_ENABLE
+    rec->fill += wave_codec_encode(frame, STORAGE_FRAME_SAMPLES, timestamp_ms, &staging[rec->fill]);
+#else
+    memcpy(&staging[rec->fill], frame, sizeof(frame));
+    rec->fill += sizeof(frame);
+#endif
+
+    while (rec->fill >= STORAGE_BUFFER_SIZE) {
+        if (flush_staging(rec, STORAGE_BUFFER_SIZE) < 0) {
+            // drop the sector rather than stalling the recorder
+            rec->fill -= STORAGE_BUFFER_SIZE;
+            memmove(staging, &staging[STORAGE_BUFFER_SIZE], rec->fill);
+        }
+    }
+
+    if (rec->opened && rec->file_size + rec->fill >= MAX_FILE_SIZE) {
+        end_file(rec);
+    }
+}
+
+//  ========== app_storage_thread ==========================================================
+static void app_storage_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct recorder rec = { .opened = false, .fill = 0 };
+
+    if (!is_lfs_mounted() && mount_lfs() < 0) {
+        LOG_ERR("could not mount %s, recorder stopped", LFS_MOUNT_POINT);
+        return;
+    }
+    scan_files();
+    scan_events();
+
+    uint32_t next = app_adc_get_head();
+
+    while (1) {
+        uint32_t head = app_adc_get_head();
+        uint32_t available = head - next;
+
+        if (available > ADC_BUFFER_SIZE - ADC_BLOCK_SIZE) {
+            // the ring overran us: restart on a new file so each file stays continuous
+            uint32_t resume = head - (ADC_BUFFER_SIZE - ADC_BLOCK_SIZE);
+            atomic_add(&lost_samples, resume - next);
+            LOG_WRN("recorder lost %u samples", resume - next);
+            next = resume;
+            end_file(&rec);
+            continue;
+        }
+
+        if (available < STORAGE_FRAME_SAMPLES) {
+            // wait until a full frame is expected, storing the captured events meanwhile
+            storage_event_t event;
+            k_timeout_t timeout = K_MSEC((STORAGE_FRAME_SAMPLES - available) * app_adc_get_sampling_rate());
+
+            if (k_msgq_get(&storage_msgq, &event, timeout) == 0) {
+                struct event_slot *slot = event_capture_get(event.slot);
+                if (slot != NULL) {
+                    store_event(slot);
+                    event_capture_release(slot);
+                }
+            }
+            continue;
+        }
+
+        if (app_adc_read(frame, STORAGE_FRAME_SAMPLES, next) != 0) {
+            continue;
+        }
+        uint64_t timestamp;
+        if (app_adc_get_sample_time(next, &timestamp) == 0) {
+            timestamp /= USEC_PER_MSEC;
+        } else {
+            timestamp = app_get_timestamp() - (uint64_t)available * app_adc_get_sampling_rate();
+        }
+        next += STORAGE_FRAME_SAMPLES;
+
+        append_frame(&rec, timestamp);
+    }
+}
+
+//  ========== app_storage_start ===========================================================
+void app_storage_start(void)
+{
+    k_thread_create(&storage_thread_data, storage_stack,
+                    K_THREAD_STACK_SIZEOF(storage_stack),
+                    app_storage_thread, NULL, NULL, NULL,
+                    PRIORITY_STORAGE, 0, K_NO_WAIT);
+    health_register_thread(HEALTH_THREAD_STORAGE, &storage_thread_data);
+}
+
+//  ========== app_storage_get_lost ========================================================
+uint32_t app_storage_get_lost(void)
+{
+    return (uint32_t)atomic_get(&lost_samples);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2025
+ * Hugo Reymond, Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_STORAGE_H
+#define APP_STORAGE_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#include "fs_utils.h"
+
+//  ========== defines =====================================================================
+// number of samples taken from the ADC ring at once, one compressed frame each
+#define STORAGE_FRAME_SAMPLES   512
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start the recorder thread
+ *
+ * The thread mounts /lfs if needed, then drains the ADC ring into rotating
+ * geophone_NNN.dat files, one STORAGE_BUFFER_SIZE write at a time. Samples are
+ * stored as raw int16 or as compressed frames (see wave_codec.h), depending on
+ * STORAGE_COMPRESS_ENABLE. When the partition is nearly full, the oldest files
+ * are deleted. Each file has a time index of its frames, see wave_index.h.
+ *
+ * Events captured by event_capture.c are also written, one event_NNNNN.dat file
+ * each, in the same format. Only the last EVENT_FILES_KEPT events are kept.
+ */
+void app_storage_start(void);
+
+/**
+ * @brief number of samples that could not be recorded because the ring overran
+ */
+uint32_t app_storage_get_lost(void);
+
+#endif /* APP_STORAGE_H */
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "bulk_dump.h"
+#include "fs_utils.h"
+#include "wave_index.h"
+
+#include <zephyr/sys/crc.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(CONFIG_USE_SEGGER_RTT)
+#include <SEGGER_RTT.h>
+#endif
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(bulk_dump);
+
+//  ========== globals =====================================================================
+struct bulk_header {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t length;
+} __packed;
+
+BUILD_ASSERT(sizeof(struct bulk_header) + sizeof(uint32_t) + BULK_CHUNK_SIZE + sizeof(uint32_t) <
+             BULK_RTT_BUFFER_SIZE, "a frame must fit in the RTT buffer");
+
+#if defined(CONFIG_USE_SEGGER_RTT)
+static uint8_t rtt_buffer[BULK_RTT_BUFFER_SIZE];
+static bool channel_ready;
+#endif
+
+// frame being sent, only used by the console thread. The file data is read in place.
+#define FRAME_DATA_OFFSET   (sizeof(struct bulk_header) + sizeof(uint32_t))
+static uint8_t frame[FRAME_DATA_OFFSET + BULK_CHUNK_SIZE + sizeof(uint32_t)] __aligned(4);
+
+//  ========== channel_write ===============================================================
+#if defined(CONFIG_USE_SEGGER_RTT)
+// wait until the debugger made room for `size` bytes, then write them without blocking
+static int channel_write(const void *data, size_t size)
+{
+    int64_t deadline = k_uptime_get() + BULK_STALL_MS;
+
+    while (SEGGER_RTT_GetAvailWriteSpace(BULK_RTT_CHANNEL) < size) {
+        if (k_uptime_get() > deadline) {
+            return -ETIMEDOUT;
+        }
+        // the debugger polls the channel, a tick is enough to let it drain
+        k_sleep(K_TICKS(1));
+    }
+    SEGGER_RTT_Write(BULK_RTT_CHANNEL, data, size);
+    return 0;
+}
+
+static int channel_open(void)
+{
+    if (!channel_ready) {
+        int rc = SEGGER_RTT_ConfigUpBuffer(BULK_RTT_CHANNEL, "bulk", rtt_buffer, sizeof(rtt_buffer),
+                                           SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+        if (rc < 0) {
+            LOG_ERR("no RTT up-buffer %d. error: %d", BULK_RTT_CHANNEL, rc);
+            return -ENODEV;
+        }
+        channel_ready = true;
+    }
+    return 0;
+}
+#else
+static int channel_write(const void *data, size_t size)
+{
+    return -ENOTSUP;
+}
+
+static int channel_open(void)
+{
+    LOG_ERR("the bulk transfer needs RTT");
+    return -ENOTSUP;
+}
+#endif
+
+//  ========== send_frame ==================================================================
+// one frame whose body is `head` then `data`, written at once when the channel has room.
+// `data` may already be in place in frame[].
+static int send_frame(enum bulk_frame_type type, const void *head, size_t head_size,
+                      const void *data, size_t data_size)
+{
+    struct bulk_header header = {
+        .magic = BULK_MAGIC,
+        .type = type,
+        .reserved = 0,
+        .length = (uint16_t)(head_size + data_size),
+    };
+    size_t size = 0;
+
+    memcpy(&frame[size], &header, sizeof(header));
+    size += sizeof(header);
+    memcpy(&frame[size], head, head_size);
+    size += head_size;
+    if (data_size > 0) {
+        memmove(&frame[size], data, data_size);
+        size += data_size;
+    }
+
+    uint32_t crc = crc32_ieee(frame, size);
+    memcpy(&frame[size], &crc, sizeof(crc));
+    size += sizeof(crc);
+
+    return channel_write(frame, size);
+}
+
+static int send_end(int status, uint32_t sent)
+{
+    int32_t body[2] = { status, (int32_t)sent };
+
+    return send_frame(BULK_END, body, sizeof(body), NULL, 0);
+}
+
+//  ========== bulk_dump_list ==============================================================
+int bulk_dump_list(void)
+{
+    struct fs_dir_t dir;
+    struct fs_dirent entry;
+    uint32_t count = 0;
+
+    int rc = channel_open();
+    if (rc < 0) {
+        return rc;
+    }
+    if (!is_lfs_mounted() && (rc = mount_lfs()) < 0) {
+        return send_end(rc, 0);
+    }
+
+    fs_dir_t_init(&dir);
+    rc = fs_opendir(&dir, LFS_MOUNT_POINT);
+    if (rc < 0) {
+        return send_end(rc, 0);
+    }
+    while ((rc = fs_readdir(&dir, &entry)) == 0 && entry.name[0] != 0) {
+        if (entry.type != FS_DIR_ENTRY_FILE) {
+            continue;
+        }
+        uint32_t size = entry.size;
+        rc = send_frame(BULK_FILE, &size, sizeof(size), entry.name, strlen(entry.name));
+        if (rc < 0) {
+            break;
+        }
+        count++;
+    }
+    fs_closedir(&dir);
+
+    return send_end(rc, count);
+}
+
+//  ========== bulk_dump_get ===============================================================
+int bulk_dump_get(const char *name, uint32_t offset, uint32_t length)
+{
+    struct fs_file_t file;
+    char path[MAX_FILE_NAME + sizeof(LFS_MOUNT_POINT) + 1];
+    uint32_t sent = 0;
+
+    int rc = channel_open();
+    if (rc < 0) {
+        return rc;
+    }
+    if (name[0] == '\0' || strchr(name, '/') != NULL) {
+        return send_end(-EINVAL, 0);
+    }
+    if (!is_lfs_mounted() && (rc = mount_lfs()) < 0) {
+        return send_end(rc, 0);
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", LFS_MOUNT_POINT, name);
+    fs_file_t_init(&file);
+    rc = fs_open(&file, path, FS_O_READ);
+    if (rc < 0) {
+        return send_end(rc, 0);
+    }
+    rc = fs_seek(&file, offset, FS_SEEK_SET);
+
+    int64_t start = k_uptime_get();
+    while (rc == 0 && sent < length) {
+        uint8_t *data = &frame[FRAME_DATA_OFFSET];
+        ssize_t got = fs_read(&file, data, MIN(BULK_CHUNK_SIZE, length - sent));
+        if (got <= 0) {
+            rc = (int)got;
+            break;
+        }
+        uint32_t data_offset = offset + sent;
+        rc = send_frame(BULK_DATA, &data_offset, sizeof(data_offset), data, got);
+        sent += got;
+    }
+    fs_close(&file);
+
+    LOG_DBG("%s: %u bytes from %u in %lld ms", path, sent, offset, k_uptime_get() - start);
+    return send_end(rc, sent);
+}
+
+//  ========== bulk_dump_find ==============================================================
+struct range_frame {
+    uint32_t offset;
+    uint32_t size;
+    uint64_t start_ms;
+    uint64_t end_ms;
+} __packed;
+
+static int send_range(const struct wave_index_range *range, void *user)
+{
+    struct range_frame body = {
+        .offset = range->offset,
+        .size = range->size,
+        .start_ms = range->start_ms,
+        .end_ms = range->end_ms,
+    };
+    char name[MAX_FILE_NAME + 1];
+
+    // name of the data file, as listed by bulk_dump_list()
+    snprintf(name, sizeof(name), "%s_%03u%s", FILE_PREFIX + sizeof(LFS_MOUNT_POINT),
+             range->file, FILE_EXT);
+    int rc = send_frame(BULK_RANGE, &body, sizeof(body), name, strlen(name));
+    if (rc < 0) {
+        *(int *)user = rc;
+    }
+    return rc;
+}
+
+int bulk_dump_find(uint64_t from_ms, uint64_t to_ms)
+{
+    int status = 0;
+
+    int rc = channel_open();
+    if (rc < 0) {
+        return rc;
+    }
+    if (!is_lfs_mounted() && (rc = mount_lfs()) < 0) {
+        return send_end(rc, 0);
+    }
+
+    rc = wave_index_query(from_ms, to_ms, send_range, &status);
+    if (rc < 0) {
+        return send_end(rc, 0);
+    }
+    return send_end(status, rc);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BULK_DUMP_H
+#define BULK_DUMP_H
+
+/*
+ * Binary transfer of the /lfs files over a dedicated RTT up-channel, for
+ * download_data.py. The legacy dump_fs() sends 100 bytes per base64 line with a fixed
+ * sleep after each one; here the file is streamed as large frames, as fast as the
+ * debugger empties the channel.
+ *
+ * Frame, little-endian:
+ *   u16 magic (BULK_MAGIC), u8 type, u8 reserved (0), u16 body length, body,
+ *   u32 CRC-32 (IEEE) of the header and the body
+ * Bodies:
+ *   BULK_FILE  u32 file size, file name (no terminator), one per file for "bulk list"
+ *   BULK_DATA  u32 offset in the file, data
+ *   BULK_RANGE u32 offset, u32 size, u64 first sample (unix ms), u64 end of the last
+ *              block (unix ms), file name, one per range of a file for "bulk find"
+ *   BULK_END   i32 status (0 or a negative error code), u32 data bytes sent or number
+ *              of files or ranges, closes every request
+ *
+ * The host asks for any byte range of a file, so an interrupted or corrupted transfer
+ * resumes from the first byte it is missing.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+#define BULK_RTT_CHANNEL            1
+#define BULK_RTT_BUFFER_SIZE        8192
+
+// file data per BULK_DATA frame, a frame must fit in the RTT buffer
+#define BULK_CHUNK_SIZE             2048
+
+// a transfer is abandoned when the debugger stops reading the channel for this long
+#define BULK_STALL_MS               5000
+
+#define BULK_MAGIC                  0x4253  // "SB"
+
+//  ========== types =======================================================================
+enum bulk_frame_type {
+    BULK_FILE = 1,
+    BULK_DATA = 2,
+    BULK_END = 3,
+    BULK_RANGE = 4,
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief send a BULK_FILE frame per file of /lfs, then BULK_END
+ */
+int bulk_dump_list(void);
+
+/**
+ * @brief send `length` bytes of /lfs/`name` from `offset` as BULK_DATA frames, then BULK_END
+ *
+ * The range is clipped to the end of the file, UINT32_MAX reads to the end.
+ */
+int bulk_dump_get(const char *name, uint32_t offset, uint32_t length);
+
+/**
+ * @brief send a BULK_RANGE frame per range of the geophone files recorded in
+ * [from_ms, to_ms), from the time index (see wave_index.h), then BULK_END
+ */
+int bulk_dump_find(uint64_t from_ms, uint64_t to_ms);
+
+#endif /* BULK_DUMP_H */
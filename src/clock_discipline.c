@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "clock_discipline.h"
+#include "clock_model.h"
+#include "app_ds3231.h"
+#include "health.h"
+
+#include <zephyr/lorawan/lorawan.h>
+#include <stdlib.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(clock);
+
+//  ========== globals =====================================================================
+// the model is read for every timestamp, updated after each observation
+static struct clock_model model;
+static K_MUTEX_DEFINE(model_mutex);
+
+static uint32_t interval_s = CLOCK_SYNC_MIN_S;
+static int32_t last_error_us;
+static int64_t next_net_ms;
+static bool net_pending;
+
+//  ========== local_now_us ================================================================
+static int64_t local_now_us(void)
+{
+    return (int64_t)app_ticks_to_us(app_get_ticks());
+}
+
+//  ========== net_read_unix ===============================================================
+// network time in whole unix seconds, kept by the LoRaWAN stack since the last answer
+static int net_read_unix(uint32_t *unix_secs)
+{
+    uint32_t gps_time;
+    int ret = lorawan_device_time_get(&gps_time);
+
+    if (ret == 0) {
+        *unix_secs = gps_time + CLOCK_GPS_EPOCH;
+    }
+    return ret;
+}
+
+//  ========== find_edge ===================================================================
+// date the next change of seconds of a source on the local clock. The coarse polling
+// locates a first edge, the fine one brackets the following edge between two reads.
+static int find_edge(int (*read_unix)(uint32_t *), uint32_t sigma_us, struct clock_obs *obs)
+{
+    uint32_t first, secs;
+    int ret = read_unix(&first);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int64_t coarse_us = 0;
+    for (int i = 0; i <= MSEC_PER_SEC / CLOCK_EDGE_COARSE_MS; i++) {
+        k_sleep(K_MSEC(CLOCK_EDGE_COARSE_MS));
+        ret = read_unix(&secs);
+        if (ret < 0) {
+            return ret;
+        }
+        if (secs != first) {
+            coarse_us = local_now_us();
+            break;
+        }
+    }
+    if (coarse_us == 0) {
+        return -ETIMEDOUT;
+    }
+
+    // the next edge is within CLOCK_EDGE_COARSE_MS before coarse_us + 1 s
+    int64_t wake_us = coarse_us + USEC_PER_SEC - CLOCK_EDGE_COARSE_MS * USEC_PER_MSEC -
+                      CLOCK_EDGE_MARGIN_US;
+    k_sleep(K_USEC(MAX(wake_us - local_now_us(), 0)));
+
+    first = secs;
+    int64_t previous_us = 0;
+    for (int i = 0; i <= (CLOCK_EDGE_COARSE_MS * USEC_PER_MSEC + 2 * CLOCK_EDGE_MARGIN_US) /
+                         CLOCK_EDGE_FINE_US; i++) {
+        int64_t start_us = local_now_us();
+        ret = read_unix(&secs);
+        if (ret < 0) {
+            return ret;
+        }
+        if (secs != first) {
+            if (previous_us == 0) {
+                // woken up after the edge, it is not bracketed
+                return -EAGAIN;
+            }
+            // the edge is between the start of the previous read and the end of this one
+            int64_t end_us = local_now_us();
+            obs->local_us = (previous_us + end_us) / 2;
+            obs->unix_us = (int64_t)secs * USEC_PER_SEC;
+            obs->sigma_us = (uint32_t)((end_us - previous_us) / 2) + sigma_us;
+            return 0;
+        }
+        previous_us = start_us;
+        k_sleep(K_USEC(CLOCK_EDGE_FINE_US));
+    }
+    return -ETIMEDOUT;
+}
+
+//  ========== model_add ===================================================================
+static int64_t model_add(const struct clock_obs *obs)
+{
+    health_mutex_lock(&model_mutex, HEALTH_LOCK_CLOCK, K_FOREVER);
+    int64_t error = clock_model_add(&model, obs);
+    k_mutex_unlock(&model_mutex);
+    return error;
+}
+
+//  ========== model_step ==================================================================
+static void model_step(const struct clock_obs *obs)
+{
+    health_mutex_lock(&model_mutex, HEALTH_LOCK_CLOCK, K_FOREVER);
+    clock_model_step(&model, obs);
+    k_mutex_unlock(&model_mutex);
+}
+
+//  ========== observe_ds3231 ==============================================================
+static int observe_ds3231(void)
+{
+    struct clock_obs obs;
+    int ret = find_edge(app_ds3231_read_unix, CLOCK_DS3231_SIGMA_US, &obs);
+    if (ret < 0) {
+        LOG_ERR("no DS3231 edge. error: %d", ret);
+        return ret;
+    }
+
+    int64_t error = model_add(&obs);
+    last_error_us = (int32_t)CLAMP(error, INT32_MIN, INT32_MAX);
+
+    // the longer the predictions hold, the less often the DS3231 is read
+    if (llabs(error) * 2 <= CLOCK_TARGET_US) {
+        interval_s = MIN(interval_s * 2, CLOCK_SYNC_MAX_S);
+    } else if (llabs(error) > CLOCK_TARGET_US) {
+        interval_s = MAX(interval_s / 2, CLOCK_SYNC_MIN_S);
+    }
+    LOG_INF("DS3231 edge: error %lld us, +/- %u us, frequency %d ppb, next in %u s",
+            error, obs.sigma_us, model.freq_ppb, interval_s);
+    return 0;
+}
+
+//  ========== set_ds3231 ==================================================================
+// write the DS3231 on a second boundary of the network time, which becomes the reference
+static int set_ds3231(const struct clock_obs *net)
+{
+    const struct device *ds3231_dev = DEVICE_DT_GET(DT_NODELABEL(i2c0));
+
+    // next network second, at least 100 ms away to be on time
+    int64_t secs = net->unix_us / USEC_PER_SEC + 1;
+    int64_t local_us = net->local_us + USEC_PER_SEC;
+    while (local_us - local_now_us() < 100 * USEC_PER_MSEC) {
+        secs++;
+        local_us += USEC_PER_SEC;
+    }
+    k_sleep(K_USEC(local_us - local_now_us()));
+
+    int ret = app_ds3231_set_time(ds3231_dev, (uint32_t)secs);
+    if (ret < 0) {
+        return ret;
+    }
+
+    struct clock_obs obs = {
+        .local_us = local_now_us(),
+        .unix_us = secs * USEC_PER_SEC,
+        .sigma_us = net->sigma_us,
+    };
+    model_step(&obs);
+    interval_s = CLOCK_SYNC_MIN_S;
+    return 0;
+}
+
+//  ========== clock_discipline_network ====================================================
+int clock_discipline_network(bool force)
+{
+    struct clock_obs obs;
+    int ret;
+
+    if (force) {
+        ret = lorawan_request_device_time(true);
+        if (ret < 0) {
+            LOG_ERR("lorawan_request_device_time returned %d", ret);
+            return ret;
+        }
+    }
+
+    ret = find_edge(net_read_unix, CLOCK_NET_SIGMA_US, &obs);
+    if (ret < 0) {
+        LOG_ERR("no network time edge. error: %d", ret);
+        return ret;
+    }
+
+    int64_t error = obs.unix_us - (int64_t)clock_discipline_unix_us(obs.local_us);
+    if (llabs(error) > CLOCK_STEP_US) {
+        // the DS3231 is wrong, not a drift: correct it and restart from the network time
+        LOG_WRN("network time %lld us away, setting the DS3231", error);
+        return set_ds3231(&obs);
+    }
+
+    model_add(&obs);
+    LOG_INF("network time: error %lld us", error);
+    return 0;
+}
+
+//  ========== clock_discipline_init =======================================================
+int clock_discipline_init(void)
+{
+    struct clock_obs obs;
+
+    clock_model_init(&model, CLOCK_SLEW_PPM);
+    next_net_ms = k_uptime_get() + k_ticks_to_ms_floor64(CLOCK_NET_PERIOD.ticks);
+
+    int ret = find_edge(app_ds3231_read_unix, CLOCK_DS3231_SIGMA_US, &obs);
+    if (ret < 0) {
+        LOG_ERR("no DS3231 edge. error: %d", ret);
+        return ret;
+    }
+    model_step(&obs);
+    LOG_INF("clock started at unix %lld s", obs.unix_us / USEC_PER_SEC);
+    return 0;
+}
+
+//  ========== clock_discipline_sync =======================================================
+k_timeout_t clock_discipline_sync(void)
+{
+    if (!model.valid) {
+        // the DS3231 was not available at boot
+        clock_discipline_init();
+    } else {
+        observe_ds3231();
+    }
+
+    // the request rides on the next uplink, its answer is used at the following call
+    if (net_pending) {
+        net_pending = false;
+        clock_discipline_network(false);
+    }
+    if (k_uptime_get() >= next_net_ms) {
+        next_net_ms = k_uptime_get() + k_ticks_to_ms_floor64(CLOCK_NET_PERIOD.ticks);
+        net_pending = lorawan_request_device_time(false) == 0;
+    }
+
+    return K_SECONDS(interval_s);
+}
+
+//  ========== clock_discipline_unix_us ====================================================
+uint64_t clock_discipline_unix_us(uint64_t clock_us)
+{
+    health_mutex_lock(&model_mutex, HEALTH_LOCK_CLOCK, K_FOREVER);
+    int64_t result = clock_model_unix_us(&model, (int64_t)clock_us);
+    k_mutex_unlock(&model_mutex);
+
+    return (result < 0) ? 0 : (uint64_t)result;
+}
+
+//  ========== clock_discipline_get_state ==================================================
+void clock_discipline_get_state(uint32_t *interval, int32_t *error_us, int32_t *freq_ppb)
+{
+    *interval = interval_s;
+    *error_us = last_error_us;
+    *freq_ppb = model.freq_ppb;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CLOCK_DISCIPLINE_H
+#define CLOCK_DISCIPLINE_H
+
+/*
+ * Unix time of the node, disciplined on the DS3231 and on the network time.
+ *
+ * Both sources only give whole seconds, so each observation waits for a second edge
+ * and dates it on the RTC2 clock. The observations feed a clock_model, which
+ * estimates the RTC2 frequency error and slews the time rather than stepping it.
+ * The DS3231 is read less often as the predictions hold, the network time is
+ * requested with an uplink every CLOCK_NET_PERIOD. It also corrects the DS3231
+ * when both disagree by more than CLOCK_STEP_US, the only case the time steps.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// DS3231 observation interval, doubled while the predictions stay within half of
+// CLOCK_TARGET_US, halved as soon as one is off by more
+#define CLOCK_SYNC_MIN_S            60
+#define CLOCK_SYNC_MAX_S            (6 * 3600)
+#define CLOCK_TARGET_US             1000
+
+// rate at which a correction is slewed out
+#define CLOCK_SLEW_PPM              500
+
+// network and DS3231 time further apart than this: the DS3231 is set and the time steps
+#define CLOCK_STEP_US               (100 * 1000)
+
+// uncertainty of the sources, added to the width of the edge
+#define CLOCK_DS3231_SIGMA_US       100
+#define CLOCK_NET_SIGMA_US          10000
+
+// edge search: coarse polling until the seconds change, then fine polling around
+// the following edge, one second later
+#define CLOCK_EDGE_COARSE_MS        20
+#define CLOCK_EDGE_FINE_US          500
+#define CLOCK_EDGE_MARGIN_US        5000
+
+// GPS epoch in unix time, the GPS time of the network ignores the leap seconds
+#define CLOCK_GPS_EPOCH             315964800
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief take a first DS3231 observation, the time is 0 until then
+ */
+int clock_discipline_init(void);
+
+/**
+ * @brief observe the sources that are due, to be called in a loop by the RTC thread
+ *
+ * @return time to wait before the next call
+ */
+k_timeout_t clock_discipline_sync(void);
+
+/**
+ * @brief observe the network time, sending an uplink for it if force is set,
+ * else using the answer to the last request
+ */
+int clock_discipline_network(bool force);
+
+/**
+ * @brief unix time in us of a RTC2 clock reading, see app_ticks_to_us()
+ */
+uint64_t clock_discipline_unix_us(uint64_t clock_us);
+
+/**
+ * @brief current DS3231 interval in s, last prediction error and frequency error
+ */
+void clock_discipline_get_state(uint32_t *interval_s, int32_t *error_us, int32_t *freq_ppb);
+
+#endif /* CLOCK_DISCIPLINE_H */
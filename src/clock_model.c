@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "clock_model.h"
+
+#include <string.h>
+
+//  ========== clock_model_init ============================================================
+void clock_model_init(struct clock_model *m, uint32_t slew_ppm)
+{
+    memset(m, 0, sizeof(*m));
+    m->slew_ppm = slew_ppm;
+}
+
+//  ========== fit_us ======================================================================
+// unix time of the fit alone
+static int64_t fit_us(const struct clock_model *m, int64_t local_us)
+{
+    int64_t dt = local_us - m->ref_us;
+    return local_us + m->offset_us + dt * m->freq_ppb / 1000000000;
+}
+
+//  ========== clock_model_unix_us =========================================================
+int64_t clock_model_unix_us(const struct clock_model *m, int64_t local_us)
+{
+    if (!m->valid) {
+        return 0;
+    }
+
+    // the remaining correction decreases linearly down to 0, readings older than the
+    // start of the slew keep the whole correction
+    int64_t slewed = 0;
+    if (local_us > m->slew_start_us) {
+        slewed = (local_us - m->slew_start_us) * m->slew_ppm / 1000000;
+    }
+    int64_t slew = m->slew_us;
+    if (slew > 0) {
+        slew = (slewed >= slew) ? 0 : slew - slewed;
+    } else {
+        slew = (slewed >= -slew) ? 0 : slew + slewed;
+    }
+
+    return fit_us(m, local_us) - slew;
+}
+
+//  ========== refit =======================================================================
+// weighted least squares of (unix - local) against local over the observations
+static void refit(struct clock_model *m)
+{
+    double sw = 0.0, sx = 0.0, sy = 0.0;
+    int64_t x0 = m->obs[(m->next + CLOCK_MODEL_POINTS - 1) % CLOCK_MODEL_POINTS].local_us;
+    int64_t y0 = m->obs[(m->next + CLOCK_MODEL_POINTS - 1) % CLOCK_MODEL_POINTS].unix_us - x0;
+    int64_t first = x0, last = x0;
+
+    // relative to the newest observation to keep the precision of the doubles
+    for (size_t i = 0; i < m->count; i++) {
+        const struct clock_obs *o = &m->obs[i];
+        double sigma = (o->sigma_us != 0) ? o->sigma_us : 1.0;
+        double w = 1.0 / (sigma * sigma);
+
+        sw += w;
+        sx += w * (double)(o->local_us - x0);
+        sy += w * (double)(o->unix_us - o->local_us - y0);
+        first = (o->local_us < first) ? o->local_us : first;
+        last = (o->local_us > last) ? o->local_us : last;
+    }
+    double mx = sx / sw;
+    double my = sy / sw;
+
+    if (last - first >= CLOCK_MODEL_MIN_SPAN_US) {
+        double sxx = 0.0, sxy = 0.0;
+        for (size_t i = 0; i < m->count; i++) {
+            const struct clock_obs *o = &m->obs[i];
+            double sigma = (o->sigma_us != 0) ? o->sigma_us : 1.0;
+            double w = 1.0 / (sigma * sigma);
+            double dx = (double)(o->local_us - x0) - mx;
+            double dy = (double)(o->unix_us - o->local_us - y0) - my;
+
+            sxx += w * dx * dx;
+            sxy += w * dx * dy;
+        }
+        double ppb = sxy / sxx * 1e9;
+        if (ppb > -CLOCK_MODEL_MAX_PPB && ppb < CLOCK_MODEL_MAX_PPB) {
+            m->freq_ppb = (int32_t)ppb;
+        }
+    }
+    // otherwise the previous frequency is kept
+
+    m->ref_us = x0 + (int64_t)mx;
+    m->offset_us = y0 + (int64_t)my;
+}
+
+//  ========== clock_model_step ============================================================
+void clock_model_step(struct clock_model *m, const struct clock_obs *obs)
+{
+    // a single observation does not fit the frequency, the oscillator keeps its last one
+    m->count = 0;
+    m->next = 0;
+    m->valid = false;
+    clock_model_add(m, obs);
+}
+
+//  ========== clock_model_add =============================================================
+int64_t clock_model_add(struct clock_model *m, const struct clock_obs *obs)
+{
+    bool was_valid = m->valid;
+    int64_t before = clock_model_unix_us(m, obs->local_us);
+
+    m->obs[m->next] = *obs;
+    m->next = (m->next + 1) % CLOCK_MODEL_POINTS;
+    if (m->count < CLOCK_MODEL_POINTS) {
+        m->count++;
+    }
+    refit(m);
+    m->valid = true;
+
+    if (!was_valid) {
+        m->slew_us = 0;
+        return 0;
+    }
+
+    // keep the output continuous at the observation, then converge on the fit
+    m->slew_start_us = obs->local_us;
+    m->slew_us = fit_us(m, obs->local_us) - before;
+    return obs->unix_us - before;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CLOCK_MODEL_H
+#define CLOCK_MODEL_H
+
+/*
+ * Model of the unix time as a function of the local clock (RTC2 in us).
+ *
+ * The offset between both is fitted by weighted least squares on the last
+ * CLOCK_MODEL_POINTS observations: unix - local = offset + freq * (local - ref).
+ * A new fit never steps the output, the difference with the previous one is slewed
+ * out at slew_ppm, so the time stays continuous and increasing.
+ */
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//  ========== defines =====================================================================
+#define CLOCK_MODEL_POINTS          8
+
+// the frequency is only fitted over observations at least this far apart
+#define CLOCK_MODEL_MIN_SPAN_US     (300LL * 1000000)
+
+// largest frequency error accepted from a fit
+#define CLOCK_MODEL_MAX_PPB         500000
+
+//  ========== types =======================================================================
+// one time reference: the unix time of a local clock reading and its uncertainty
+struct clock_obs {
+    int64_t local_us;
+    int64_t unix_us;
+    uint32_t sigma_us;
+};
+
+struct clock_model {
+    struct clock_obs obs[CLOCK_MODEL_POINTS];
+    size_t count;
+    size_t next;
+    bool valid;
+
+    // fit
+    int64_t ref_us;             // local time of the fit reference
+    int64_t offset_us;          // unix - local at ref_us
+    int32_t freq_ppb;           // rate of unix time minus rate of the local clock
+
+    // correction being slewed out: output = fit - slew_us, decreasing at slew_ppm
+    int64_t slew_start_us;
+    int64_t slew_us;
+    uint32_t slew_ppm;
+};
+
+//  ========== prototypes ==================================================================
+void clock_model_init(struct clock_model *m, uint32_t slew_ppm);
+
+/**
+ * @brief forget every observation and restart from this one, stepping the output
+ */
+void clock_model_step(struct clock_model *m, const struct clock_obs *obs);
+
+/**
+ * @brief add an observation and refit, the change is slewed from obs->local_us on
+ *
+ * @return the error of the previous output at the observation, in us
+ */
+int64_t clock_model_add(struct clock_model *m, const struct clock_obs *obs);
+
+/**
+ * @brief unix time in us of a local clock reading, 0 before the first observation
+ */
+int64_t clock_model_unix_us(const struct clock_model *m, int64_t local_us);
+
+#endif /* CLOCK_MODEL_H */
@@ -8,8 +8,20 @@
 
 #define LOG_LEVEL SASTRESS_LOG_LVL
 
-#define BTH_PERIOD K_MINUTES(30)
-#define PERIODIC_SAMPLE_PERIOD K_MINUTES(30)
+// period of the BTH record in s. This one and the settings marked (default) below are only the values at boot,
+// a downlink can change them on a running node (see node_config.h)
+#define BTH_PERIOD_S (5 * 60)
+#define PERIODIC_SAMPLE_PERIOD K_MINUTES(5)
+#define HEALTH_PERIOD K_HOURS(1)
+// network time requested with the next uplink (DeviceTimeReq), the DS3231 is read more often, see clock_discipline.h
+#define CLOCK_NET_PERIOD K_HOURS(24)
+// longest time a BTH or periodic record waits to be batched with others before it is sent
+#define UPLINK_BATCH_LATENCY_MS (30 * 60 * 1000)
+// longest time a queued uplink or a sent one stays in RAM before the uplink log is written
+#define UPLINK_LOG_FLUSH_MS (10 * 1000)
+// status uplinks are unconfirmed, the next one is confirmed after this long without any,
+// which bounds what a gateway outage loses before it is noticed (anomalies are always confirmed)
+#define UPLINK_CONFIRM_PERIOD_MS (2 * 60 * 60 * 1000)
 
 // Configuration of the sensor functionalities
 // BTH_ENABLE : if set to 0, the sensor won't send sensor status messages (battery, temperature, humidity) 
@@ -18,8 +30,43 @@
 #define PERIODIC_SAMPLE_ENABLE 1
 // PERIODIC_SAMPLE_ENABLE : if set to 0, the sensor won't send anomaly detected messages
 #define ANOMALY_SEND 1
-// ANOMALY_SEND_SAMPLES : if set to 0, the sensor won't send the samples linked to a detected anomaly
+// ANOMALY_SEND_SAMPLES : if set to 0, the sensor won't send the samples linked to a detected anomaly (default)
 #define ANOMALY_SEND_SAMPLES 1
+// ADC_CONTINUOUS_ENABLE : if set to 0, the geophone is polled with adc_read() every SAMPLING_RATE_MS,
+// else the SAADC is set up once, sampled on a timer and full blocks of ADC_BLOCK_SIZE samples are handed to the consumers
+#define ADC_CONTINUOUS_ENABLE 1
+// ADC_BLOCK_SIZE : number of samples handed at once to the consumers, the detector wakes once per block.
+// From 1 (every sample) to 100 (1 s at SAMPLING_RATE_MS): larger blocks mean fewer wakeups, the detection
+// and the anomaly uplink come up to one block later. "power" on the console gives the resulting figures
+#define ADC_BLOCK_SIZE 10
+// STORAGE_ENABLE : if set to 0, the sensor won't record the geophone signal to the flash
+#define STORAGE_ENABLE 1
+// STORAGE_COMPRESS_ENABLE : if set to 0, the signal is recorded as raw int16 samples instead of compressed frames
+#define STORAGE_COMPRESS_ENABLE 1
+// STA_LTA_MODE : 0 recomputes the STA and LTA windows on each new data (legacy),
+// 1 updates exact running sums per sample, 2 uses the recursive (exponential) STA/LTA
+#define STA_LTA_MODE 1
+// DETECTOR_ER_ENABLE, DETECTOR_MER_ENABLE, DETECTOR_THRESHOLD_ENABLE : if set to 1, the energy ratio, modified
+// energy ratio or amplitude threshold detector runs next to the STA/LTA (streaming modes only, see detectors.h) (default)
+#define DETECTOR_ER_ENABLE 0
+#define DETECTOR_MER_ENABLE 0
+#define DETECTOR_THRESHOLD_ENABLE 0
+// DETECTOR_VOTES : number of running detectors that must be on together to report an anomaly (default)
+#define DETECTOR_VOTES 1
+// SPECTRAL_ENABLE : if set to 0, no FFT is computed on the device and the spectral features are sent as zeros
+#define SPECTRAL_ENABLE 1
+// PACKET_V2_ENABLE : if set to 0, each status message is sent alone with the v1 header (type + 64-bit timestamp),
+// else the pending messages are packed as records of a v2 frame (see packet_codec.h), and the BTH and
+// periodic records are held until they fill an uplink or UPLINK_BATCH_LATENCY_MS expires
+#define PACKET_V2_ENABLE 1
+// HEALTH_ENABLE : if set to 0, the node won't send its health record (CPU and stack use per thread,
+// queue peaks, loss counters, detector latency) every HEALTH_PERIOD, see health.h
+#define HEALTH_ENABLE 1
+// UPLINK_LOG_ENABLE : if set to 0, the queued uplinks only live in RAM and are lost when their queue is full or on a
+// reset, else they are also kept on the flash until sent, and replayed in order once the network is back (see uplink_log.h)
+#define UPLINK_LOG_ENABLE 1
+// CONSOLE_ENABLE : if set to 0, no command is read from the RTT console (health, dump, see app_console.h)
+#define CONSOLE_ENABLE 1
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "config_codec.h"
+
+#include <errno.h>
+
+//  ========== config_param_size ===========================================================
+size_t config_param_size(uint8_t param)
+{
+    switch (param) {
+    case PARAM_SAMPLING_RATE:
+    case PARAM_STA_WINDOW:
+    case PARAM_LTA_WINDOW:
+    case PARAM_RATIO_ON:
+    case PARAM_RATIO_OFF:
+        return sizeof(uint16_t);
+    case PARAM_ANOMALY_DELAY:
+    case PARAM_BTH_PERIOD:
+        return sizeof(uint32_t);
+    case PARAM_SEND_SAMPLES:
+    case PARAM_DETECTORS:
+    case PARAM_VOTES:
+        return sizeof(uint8_t);
+    default:
+        return 0;
+    }
+}
+
+//  ========== get_le ======================================================================
+static uint32_t get_le(const uint8_t *data, size_t size)
+{
+    uint32_t value = 0;
+
+    for (size_t i = size; i > 0; i--) {
+        value = (value << 8) | data[i - 1];
+    }
+    return value;
+}
+
+//  ========== config_parse ================================================================
+int config_parse(const uint8_t *data, size_t len, struct node_config_t *config, uint8_t *param)
+{
+    size_t pos = 0;
+
+    *param = 0;
+    while (pos < len) {
+        uint8_t id = data[pos++];
+        size_t size = config_param_size(id);
+
+        *param = id;
+        if (size == 0) {
+            return -EINVAL;
+        }
+        if (len - pos < size) {
+            return -EMSGSIZE;
+        }
+        uint32_t value = get_le(&data[pos], size);
+        pos += size;
+
+        switch (id) {
+        case PARAM_SAMPLING_RATE:
+            config->sampling_rate_ms = (uint16_t)value;
+            break;
+        case PARAM_STA_WINDOW:
+            config->sta_window_ms = (uint16_t)value;
+            break;
+        case PARAM_LTA_WINDOW:
+            config->lta_window_ms = (uint16_t)value;
+            break;
+        case PARAM_RATIO_ON:
+            config->ratio_on = (uint16_t)value;
+            break;
+        case PARAM_RATIO_OFF:
+            config->ratio_off = (uint16_t)value;
+            break;
+        case PARAM_ANOMALY_DELAY:
+            config->anomaly_delay_ms = value;
+            break;
+        case PARAM_BTH_PERIOD:
+            config->bth_period_s = value;
+            break;
+        case PARAM_SEND_SAMPLES:
+            config->send_samples = (uint8_t)value;
+            break;
+        case PARAM_DETECTORS:
+            config->detectors = (uint8_t)value;
+            break;
+        case PARAM_VOTES:
+            config->votes = (uint8_t)value;
+            break;
+        }
+    }
+    *param = 0;
+    return 0;
+}
+
+//  ========== config_check ================================================================
+// the first failed rule names the parameter, the order follows the dependencies
+int config_check(const struct node_config_t *config, uint8_t *param)
+{
+    uint32_t rate = config->sampling_rate_ms;
+    int detectors = 0;
+
+    for (uint8_t mask = config->detectors; mask != 0; mask &= mask - 1) {
+        detectors++;
+    }
+
+    if (rate < PARAM_RATE_MIN_MS || rate > PARAM_RATE_MAX_MS) {
+        *param = PARAM_SAMPLING_RATE;
+    } else if (config->sta_window_ms / rate < 1 ||
+               config->sta_window_ms / rate > PARAM_STA_MAX_SAMPLES) {
+        *param = PARAM_STA_WINDOW;
+    } else if (config->lta_window_ms / rate <= config->sta_window_ms / rate ||
+               config->lta_window_ms / rate > PARAM_LTA_MAX_SAMPLES) {
+        *param = PARAM_LTA_WINDOW;
+    } else if (config->ratio_on <= PARAM_RATIO_MIN) {
+        *param = PARAM_RATIO_ON;
+    } else if (config->ratio_off < PARAM_RATIO_MIN || config->ratio_off > config->ratio_on) {
+        *param = PARAM_RATIO_OFF;
+    } else if (config->anomaly_delay_ms > PARAM_DELAY_MAX_MS) {
+        *param = PARAM_ANOMALY_DELAY;
+    } else if (config->bth_period_s < PARAM_BTH_MIN_S || config->bth_period_s > PARAM_BTH_MAX_S) {
+        *param = PARAM_BTH_PERIOD;
+    } else if (config->send_samples > 1) {
+        *param = PARAM_SEND_SAMPLES;
+    } else if ((config->detectors & ~PARAM_DETECTORS_ALL) != 0) {
+        *param = PARAM_DETECTORS;
+    } else if (config->votes < 1 || config->votes > 1 + detectors) {
+        *param = PARAM_VOTES;
+    } else {
+        *param = 0;
+        return 0;
+    }
+    return -ERANGE;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CONFIG_CODEC_H
+#define CONFIG_CODEC_H
+
+/*
+ * Parameters of a DOWNLINK_CONFIG_SET request (see downlink.h).
+ *
+ * The arguments are a list of parameters, each one byte of enum config_param followed by
+ * its value, little-endian, of the size given by config_param_size():
+ *
+ *   02  01 1400  09 03  0a 02   DOWNLINK_CONFIG_SET: sampling period 20 ms, ER and MER
+ *                               detectors next to the STA/LTA, 2 votes
+ *
+ * A parameter may come more than once, the last value counts. The list is applied on a
+ * copy of the configuration in effect, then the whole result is checked: a window given
+ * in ms must still hold a number of samples the buffers can take at the new sampling
+ * period, so the parameters are checked together, not one by one.
+ *
+ * No Zephyr include here, the parsing builds on the host as well.
+ */
+
+//  ========== includes ====================================================================
+#include "config.h"
+#include "data_types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// sampling period. Polled, an adc_read() per sample does not hold below 10 ms. On the
+// timer, 2 ms still leaves the ADC ring 8 s of slack for the recorder and the statistics,
+// and the lowest spectral band (1-4 Hz) still spans a bin. The ADC blocks stay within
+// 1 s up to ADC_BLOCK_SIZE 10.
+#define PARAM_RATE_MIN_MS           (ADC_CONTINUOUS_ENABLE ? 2 : 10)
+#define PARAM_RATE_MAX_MS           100
+
+// samples of the STA and LTA windows the detector buffers hold. The STA window is sent
+// with each event, it must fit in the pre-trigger part of the capture (event_capture.c),
+// the ADC ring holds two LTA windows.
+#define PARAM_STA_MAX_SAMPLES       256
+#define PARAM_LTA_MAX_SAMPLES       2048
+
+// STA/LTA ratios, in 0.01: reporting below 1 would fire on the noise
+#define PARAM_RATIO_MIN             100
+
+#define PARAM_DELAY_MAX_MS          (24 * 60 * 60 * 1000)
+#define PARAM_BTH_MIN_S             60
+#define PARAM_BTH_MAX_S             (7 * 24 * 60 * 60)
+
+// detectors running next to the STA/LTA, see detectors.h
+#define PARAM_DETECTOR_ER           (1u << 0)
+#define PARAM_DETECTOR_MER          (1u << 1)
+#define PARAM_DETECTOR_THRESHOLD    (1u << 2)
+#define PARAM_DETECTORS_ALL         (PARAM_DETECTOR_ER | PARAM_DETECTOR_MER | PARAM_DETECTOR_THRESHOLD)
+
+//  ========== types =======================================================================
+// field of struct node_config_t set by a parameter
+enum config_param {
+    PARAM_SAMPLING_RATE = 0x01,     // u16 ms
+    PARAM_STA_WINDOW = 0x02,        // u16 ms
+    PARAM_LTA_WINDOW = 0x03,        // u16 ms
+    PARAM_RATIO_ON = 0x04,          // u16, 0.01
+    PARAM_RATIO_OFF = 0x05,         // u16, 0.01
+    PARAM_ANOMALY_DELAY = 0x06,     // u32 ms
+    PARAM_BTH_PERIOD = 0x07,        // u32 s
+    PARAM_SEND_SAMPLES = 0x08,      // u8, 0 or 1
+    PARAM_DETECTORS = 0x09,         // u8, PARAM_DETECTOR_* mask
+    PARAM_VOTES = 0x0a,             // u8
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief size of the value of a parameter
+ *
+ * @return bytes after the parameter byte, 0 for an unknown parameter
+ */
+size_t config_param_size(uint8_t param);
+
+/**
+ * @brief apply a list of parameters to `config`
+ *
+ * `config` is left partly updated on an error, pass a copy.
+ *
+ * @param param set to the parameter in error, 0 if none
+ * @return 0, -EINVAL on an unknown parameter, -EMSGSIZE on a truncated value
+ */
+int config_parse(const uint8_t *data, size_t len, struct node_config_t *config, uint8_t *param);
+
+/**
+ * @brief check a whole configuration against the limits above
+ *
+ * @param param set to the first parameter out of range, 0 if none
+ * @return 0 or -ERANGE
+ */
+int config_check(const struct node_config_t *config, uint8_t *param);
+
+#endif /* CONFIG_CODEC_H */
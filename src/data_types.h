@@ -12,7 +12,12 @@ typedef enum packet_type {
     BTH = 1,
     ANOMALY = 2,
     SAMPLES = 3,
-    PERIODIC_SAMPLE = 4
+    PERIODIC_SAMPLE = 4,
+    EVENT_FRAGMENT = 5,
+    HEALTH = 6,
+    WINDOW = 7,
+    CONFIG = 8,
+    PACKET_TYPE_END         // one past the last type, see packet_codec.h
 } PACKET_TYPE;
 
 struct bth_payload_t {
@@ -21,28 +26,133 @@ struct bth_payload_t {
     int16_t humidity;
 };
 
+// number of band energies in the spectral features
+#define SPECTRAL_BANDS 4
+
+// spectral features of the geophone signal, see spectral.h
+struct spectral_payload_t {
+    uint16_t dominant;      // dominant frequency, in 0.1 Hz
+    uint16_t bands[SPECTRAL_BANDS]; // RMS amplitude of each band, in 10 uV
+};
+
+// min and max are in mV relative to the geophone DC level, mean is the absolute level in mV
 struct anomaly_payload_t {
     int16_t min;
     int16_t max;
     int16_t stalta;
     int16_t mean;
+    uint16_t event_id;      // carried by the EVENT_FRAGMENT packets of this event
+    struct spectral_payload_t spectral; // last frame before the report
+    uint16_t time_us;       // us to add to the ms timestamp of the record, 0 to 999
+    int16_t rate_ppm;       // deviation of the sampling period from the nominal one
+    uint16_t period_ms;     // nominal sampling period at the trigger
 };
 
+// statistics over the whole period, in mV relative to the geophone DC level
+// except the mean, which is the absolute level. Percentiles are of the absolute amplitude.
 struct periodic_sample_payload_t {
     int16_t min;
     int16_t max;
     int16_t mean;
+    uint16_t rms;
+    uint16_t p50;
+    uint16_t p90;
+    uint16_t p99;
+    struct spectral_payload_t spectral; // mean spectrum of the period
 };
 
+// queues and threads reported in the health record, in the order of health.h
+#define HEALTH_PAYLOAD_QUEUES 6
+#define HEALTH_PAYLOAD_THREADS 9
+
+// node health over the last period (see health.h), counters are since boot
+struct health_payload_t {
+    uint32_t uptime;        // s
+    uint16_t cpu_load;      // 0.1 %
+    uint16_t adc_overruns;  // ADC blocks overwritten before being consumed
+    uint16_t lost_samples;  // samples skipped by the recorder and the detector
+    uint16_t dropped;       // events and uplinks dropped on a full queue or slot pool
+    uint16_t lock_wait_max; // longest wait on a shared mutex, in 10 us
+    uint16_t latency_p99;   // detector latency, upper bound of the 99th percentile bucket, in 10 us
+    uint16_t latency_max;   // longest detector latency, in 10 us
+    uint8_t queue_peak[HEALTH_PAYLOAD_QUEUES];      // highest occupancy, in messages
+    uint8_t thread_cpu[HEALTH_PAYLOAD_THREADS];     // CPU share, in 0.5 %
+    uint8_t thread_stack[HEALTH_PAYLOAD_THREADS];   // stack high-water mark, in %
+} __attribute__((packed));
+
+// number of file ranges listed in a window record
+#define WINDOW_PAYLOAD_RANGES 2
+
+// part of a geophone file, see wave_index.h
+struct window_range_t {
+    uint16_t file;          // geophone_NNN.dat
+    uint32_t offset;
+    uint32_t size;          // bytes
+} __attribute__((packed));
+
+// answer to a DOWNLINK_WINDOW request (see downlink.h): what the flash still holds of the window
+struct window_payload_t {
+    uint32_t from;          // start of the window, unix s
+    uint16_t duration;      // s
+    uint16_t ranges;        // ranges found, the first WINDOW_PAYLOAD_RANGES are listed
+    uint16_t blocks;
+    uint32_t samples;
+    struct window_range_t range[WINDOW_PAYLOAD_RANGES];
+} __attribute__((packed));
+
+// parameters of the node that a downlink can change, see node_config.h and config_codec.h
+struct node_config_t {
+    uint16_t sampling_rate_ms;
+    uint16_t sta_window_ms;
+    uint16_t lta_window_ms;
+    uint16_t ratio_on;      // STA/LTA ratio reporting an anomaly, in 0.01
+    uint16_t ratio_off;     // STA/LTA ratio re-arming the detector, in 0.01
+    uint32_t anomaly_delay_ms; // minimal time between two anomalies
+    uint32_t bth_period_s;
+    uint8_t send_samples;   // 0 or 1, send the samples of each anomaly
+    uint8_t detectors;      // PARAM_DETECTOR_* running next to the STA/LTA
+    uint8_t votes;          // detectors that must be on together
+} __attribute__((packed));
+
+// answer to a DOWNLINK_CONFIG_* request (see downlink.h)
+struct config_payload_t {
+    int8_t status;          // 0, or the negative error code of a refused request
+    uint8_t param;          // parameter refused, 0 if none
+    struct node_config_t config; // in effect after the request
+} __attribute__((packed));
+
+// samples in mV relative to the geophone DC level
 struct samples_payload_t {
     int16_t samples[MAX_SAMPLES];
 };
 
 
+// header of an EVENT_FRAGMENT packet, followed by int16 samples in mV relative to the DC level.
+// It replaces the 64-bit timestamp: the time of a sample is the anomaly timestamp of the
+// event (with its time_us) plus (offset + i) * period_ms * (1 + rate_ppm / 10^6), both
+// period_ms and rate_ppm from the anomaly record of the event.
+struct fragment_header_t {
+    uint8_t type;           // EVENT_FRAGMENT
+    uint16_t event_id;
+    uint8_t seq;            // fragment number, FRAGMENT_LAST set on the last one
+    int16_t offset;         // first sample of the fragment, relative to the trigger sample
+} __attribute__((packed));
+
+#define FRAGMENT_LAST 0x80
+
+// largest application payload of a LoRaWAN uplink (EU868 DR5)
+#define LORA_MAX_FRAME 242
+
+// largest application payload carried by a packet
+#define PACKET_MAX_PAYLOAD 100
+
 typedef struct packet_t {
     PACKET_TYPE type;
     uint64_t timestamp;
-    uint8_t payload[100];
+    uint8_t payload[PACKET_MAX_PAYLOAD];
 } __attribute__((packed)) PACKET;
 
+// bytes added by the packet header in front of the payload
+#define LORA_HEADER_SIZE (sizeof(PACKET_TYPE) + sizeof(uint64_t))
+
 #endif
\ No newline at end of file
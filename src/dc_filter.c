@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "dc_filter.h"
+
+//  ========== dc_filter_init ==============================================================
+void dc_filter_init(struct dc_filter *f, uint32_t corner_mhz, uint32_t sample_rate_mhz)
+{
+    f->baseline = 0;
+    f->primed = false;
+    dc_filter_set_corner(f, corner_mhz, sample_rate_mhz);
+}
+
+//  ========== dc_filter_set_corner ========================================================
+void dc_filter_set_corner(struct dc_filter *f, uint32_t corner_mhz, uint32_t sample_rate_mhz)
+{
+    // alpha = 2*pi*fc/fs in Q16, with pi ~ 355/113
+    int64_t alpha = ((int64_t)2 * 355 * corner_mhz << 16) / ((int64_t)113 * sample_rate_mhz);
+
+    if (alpha < 1) {
+        alpha = 1;
+    }
+    if (alpha > (1 << 16)) {
+        alpha = 1 << 16;
+    }
+    f->alpha = (int32_t)alpha;
+}
+
+//  ========== dc_filter_update ============================================================
+int16_t dc_filter_update(struct dc_filter *f, int32_t x)
+{
+    int32_t xq = x * (1 << 16);
+
+    if (!f->primed) {
+        f->baseline = xq;
+        f->primed = true;
+    }
+
+    // output against the previous baseline, then track. The difference of two Q16 values
+    // of the int16 range needs 33 bits.
+    int64_t d = (int64_t)xq - f->baseline;
+    int32_t y = (int32_t)((d + (1 << 15)) >> 16);
+    f->baseline += (int32_t)((d * f->alpha) >> 16);
+
+    if (y > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (y < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)y;
+}
+
+//  ========== dc_filter_baseline ==========================================================
+int16_t dc_filter_baseline(const struct dc_filter *f)
+{
+    return (int16_t)((f->baseline + (1 << 15)) >> 16);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DC_FILTER_H
+#define DC_FILTER_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+//  ========== defines =====================================================================
+// corner frequency of the DC removal stage in mHz, below the geophone natural frequency
+#define DC_FILTER_CORNER_MHZ        50
+
+//  ========== types =======================================================================
+/**
+ * @brief first-order integer DC tracker / high-pass filter
+ *
+ * The baseline follows the input with b += alpha * (x - b), kept in Q16 so that slow
+ * drifts (temperature, battery) below the corner frequency are tracked without
+ * rounding stalls. The output is x - b, i.e. the signal with its DC level removed.
+ */
+struct dc_filter {
+    int32_t baseline;       // Q16
+    int32_t alpha;          // Q16, ~2*pi*fc/fs
+    bool primed;
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief initialize the filter for a corner frequency and a sampling rate
+ *
+ * @param corner_mhz corner frequency in mHz
+ * @param sample_rate_mhz sampling rate in mHz
+ */
+void dc_filter_init(struct dc_filter *f, uint32_t corner_mhz, uint32_t sample_rate_mhz);
+
+/**
+ * @brief change the corner frequency or the sampling rate, keeping the baseline
+ */
+void dc_filter_set_corner(struct dc_filter *f, uint32_t corner_mhz, uint32_t sample_rate_mhz);
+
+/**
+ * @brief remove the DC level from one sample
+ *
+ * The first sample primes the baseline, so the output starts at 0 instead of
+ * ringing down from the raw level.
+ */
+int16_t dc_filter_update(struct dc_filter *f, int32_t x);
+
+/**
+ * @brief current DC level, rounded to the input unit
+ */
+int16_t dc_filter_baseline(const struct dc_filter *f);
+
+#endif /* DC_FILTER_H */
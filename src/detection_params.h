@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DETECTION_PARAMS_H
+#define DETECTION_PARAMS_H
+
+//  ========== defines =====================================================================
+// No Zephyr include here: tools/replay builds the detection code on the host with
+// these same values. On the node, the windows, the STA/LTA ratios and the minimal delay
+// are the defaults of the downlink configuration (see node_config.h).
+
+// STA and LTA window durations in milliseconds
+#define STA_WINDOW_DURATION_MS      1024     // 1 seconds
+#define LTA_WINDOW_DURATION_MS      16384    // 10 seconds
+
+// Minimal time between two anomalies
+#define MINIMAL_DELAY_ANOMALY_MS 10000
+
+// threshold of the STA/LTA ratio above which we consider an event detected, and below
+// which the detector re-arms
+#define DETECTION_RATIO             3.f
+#define DETECTION_RATIO_OFF         1.5f
+
+// other detectors, enabled in config.h. The MER is (ER * |x|)^3 with x in mV.
+#define ER_ON                       4.f
+#define ER_OFF                      2.f
+#define MER_ON                      1e6f
+#define MER_OFF                     1e5f
+#define THRESHOLD_ON_MV             500.f
+#define THRESHOLD_OFF_MV            250.f
+
+#endif /* DETECTION_PARAMS_H */
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "detectors.h"
+
+#include <errno.h>
+#include <string.h>
+
+//  ========== energy ======================================================================
+static inline uint32_t energy(int16_t sample)
+{
+    uint32_t a = (uint32_t)(sample < 0 ? -(int32_t)sample : sample);
+    return a * a;
+}
+
+//  ========== detector_init ===============================================================
+static void detector_init(struct detector *d, uint8_t kind, float on, float off)
+{
+    memset(d, 0, sizeof(*d));
+    d->kind = kind;
+    d->on = on;
+    d->off = (off > on) ? on : off;
+}
+
+void detector_init_sta_lta(struct detector *d, uint8_t mode, int16_t *history,
+                           size_t sta_len, size_t lta_len, float on, float off)
+{
+    detector_init(d, DETECTOR_STA_LTA, on, off);
+    sta_lta_init(&d->sta_lta, mode, history, sta_len, lta_len, 0);
+}
+
+void detector_init_energy_ratio(struct detector *d, int16_t *history, size_t len,
+                                float on, float off)
+{
+    detector_init(d, DETECTOR_ENERGY_RATIO, on, off);
+    d->er.history = history;
+    d->er.len = len;
+}
+
+void detector_init_mer(struct detector *d, int16_t *history, size_t len, float on, float off)
+{
+    detector_init_energy_ratio(d, history, len, on, off);
+    d->kind = DETECTOR_MER;
+}
+
+void detector_init_threshold(struct detector *d, float on, float off)
+{
+    detector_init(d, DETECTOR_THRESHOLD, on, off);
+}
+
+//  ========== energy_ratio_update =========================================================
+// returns the ER and the sample it refers to, 0 until both windows are full
+static float energy_ratio_update(struct energy_ratio *er, int16_t sample, int16_t *onset)
+{
+    size_t span = 2 * er->len;
+
+    // the sample leaving the newest window enters the older one, len samples behind
+    size_t mid = er->pos + er->len;
+    if (mid >= span) {
+        mid -= span;
+    }
+
+    if (er->count >= span) {
+        er->pre_sum -= energy(er->history[er->pos]);
+    }
+    if (er->count >= er->len) {
+        uint32_t e = energy(er->history[mid]);
+        er->post_sum -= e;
+        er->pre_sum += e;
+    }
+    er->post_sum += energy(sample);
+
+    er->history[er->pos] = sample;
+    if (++er->pos == span) {
+        er->pos = 0;
+    }
+    if (er->count < span) {
+        er->count++;
+    }
+
+    // oldest sample of the newest window, now at pos + len
+    mid = er->pos + er->len;
+    if (mid >= span) {
+        mid -= span;
+    }
+    *onset = er->history[mid];
+
+    if (er->count < span || er->pre_sum == 0) {
+        return 0.0f;
+    }
+    return (float)er->post_sum / (float)er->pre_sum;
+}
+
+//  ========== detector_update =============================================================
+bool detector_update(struct detector *d, int16_t sample)
+{
+    int16_t onset;
+
+    switch (d->kind) {
+    case DETECTOR_STA_LTA:
+        d->value = sta_lta_update(&d->sta_lta, sample);
+        break;
+    case DETECTOR_ENERGY_RATIO:
+        d->value = energy_ratio_update(&d->er, sample, &onset);
+        break;
+    case DETECTOR_MER: {
+        float v = energy_ratio_update(&d->er, sample, &onset);
+        v *= (onset < 0) ? -(float)onset : (float)onset;
+        d->value = v * v * v;
+        break;
+    }
+    case DETECTOR_THRESHOLD:
+    default:
+        d->value = (sample < 0) ? -(float)sample : (float)sample;
+        break;
+    }
+
+    // hysteresis
+    if (!d->active && d->value >= d->on) {
+        d->active = true;
+    } else if (d->active && d->value < d->off) {
+        d->active = false;
+    }
+    return d->active;
+}
+
+//  ========== detector_bank_init ==========================================================
+int detector_bank_init(struct detector_bank *bank, struct detector *detectors, size_t count,
+                       uint8_t votes, uint32_t coincidence)
+{
+    if (count == 0 || count > DETECTOR_BANK_MAX || votes == 0 || votes > count) {
+        return -EINVAL;
+    }
+
+    memset(bank, 0, sizeof(*bank));
+    bank->detectors = detectors;
+    bank->count = count;
+    bank->votes = votes;
+    bank->coincidence = coincidence;
+    for (size_t i = 0; i < count; i++) {
+        bank->last_vote[i] = UINT32_MAX;
+    }
+    return 0;
+}
+
+//  ========== detector_bank_update ========================================================
+bool detector_bank_update(struct detector_bank *bank, int16_t sample)
+{
+    uint8_t votes = 0;
+
+    for (size_t i = 0; i < bank->count; i++) {
+        if (detector_update(&bank->detectors[i], sample)) {
+            bank->last_vote[i] = 0;
+        } else if (bank->last_vote[i] != UINT32_MAX) {
+            bank->last_vote[i]++;
+        }
+        if (bank->last_vote[i] <= bank->coincidence) {
+            votes++;
+        }
+    }
+
+    bool was_active = bank->active;
+    bank->active = (votes >= bank->votes);
+    return bank->active && !was_active;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DETECTORS_H
+#define DETECTORS_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sta_lta.h"
+
+//  ========== defines =====================================================================
+#define DETECTOR_STA_LTA            0   // STA/LTA of the energy, see sta_lta.h
+#define DETECTOR_ENERGY_RATIO       1   // ER: energy of the last window over the one before
+#define DETECTOR_MER                2   // modified energy ratio, (ER * |x|)^3
+#define DETECTOR_THRESHOLD          3   // absolute amplitude
+
+#define DETECTOR_BANK_MAX           8
+
+//  ========== types =======================================================================
+/**
+ * @brief causal energy ratio over two adjacent windows of len samples
+ *
+ * ER(i) = sum(x^2, i-len+1 .. i) / sum(x^2, i-2len+1 .. i-len), i.e. the ER of
+ * spectrogram.py at the sample i-len+1, available len samples later. The MER uses the
+ * amplitude of that same sample. Note that spectrogram.py plots the inverse ratio
+ * (before over after), this one rises at an onset like the STA/LTA.
+ */
+struct energy_ratio {
+    int16_t *history;       // 2 * len samples
+    size_t len;
+    size_t pos;             // index of the oldest sample of history
+    uint32_t count;         // samples seen, saturates at 2 * len
+    uint64_t post_sum;      // newest window
+    uint64_t pre_sum;       // window before it
+};
+
+/**
+ * @brief one detector: a characteristic function and an on/off hysteresis
+ *
+ * The detector turns on when the function reaches `on` and off once it drops below
+ * `off`, with off <= on, so a value hovering around a single threshold does not
+ * toggle it at every sample. Every update is O(1) whatever the window lengths.
+ */
+struct detector {
+    uint8_t kind;
+    bool active;
+    float on;
+    float off;
+    float value;            // last value of the characteristic function
+    union {
+        struct sta_lta sta_lta;
+        struct energy_ratio er;
+    };
+};
+
+/**
+ * @brief detectors running over the same stream, combined by K-of-N voting
+ *
+ * A detector votes while it is active and for `coincidence` samples after it turned
+ * off, so detectors reacting with different delays still coincide. The bank
+ * triggers when at least `votes` detectors vote and releases when fewer do.
+ */
+struct detector_bank {
+    struct detector *detectors;
+    size_t count;
+    uint8_t votes;
+    uint32_t coincidence;
+    uint32_t last_vote[DETECTOR_BANK_MAX];  // samples since each detector last voted
+    bool active;
+};
+
+//  ========== prototypes ==================================================================
+void detector_init_sta_lta(struct detector *d, uint8_t mode, int16_t *history,
+                           size_t sta_len, size_t lta_len, float on, float off);
+
+/**
+ * @param history buffer of 2 * len samples
+ */
+void detector_init_energy_ratio(struct detector *d, int16_t *history, size_t len,
+                                float on, float off);
+void detector_init_mer(struct detector *d, int16_t *history, size_t len, float on, float off);
+void detector_init_threshold(struct detector *d, float on, float off);
+
+/**
+ * @brief feed one sample, update the characteristic function and the on/off state
+ *
+ * @return true while the detector is on
+ */
+bool detector_update(struct detector *d, int16_t sample);
+
+/**
+ * @param votes number of active detectors needed to trigger, 1 to count
+ * @param coincidence samples a detector keeps voting after it turned off
+ */
+int detector_bank_init(struct detector_bank *bank, struct detector *detectors, size_t count,
+                       uint8_t votes, uint32_t coincidence);
+
+/**
+ * @brief feed one sample to every detector of the bank
+ *
+ * @return true on the sample where the bank triggers, false otherwise
+ */
+bool detector_bank_update(struct detector_bank *bank, int16_t sample);
+
+#endif /* DETECTORS_H */
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "downlink.h"
+#include "app_ds3231.h"
+#include "config_codec.h"
+#include "data_types.h"
+#include "node_config.h"
+#include "uplink.h"
+#include "wave_index.h"
+
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(downlink);
+
+//  ========== globals =====================================================================
+K_THREAD_STACK_DEFINE(downlink_stack, 2048);
+struct k_thread downlink_thread_data;
+
+struct downlink_msg {
+    uint8_t len;
+    uint8_t data[DOWNLINK_MAX_SIZE];
+};
+
+K_MSGQ_DEFINE(downlink_msgq, sizeof(struct downlink_msg), DOWNLINK_QUEUE, 4);
+
+//  ========== downlink_receive ============================================================
+void downlink_receive(uint8_t port, const uint8_t *data, uint8_t len)
+{
+    struct downlink_msg msg;
+
+    if (port != DOWNLINK_PORT || len == 0) {
+        return;
+    }
+    if (len > sizeof(msg.data)) {
+        LOG_WRN("downlink of %u bytes ignored", len);
+        return;
+    }
+    msg.len = len;
+    memcpy(msg.data, data, len);
+    if (k_msgq_put(&downlink_msgq, &msg, K_NO_WAIT) != 0) {
+        LOG_WRN("downlink queue full, command 0x%02x dropped", data[0]);
+    }
+}
+
+//  ========== window ======================================================================
+static int add_range(const struct wave_index_range *range, void *user)
+{
+    struct window_payload_t *payload = user;
+
+    if (payload->ranges < WINDOW_PAYLOAD_RANGES) {
+        payload->range[payload->ranges] = (struct window_range_t) {
+            .file = (uint16_t)range->file,
+            .offset = range->offset,
+            .size = range->size,
+        };
+    }
+    payload->ranges++;
+    payload->blocks += range->blocks;
+    payload->samples += range->samples;
+    return 0;
+}
+
+static void window(const uint8_t *args, size_t size)
+{
+    struct window_payload_t payload = { 0 };
+
+    if (size < sizeof(uint32_t) + sizeof(uint16_t)) {
+        LOG_WRN("window request of %u bytes", (unsigned int)size);
+        return;
+    }
+    payload.from = sys_get_le32(&args[0]);
+    payload.duration = sys_get_le16(&args[4]);
+
+    uint64_t from_ms = (uint64_t)payload.from * MSEC_PER_SEC;
+    int rc = wave_index_query(from_ms, from_ms + (uint64_t)payload.duration * MSEC_PER_SEC,
+                              add_range, &payload);
+    if (rc < 0) {
+        LOG_WRN("window query failed. error: %d", rc);
+    }
+    LOG_INF("window %u + %u s: %u ranges, %u samples", payload.from, payload.duration,
+            payload.ranges, payload.samples);
+    uplink_enqueue(WINDOW, app_get_timestamp(), &payload, sizeof(payload), K_NO_WAIT);
+}
+
+//  ========== config ======================================================================
+// answer with the configuration in effect after the request
+static void config_reply(int status, uint8_t param)
+{
+    struct config_payload_t payload = {
+        .status = (int8_t)status,
+        .param = param,
+    };
+
+    node_config_get(&payload.config);
+    uplink_enqueue(CONFIG, app_get_timestamp(), &payload, sizeof(payload), K_NO_WAIT);
+}
+
+static void config_set(const uint8_t *args, size_t size)
+{
+    struct node_config_t config;
+    uint8_t param;
+
+    // the parameters change a copy, nothing applies unless all of them are valid
+    node_config_get(&config);
+    int rc = config_parse(args, size, &config, &param);
+    bool parsed = (rc == 0);
+    if (parsed) {
+        rc = node_config_set(&config, &param);
+    }
+    if (rc == 0) {
+        LOG_INF("configuration applied");
+    } else if (parsed && param == 0) {
+        // passed the check, no parameter at fault: it applied, only saving it failed
+        LOG_WRN("configuration applied but not saved. error: %d", rc);
+    } else {
+        LOG_WRN("configuration refused, parameter 0x%02x. error: %d", param, rc);
+    }
+    config_reply(rc, param);
+}
+
+//  ========== downlink_handle =============================================================
+void downlink_handle(const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    switch (data[0]) {
+    case DOWNLINK_WINDOW:
+        window(&data[1], len - 1);
+        break;
+    case DOWNLINK_CONFIG_SET:
+        config_set(&data[1], len - 1);
+        break;
+    case DOWNLINK_CONFIG_GET:
+        config_reply(0, 0);
+        break;
+    case DOWNLINK_CONFIG_RESET:
+        config_reply(node_config_reset(), 0);
+        break;
+    default:
+        LOG_WRN("unknown downlink command 0x%02x", data[0]);
+        break;
+    }
+}
+
+//  ========== downlink_thread =============================================================
+static void downlink_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct downlink_msg msg;
+
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+    while (1) {
+        k_msgq_get(&downlink_msgq, &msg, K_FOREVER);
+        downlink_handle(msg.data, msg.len);
+    }
+}
+
+//  ========== downlink_start ==============================================================
+void downlink_start(void)
+{
+    k_thread_create(&downlink_thread_data, downlink_stack,
+                    K_THREAD_STACK_SIZEOF(downlink_stack),
+                    downlink_thread, NULL, NULL, NULL,
+                    PRIORITY_DOWNLINK, 0, K_NO_WAIT);
+    k_thread_name_set(&downlink_thread_data, "downlink");
+}
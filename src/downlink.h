@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+/*
+ * Requests sent to the node as LoRaWAN downlinks on DOWNLINK_PORT.
+ *
+ * The first byte of the payload is the command, its arguments follow, little-endian:
+ *   DOWNLINK_WINDOW   u32 start (unix s), u16 duration (s)
+ *                     answered by a WINDOW uplink record (see data_types.h): the parts
+ *                     of the geophone files recorded in that window, from the time index
+ *                     (see wave_index.h), to fetch with download_data.py --window
+ *   DOWNLINK_CONFIG_SET  list of parameters, see config_codec.h
+ *                     applied and saved as a whole, or refused as a whole (see node_config.h)
+ *   DOWNLINK_CONFIG_GET  no argument
+ *   DOWNLINK_CONFIG_RESET  no argument, back to the compile-time configuration
+ *                     the three are answered by a CONFIG uplink record (see data_types.h):
+ *                     the status, the parameter refused and the configuration in effect
+ *
+ * downlink_encoder.py builds the payloads.
+ *
+ * The LoRaWAN stack hands the downlinks over from its own context, they are queued and
+ * handled by the downlink thread.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+#define DOWNLINK_PORT               3
+
+// largest downlink kept (EU868 DR0 to DR2), and requests waiting for the thread
+#define DOWNLINK_MAX_SIZE           51
+#define DOWNLINK_QUEUE              4
+
+#define PRIORITY_DOWNLINK           7
+
+//  ========== types =======================================================================
+enum downlink_command {
+    DOWNLINK_WINDOW = 0x01,
+    DOWNLINK_CONFIG_SET = 0x02,
+    DOWNLINK_CONFIG_GET = 0x03,
+    DOWNLINK_CONFIG_RESET = 0x04,
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start the thread handling the requests
+ */
+void downlink_start(void);
+
+/**
+ * @brief queue a downlink received on `port`, never blocks
+ *
+ * Called from the downlink callback of the LoRaWAN stack, the other ports are ignored.
+ */
+void downlink_receive(uint8_t port, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief handle one request in the calling thread and queue its answer
+ *
+ * The downlink thread calls it for each queued downlink, the host tests directly.
+ */
+void downlink_handle(const uint8_t *data, size_t len);
+
+#endif /* DOWNLINK_H */
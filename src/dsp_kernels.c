@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "dsp_kernels.h"
+
+#include <string.h>
+
+#if DSP_KERNELS_SIMD
+#include <cmsis_core.h>
+
+//  ========== read_q15x2 ==================================================================
+// load two consecutive samples in one word (unaligned loads are fine on Cortex-M4)
+static inline uint32_t read_q15x2(const int16_t *p)
+{
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+//  ========== pack_q15x2 ==================================================================
+static inline uint32_t pack_q15x2(int16_t v)
+{
+    return ((uint32_t)(uint16_t)v << 16) | (uint16_t)v;
+}
+
+//  ========== max_q15x2 / min_q15x2 =======================================================
+// SSUB16 sets the GE flags per half, SEL picks the half of its first operand where it is
+// set. The flags are not an operand the compiler knows of: the two instructions are one
+// asm statement, so that nothing (another SSUB16 of the loop) is scheduled in between.
+static inline uint32_t max_q15x2(uint32_t a, uint32_t b)
+{
+    uint32_t r;
+#if defined(__arm__)
+    __asm__("ssub16 %0, %1, %2\n\t"
+            "sel %0, %1, %2"
+            : "=&r"(r) : "r"(a), "r"(b) : "cc");
+#else
+    // host check of this path on emulated intrinsics (tools/tests), run in order
+    (void)__SSUB16(a, b);
+    r = __SEL(a, b);
+#endif
+    return r;
+}
+
+static inline uint32_t min_q15x2(uint32_t a, uint32_t b)
+{
+    uint32_t r;
+#if defined(__arm__)
+    __asm__("ssub16 %0, %2, %1\n\t"
+            "sel %0, %1, %2"
+            : "=&r"(r) : "r"(a), "r"(b) : "cc");
+#else
+    (void)__SSUB16(b, a);
+    r = __SEL(a, b);
+#endif
+    return r;
+}
+#endif
+
+//  ========== sat_q15 =====================================================================
+static inline int32_t sat_q15(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return v;
+}
+
+//  ========== dsp_sum_q15 =================================================================
+int32_t dsp_sum_q15(const int16_t *x, size_t n)
+{
+    int32_t sum = 0;
+    size_t i = 0;
+
+#if DSP_KERNELS_SIMD
+    // lo * 1 + hi * 1 + acc
+    for (; i + 1 < n; i += 2) {
+        sum = (int32_t)__SMLAD(read_q15x2(&x[i]), 0x00010001u, (uint32_t)sum);
+    }
+#endif
+    for (; i < n; i++) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+//  ========== dsp_sum_sq_q15 ==============================================================
+uint64_t dsp_sum_sq_q15(const int16_t *x, size_t n, int16_t offset)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+
+#if DSP_KERNELS_SIMD
+    uint32_t off = pack_q15x2(offset);
+    int64_t acc = 0;
+    for (; i + 1 < n; i += 2) {
+        // saturated (x - offset) on both halves, then lo*lo + hi*hi into 64 bits
+        uint32_t d = __QSUB16(read_q15x2(&x[i]), off);
+        acc = (int64_t)__SMLALD(d, d, (uint64_t)acc);
+    }
+    sum = (uint64_t)acc;
+#endif
+    for (; i < n; i++) {
+        int32_t d = sat_q15((int32_t)x[i] - offset);
+        sum += (uint32_t)(d * d);
+    }
+    return sum;
+}
+
+//  ========== dsp_min_max_q15 =============================================================
+void dsp_min_max_q15(const int16_t *x, size_t n, int16_t *min, int16_t *max)
+{
+    int16_t lo = x[0];
+    int16_t hi = x[0];
+    size_t i = 0;
+
+#if DSP_KERNELS_SIMD
+    if (n >= 2) {
+        uint32_t vmin = read_q15x2(&x[0]);
+        uint32_t vmax = vmin;
+        for (i = 2; i + 1 < n; i += 2) {
+            uint32_t v = read_q15x2(&x[i]);
+            vmax = max_q15x2(v, vmax);
+            vmin = min_q15x2(v, vmin);
+        }
+        int16_t min0 = (int16_t)vmin, min1 = (int16_t)(vmin >> 16);
+        int16_t max0 = (int16_t)vmax, max1 = (int16_t)(vmax >> 16);
+        lo = (min0 < min1) ? min0 : min1;
+        hi = (max0 > max1) ? max0 : max1;
+    }
+#endif
+    for (; i < n; i++) {
+        if (x[i] < lo) {
+            lo = x[i];
+        }
+        if (x[i] > hi) {
+            hi = x[i];
+        }
+    }
+    *min = lo;
+    *max = hi;
+}
+
+//  ========== dsp_mean_q15 ================================================================
+int16_t dsp_mean_q15(const int16_t *x, size_t n)
+{
+    if (n == 0) {
+        return 0;
+    }
+
+    int32_t sum = dsp_sum_q15(x, n);
+    int32_t half = (int32_t)(n / 2);
+    return (int16_t)((sum >= 0 ? sum + half : sum - half) / (int32_t)n);
+}
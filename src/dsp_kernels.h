@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stddef.h>
+
+//  ========== defines =====================================================================
+// set when the kernels use the Cortex-M4 SIMD instructions (SMLAD, SMLALD, SSUB16, SEL).
+// The host tests set it to check that path on emulated intrinsics.
+#if defined(DSP_KERNELS_SIMD)
+#elif defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define DSP_KERNELS_SIMD            1
+#else
+#define DSP_KERNELS_SIMD            0
+#endif
+
+//  ========== prototypes ==================================================================
+// fixed-point kernels over Q15 (int16) samples, two samples per instruction on Cortex-M4
+// and a portable C version everywhere else (native_sim, host tools). Both give the same
+// results bit for bit.
+
+/**
+ * @brief sum of the samples
+ */
+int32_t dsp_sum_q15(const int16_t *x, size_t n);
+
+/**
+ * @brief sum of (x - offset)^2, with (x - offset) saturated to the Q15 range
+ */
+uint64_t dsp_sum_sq_q15(const int16_t *x, size_t n, int16_t offset);
+
+/**
+ * @brief minimum and maximum of the samples, n must be at least 1
+ */
+void dsp_min_max_q15(const int16_t *x, size_t n, int16_t *min, int16_t *max);
+
+/**
+ * @brief mean of the samples rounded to the nearest integer, 0 if n is 0
+ */
+int16_t dsp_mean_q15(const int16_t *x, size_t n);
+
+#endif /* DSP_KERNELS_H */
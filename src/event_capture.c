@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "event_capture.h"
+#include "app_sta_lta_tx.h"
+#include "health.h"
+#include "node_config.h"
+#include "config_codec.h"
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(event_capture);
+
+//  ========== globals =====================================================================
+BUILD_ASSERT(EVENT_SAMPLES + ADC_BLOCK_SIZE < ADC_BUFFER_SIZE,
+             "the ADC ring must hold a whole event");
+BUILD_ASSERT(PARAM_STA_MAX_SAMPLES <=
+                 EVENT_SAMPLES * EVENT_PRE_TRIGGER_MS / (EVENT_PRE_TRIGGER_MS + EVENT_POST_TRIGGER_MS) + 1,
+             "the STA window sent with an event must be in its capture");
+
+// fixed pool of event slots
+static struct event_slot slots[EVENT_SLOTS];
+
+// protects the state of the slots
+static struct k_spinlock slots_lock;
+
+static uint16_t next_id;
+static atomic_t lost_events = ATOMIC_INIT(0);
+
+//  ========== set_geometry ================================================================
+// samples kept before and after the trigger at a sampling period, within the slot
+static void set_geometry(struct event_slot *slot, uint32_t rate_ms)
+{
+    uint32_t pre = EVENT_PRE_TRIGGER_MS / rate_ms;
+    uint32_t post = EVENT_POST_TRIGGER_MS / rate_ms;
+
+    // faster than the default, the capture is shorter than the configured times
+    if (pre + post > EVENT_SAMPLES) {
+        pre = EVENT_SAMPLES * EVENT_PRE_TRIGGER_MS / (EVENT_PRE_TRIGGER_MS + EVENT_POST_TRIGGER_MS);
+        post = EVENT_SAMPLES - pre;
+    }
+    // slower, the pre-trigger part still holds the longest STA window sent with the event
+    pre = MAX(pre, PARAM_STA_MAX_SAMPLES - 1);
+    post = MIN(post, EVENT_SAMPLES - pre);
+
+    slot->pre_samples = (uint16_t)pre;
+    slot->post_samples = (uint16_t)post;
+}
+
+//  ========== event_capture_start =========================================================
+struct event_slot *event_capture_start(uint32_t trigger_index, uint64_t timestamp_us)
+{
+    struct event_slot *slot = NULL;
+    uint32_t rate_ms = app_adc_get_sampling_rate();
+    k_spinlock_key_t key = k_spin_lock(&slots_lock);
+
+    for (int i = 0; i < EVENT_SLOTS; i++) {
+        if (slots[i].state == EVENT_FREE) {
+            slot = &slots[i];
+            slot->state = EVENT_CAPTURING;
+            slot->id = next_id++;
+            slot->trigger_index = trigger_index;
+            slot->timestamp_us = timestamp_us;
+            set_geometry(slot, rate_ms);
+            break;
+        }
+    }
+    k_spin_unlock(&slots_lock, key);
+
+    if (slot == NULL) {
+        atomic_inc(&lost_events);
+        LOG_ERR("no free event slot, event lost");
+    }
+    return slot;
+}
+
+//  ========== event_capture_poll ==========================================================
+void event_capture_poll(uint32_t head)
+{
+    for (int i = 0; i < EVENT_SLOTS; i++) {
+        struct event_slot *slot = &slots[i];
+
+        if (slot->state != EVENT_CAPTURING ||
+            (int32_t)(head - (slot->trigger_index + 1 + slot->post_samples)) < 0) {
+            continue;
+        }
+
+        size_t count = slot->pre_samples + slot->post_samples;
+        int err = app_adc_read(slot->samples, count, slot->trigger_index - slot->pre_samples);
+        if (err != 0) {
+            LOG_ERR("event %u capture failed. error: %d", slot->id, err);
+            slot->state = EVENT_FREE;
+            atomic_inc(&lost_events);
+            continue;
+        }
+
+        // sampling period from the time tags of the first and last samples, nominal without them
+        uint32_t first = slot->trigger_index - slot->pre_samples;
+        uint64_t first_us, last_us;
+        slot->period_ns = app_adc_get_sampling_rate() * NSEC_PER_MSEC;
+        if (app_adc_get_sample_time(first, &first_us) == 0 &&
+            app_adc_get_sample_time(first + count - 1, &last_us) == 0) {
+            slot->period_ns = (uint32_t)((last_us - first_us) * NSEC_PER_USEC / (count - 1));
+        }
+
+        // one reference per consumer, taken before the slot is published
+        struct node_config_t config;
+        node_config_get(&config);
+        int consumers = (STORAGE_ENABLE != 0) + (config.send_samples != 0);
+        if (consumers == 0) {
+            slot->state = EVENT_FREE;
+            continue;
+        }
+        atomic_set(&slot->refs, consumers);
+        slot->state = EVENT_READY;
+        LOG_INF("event %u captured", slot->id);
+
+        storage_event_t storage_evt = { .slot = i };
+        if (STORAGE_ENABLE != 0) {
+            if (k_msgq_put(&storage_msgq, &storage_evt, K_NO_WAIT) != 0) {
+                LOG_ERR("storage queue full, event %u not stored", slot->id);
+                atomic_inc(&lost_events);
+                event_capture_release(slot);
+            } else {
+                health_queue_level(HEALTH_QUEUE_STORAGE, &storage_msgq);
+            }
+        }
+
+        lta_event_t lora_evt = { .kind = LTA_EVENT_WAVEFORM, .slot = i };
+        if (config.send_samples != 0) {
+            if (k_msgq_put(&lorawan_msgq, &lora_evt, K_NO_WAIT) != 0) {
+                LOG_ERR("LoRaWAN queue full, event %u samples not sent", slot->id);
+                atomic_inc(&lost_events);
+                event_capture_release(slot);
+            } else {
+                health_queue_level(HEALTH_QUEUE_EVENTS, &lorawan_msgq);
+            }
+        }
+    }
+}
+
+//  ========== event_capture_release =======================================================
+void event_capture_release(struct event_slot *slot)
+{
+    if (atomic_dec(&slot->refs) == 1) {
+        slot->state = EVENT_FREE;
+    }
+}
+
+//  ========== event_capture_get ===========================================================
+struct event_slot *event_capture_get(uint8_t index)
+{
+    return (index < EVENT_SLOTS) ? &slots[index] : NULL;
+}
+
+//  ========== event_capture_index =========================================================
+uint8_t event_capture_index(const struct event_slot *slot)
+{
+    return (uint8_t)(slot - slots);
+}
+
+//  ========== event_capture_set_next_id ===================================================
+void event_capture_set_next_id(uint16_t id)
+{
+    k_spinlock_key_t key = k_spin_lock(&slots_lock);
+    next_id = id;
+    k_spin_unlock(&slots_lock, key);
+}
+
+//  ========== event_capture_get_lost ======================================================
+uint32_t event_capture_get_lost(void)
+{
+    return (uint32_t)atomic_get(&lost_events);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_adc.h"
+
+//  ========== defines =====================================================================
+// signal kept around a trigger
+#define EVENT_PRE_TRIGGER_MS        5000
+#define EVENT_POST_TRIGGER_MS       20000
+
+// samples of a slot, the whole capture at the default sampling period. At the period set
+// by a downlink, both parts are counted again and shrink to the slot in the same proportion.
+#define EVENT_SAMPLES               ((EVENT_PRE_TRIGGER_MS + EVENT_POST_TRIGGER_MS) / SAMPLING_RATE_MS)
+
+// number of events that can be captured, stored and sent at the same time
+#define EVENT_SLOTS                 3
+
+// event files kept on the flash, the older ones are deleted
+#define EVENT_FILES_KEPT            100
+#define EVENT_FILE_PREFIX           "/lfs/event"
+
+//  ========== types =======================================================================
+enum event_state {
+    EVENT_FREE = 0,
+    EVENT_CAPTURING,        // waiting for the post-trigger samples
+    EVENT_READY,            // samples copied, being stored and/or sent
+};
+
+/**
+ * @brief one captured event, from pre_samples before the trigger to post_samples
+ * after it, counted at the sampling period of the trigger. The trigger sample is
+ * samples[pre_samples].
+ *
+ * Once READY, the samples do not change until every consumer released the slot.
+ */
+struct event_slot {
+    uint8_t state;
+    atomic_t refs;
+    uint16_t id;
+    uint32_t trigger_index;     // absolute ADC sample index of the trigger
+    uint64_t timestamp_us;      // time of the trigger sample
+    uint32_t period_ns;         // measured sampling period over the capture
+    uint16_t pre_samples;
+    uint16_t post_samples;
+    int16_t samples[EVENT_SAMPLES];
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start capturing an event around the trigger sample
+ *
+ * @return the event slot, NULL if every slot is in use (the event is counted as lost)
+ */
+struct event_slot *event_capture_start(uint32_t trigger_index, uint64_t timestamp_us);
+
+/**
+ * @brief complete the captures whose post-trigger window is in the ADC ring
+ *
+ * Completed events are handed to the storage thread (storage_msgq) and to the
+ * LoRaWAN thread (lorawan_msgq), each holding a reference on the slot.
+ * To be called by the detection thread after processing new samples.
+ */
+void event_capture_poll(uint32_t head);
+
+/**
+ * @brief give back a reference on a READY slot, the slot is freed with the last one
+ */
+void event_capture_release(struct event_slot *slot);
+
+/**
+ * @brief slot of a given index in the pool, used to pass slots through message queues
+ */
+struct event_slot *event_capture_get(uint8_t index);
+uint8_t event_capture_index(const struct event_slot *slot);
+
+/**
+ * @brief continue event numbering after the events already stored
+ */
+void event_capture_set_next_id(uint16_t id);
+
+/**
+ * @brief number of events lost because no slot was free, or not handed to the
+ *        recorder or the uplink because their queue was full
+ */
+uint32_t event_capture_get_lost(void);
+
+#endif /* EVENT_CAPTURE_H */
@@ -6,6 +6,7 @@
  */
 #include "fs_utils.h"
 #include <zephyr/sys/base64.h>
+#include <string.h>
 
 #include "config.h" // for log level
 #include <zephyr/logging/log.h>
@@ -83,7 +84,8 @@ void dump_fs(bool clean)
         snprintf(file_path, sizeof(file_path), "%s%s", "/lfs/", dir_entry.name);
 
         dump_file(file_path);
-        if(clean) {
+        // the uplink log is in use, the uplink scheduler deletes it once it is sent
+        if(clean && strncmp(dir_entry.name, UPLINK_LOG_PREFIX, strlen(UPLINK_LOG_PREFIX)) != 0) {
             rc = fs_unlink(file_path);
             if (rc < 0)
             {
@@ -12,10 +12,25 @@
 #include <zephyr/fs/littlefs.h>
 
 //  ========== defines =====================================================================
+#define LFS_MOUNT_POINT         "/lfs"
 #define FILE_PREFIX             "/lfs/geophone"
 #define FILE_EXT                ".dat"
-#define MAX_FILE_SIZE           (64 * 1024)   // 512 KB per file (adjustable)
-#define STORAGE_BUFFER_SIZE     64
+// time index of each geophone file, next to it (see wave_index.h)
+#define INDEX_EXT               ".idx"
+#define MAX_FILE_SIZE           (64 * 1024)   // 64 KB per file (adjustable)
+
+// store-and-forward log of the uplinks and its acknowledgements, see uplink_log.h
+#define UPLINK_LOG_PREFIX       "uplink"
+#define UPLINK_LOG_PATH         "/lfs/uplink.log"
+#define UPLINK_LOG_ACK_PATH     "/lfs/uplink.ack"
+#define UPLINK_LOG_TMP_PATH     "/lfs/uplink.tmp"
+
+// the recorder writes whole MX25R64 erase sectors (4 KB = 16 pages of 256 bytes)
+#define STORAGE_BUFFER_SIZE     4096
+// number of buffers written between two fs_sync() calls
+#define STORAGE_SYNC_BLOCKS     4
+// free space kept on the partition, the oldest files are deleted below it
+#define STORAGE_MIN_FREE        (2 * MAX_FILE_SIZE)
 
 //  ========== prototypes ==================================================================
 /**
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "health.h"
+#include "data_types.h"
+#include "app_adc.h"
+#include "app_ds3231.h"
+#include "app_sta_lta_tx.h"
+#include "app_storage.h"
+#include "event_capture.h"
+#include "uplink.h"
+
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(health);
+
+//  ========== globals =====================================================================
+BUILD_ASSERT(HEALTH_THREADS == HEALTH_PAYLOAD_THREADS, "health record and threads differ");
+BUILD_ASSERT(HEALTH_QUEUES == HEALTH_PAYLOAD_QUEUES, "health record and queues differ");
+
+K_THREAD_STACK_DEFINE(health_stack, 1536);
+struct k_thread health_thread_data;
+
+static const char *const thread_names[HEALTH_THREADS] = {
+    [HEALTH_THREAD_ADC] = "adc",
+    [HEALTH_THREAD_DETECT] = "detect",
+    [HEALTH_THREAD_EVENTS] = "events",
+    [HEALTH_THREAD_UPLINK] = "uplink",
+    [HEALTH_THREAD_STORAGE] = "storage",
+    [HEALTH_THREAD_SPECTRAL] = "spectral",
+    [HEALTH_THREAD_PERIODIC] = "periodic",
+    [HEALTH_THREAD_BTH] = "bth",
+    [HEALTH_THREAD_RTC] = "rtc",
+};
+
+static const char *const queue_names[HEALTH_QUEUES] = {
+    [HEALTH_QUEUE_EVENTS] = "events",
+    [HEALTH_QUEUE_STORAGE] = "storage",
+    [HEALTH_QUEUE_ANOMALY] = "anomaly",
+    [HEALTH_QUEUE_BTH] = "bth",
+    [HEALTH_QUEUE_PERIODIC] = "periodic",
+    [HEALTH_QUEUE_WAVEFORM] = "waveform",
+};
+
+static const char *const lock_names[HEALTH_LOCKS] = {
+    [HEALTH_LOCK_CLOCK] = "clock",
+    [HEALTH_LOCK_SPECTRAL] = "spectral",
+    [HEALTH_LOCK_STATS] = "stats",
+};
+
+static k_tid_t threads[HEALTH_THREADS];
+
+// figures of the current period, reset by each health record
+struct lock_stats {
+    uint32_t count;
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+};
+
+static struct k_spinlock period_lock;
+static struct lock_stats locks[HEALTH_LOCKS];
+static uint32_t histogram[HEALTH_HIST_BUCKETS];
+static uint32_t latency_max_us;
+static uint8_t queue_peak[HEALTH_QUEUES];
+
+// runtime counters at the start of the period
+static uint64_t period_thread_cycles[HEALTH_THREADS];
+static uint64_t period_all_cycles;
+static uint64_t period_busy_cycles;
+
+//  ========== health_register_thread ======================================================
+void health_register_thread(enum health_thread id, k_tid_t tid)
+{
+    k_thread_name_set(tid, thread_names[id]);
+    threads[id] = tid;
+
+    k_thread_runtime_stats_t stats;
+    if (k_thread_runtime_stats_get(tid, &stats) == 0) {
+        period_thread_cycles[id] = stats.execution_cycles;
+    }
+}
+
+//  ========== health_queue_level ==========================================================
+void health_queue_level(enum health_queue id, struct k_msgq *msgq)
+{
+    uint32_t used = k_msgq_num_used_get(msgq);
+
+    k_spinlock_key_t key = k_spin_lock(&period_lock);
+    queue_peak[id] = MAX(queue_peak[id], MIN(used, UINT8_MAX));
+    k_spin_unlock(&period_lock, key);
+}
+
+//  ========== health_mutex_lock ===========================================================
+int health_mutex_lock(struct k_mutex *mutex, enum health_lock id, k_timeout_t timeout)
+{
+    uint32_t start = k_cycle_get_32();
+    int ret = k_mutex_lock(mutex, timeout);
+    uint32_t wait = k_cycle_get_32() - start;
+
+    k_spinlock_key_t key = k_spin_lock(&period_lock);
+    locks[id].count++;
+    locks[id].total_cycles += wait;
+    locks[id].max_cycles = MAX(locks[id].max_cycles, wait);
+    k_spin_unlock(&period_lock, key);
+    return ret;
+}
+
+//  ========== health_detect_latency =======================================================
+void health_detect_latency(uint32_t latency_us)
+{
+    uint32_t v = latency_us >> HEALTH_HIST_SHIFT;
+    size_t bucket = 0;
+
+    while (v != 0 && bucket < HEALTH_HIST_BUCKETS - 1) {
+        v >>= 1;
+        bucket++;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&period_lock);
+    histogram[bucket]++;
+    latency_max_us = MAX(latency_max_us, latency_us);
+    k_spin_unlock(&period_lock, key);
+}
+
+//  ========== to_10us =====================================================================
+static uint16_t to_10us(uint64_t us)
+{
+    return (uint16_t)MIN(us / 10, UINT16_MAX);
+}
+
+//  ========== latency_p99_us ==============================================================
+// upper bound of the bucket holding the 99th percentile, 0 without any latency
+static uint32_t latency_p99_us(const uint32_t *hist)
+{
+    uint64_t total = 0, seen = 0;
+
+    for (size_t i = 0; i < HEALTH_HIST_BUCKETS; i++) {
+        total += hist[i];
+    }
+    for (size_t i = 0; i < HEALTH_HIST_BUCKETS && total != 0; i++) {
+        seen += hist[i];
+        if (seen * 100 >= total * 99) {
+            return 1U << (i + HEALTH_HIST_SHIFT);
+        }
+    }
+    return 0;
+}
+
+//  ========== health_collect ==============================================================
+// fill a record with the current period, which restarts if reset is set
+static void health_collect(struct health_payload_t *p, bool reset)
+{
+    k_thread_runtime_stats_t all;
+    uint64_t all_cycles = 0, busy_cycles = 0;
+
+    memset(p, 0, sizeof(*p));
+    p->uptime = (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+    p->adc_overruns = (uint16_t)MIN(app_adc_get_overruns(), UINT16_MAX);
+    p->lost_samples = (uint16_t)MIN(app_storage_get_lost() + app_sta_lta_get_lost(), UINT16_MAX);
+    p->dropped = (uint16_t)MIN(uplink_get_dropped() + event_capture_get_lost() +
+                               app_sta_lta_get_dropped(), UINT16_MAX);
+
+    if (k_thread_runtime_stats_all_get(&all) == 0) {
+        all_cycles = all.execution_cycles - period_all_cycles;
+        busy_cycles = all.total_cycles - period_busy_cycles;
+        if (all_cycles != 0) {
+            p->cpu_load = (uint16_t)(busy_cycles * 1000 / all_cycles);
+        }
+    }
+
+    for (size_t i = 0; i < HEALTH_THREADS; i++) {
+        k_thread_runtime_stats_t stats;
+        size_t unused;
+
+        if (threads[i] == NULL) {
+            continue;
+        }
+        if (k_thread_runtime_stats_get(threads[i], &stats) == 0 && all_cycles != 0) {
+            uint64_t cycles = stats.execution_cycles - period_thread_cycles[i];
+            p->thread_cpu[i] = (uint8_t)MIN(cycles * 200 / all_cycles, UINT8_MAX);
+            if (reset) {
+                period_thread_cycles[i] = stats.execution_cycles;
+            }
+        }
+        if (k_thread_stack_space_get(threads[i], &unused) == 0) {
+            size_t size = threads[i]->stack_info.size;
+            p->thread_stack[i] = (uint8_t)((size - unused) * 100 / size);
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&period_lock);
+    uint32_t lock_max = 0;
+    for (size_t i = 0; i < HEALTH_LOCKS; i++) {
+        lock_max = MAX(lock_max, locks[i].max_cycles);
+    }
+    p->lock_wait_max = to_10us(k_cyc_to_us_ceil64(lock_max));
+    p->latency_p99 = to_10us(latency_p99_us(histogram));
+    p->latency_max = to_10us(latency_max_us);
+    memcpy(p->queue_peak, queue_peak, sizeof(queue_peak));
+    if (reset) {
+        memset(locks, 0, sizeof(locks));
+        memset(histogram, 0, sizeof(histogram));
+        memset(queue_peak, 0, sizeof(queue_peak));
+        latency_max_us = 0;
+        period_all_cycles += all_cycles;
+        period_busy_cycles += busy_cycles;
+    }
+    k_spin_unlock(&period_lock, key);
+}
+
+//  ========== health_thread ===============================================================
+static void health_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct health_payload_t payload;
+
+    while (1) {
+        k_sleep(HEALTH_PERIOD);
+
+        health_collect(&payload, true);
+        LOG_INF("cpu %u.%u %%, %u overruns, %u lost samples, %u dropped",
+                payload.cpu_load / 10, payload.cpu_load % 10, payload.adc_overruns,
+                payload.lost_samples, payload.dropped);
+        uplink_enqueue(HEALTH, app_get_timestamp(), &payload, sizeof(payload), K_NO_WAIT);
+    }
+}
+
+//  ========== health_start ================================================================
+void health_start(void)
+{
+    k_thread_create(&health_thread_data, health_stack,
+                    K_THREAD_STACK_SIZEOF(health_stack),
+                    health_thread, NULL, NULL, NULL,
+                    PRIORITY_HEALTH, 0, K_NO_WAIT);
+    k_thread_name_set(&health_thread_data, "health");
+}
+
+//  ========== health_dump =================================================================
+// figures of the period so far, the next health record still covers the whole period
+void health_dump(void)
+{
+    struct health_payload_t p;
+    struct lock_stats lock_copy[HEALTH_LOCKS];
+    uint32_t hist_copy[HEALTH_HIST_BUCKETS];
+
+    health_collect(&p, false);
+    k_spinlock_key_t key = k_spin_lock(&period_lock);
+    memcpy(lock_copy, locks, sizeof(locks));
+    memcpy(hist_copy, histogram, sizeof(histogram));
+    k_spin_unlock(&period_lock, key);
+
+    printk("HEALTH uptime %u s, cpu %u.%u %%\n", p.uptime, p.cpu_load / 10, p.cpu_load % 10);
+    printk("counters: adc overruns %u, lost samples %u, dropped %u\n",
+           p.adc_overruns, p.lost_samples, p.dropped);
+
+    for (size_t i = 0; i < HEALTH_THREADS; i++) {
+        if (threads[i] == NULL) {
+            continue;
+        }
+        printk("thread %-9s prio %2d cpu %3u.%u %% stack %3u %% of %u\n", thread_names[i],
+               k_thread_priority_get(threads[i]), p.thread_cpu[i] / 2, (p.thread_cpu[i] % 2) * 5,
+               p.thread_stack[i], threads[i]->stack_info.size);
+    }
+    for (size_t i = 0; i < HEALTH_QUEUES; i++) {
+        printk("queue %-9s peak %u\n", queue_names[i], p.queue_peak[i]);
+    }
+    for (size_t i = 0; i < HEALTH_LOCKS; i++) {
+        uint32_t avg = lock_copy[i].count ? lock_copy[i].total_cycles / lock_copy[i].count : 0;
+        printk("lock %-9s %u waits, mean %u us, max %u us\n", lock_names[i], lock_copy[i].count,
+               k_cyc_to_us_ceil32(avg), k_cyc_to_us_ceil32(lock_copy[i].max_cycles));
+    }
+    printk("detector latency: p99 < %u us, max %u us\n", p.latency_p99 * 10, p.latency_max * 10);
+    for (size_t i = 0; i < HEALTH_HIST_BUCKETS; i++) {
+        if (i < HEALTH_HIST_BUCKETS - 1) {
+            printk("  < %6u us: %u\n", 1U << (i + HEALTH_HIST_SHIFT), hist_copy[i]);
+        } else {
+            printk("  >=%6u us: %u\n", 1U << (i - 1 + HEALTH_HIST_SHIFT), hist_copy[i]);
+        }
+    }
+    printk("HEALTH_END\n");
+}
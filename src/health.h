@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+/*
+ * Runtime instrumentation of the node.
+ *
+ * Collects the CPU share and stack high-water mark of each application thread, the
+ * peak occupancy of the message queues, the time spent waiting on the shared mutexes,
+ * the detector latency (from a block being acquired to it being processed) and the
+ * loss counters of the other modules. A HEALTH record summarising them is queued every
+ * HEALTH_PERIOD, and the "health" console command prints everything.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// detector latency histogram: bucket i counts latencies below 2^(i + HEALTH_HIST_SHIFT) us,
+// the last one everything above
+#define HEALTH_HIST_BUCKETS         12
+#define HEALTH_HIST_SHIFT           6
+
+#define PRIORITY_HEALTH             7   // below every processing thread
+
+//  ========== types =======================================================================
+// threads followed, in the order of the health record
+enum health_thread {
+    HEALTH_THREAD_ADC = 0,
+    HEALTH_THREAD_DETECT,
+    HEALTH_THREAD_EVENTS,
+    HEALTH_THREAD_UPLINK,
+    HEALTH_THREAD_STORAGE,
+    HEALTH_THREAD_SPECTRAL,
+    HEALTH_THREAD_PERIODIC,
+    HEALTH_THREAD_BTH,
+    HEALTH_THREAD_RTC,
+    HEALTH_THREADS,
+};
+
+enum health_queue {
+    HEALTH_QUEUE_EVENTS = 0,        // lorawan_msgq
+    HEALTH_QUEUE_STORAGE,           // storage_msgq
+    HEALTH_QUEUE_ANOMALY,           // uplink queues, by priority
+    HEALTH_QUEUE_BTH,
+    HEALTH_QUEUE_PERIODIC,
+    HEALTH_QUEUE_WAVEFORM,
+    HEALTH_QUEUES,
+};
+
+enum health_lock {
+    HEALTH_LOCK_CLOCK = 0,          // clock model, taken for every timestamp
+    HEALTH_LOCK_SPECTRAL,           // spectral features
+    HEALTH_LOCK_STATS,              // statistics engine of the periodic summary
+    HEALTH_LOCKS,
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief name a thread and follow its CPU time and stack usage
+ */
+void health_register_thread(enum health_thread id, k_tid_t tid);
+
+/**
+ * @brief record the occupancy of a queue after a message was put, keeps the peak
+ */
+void health_queue_level(enum health_queue id, struct k_msgq *msgq);
+
+/**
+ * @brief k_mutex_lock() keeping track of the time spent waiting for the mutex
+ */
+int health_mutex_lock(struct k_mutex *mutex, enum health_lock id, k_timeout_t timeout);
+
+/**
+ * @brief add a detector latency, in us, to the histogram
+ */
+void health_detect_latency(uint32_t latency_us);
+
+/**
+ * @brief start the thread queueing a HEALTH record every HEALTH_PERIOD
+ */
+void health_start(void);
+
+/**
+ * @brief print every counter, the per-thread figures and the latency histogram
+ */
+void health_dump(void);
+
+#endif /* HEALTH_H */
@@ -1,6 +1,7 @@
 #include "data_types.h"
 #include "lorawan.h"
 #include "app_ds3231.h"
+#include "downlink.h"
 
 #include "config.h" // for log level
 #include <zephyr/logging/log.h>
@@ -13,17 +14,24 @@ static void dl_callback(uint8_t port, uint8_t data_pending,
 			uint8_t len, const uint8_t *hex_data)
 {
 	LOG_INF("Port %d, Pending %d, RSSI %ddB, SNR %ddBm", port, data_pending, rssi, snr);
+	downlink_receive(port, hex_data, len);
 }
 
+// current uplink datarate, the slowest one until the stack reports it
+static enum lorawan_datarate current_dr = LORAWAN_DR_0;
+
 static void lorawan_datarate_changed(enum lorawan_datarate dr)
 {
+    current_dr = dr;
     uint8_t unused, max_size;
     lorawan_get_payload_sizes(&unused, &max_size);
     LOG_INF("new datarate: DR_%d, max payload %d", dr, max_size);
 }
 
 // initialize LoRaWAN protocol and register the device
-const struct device *lora_dev = NULL;
+// (no lora0 radio on native_sim, the loopback backend of src/sim stands in for the stack)
+static bool lora_started = false;
+static bool lora_joined = false;
 struct lorawan_join_config join_cfg;
 
 struct lorawan_downlink_cb downlink_cb = {
@@ -35,11 +43,13 @@ struct lorawan_downlink_cb downlink_cb = {
 /*** Initialize Lora chip, and register callbacks
  */
 int lora_init() {
-	lora_dev = DEVICE_DT_GET(DT_ALIAS(lora0));
-	if (!device_is_ready(lora_dev)) {
-		LOG_ERR("%s: device not ready", lora_dev->name);
+#if DT_NODE_EXISTS(DT_ALIAS(lora0))
+	const struct device *radio = DEVICE_DT_GET(DT_ALIAS(lora0));
+	if (!device_is_ready(radio)) {
+		LOG_ERR("%s: device not ready", radio->name);
 		return -1;
 	}
+#endif
 
 	int ret = lorawan_start();
 	if (ret < 0) {
@@ -49,6 +59,7 @@ int lora_init() {
 
 	lorawan_register_downlink_callback(&downlink_cb);
 	lorawan_register_dr_changed_callback(lorawan_datarate_changed);
+	lora_started = true;
 
     return 0;
 }
@@ -60,7 +71,7 @@ int lora_init() {
  *  Return 0 on success
  */
 int lora_joinnet() {
-    if(lora_dev == NULL) {
+    if(!lora_started) {
         if(lora_init()) {
             LOG_ERR("[ERROR] Could not initalize LoRa");
             return -1;
@@ -83,66 +94,94 @@ int lora_joinnet() {
 	if (ret < 0) {
 		LOG_ERR("lorawan_join_network failed. error %d", ret);
 	}
+    lora_joined = (ret == 0);
     
     return ret;
 }
 
+bool lora_is_joined(void) {
+    return lora_joined;
+}
+
+enum lorawan_datarate lora_get_datarate(void) {
+    return current_dr;
+}
+
 int lora_send_packet(PACKET_TYPE type, uint8_t * payload, int payload_size) {
     return lora_send_timestamp(type, app_get_timestamp(), payload, payload_size);
 }
 
 int lora_send_timestamp(PACKET_TYPE type, uint64_t timestamp, uint8_t * payload, int payload_size) {
-    if(lora_dev == NULL) {
-        if(lora_init()) {
-            LOG_ERR("[ERROR] Could not initalize LoRa");
-            return -1;
-        }
-        if(lora_joinnet()) {
-            LOG_ERR("[ERROR] Could not join LoRa network");
-            return -1;
-        }
-    }
     struct packet_t packet;
     packet.type = type;
     packet.timestamp = timestamp;
     const int header_size = sizeof(type) + sizeof(timestamp);
     
+    if(payload_size > PACKET_MAX_PAYLOAD) {
+        LOG_ERR("[ERROR] Trying to send more than %d bytes !", PACKET_MAX_PAYLOAD);
+        return -EINVAL;
+    }
+
     for(int i= 0; i< payload_size ; i++) {
         packet.payload[i] = payload[i];
     }
 
-    if(payload_size + header_size > 255) {
-        LOG_ERR("[ERROR] Trying to send more than 255 bytes !");
+    LOG_DBG("Packet Timestamp : %llu", packet.timestamp);
+    return lora_send_frame((uint8_t *) &packet, payload_size + header_size, false);
+}
+
+/*** Send an already built uplink, packet type first
+ *
+ *  Single attempt, retries and re-joins are up to the uplink scheduler.
+ *  A confirmed uplink only succeeds once the network acknowledged it.
+ *
+ *  Return 0 on success
+ */
+int lora_send_frame(const uint8_t * frame, int size, bool confirmed) {
+    if(!lora_started) {
+        if(lora_init()) {
+            LOG_ERR("[ERROR] Could not initalize LoRa");
+            return -1;
+        }
+        if(lora_joinnet()) {
+            LOG_ERR("[ERROR] Could not join LoRa network");
+            return -1;
+        }
     }
 
-    LOG_INF("Sending Payload of type : %d", type);
-    LOG_DBG("Size of packet %d", header_size + payload_size);
-    LOG_DBG("Packet Timestamp : %llu", packet.timestamp);
-    LOG_DBG("Timestamp hexa: %llx", packet.timestamp);
-    LOG_DBG("Size of packet-type : %d", sizeof(PACKET_TYPE));
+    LOG_INF("Sending Payload of type : %d", frame[0]);
+    LOG_DBG("Size of packet %d", size);
     LOG_DBG("Entire payload : ");
-
-    int8_t * p = ((int8_t *) (&packet));
-    for(int i = 0; i < payload_size + header_size; i++) {
-        LOG_DBG("%X ", (int8_t) *p);
-        p++;
+    for(int i = 0; i < size; i++) {
+        LOG_DBG("%X ", frame[i]);
     }
-    
 
-    int ret = -1;
-    while (ret != 0) {
-        ret = lorawan_send(LORAWAN_PORT, (int8_t *) &packet, payload_size + header_size, LORAWAN_MSG_UNCONFIRMED);
+    int ret = lorawan_send(LORAWAN_PORT, (uint8_t *) frame, size,
+                           confirmed ? LORAWAN_MSG_CONFIRMED : LORAWAN_MSG_UNCONFIRMED);
+    if (ret != 0) {
+        LOG_ERR("lorawan_send failed: %d", ret);
+    } else {
         LOG_INF("Message sent");
-        if (ret != 0) {
-            LOG_ERR("lorawan_send failed: %d", ret);
-            if(lora_joinnet()) {
-                LOG_ERR("Could not join LoRa network");
-            }
-            k_sleep(K_SECONDS(30)); 
-        }
-    
     }
-
-    // return ret == -EAGAIN ? 0 : ret;
     return ret;
-}
\ No newline at end of file
+}
+
+/*** Largest application payload of the next uplink at the current datarate
+ *
+ *  Pending MAC commands are already taken out by the stack
+ */
+size_t lora_get_max_payload(void) {
+    uint8_t max_next, max_size;
+    lorawan_get_payload_sizes(&max_next, &max_size);
+    return max_next;
+}
+
+/*** Largest application payload at the current datarate, without pending MAC commands
+ *
+ *  A larger frame cannot be sent until the datarate goes up
+ */
+size_t lora_get_datarate_max_payload(void) {
+    uint8_t max_next, max_size;
+    lorawan_get_payload_sizes(&max_next, &max_size);
+    return max_size;
+}
@@ -35,4 +35,9 @@ int lora_init();
 int lora_joinnet();
 int lora_send_packet(PACKET_TYPE type, uint8_t * payload, int payload_size);
 int lora_send_timestamp(PACKET_TYPE type, uint64_t timestamp, uint8_t * payload, int payload_size);
+int lora_send_frame(const uint8_t * frame, int size, bool confirmed);
+bool lora_is_joined(void);
+size_t lora_get_max_payload(void);
+size_t lora_get_datarate_max_payload(void);
+enum lorawan_datarate lora_get_datarate(void);
 #endif /* APP_LORAWAN_H */
\ No newline at end of file
@@ -9,11 +9,19 @@
 #include "app_adc.h"
 #include "config.h"
 #include "app_ds3231.h"
+#include "clock_discipline.h"
 #include "lorawan.h"
 #include "app_sensors.h"
 #include "periodic_samples.h"
 #include "app_sta_lta_tx.h"
 #include "fs_utils.h"
+#include "app_storage.h"
+#include "uplink.h"
+#include "downlink.h"
+#include "node_config.h"
+#include "app_spectral.h"
+#include "health.h"
+#include "app_console.h"
 
 #include <zephyr/sys/reboot.h>
 #include <zephyr/lorawan/lorawan.h>
@@ -28,11 +36,11 @@ K_SEM_DEFINE(init_done_sem, 0, 1);
 void rtc_thread_func(void)
 {
     k_sem_take(&init_done_sem, K_FOREVER);
-    const struct device *ds3231_dev = DEVICE_DT_GET_ONE(maxim_ds3231);
+    k_timeout_t wait = K_SECONDS(CLOCK_SYNC_MIN_S);
 
     while (true) {
-        k_sleep(K_SECONDS(30));                     // wait first, then sync
-        app_ds3231_periodic_sync(ds3231_dev);       // re-anchor offset to DS3231
+        k_sleep(wait);                              // wait first, then sync
+        wait = clock_discipline_sync();             // the interval follows the clock stability
     }
 }
 K_THREAD_DEFINE(rtc_thread_id, 2048, rtc_thread_func,
@@ -44,55 +52,28 @@ bool bth_thread_flag = true;
 
 void bth_thread_func(void)
 {
+    struct node_config_t config;
+
     LOG_INF("sensor thread started");
     while (bth_thread_flag == true) {
         LOG_INF("performing periodic sensor read");
         (void)app_sensors_handler();
-        k_sleep(BTH_PERIOD);
+
+        // a period changed by a downlink counts from the last read
+        int64_t last = k_uptime_get();
+        while (true) {
+            uint32_t generation = node_config_get(&config);
+            int64_t left = last + (int64_t)config.bth_period_s * MSEC_PER_SEC - k_uptime_get();
+            if (left <= 0) {
+                break;
+            }
+            node_config_wait(generation, K_MSEC(left));
+        }
     }
 }
 K_THREAD_DEFINE(bth_thread_id, 2048, bth_thread_func,
                 NULL, NULL, NULL, PRIORITY_TTN, 0, K_TICKS_FOREVER);
 
-
-// Synchro clock 
-void sync_clock(const struct device * ds3231_dev)
-{
-    int ret;
-    uint32_t gps_time;
-    time_t unix_time;
-    struct tm timeinfo;
-    char buf[32];
-
-    ret = lorawan_request_device_time(1);
-
-    if (ret != 0)
-    {
-        LOG_ERR("lorawan_request_device_time returned %d\n", ret);
-        return;
-    }
-
-    /*
-    * Once time synchronisation has occurred, lorawan_clock_sync_get() can
-    * be called to populate an uint32_t variable with GPS Time. This is the
-    * number of seconds since Jan 6th 1980 ignoring leap seconds.
-    */
-    ret = lorawan_device_time_get(&gps_time);
-    if (ret != 0)
-    {
-        LOG_ERR("lorawan_device_time_get returned %d\n", ret);
-    }
-    else
-    {
-        gps_time += 315964800;
-        unix_time = gps_time;
-        app_ds3231_set_time(ds3231_dev, gps_time);
-        localtime_r(&unix_time, &timeinfo);
-        strftime(buf, sizeof(buf), "%A %B %d %Y %I:%M:%S %p %Z", &timeinfo);
-        LOG_INF("Sync with GPS Time = %lli, UTC Time: %s", unix_time, buf);
-    }
-}
-
 //  ========== main ========================================================================
 int main(void)
 {
@@ -106,31 +87,46 @@ int main(void)
         sys_reboot(SYS_REBOOT_COLD); // Reset on failure
     }
 
-	// set time (also computes initial offset)
-    app_ds3231_set_time(ds3231_dev, 1741773600);
-
-	// start nRF internal RTC counter for sub-second precision
+	// start nRF internal RTC counter for sub-second precision, before the offset is computed
     const struct device *nrf_rtc = DEVICE_DT_GET(DT_NODELABEL(rtc2));
     counter_start(nrf_rtc);
 
+	// set time, then date its first edge on the nRF counter
+    app_ds3231_set_time(ds3231_dev, 1741773600);
+    clock_discipline_init();
+
 	// unblock RTC sync thread
     k_sem_give(&init_done_sem);
+
+    // configuration saved from the downlinks, before the threads reading it start
+    node_config_init();
+
 	ret = lora_init();
 	if (ret != 0) {
 		LOG_ERR("Could not initalize LoRa");
 		sys_reboot(SYS_REBOOT_COLD); // Reset on failure
 	}
 
+	// without a network, the uplinks wait in the uplink log and the scheduler joins later
 	ret = lora_joinnet();
 	if (ret != 0) {
-		LOG_ERR("Could not connect to LoRa net");
-		sys_reboot(SYS_REBOOT_COLD); // Reset on failure
+		LOG_WRN("Could not connect to LoRa net, the uplink scheduler retries");
 	}
 	LOG_INF("Geophone Measurement and Process Information");
 
-    sync_clock(ds3231_dev);
+    // network time, sets the DS3231 if it is wrong
+    if (ret == 0) {
+        clock_discipline_network(true);
+    }
+
+    // the uplink scheduler owns the radio from now on
+    uplink_start();
+    // requests received with the downlinks
+    downlink_start();
 	// start threads and sampling only after all HW is ready
     bth_thread_flag = true;
+    health_register_thread(HEALTH_THREAD_BTH, bth_thread_id);
+    health_register_thread(HEALTH_THREAD_RTC, rtc_thread_id);
     if(BTH_ENABLE != 0) {
         k_thread_start(bth_thread_id);
     }
@@ -141,11 +137,31 @@ int main(void)
 
 	// start storage and strategy to watch an event with sent the event
 	app_sta_lta_start_tx();
+
+    // spectral features of the geophone signal
+    if(SPECTRAL_ENABLE != 0) {
+        app_spectral_start();
+    }
+
+    // record the geophone signal to the flash
+    if(STORAGE_ENABLE != 0) {
+        app_storage_start();
+    }
     
-    // Start to send a periodic sample every hour
+    // Start the statistics thread, a summary is sent every PERIODIC_SAMPLE_PERIOD
     if(PERIODIC_SAMPLE_ENABLE != 0) {
         start_periodic_sample();
     }
 
+    // runtime figures of the threads and queues, sent every HEALTH_PERIOD
+    if(HEALTH_ENABLE != 0) {
+        health_start();
+    }
+
+    // commands from the debug console
+    if(CONSOLE_ENABLE != 0) {
+        app_console_start();
+    }
+
 	return 0;
 }
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "node_config.h"
+#include "config_codec.h"
+#include "app_adc.h"
+#include "detection_params.h"
+
+#include <zephyr/settings/settings.h>
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(node_config);
+
+//  ========== globals =====================================================================
+static const struct node_config_t defaults = {
+    .sampling_rate_ms = SAMPLING_RATE_MS,
+    .sta_window_ms = STA_WINDOW_DURATION_MS,
+    .lta_window_ms = LTA_WINDOW_DURATION_MS,
+    .ratio_on = (uint16_t)(DETECTION_RATIO * 100),
+    .ratio_off = (uint16_t)(DETECTION_RATIO_OFF * 100),
+    .anomaly_delay_ms = MINIMAL_DELAY_ANOMALY_MS,
+    .bth_period_s = BTH_PERIOD_S,
+    .send_samples = (ANOMALY_SEND_SAMPLES != 0),
+    .detectors = (DETECTOR_ER_ENABLE ? PARAM_DETECTOR_ER : 0) |
+                 (DETECTOR_MER_ENABLE ? PARAM_DETECTOR_MER : 0) |
+                 (DETECTOR_THRESHOLD_ENABLE ? PARAM_DETECTOR_THRESHOLD : 0),
+    .votes = DETECTOR_VOTES,
+};
+
+// the detector bank refuses any other number of votes, a downlink can not set one either
+BUILD_ASSERT(DETECTOR_VOTES >= 1 &&
+             DETECTOR_VOTES <= 1 + (DETECTOR_ER_ENABLE != 0) + (DETECTOR_MER_ENABLE != 0) +
+                               (DETECTOR_THRESHOLD_ENABLE != 0),
+             "DETECTOR_VOTES must be between 1 and the number of running detectors");
+
+// configuration in effect, the condition variable wakes the threads waiting for a change
+static struct node_config_t current;
+static uint32_t generation;
+K_MUTEX_DEFINE(config_mutex);
+K_CONDVAR_DEFINE(config_changed);
+
+//  ========== settings ====================================================================
+// called by settings_load_subtree() for each key saved under "node"
+static int config_load(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    struct node_config_t loaded;
+    uint8_t param;
+
+    if (!settings_name_steq(key, "config", NULL)) {
+        return -ENOENT;
+    }
+    // saved by a firmware with another layout, the defaults are kept
+    if (len != sizeof(loaded)) {
+        LOG_WRN("saved configuration of %u bytes ignored", (unsigned int)len);
+        return 0;
+    }
+    if (read_cb(cb_arg, &loaded, sizeof(loaded)) != sizeof(loaded)) {
+        return -EIO;
+    }
+    if (config_check(&loaded, &param) != 0) {
+        LOG_WRN("saved configuration ignored, parameter 0x%02x out of range", param);
+        return 0;
+    }
+    current = loaded;
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(node, "node", NULL, config_load, NULL, NULL);
+
+//  ========== apply =======================================================================
+// called with config_mutex held, the other users see the new generation
+static void apply(const struct node_config_t *config)
+{
+    if (config->sampling_rate_ms != app_adc_get_sampling_rate()) {
+        app_adc_set_sampling_rate(config->sampling_rate_ms);
+    }
+    current = *config;
+    generation++;
+    k_condvar_broadcast(&config_changed);
+}
+
+//  ========== node_config_init ============================================================
+void node_config_init(void)
+{
+    uint8_t param;
+
+    if (config_check(&defaults, &param) != 0) {
+        LOG_ERR("compile-time parameter 0x%02x out of the downlink range", param);
+    }
+    current = defaults;
+
+    int rc = settings_subsys_init();
+    if (rc == 0) {
+        rc = settings_load_subtree("node");
+    }
+    if (rc != 0) {
+        LOG_ERR("could not load the settings. error: %d", rc);
+    }
+
+    k_mutex_lock(&config_mutex, K_FOREVER);
+    struct node_config_t loaded = current;
+    apply(&loaded);
+    k_mutex_unlock(&config_mutex);
+    if (memcmp(&loaded, &defaults, sizeof(defaults)) != 0) {
+        LOG_INF("configuration loaded from the settings");
+    }
+}
+
+//  ========== node_config_get =============================================================
+uint32_t node_config_get(struct node_config_t *config)
+{
+    k_mutex_lock(&config_mutex, K_FOREVER);
+    *config = current;
+    uint32_t gen = generation;
+    k_mutex_unlock(&config_mutex);
+    return gen;
+}
+
+//  ========== node_config_set =============================================================
+int node_config_set(const struct node_config_t *config, uint8_t *param)
+{
+    int rc = config_check(config, param);
+    if (rc != 0) {
+        return rc;
+    }
+
+    k_mutex_lock(&config_mutex, K_FOREVER);
+    apply(config);
+    k_mutex_unlock(&config_mutex);
+
+    rc = settings_save_one(NODE_CONFIG_KEY, config, sizeof(*config));
+    if (rc != 0) {
+        LOG_ERR("could not save the configuration. error: %d", rc);
+    }
+    return rc;
+}
+
+//  ========== node_config_reset ===========================================================
+int node_config_reset(void)
+{
+    k_mutex_lock(&config_mutex, K_FOREVER);
+    apply(&defaults);
+    k_mutex_unlock(&config_mutex);
+
+    int rc = settings_delete(NODE_CONFIG_KEY);
+    if (rc != 0) {
+        LOG_ERR("could not delete the saved configuration. error: %d", rc);
+    }
+    return rc;
+}
+
+//  ========== node_config_wait ============================================================
+bool node_config_wait(uint32_t gen, k_timeout_t timeout)
+{
+    k_mutex_lock(&config_mutex, K_FOREVER);
+    if (generation == gen) {
+        k_condvar_wait(&config_changed, &config_mutex, timeout);
+    }
+    bool changed = (generation != gen);
+    k_mutex_unlock(&config_mutex);
+    return changed;
+}
+
+//  ========== node_config_dump ============================================================
+void node_config_dump(void)
+{
+    struct node_config_t config;
+    uint32_t gen = node_config_get(&config);
+
+    printk("generation %u%s\n", gen,
+           memcmp(&config, &defaults, sizeof(config)) == 0 ? " (defaults)" : "");
+    printk("sampling %u ms, STA %u ms, LTA %u ms\n", config.sampling_rate_ms,
+           config.sta_window_ms, config.lta_window_ms);
+    printk("ratio on %u.%02u, off %u.%02u, anomaly delay %u ms\n",
+           config.ratio_on / 100, config.ratio_on % 100,
+           config.ratio_off / 100, config.ratio_off % 100, config.anomaly_delay_ms);
+    printk("detectors 0x%02x, votes %u, send samples %u, BTH every %u s\n",
+           config.detectors, config.votes, config.send_samples, config.bth_period_s);
+}
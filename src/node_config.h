@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NODE_CONFIG_H
+#define NODE_CONFIG_H
+
+/*
+ * Configuration of the node changed by the DOWNLINK_CONFIG_* requests (see downlink.h).
+ *
+ * The defaults are the compile-time values: SAMPLING_RATE_MS, detection_params.h and
+ * config.h. A new configuration is saved with the settings subsystem (NVS on the storage
+ * partition of the internal flash) and loaded at boot, a reset keeps it, a
+ * DOWNLINK_CONFIG_RESET goes back to the defaults.
+ *
+ * It applies without a reboot. The sampling period is handed to the ADC at once, the
+ * other users read the configuration when node_config_get() returns a new generation:
+ * the detector thread on its next block (its windows and detectors start over), the BTH
+ * thread on its next wait, the event capture on its next event. The statistics and the
+ * spectral threads wake on the new generation and start over at a new sampling period,
+ * their rollups and bins depend on it.
+ */
+
+//  ========== includes ====================================================================
+#include "data_types.h"
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// settings key of the saved configuration
+#define NODE_CONFIG_KEY             "node/config"
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief load the saved configuration, the defaults without one
+ *
+ * Called once at boot, before the threads reading the configuration start.
+ */
+void node_config_init(void);
+
+/**
+ * @brief copy of the configuration in effect
+ *
+ * @return generation of the configuration, changed by each node_config_set()
+ */
+uint32_t node_config_get(struct node_config_t *config);
+
+/**
+ * @brief check, apply and save a whole configuration
+ *
+ * @param param set to the parameter out of range, 0 if none
+ * @return 0, -ERANGE if refused, or the error of the settings (applied but not saved)
+ */
+int node_config_set(const struct node_config_t *config, uint8_t *param);
+
+/**
+ * @brief apply the defaults and forget the saved configuration
+ */
+int node_config_reset(void);
+
+/**
+ * @brief wait until the generation is no longer `generation`, or for `timeout`
+ *
+ * @return true on a change
+ */
+bool node_config_wait(uint32_t generation, k_timeout_t timeout);
+
+/**
+ * @brief print the configuration in effect, for the console
+ */
+void node_config_dump(void);
+
+#endif /* NODE_CONFIG_H */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "packet_codec.h"
+#include "data_types.h"
+
+#include <errno.h>
+#include <string.h>
+
+//  ========== packet_record_size ==========================================================
+int packet_record_size(uint8_t type)
+{
+    switch (type) {
+    case BTH:
+        return sizeof(struct bth_payload_t);
+    case ANOMALY:
+        return sizeof(struct anomaly_payload_t);
+    case PERIODIC_SAMPLE:
+        return sizeof(struct periodic_sample_payload_t);
+    case HEALTH:
+        return sizeof(struct health_payload_t);
+    case WINDOW:
+        return sizeof(struct window_payload_t);
+    case CONFIG:
+        return sizeof(struct config_payload_t);
+    case SAMPLES:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+//  ========== put_varint ==================================================================
+// zigzag then LEB128, returns the number of bytes written, at most 5 for 32 bits
+static size_t put_varint(uint8_t *out, int32_t value)
+{
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+//  ========== packet_writer_init ==========================================================
+void packet_writer_init(struct packet_writer *w, uint8_t *buf, size_t capacity, uint64_t base_ms)
+{
+    uint32_t base_s = (uint32_t)(base_ms / 1000);
+
+    w->buf = buf;
+    w->capacity = capacity;
+    w->len = PACKET_V2_HEADER_SIZE;
+    w->last_ms = (uint64_t)base_s * 1000;
+    w->count = 0;
+    w->closed = 0;
+
+    if (capacity >= PACKET_V2_HEADER_SIZE) {
+        buf[0] = PACKET_V2_VERSION << 4;
+        buf[1] = (uint8_t)base_s;
+        buf[2] = (uint8_t)(base_s >> 8);
+        buf[3] = (uint8_t)(base_s >> 16);
+        buf[4] = (uint8_t)(base_s >> 24);
+    }
+}
+
+//  ========== packet_writer_add ===========================================================
+int packet_writer_add(struct packet_writer *w, uint8_t type, uint64_t timestamp_ms,
+                      const void *payload, size_t size)
+{
+    int fixed = packet_record_size(type);
+    uint8_t header[PACKET_V2_RECORD_OVERHEAD];
+
+    if (fixed < 0 || (fixed > 0 && size != (size_t)fixed)) {
+        return -EINVAL;
+    }
+    if (w->closed || w->count >= PACKET_V2_MAX_RECORDS) {
+        return -ENOSPC;
+    }
+
+    // records are at most ~24 days apart, far more than any batching delay
+    int64_t delta = (int64_t)(timestamp_ms - w->last_ms);
+    if (delta > INT32_MAX || delta < INT32_MIN) {
+        return -EINVAL;
+    }
+
+    header[0] = type << 4;
+    size_t header_size = 1 + put_varint(&header[1], (int32_t)delta);
+    if (w->len + header_size + size > w->capacity) {
+        return -ENOSPC;
+    }
+
+    memcpy(&w->buf[w->len], header, header_size);
+    memcpy(&w->buf[w->len + header_size], payload, size);
+    w->len += header_size + size;
+    w->last_ms = timestamp_ms;
+    w->count++;
+    w->closed = (fixed == 0);
+    w->buf[0] = (PACKET_V2_VERSION << 4) | w->count;
+    return 0;
+}
+
+//  ========== packet_writer_size ==========================================================
+size_t packet_writer_size(const struct packet_writer *w)
+{
+    return (w->count > 0) ? w->len : 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PACKET_CODEC_H
+#define PACKET_CODEC_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stddef.h>
+
+//  ========== defines =====================================================================
+/*
+ * Uplink frame v2, all fields little-endian:
+ *
+ *   0   u8   (PACKET_V2_VERSION << 4) | number of records (1 to 15)
+ *   1   u32  base time, unix seconds
+ *   5   records, each:
+ *        - u8      packet type << 4 (low nibble reserved, 0)
+ *        - varint  zigzag of the record time minus the previous record time in ms,
+ *                  the first record counts from the base time
+ *        - payload of the type, fixed size, see packet_record_size()
+ *
+ * A SAMPLES record has no fixed size: it can only be the last record and its
+ * payload runs to the end of the frame.
+ *
+ * v1 frames, event fragments included, start with their packet type: BTH (1) up to
+ * PACKET_TYPE_END, whose high nibble is 0. The high nibble of a v2 frame is PACKET_V2_VERSION,
+ * so the first byte tells both versions apart as long as every type stays below
+ * PACKET_V2_VERSION << 4 (0x20). A record type is also a nibble, below 16: both are
+ * asserted against PACKET_TYPE_END in uplink.c.
+ */
+#define PACKET_V2_VERSION           2
+#define PACKET_V2_HEADER_SIZE       5
+#define PACKET_V2_MAX_RECORDS       15
+
+// record header and the largest time delta varint
+#define PACKET_V2_RECORD_OVERHEAD   (1 + 5)
+
+//  ========== types =======================================================================
+struct packet_writer {
+    uint8_t *buf;
+    size_t capacity;
+    size_t len;
+    uint64_t last_ms;           // time of the previous record
+    uint8_t count;
+    uint8_t closed;             // a variable size record was added
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief fixed payload size of a record type
+ *
+ * @return the size in bytes, 0 for the variable size SAMPLES record, -1 for a
+ *         type that cannot be carried in a v2 frame
+ */
+int packet_record_size(uint8_t type);
+
+/**
+ * @brief start a v2 frame whose base time is the second of `base_ms`
+ */
+void packet_writer_init(struct packet_writer *w, uint8_t *buf, size_t capacity, uint64_t base_ms);
+
+/**
+ * @brief append one record, the frame is left unchanged on error
+ *
+ * @return 0 on success, -ENOSPC if the record does not fit or the frame is full,
+ *         -EINVAL for a type that cannot be carried or a wrong payload size
+ */
+int packet_writer_add(struct packet_writer *w, uint8_t type, uint64_t timestamp_ms,
+                      const void *payload, size_t size);
+
+/**
+ * @brief number of bytes of the frame, 0 while it holds no record
+ */
+size_t packet_writer_size(const struct packet_writer *w);
+
+#endif /* PACKET_CODEC_H */
@@ -2,8 +2,13 @@
 
 #include <zephyr/kernel.h>
 #include "config.h"
+#include "app_adc.h"
 #include "app_sta_lta_tx.h"
-#include "lorawan.h"
+#include "app_ds3231.h"
+#include "uplink.h"
+#include "app_spectral.h"
+#include "health.h"
+#include "node_config.h"
 
 #include "config.h" // for log level
 #include <zephyr/logging/log.h>
@@ -13,50 +18,111 @@ LOG_MODULE_REGISTER(periodic_samples);
 struct k_thread periodic_thread_data;
 K_THREAD_STACK_DEFINE(periodic_thread_stack, 2048);
 
-// Buffer used for computing statistics
-uint16_t buffer[STA_WINDOW_SIZE];
+// Statistics over the whole period, updated with every sample. A mutex and not a
+// spinlock: a chunk takes a while and must not mask the ADC interrupt
+static struct stats_engine engine;
+K_MUTEX_DEFINE(engine_lock);
 
-struct periodic_sample_payload_t get_statistics(const uint16_t *buffer, int size)
+// Chunk of samples read from the ADC ring
+static int16_t buffer[STA_LTA_CHUNK_SIZE];
+
+// Feed the engine with every sample from `*next` to the ring head
+static void drain_ring(uint32_t *next)
 {
-    struct periodic_sample_payload_t p;
-    int16_t max = 0;
-    int16_t min = 5000;
-    float sum = 0.0;
-    if(size < 0) {
-        return p;
+    uint32_t head = app_adc_get_head();
+
+    if (head - *next > ADC_BUFFER_SIZE - ADC_BLOCK_SIZE) {
+        // the ring overran us, keep going from the oldest sample still there
+        LOG_WRN("statistics lost %u samples", head - *next - (ADC_BUFFER_SIZE - ADC_BLOCK_SIZE));
+        *next = head - (ADC_BUFFER_SIZE - ADC_BLOCK_SIZE);
     }
-    for (int i = 0; i < size; i++) {
-        int16_t x = (buffer[i]);
-        if(x > max) {
-            max = x;
+
+    while (*next != head) {
+        size_t count = MIN(head - *next, STA_LTA_CHUNK_SIZE);
+        if (app_adc_read(buffer, count, *next) != 0) {
+            *next = app_adc_get_head();
+            return;
         }
-        if(x < min) {
-            min = x;
+
+        health_mutex_lock(&engine_lock, HEALTH_LOCK_STATS, K_FOREVER);
+        for (size_t i = 0; i < count; i++) {
+            stats_engine_update(&engine, buffer[i]);
         }
-        sum += (float) x;
+        k_mutex_unlock(&engine_lock);
+        *next += count;
     }
-
-    p.max = max;
-    p.min = min;
-    
-    p.mean = sum / size;
-    return p;
 }
 
 static void periodic_sample_app(void *arg1, void *arg2, void *arg3) {
-    struct periodic_sample_payload_t p;
-    app_adc_get_buffer(buffer, STA_WINDOW_SIZE, -STA_WINDOW_SIZE);
-    p = get_statistics(buffer, STA_WINDOW_SIZE);
-    lora_send_packet(PERIODIC_SAMPLE, (uint8_t *) &p, sizeof(p));
-    k_sleep(PERIODIC_SAMPLE_PERIOD);
+    struct node_config_t config;
+    uint32_t generation = node_config_get(&config);
+    uint32_t rate = config.sampling_rate_ms;
+    uint32_t next = app_adc_get_head();
+    int64_t period_end = k_uptime_get() + k_ticks_to_ms_floor64(PERIODIC_SAMPLE_PERIOD.ticks);
+
+    stats_engine_init(&engine, rate);
+
+    while (1) {
+        // the ring holds ADC_BUFFER_SIZE samples, read it when a quarter has filled up
+        uint32_t interval_ms = MIN(ADC_BUFFER_SIZE / 4 * rate, STATS_READ_INTERVAL_MS);
+        bool changed = node_config_wait(generation, K_MSEC(interval_ms));
+        drain_ring(&next);
+
+        if (changed) {
+            generation = node_config_get(&config);
+        }
+        if (config.sampling_rate_ms != rate) {
+            // the rollups count samples, the period and the rollups start over at the new rate
+            rate = config.sampling_rate_ms;
+            health_mutex_lock(&engine_lock, HEALTH_LOCK_STATS, K_FOREVER);
+            stats_engine_init(&engine, rate);
+            k_mutex_unlock(&engine_lock);
+            LOG_INF("statistics restarted at %u ms", rate);
+        }
+
+        if (k_uptime_get() < period_end) {
+            continue;
+        }
+        period_end += k_ticks_to_ms_floor64(PERIODIC_SAMPLE_PERIOD.ticks);
+
+        struct stats_summary s;
+        health_mutex_lock(&engine_lock, HEALTH_LOCK_STATS, K_FOREVER);
+        stats_engine_take_period(&engine, &s);
+        k_mutex_unlock(&engine_lock);
+
+        // samples are relative to the baseline, the mean is reported as an absolute DC level
+        struct periodic_sample_payload_t p = {
+            .min = s.min,
+            .max = s.max,
+            .mean = app_adc_get_baseline() + s.mean,
+            .rms = s.rms,
+            .p50 = s.percentiles[0],
+            .p90 = s.percentiles[1],
+            .p99 = s.percentiles[2],
+        };
+        if (SPECTRAL_ENABLE != 0) {
+            app_spectral_take_average(&p.spectral);
+        }
+        LOG_INF("period of %u samples: min %d max %d rms %u p99 %u", s.count, s.min, s.max, s.rms, p.p99);
+        uplink_enqueue(PERIODIC_SAMPLE, app_get_timestamp(), &p, sizeof(p), K_NO_WAIT);
+    }
+}
+
+int periodic_samples_get_rollup(int level, struct stats_summary *out)
+{
+    health_mutex_lock(&engine_lock, HEALTH_LOCK_STATS, K_FOREVER);
+    int ret = stats_engine_get_rollup(&engine, level, out);
+    k_mutex_unlock(&engine_lock);
+    return ret;
 }
 
 void start_periodic_sample(void)
 {
-    // original STA/LTA detection thread
+    // statistics thread, below the detector
     k_thread_create(&periodic_thread_data, periodic_thread_stack,
                     K_THREAD_STACK_SIZEOF(periodic_thread_stack),
                     periodic_sample_app, NULL, NULL, NULL,
-                    5, 0, PERIODIC_SAMPLE_PERIOD);
+                    5, 0, K_NO_WAIT);
+    health_register_thread(HEALTH_THREAD_PERIODIC, &periodic_thread_data);
 
-}
\ No newline at end of file
+}
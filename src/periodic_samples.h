@@ -3,8 +3,15 @@
 
 #include <stdint.h>
 #include "data_types.h"
-// Get statistics over a given window
-struct periodic_sample_payload_t get_statistics(const uint16_t *buffer, int size);
+#include "stats_engine.h"
+
+// Longest interval between two reads of the ADC ring by the statistics thread, it wakes
+// earlier when a quarter of the ring has filled up (ADC_BUFFER_SIZE / 4 samples)
+#define STATS_READ_INTERVAL_MS 10000
+
+// Start the statistics thread, it sends a summary of every PERIODIC_SAMPLE_PERIOD
 void start_periodic_sample(void);
+// Last complete 1 min, 10 min or 1 h rollup (STATS_ROLLUP_*), 0 on success
+int periodic_samples_get_rollup(int level, struct stats_summary *out);
 
-#endif
\ No newline at end of file
+#endif
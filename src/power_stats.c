@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "power_stats.h"
+#include "app_adc.h"
+
+//  ========== globals =====================================================================
+static const char *const wakeup_names[POWER_WAKEUPS] = {
+    [POWER_WAKEUP_ADC] = "adc",
+    [POWER_WAKEUP_DETECT] = "detect",
+};
+
+static atomic_t wakeups[POWER_WAKEUPS];
+static atomic_t idle_entries = ATOMIC_INIT(0);
+
+// start of the window
+static struct k_spinlock window_lock;
+static int64_t window_start_ms;
+static uint64_t window_busy_cycles;
+
+//  ========== sys_trace_idle_user =========================================================
+#if defined(CONFIG_TRACING_USER)
+// called by the kernel each time the idle thread runs, so once per CPU wakeup
+void sys_trace_idle_user(void)
+{
+    atomic_inc(&idle_entries);
+}
+#endif
+
+//  ========== power_stats_wakeup ==========================================================
+void power_stats_wakeup(enum power_wakeup id)
+{
+    atomic_inc(&wakeups[id]);
+}
+
+//  ========== power_stats_get =============================================================
+void power_stats_get(struct power_figures *f, bool reset)
+{
+    k_thread_runtime_stats_t all;
+    uint64_t busy_cycles = 0;
+
+    if (k_thread_runtime_stats_all_get(&all) == 0) {
+        busy_cycles = all.total_cycles;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&window_lock);
+    int64_t now = k_uptime_get();
+
+    f->elapsed_ms = (uint32_t)(now - window_start_ms);
+    f->active_us = k_cyc_to_us_floor64(busy_cycles - window_busy_cycles);
+    for (size_t i = 0; i < POWER_WAKEUPS; i++) {
+        f->wakeups[i] = reset ? (uint32_t)atomic_clear(&wakeups[i]) : (uint32_t)atomic_get(&wakeups[i]);
+    }
+    f->idle_entries = reset ? (uint32_t)atomic_clear(&idle_entries) : (uint32_t)atomic_get(&idle_entries);
+    if (reset) {
+        window_start_ms = now;
+        window_busy_cycles = busy_cycles;
+    }
+    k_spin_unlock(&window_lock, key);
+}
+
+//  ========== power_stats_print ===========================================================
+void power_stats_print(bool reset)
+{
+    struct power_figures f;
+
+    power_stats_get(&f, reset);
+    if (f.elapsed_ms == 0) {
+        return;
+    }
+
+    printk("POWER block %u samples, %u.%03u s\n", ADC_BLOCK_SIZE, f.elapsed_ms / 1000,
+           f.elapsed_ms % 1000);
+    for (size_t i = 0; i < POWER_WAKEUPS; i++) {
+        uint64_t milli = (uint64_t)f.wakeups[i] * 1000000 / f.elapsed_ms;
+        printk("wakeups %-7s %u.%03u /s\n", wakeup_names[i], (uint32_t)(milli / 1000),
+               (uint32_t)(milli % 1000));
+    }
+#if defined(CONFIG_TRACING_USER)
+    uint64_t milli = (uint64_t)f.idle_entries * 1000000 / f.elapsed_ms;
+    printk("wakeups cpu     %u.%03u /s\n", (uint32_t)(milli / 1000), (uint32_t)(milli % 1000));
+#endif
+    // active us per ms of window, in 0.001 %
+    uint64_t duty = f.active_us * 100000 / ((uint64_t)f.elapsed_ms * 1000);
+    printk("cpu active %llu us, %u.%03u %%\n", f.active_us, (uint32_t)(duty / 1000),
+           (uint32_t)(duty % 1000));
+}
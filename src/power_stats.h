@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef POWER_STATS_H
+#define POWER_STATS_H
+
+/*
+ * Wakeup and CPU duty cycle figures, to compare the ADC_BLOCK_SIZE settings.
+ *
+ * The acquisition and detection threads count their wakeups. With CONFIG_TRACING_USER,
+ * every entry of the idle thread is counted too, which includes the interrupts that
+ * did not wake any thread. The active time is the non-idle CPU time of the kernel
+ * runtime statistics. Printed by the "power" console command, and periodically on
+ * native_sim with --power-report.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//  ========== types =======================================================================
+enum power_wakeup {
+    POWER_WAKEUP_ADC = 0,
+    POWER_WAKEUP_DETECT,
+    POWER_WAKEUPS,
+};
+
+struct power_figures {
+    uint32_t elapsed_ms;
+    uint32_t wakeups[POWER_WAKEUPS];
+    uint32_t idle_entries;      // 0 without CONFIG_TRACING_USER
+    uint64_t active_us;         // non-idle CPU time
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief count a wakeup of a processing thread
+ */
+void power_stats_wakeup(enum power_wakeup id);
+
+/**
+ * @brief figures since the start of the window, which restarts if reset is set
+ */
+void power_stats_get(struct power_figures *f, bool reset);
+
+/**
+ * @brief print the figures of the window as rates, restarting it if reset is set
+ */
+void power_stats_print(bool reset);
+
+#endif /* POWER_STATS_H */
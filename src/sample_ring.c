@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "sample_ring.h"
+
+#include <zephyr/sys/barrier.h>
+
+#include <string.h>
+#include <errno.h>
+
+//  ========== sample_ring_init ============================================================
+void sample_ring_init(struct sample_ring *ring, int16_t *buffer, size_t capacity)
+{
+    __ASSERT((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    ring->buffer = buffer;
+    ring->mask = capacity - 1;
+    atomic_set(&ring->head, 0);
+    atomic_set(&ring->claim, 0);
+}
+
+//  ========== sample_ring_write ===========================================================
+void sample_ring_write(struct sample_ring *ring, const int16_t *src, size_t count)
+{
+    uint32_t head = (uint32_t)atomic_get(&ring->head);
+    uint32_t capacity = ring->mask + 1;
+
+    if (count > capacity) {
+        // only the newest samples can be kept
+        head += count - capacity;
+        src += count - capacity;
+        count = capacity;
+    }
+
+    // announce the slots about to be overwritten before touching them
+    atomic_set(&ring->claim, (atomic_val_t)(head + count));
+    barrier_dmem_fence_full();
+
+    uint32_t pos = head & ring->mask;
+    size_t first = MIN(count, capacity - pos);
+    memcpy(&ring->buffer[pos], src, first * sizeof(int16_t));
+    memcpy(&ring->buffer[0], src + first, (count - first) * sizeof(int16_t));
+
+    // atomic_set is a full barrier: readers see the data before the new head
+    atomic_set(&ring->head, (atomic_val_t)(head + count));
+}
+
+//  ========== sample_ring_head ============================================================
+uint32_t sample_ring_head(const struct sample_ring *ring)
+{
+    return (uint32_t)atomic_get((atomic_t *)&ring->head);
+}
+
+//  ========== sample_ring_read ============================================================
+int sample_ring_read(const struct sample_ring *ring, int16_t *dest, size_t count, uint32_t start)
+{
+    uint32_t capacity = ring->mask + 1;
+
+    for (int attempt = 0; attempt < SAMPLE_RING_READ_RETRIES; attempt++) {
+        uint32_t head = sample_ring_head(ring);
+
+        // unsigned differences stay valid across the 32-bit index wrap
+        if ((uint32_t)(head - start) < count || (uint32_t)(head - start) > capacity) {
+            return -ERANGE;
+        }
+
+        uint32_t pos = start & ring->mask;
+        size_t first = MIN(count, capacity - pos);
+        memcpy(dest, &ring->buffer[pos], first * sizeof(int16_t));
+        memcpy(dest + first, &ring->buffer[0], (count - first) * sizeof(int16_t));
+
+        // the copy is valid if the producer did not reach our oldest slot meanwhile
+        barrier_dmem_fence_full();
+        uint32_t claim = (uint32_t)atomic_get((atomic_t *)&ring->claim);
+        if ((uint32_t)(claim - start) <= capacity) {
+            return 0;
+        }
+    }
+
+    return -EAGAIN;
+}
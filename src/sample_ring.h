@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+//  ========== defines =====================================================================
+// number of attempts of a reader before giving up when the writer keeps overwriting it
+#define SAMPLE_RING_READ_RETRIES    4
+
+//  ========== types =======================================================================
+/**
+ * @brief single-producer / multi-reader ring of samples
+ *
+ * Samples are addressed by their absolute index since the start of the acquisition.
+ * The producer never blocks: it writes the slots, then publishes the new head.
+ * Readers copy without lock and check afterwards that the producer did not
+ * overwrite the copied range in the meantime.
+ */
+struct sample_ring {
+    int16_t *buffer;
+    uint32_t mask;          // capacity - 1, capacity is a power of two
+    atomic_t head;          // index of the next sample to publish
+    atomic_t claim;         // index up to which the producer may be writing
+};
+
+// static initializer, equivalent to sample_ring_init()
+#define SAMPLE_RING_INITIALIZER(buf, capacity)          \
+    {                                                   \
+        .buffer = (buf),                                \
+        .mask = (capacity) - 1,                         \
+        .head = ATOMIC_INIT(0),                         \
+        .claim = ATOMIC_INIT(0),                        \
+    }
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief initialize a ring over a caller-supplied buffer
+ *
+ * @param capacity number of samples of @p buffer, must be a power of two
+ */
+void sample_ring_init(struct sample_ring *ring, int16_t *buffer, size_t capacity);
+
+/**
+ * @brief append samples to the ring (producer only, never blocks)
+ */
+void sample_ring_write(struct sample_ring *ring, const int16_t *src, size_t count);
+
+/**
+ * @brief absolute index of the next sample to be published
+ */
+uint32_t sample_ring_head(const struct sample_ring *ring);
+
+/**
+ * @brief copy @p count samples starting at absolute index @p start
+ *
+ * @retval 0 on success
+ * @retval -ERANGE the range is not published yet or already overwritten
+ * @retval -EAGAIN the producer kept overwriting the range while copying
+ */
+int sample_ring_read(const struct sample_ring *ring, int16_t *dest, size_t count, uint32_t start);
+
+#endif /* SAMPLE_RING_H */
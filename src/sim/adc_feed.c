@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * native_sim: feeds the ADC emulator with a recorded geophone file.
+ *
+ * Each conversion of channel 0 returns the next sample of --adc-file (raw int16 or
+ * compressed frames, as written by the recorder) on top of a mid-scale bias, so the
+ * application sees the same signal as the node did. Channel 1 is a fixed battery level.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/init.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "soc.h"
+
+#include "app_adc.h"
+#include "app_storage.h"
+#include "wave_codec.h"
+#include "sim.h"
+#include "sim_host_io.h"
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(adc_feed);
+
+//  ========== defines =====================================================================
+// DC level of the geophone input, the recorded samples have theirs removed
+#define ADC_FEED_BIAS_MV            (ADC_FULL_SCALE_MV / 2)
+
+// battery voltage seen on AIN1 behind the divider
+#define ADC_FEED_BATTERY_MV         3900
+
+#define ADC_FEED_CHUNK              256
+
+//  ========== globals =====================================================================
+static const char *adc_file;
+static bool adc_once;
+
+static int feed_fd = -1;
+static bool feed_compressed;
+static bool feed_ended;
+
+static uint8_t in_buffer[WAVE_CODEC_MAX_FRAME(STORAGE_FRAME_SAMPLES)];
+static size_t in_size;
+static int16_t samples[MAX(STORAGE_FRAME_SAMPLES, ADC_FEED_CHUNK)];
+static size_t sample_count;
+static size_t sample_pos;
+
+// samples handed to the emulator, for the latency measurements on the host side
+static atomic_t fed_samples = ATOMIC_INIT(0);
+
+//  ========== adc_feed_options ============================================================
+static void adc_feed_options(void)
+{
+    static struct args_struct_t options[] = {
+        { .option = "adc-file", .name = "path", .type = 's', .dest = (void *)&adc_file,
+          .descript = "geophone recording (raw or compressed .dat) fed to ADC channel 0" },
+        { .is_switch = true, .option = "adc-once", .type = 'b', .dest = (void *)&adc_once,
+          .descript = "stop at the end of the recording instead of looping over it" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(options);
+}
+NATIVE_TASK(adc_feed_options, PRE_BOOT_1, 1);
+
+//  ========== feed_refill =================================================================
+// read the next raw chunk or compressed frame, false at the end of the file
+static bool feed_refill(void)
+{
+    if (!feed_compressed) {
+        long n = sim_host_read(feed_fd, samples, sizeof(samples));
+        sample_count = (n > 0) ? (size_t)n / sizeof(int16_t) : 0;
+        sample_pos = 0;
+        return sample_count > 0;
+    }
+
+    while (true) {
+        int used = wave_codec_decode(in_buffer, in_size, samples, ARRAY_SIZE(samples),
+                                     &sample_count, NULL);
+        if (used > 0) {
+            in_size -= used;
+            memmove(in_buffer, &in_buffer[used], in_size);
+            sample_pos = 0;
+            return true;
+        }
+        if (used != -EAGAIN || in_size == sizeof(in_buffer)) {
+            LOG_ERR("bad frame in %s: %d", adc_file, used);
+            return false;
+        }
+
+        long n = sim_host_read(feed_fd, &in_buffer[in_size], sizeof(in_buffer) - in_size);
+        if (n <= 0) {
+            return false;
+        }
+        in_size += n;
+    }
+}
+
+//  ========== feed_next ===================================================================
+static int16_t feed_next(void)
+{
+    if (feed_fd < 0 || feed_ended) {
+        return 0;
+    }
+
+    if (sample_pos == sample_count && !feed_refill()) {
+        if (adc_once) {
+            LOG_INF("end of %s after %ld samples", adc_file, (long)atomic_get(&fed_samples));
+            feed_ended = true;
+            return 0;
+        }
+        // loop over the recording
+        in_size = 0;
+        if (sim_host_rewind(feed_fd) < 0 || !feed_refill()) {
+            feed_ended = true;
+            return 0;
+        }
+    }
+
+    atomic_inc(&fed_samples);
+    return samples[sample_pos++];
+}
+
+//  ========== adc_feed_value ==============================================================
+// called by the emulator on each conversion, returns the input voltage in mV
+static int adc_feed_value(const struct device *dev, unsigned int chan, void *data,
+                          uint32_t *result)
+{
+    int32_t mv = (chan == 0) ? ADC_FEED_BIAS_MV + feed_next()
+                             : ADC_FEED_BATTERY_MV * DIVIDER_RATIO_DEN / DIVIDER_RATIO_NUM;
+
+    *result = CLAMP(mv, 0, ADC_FULL_SCALE_MV);
+    return 0;
+}
+
+//  ========== sim_adc_feed_get_count ======================================================
+uint32_t sim_adc_feed_get_count(void)
+{
+    return (uint32_t)atomic_get(&fed_samples);
+}
+
+//  ========== adc_feed_init ===============================================================
+static int adc_feed_init(void)
+{
+    const struct device *adc = DEVICE_DT_GET(DT_NODELABEL(adc0));
+
+    if (adc_file != NULL) {
+        feed_fd = sim_host_open_read(adc_file);
+        if (feed_fd < 0) {
+            LOG_ERR("cannot open %s, the geophone input stays flat", adc_file);
+        } else {
+            uint8_t magic[2];
+            feed_compressed = sim_host_read(feed_fd, magic, sizeof(magic)) == sizeof(magic) &&
+                              (magic[0] | (magic[1] << 8)) == WAVE_CODEC_MAGIC;
+            sim_host_rewind(feed_fd);
+            LOG_INF("feeding %s (%s)", adc_file, feed_compressed ? "compressed" : "raw");
+        }
+    }
+
+    adc_emul_value_func_set(adc, 0, adc_feed_value, NULL);
+    adc_emul_value_func_set(adc, 1, adc_feed_value, NULL);
+    return 0;
+}
+SYS_INIT(adc_feed_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
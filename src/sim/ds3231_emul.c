@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * native_sim: DS3231 on the I2C emulator controller.
+ *
+ * A register file with auto-incremented address pointer, as the chip. The time
+ * registers count from the last time written, on the kernel uptime, and start at
+ * the host wall clock.
+ */
+
+#define DT_DRV_COMPAT maxim_ds3231
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/sys/timeutil.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim_host_io.h"
+
+//  ========== defines =====================================================================
+#define DS3231_EMUL_REGS            0x13    // up to the temperature registers
+#define DS3231_EMUL_TIME_REGS       7       // seconds to year, BCD
+#define DS3231_EMUL_REG_STATUS      0x0f
+#define DS3231_EMUL_REG_TEMP_MSB    0x11
+
+//  ========== types =======================================================================
+struct ds3231_emul_data {
+    uint8_t regs[DS3231_EMUL_REGS];
+    uint8_t pointer;
+    int64_t base_unix;          // time last written to the chip
+    int64_t base_uptime_ms;     // uptime when it was written
+};
+
+//  ========== bcd helpers =================================================================
+static uint8_t bin_to_bcd(int val)
+{
+    return ((val / 10) << 4) | (val % 10);
+}
+
+static int bcd_to_bin(uint8_t val)
+{
+    return ((val >> 4) * 10) + (val & 0x0f);
+}
+
+//  ========== time_to_regs ================================================================
+static void time_to_regs(struct ds3231_emul_data *data)
+{
+    time_t now = data->base_unix + (k_uptime_get() - data->base_uptime_ms) / MSEC_PER_SEC;
+    struct tm utc;
+
+    gmtime_r(&now, &utc);
+    data->regs[0] = bin_to_bcd(utc.tm_sec);
+    data->regs[1] = bin_to_bcd(utc.tm_min);
+    data->regs[2] = bin_to_bcd(utc.tm_hour);
+    data->regs[3] = bin_to_bcd(utc.tm_wday + 1);
+    data->regs[4] = bin_to_bcd(utc.tm_mday);
+    data->regs[5] = bin_to_bcd(utc.tm_mon + 1) | ((utc.tm_year >= 200) ? 0x80 : 0);
+    data->regs[6] = bin_to_bcd(utc.tm_year % 100);
+}
+
+//  ========== regs_to_time ================================================================
+static void regs_to_time(struct ds3231_emul_data *data)
+{
+    struct tm utc = {
+        .tm_sec  = bcd_to_bin(data->regs[0] & 0x7f),
+        .tm_min  = bcd_to_bin(data->regs[1] & 0x7f),
+        .tm_hour = bcd_to_bin(data->regs[2] & 0x3f),
+        .tm_mday = bcd_to_bin(data->regs[4] & 0x3f),
+        .tm_mon  = bcd_to_bin(data->regs[5] & 0x1f) - 1,
+        .tm_year = bcd_to_bin(data->regs[6]) + ((data->regs[5] & 0x80) ? 200 : 100),
+    };
+
+    data->base_unix = timeutil_timegm64(&utc);
+    data->base_uptime_ms = k_uptime_get();
+}
+
+//  ========== ds3231_emul_transfer ========================================================
+// a write sets the register pointer then stores the following bytes, a read returns
+// the registers from the pointer, both wrap at the end of the register file
+static int ds3231_emul_transfer(const struct emul *target, struct i2c_msg *msgs,
+                                int num_msgs, int addr)
+{
+    struct ds3231_emul_data *data = target->data;
+
+    for (int m = 0; m < num_msgs; m++) {
+        struct i2c_msg *msg = &msgs[m];
+
+        if (msg->flags & I2C_MSG_READ) {
+            time_to_regs(data);
+            for (uint32_t i = 0; i < msg->len; i++) {
+                msg->buf[i] = data->regs[data->pointer];
+                data->pointer = (data->pointer + 1) % DS3231_EMUL_REGS;
+            }
+            continue;
+        }
+
+        if (msg->len == 0) {
+            continue;
+        }
+        bool time_written = false;
+        data->pointer = msg->buf[0] % DS3231_EMUL_REGS;
+        if (msg->len > 1) {
+            // keep the registers that are not written in the current time
+            time_to_regs(data);
+        }
+        for (uint32_t i = 1; i < msg->len; i++) {
+            time_written |= data->pointer < DS3231_EMUL_TIME_REGS;
+            // the oscillator stop flag can only be cleared
+            if (data->pointer == DS3231_EMUL_REG_STATUS) {
+                uint8_t *status = &data->regs[DS3231_EMUL_REG_STATUS];
+                *status = (*status & msg->buf[i] & 0x80) | (msg->buf[i] & 0x7f);
+            } else if (data->pointer < DS3231_EMUL_REG_TEMP_MSB) {
+                data->regs[data->pointer] = msg->buf[i];
+            }
+            data->pointer = (data->pointer + 1) % DS3231_EMUL_REGS;
+        }
+        if (time_written) {
+            regs_to_time(data);
+        }
+    }
+    return 0;
+}
+
+static const struct i2c_emul_api ds3231_emul_api = {
+    .transfer = ds3231_emul_transfer,
+};
+
+//  ========== ds3231_emul_init ============================================================
+static int ds3231_emul_init(const struct emul *target, const struct device *parent)
+{
+    struct ds3231_emul_data *data = target->data;
+
+    memset(data->regs, 0, sizeof(data->regs));
+    data->regs[0x0e] = 0x1c;                      // control: INTCN, 8.192 kHz, as after power-on
+    data->regs[DS3231_EMUL_REG_TEMP_MSB] = 25;    // 25 degrees
+    data->pointer = 0;
+    data->base_unix = sim_host_unix_time();
+    data->base_uptime_ms = k_uptime_get();
+    return 0;
+}
+
+#define DS3231_EMUL(n)                                                              \
+    static struct ds3231_emul_data ds3231_emul_data_##n;                            \
+    EMUL_DT_INST_DEFINE(n, ds3231_emul_init, &ds3231_emul_data_##n, NULL,           \
+                        &ds3231_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(DS3231_EMUL)
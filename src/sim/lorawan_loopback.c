@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * native_sim: stand-in for the LoRaWAN stack (CONFIG_LORAWAN is off on this board).
+ *
+ * Implements the part of the <zephyr/lorawan/lorawan.h> API used by the application.
+ * The join always succeeds and every uplink is written to --uplink-file as one line:
+ *   <unix ms> <uptime ms> <samples fed to the ADC> <frame in hex>
+ * or printed as "UL:<frame in hex>" without the option. lorawan_send() blocks for the
+ * time on air and the receive windows, as the real stack does for unconfirmed uplinks,
+ * so the scheduler and the duty-cycle budget behave as on the node.
+ *
+ * --lora-outage-at and --lora-outage-for take the gateway down for a while: the
+ * unconfirmed uplinks are lost, the confirmed ones and the joins fail.
+ *
+ * --downlink-file gives the downlinks of the network, one per line:
+ *   <uptime s> <port> <payload in hex>
+ * As in class A, each one is received after the first uplink sent from that uptime on.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/lorawan/lorawan.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "soc.h"
+
+#include "app_ds3231.h"
+#include "clock_discipline.h"
+#include "uplink.h"
+#include "sim.h"
+#include "sim_host_io.h"
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lorawan_loopback);
+
+//  ========== defines =====================================================================
+// an unconfirmed uplink returns once RX2 (RECEIVE_DELAY2) is over
+#define LOOPBACK_RX_WINDOWS_MS      2000
+// JOIN_ACCEPT_DELAY2
+#define LOOPBACK_JOIN_MS            6000
+
+//  ========== globals =====================================================================
+static const char *uplink_file;
+static const char *downlink_file;
+static int32_t loopback_dr = LORAWAN_DR_5;
+static int32_t outage_at_s = -1;
+static int32_t outage_for_s;
+
+static int uplink_fd = -1;
+static bool joined;
+static int64_t network_base_unix;
+static lorawan_dr_changed_cb_t dr_changed_cb;
+static sys_slist_t downlink_callbacks = SYS_SLIST_STATIC_INIT(&downlink_callbacks);
+
+// content of --downlink-file and the start of the next line to deliver
+static char downlinks[1024];
+static size_t downlinks_pos;
+
+// EU868 application payload limits per datarate, without MAC commands
+static const uint8_t max_payload[] = { 51, 51, 51, 115, 222, 222, 222, 222 };
+
+//  ========== loopback_options ============================================================
+static void loopback_options(void)
+{
+    static struct args_struct_t options[] = {
+        { .option = "uplink-file", .name = "path", .type = 's', .dest = (void *)&uplink_file,
+          .descript = "write every uplink to this file instead of the console" },
+        { .option = "lora-dr", .name = "dr", .type = 'i', .dest = (void *)&loopback_dr,
+          .descript = "datarate given by the loopback network (0..5, default 5)" },
+        { .option = "lora-outage-at", .name = "s", .type = 'i', .dest = (void *)&outage_at_s,
+          .descript = "uptime at which the gateway goes down" },
+        { .option = "lora-outage-for", .name = "s", .type = 'i', .dest = (void *)&outage_for_s,
+          .descript = "duration of the gateway outage" },
+        { .option = "downlink-file", .name = "path", .type = 's', .dest = (void *)&downlink_file,
+          .descript = "downlinks to receive, \"<uptime s> <port> <hex>\" per line" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(options);
+}
+NATIVE_TASK(loopback_options, PRE_BOOT_1, 1);
+
+//  ========== gateway_down ================================================================
+static bool gateway_down(void)
+{
+    int64_t uptime_s = k_uptime_get() / MSEC_PER_SEC;
+
+    return outage_at_s >= 0 && uptime_s >= outage_at_s && uptime_s < outage_at_s + outage_for_s;
+}
+
+//  ========== lorawan_start ===============================================================
+int lorawan_start(void)
+{
+    loopback_dr = CLAMP(loopback_dr, LORAWAN_DR_0, LORAWAN_DR_5);
+    network_base_unix = sim_host_unix_time() - k_uptime_get() / MSEC_PER_SEC;
+
+    if (uplink_file != NULL && uplink_fd < 0) {
+        uplink_fd = sim_host_open_write(uplink_file);
+        if (uplink_fd < 0) {
+            LOG_ERR("cannot open %s", uplink_file);
+            return -EIO;
+        }
+        static const char header[] = "# unix_ms uptime_ms adc_samples frame\n";
+        sim_host_write(uplink_fd, header, sizeof(header) - 1);
+    }
+    if (downlink_file != NULL) {
+        int fd = sim_host_open_read(downlink_file);
+        if (fd < 0) {
+            LOG_ERR("cannot open %s", downlink_file);
+            return -EIO;
+        }
+        long size = sim_host_read(fd, downlinks, sizeof(downlinks) - 1);
+        downlinks[MAX(size, 0)] = '\0';
+        sim_host_close(fd);
+    }
+    LOG_INF("loopback LoRaWAN backend, DR_%d", loopback_dr);
+    return 0;
+}
+
+//  ========== lorawan_join ================================================================
+int lorawan_join(const struct lorawan_join_config *config)
+{
+    ARG_UNUSED(config);
+
+    k_sleep(K_MSEC(LOOPBACK_JOIN_MS));
+    if (gateway_down()) {
+        return -ETIMEDOUT;
+    }
+    joined = true;
+    if (dr_changed_cb != NULL) {
+        dr_changed_cb(loopback_dr);
+    }
+    return 0;
+}
+
+//  ========== receive_downlink ============================================================
+// hand the next line of --downlink-file to the callbacks once its uptime is reached
+static void receive_downlink(void)
+{
+    uint8_t data[UINT8_MAX];
+    uint8_t len = 0;
+
+    // comments and empty lines
+    while (downlinks[downlinks_pos] == '#' || downlinks[downlinks_pos] == '\n') {
+        downlinks_pos += strcspn(&downlinks[downlinks_pos], "\n");
+        downlinks_pos += (downlinks[downlinks_pos] == '\n') ? 1 : 0;
+    }
+    char *line = &downlinks[downlinks_pos];
+    char *end;
+    long at_s = strtol(line, &end, 10);
+    if (end == line || at_s > k_uptime_get() / MSEC_PER_SEC) {
+        return;
+    }
+    uint8_t port = (uint8_t)strtol(end, &end, 10);
+    while (*end == ' ') {
+        end++;
+    }
+    while (len < sizeof(data) && isxdigit((unsigned char)end[0]) && isxdigit((unsigned char)end[1])) {
+        char hex[3] = { end[0], end[1], '\0' };
+        data[len++] = (uint8_t)strtoul(hex, NULL, 16);
+        end += 2;
+    }
+    downlinks_pos += strcspn(line, "\n");
+    downlinks_pos += (downlinks[downlinks_pos] == '\n') ? 1 : 0;
+
+    LOG_DBG("downlink of %u bytes on port %u", len, port);
+    struct lorawan_downlink_cb *cb;
+    SYS_SLIST_FOR_EACH_CONTAINER(&downlink_callbacks, cb, node) {
+        if (cb->port == LW_RECV_PORT_ANY || cb->port == port) {
+            cb->cb(port, 0, -60, 10, len, data);
+        }
+    }
+}
+
+//  ========== lorawan_send ================================================================
+int lorawan_send(uint8_t port, uint8_t *data, uint8_t len, enum lorawan_message_type type)
+{
+    if (!joined) {
+        return -EAGAIN;
+    }
+    if (len > max_payload[loopback_dr]) {
+        return -EMSGSIZE;
+    }
+
+    // the frame leaves at the end of the transmission, then the receive windows follow
+    k_sleep(K_USEC(uplink_time_on_air_us(loopback_dr, len)));
+    if (gateway_down()) {
+        k_sleep(K_MSEC(LOOPBACK_RX_WINDOWS_MS));
+        LOG_DBG("gateway down, uplink of %d bytes lost", len);
+        // no acknowledgement
+        return (type == LORAWAN_MSG_CONFIRMED) ? -ETIMEDOUT : 0;
+    }
+
+    char line[64 + 2 * UINT8_MAX];
+    int pos = 0;
+    if (uplink_fd >= 0) {
+        pos = snprintf(line, sizeof(line), "%llu %lld %u ",
+                       (unsigned long long)app_get_timestamp(), k_uptime_get(),
+                       sim_adc_feed_get_count());
+    } else {
+        pos = snprintf(line, sizeof(line), "UL:");
+    }
+    for (int i = 0; i < len; i++) {
+        pos += snprintf(&line[pos], sizeof(line) - pos, "%02x", data[i]);
+    }
+    line[pos++] = '\n';
+
+    if (uplink_fd >= 0) {
+        sim_host_write(uplink_fd, line, pos);
+    } else {
+        printk("%.*s", pos, line);
+    }
+    LOG_DBG("uplink of %d bytes on port %d", len, port);
+
+    k_sleep(K_MSEC(LOOPBACK_RX_WINDOWS_MS));
+    receive_downlink();
+    return 0;
+}
+
+//  ========== lorawan_register_downlink_callback ==========================================
+void lorawan_register_downlink_callback(struct lorawan_downlink_cb *cb)
+{
+    sys_slist_append(&downlink_callbacks, &cb->node);
+}
+
+//  ========== lorawan_register_dr_changed_callback ========================================
+void lorawan_register_dr_changed_callback(lorawan_dr_changed_cb_t cb)
+{
+    dr_changed_cb = cb;
+}
+
+//  ========== lorawan_get_payload_sizes ===================================================
+void lorawan_get_payload_sizes(uint8_t *max_next_payload_size, uint8_t *max_payload_size)
+{
+    *max_next_payload_size = max_payload[loopback_dr];
+    *max_payload_size = max_payload[loopback_dr];
+}
+
+//  ========== lorawan_request_device_time =================================================
+int lorawan_request_device_time(bool force_request)
+{
+    ARG_UNUSED(force_request);
+    return joined ? 0 : -EAGAIN;
+}
+
+//  ========== lorawan_device_time_get =====================================================
+// the network time is the wall clock of the host at start, then runs on the kernel
+// uptime as the DS3231 emulator does, so it stays consistent without real time
+int lorawan_device_time_get(uint32_t *gps_time)
+{
+    int64_t unix_time = network_base_unix + k_uptime_get() / MSEC_PER_SEC;
+
+    *gps_time = (uint32_t)(unix_time - CLOCK_GPS_EPOCH);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * native_sim: prints the power_stats figures every --power-report seconds.
+ *
+ * Code runs in zero simulated time on native_sim, so the active time of the kernel
+ * statistics stays at 0. The CPU time of the host process is printed instead, per
+ * simulated second, to compare the ADC_BLOCK_SIZE settings against each other.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+
+#include "cmdline.h"
+#include "soc.h"
+
+#include "power_stats.h"
+#include "sim.h"
+#include "sim_host_io.h"
+
+//  ========== globals =====================================================================
+static int32_t report_period_s;
+
+static int64_t last_cpu_us;
+static int64_t last_uptime_ms;
+
+static void power_report_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(report_work, power_report_handler);
+
+//  ========== power_report_options ========================================================
+static void power_report_options(void)
+{
+    static struct args_struct_t options[] = {
+        { .option = "power-report", .name = "s", .type = 'i', .dest = (void *)&report_period_s,
+          .descript = "print the wakeup rates and the host CPU time every s simulated seconds" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(options);
+}
+NATIVE_TASK(power_report_options, PRE_BOOT_1, 1);
+
+//  ========== power_report_handler ========================================================
+static void power_report_handler(struct k_work *work)
+{
+    int64_t cpu_us = sim_host_cpu_time_us();
+    int64_t uptime_ms = k_uptime_get();
+
+    power_stats_print(true);
+    if (uptime_ms > last_uptime_ms) {
+        printk("host cpu %lld us per simulated s\n",
+               (cpu_us - last_cpu_us) * MSEC_PER_SEC / (uptime_ms - last_uptime_ms));
+    }
+    last_cpu_us = cpu_us;
+    last_uptime_ms = uptime_ms;
+
+    k_work_schedule(&report_work, K_SECONDS(report_period_s));
+}
+
+//  ========== power_report_init ===========================================================
+static int power_report_init(void)
+{
+    if (report_period_s > 0) {
+        last_cpu_us = sim_host_cpu_time_us();
+        last_uptime_ms = k_uptime_get();
+        k_work_schedule(&report_work, K_SECONDS(report_period_s));
+    }
+    return 0;
+}
+SYS_INIT(power_report_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
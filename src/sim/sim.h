@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * native_sim stand-ins for the node peripherals:
+ *  - adc_feed.c: ADC emulator fed from a recorded geophone file (--adc-file, --adc-once)
+ *  - ds3231_emul.c: DS3231 on the I2C emulator controller
+ *  - lorawan_loopback.c: LoRaWAN API writing the uplinks to a file (--uplink-file, --lora-dr,
+ *    --lora-outage-at, --lora-outage-for, --downlink-file)
+ *  - power_report.c: wakeup rates and CPU time printed periodically (--power-report)
+ *  - sim_host_io.c: host file access, built in the native simulator runner
+ * The flash simulator of native_sim backs lfs_storage (--flash=<file>).
+ */
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+
+//  ========== prototypes ==================================================================
+// number of geophone samples handed to the ADC emulator so far
+uint32_t sim_adc_feed_get_count(void);
+
+#endif /* SIM_H */
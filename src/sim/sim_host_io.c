@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// built into the native simulator runner with the host C library, see CMakeLists.txt
+
+//  ========== includes ====================================================================
+#include "sim_host_io.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+//  ========== sim_host_open_read ==========================================================
+int sim_host_open_read(const char *path)
+{
+    return open(path, O_RDONLY);
+}
+
+//  ========== sim_host_open_write =========================================================
+int sim_host_open_write(const char *path)
+{
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+//  ========== sim_host_read ===============================================================
+long sim_host_read(int fd, void *buffer, unsigned long size)
+{
+    return read(fd, buffer, size);
+}
+
+//  ========== sim_host_write ==============================================================
+long sim_host_write(int fd, const void *buffer, unsigned long size)
+{
+    return write(fd, buffer, size);
+}
+
+//  ========== sim_host_rewind =============================================================
+int sim_host_rewind(int fd)
+{
+    return (lseek(fd, 0, SEEK_SET) < 0) ? -1 : 0;
+}
+
+//  ========== sim_host_close ==============================================================
+int sim_host_close(int fd)
+{
+    return close(fd);
+}
+
+//  ========== sim_host_unix_time ==========================================================
+int64_t sim_host_unix_time(void)
+{
+    return (int64_t)time(NULL);
+}
+
+//  ========== sim_host_cpu_time_us ========================================================
+int64_t sim_host_cpu_time_us(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+        return -1;
+    }
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SIM_HOST_IO_H
+#define SIM_HOST_IO_H
+
+/*
+ * Host file access for the native_sim stand-ins.
+ *
+ * sim_host_io.c is built with the host C library, in the native simulator runner, so
+ * this header must not depend on the Zephyr or the host headers.
+ */
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+
+//  ========== prototypes ==================================================================
+// return a host file descriptor, or -1
+int sim_host_open_read(const char *path);
+int sim_host_open_write(const char *path);
+
+// return the number of bytes transferred, 0 at the end of the file, or -1
+long sim_host_read(int fd, void *buffer, unsigned long size);
+long sim_host_write(int fd, const void *buffer, unsigned long size);
+
+int sim_host_rewind(int fd);
+int sim_host_close(int fd);
+
+// wall clock of the host in unix seconds
+int64_t sim_host_unix_time(void);
+
+// CPU time used by the host process in us, the simulated CPU time does not advance
+int64_t sim_host_cpu_time_us(void);
+
+#endif /* SIM_HOST_IO_H */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "spectral.h"
+#include "dsp_kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+//  ========== defines =====================================================================
+#define HALF                        (SPECTRAL_FFT_SIZE / 2)
+
+// windowed samples are x * w >> WINDOW_SHIFT: 2^23 at most, and the 128-point FFT
+// grows them by 2^7 at most, so the butterflies stay below 2^30
+#define WINDOW_SHIFT                7
+
+//  ========== globals =====================================================================
+static const uint16_t band_edges_hz[SPECTRAL_BANDS + 1] = SPECTRAL_BAND_EDGES_HZ;
+
+//  ========== q15 =========================================================================
+static int16_t q15(double v)
+{
+    long r = lround(v * 32768.0);
+    return (int16_t)((r > 32767) ? 32767 : ((r < -32768) ? -32768 : r));
+}
+
+//  ========== spectral_init ===============================================================
+void spectral_init(struct spectral *s, uint32_t sampling_rate_ms)
+{
+    const double pi = 3.14159265358979323846;
+    double window_energy = 0.0;
+
+    memset(s, 0, sizeof(*s));
+    s->sampling_rate_ms = sampling_rate_ms;
+
+    for (int n = 0; n < SPECTRAL_FFT_SIZE; n++) {
+        double w = 0.5 - 0.5 * cos(2.0 * pi * n / SPECTRAL_FFT_SIZE);
+        s->window[n] = q15(w);
+        window_energy += w * w;
+    }
+    for (int k = 0; k < HALF; k++) {
+        s->cos_tab[k] = q15(cos(2.0 * pi * k / SPECTRAL_FFT_SIZE));
+        s->sin_tab[k] = q15(sin(2.0 * pi * k / SPECTRAL_FFT_SIZE));
+    }
+
+    // one-sided mean square of a bin, as scipy's spectrogram density times the bin width,
+    // undoing the 2^(15 - WINDOW_SHIFT) gain of the windowed samples
+    double gain = (double)(1 << (15 - WINDOW_SHIFT));
+    s->scale = (float)(2.0 / (SPECTRAL_FFT_SIZE * window_energy * gain * gain));
+
+    // bins of the bands, f = k * fs / N
+    uint32_t nyquist_bin = HALF;
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        uint32_t lo = (band_edges_hz[b] * SPECTRAL_FFT_SIZE * sampling_rate_ms + 999) / 1000;
+        uint32_t hi = (band_edges_hz[b + 1] * SPECTRAL_FFT_SIZE * sampling_rate_ms + 999) / 1000;
+        s->band_lo[b] = (lo > nyquist_bin) ? nyquist_bin + 1 : lo;
+        s->band_hi[b] = (hi > nyquist_bin) ? nyquist_bin + 1 : hi;
+    }
+}
+
+//  ========== fft =========================================================================
+// in-place radix-2 decimation in time complex FFT of HALF points, unscaled
+static void fft(struct spectral *s)
+{
+    int32_t *re = s->re, *im = s->im;
+
+    // bit reversal permutation
+    for (uint32_t i = 1, j = 0; i < HALF; i++) {
+        uint32_t bit = HALF >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int32_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    for (uint32_t len = 2; len <= HALF; len <<= 1) {
+        // W_len^j = W_N^(j * N / len)
+        uint32_t step = SPECTRAL_FFT_SIZE / len;
+        for (uint32_t i = 0; i < HALF; i += len) {
+            for (uint32_t j = 0; j < len / 2; j++) {
+                int32_t wr = s->cos_tab[j * step];
+                int32_t wi = -s->sin_tab[j * step];
+                uint32_t a = i + j, b = a + len / 2;
+
+                int32_t vr = (int32_t)(((int64_t)re[b] * wr - (int64_t)im[b] * wi) >> 15);
+                int32_t vi = (int32_t)(((int64_t)re[b] * wi + (int64_t)im[b] * wr) >> 15);
+                re[b] = re[a] - vr;
+                im[b] = im[a] - vi;
+                re[a] += vr;
+                im[a] += vi;
+            }
+        }
+    }
+}
+
+//  ========== features ====================================================================
+static void features(const struct spectral *s, const float *power, float scale,
+                     struct spectral_payload_t *out)
+{
+    // dominant frequency, DC excluded
+    int peak = 1;
+    for (int k = 2; k < SPECTRAL_BINS; k++) {
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+    out->dominant = (uint16_t)(peak * 10000U / (s->sampling_rate_ms * SPECTRAL_FFT_SIZE));
+
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        float sum = 0.0f;
+        for (int k = s->band_lo[b]; k < s->band_hi[b]; k++) {
+            sum += power[k];
+        }
+        float rms = sqrtf(sum * scale) * 100.0f;
+        out->bands[b] = (rms > 65535.0f) ? 65535 : (uint16_t)lroundf(rms);
+    }
+}
+
+//  ========== windowed ====================================================================
+// x - mean saturated to Q15, times the window
+static int32_t windowed(int32_t x, int32_t mean, int16_t w)
+{
+    int32_t d = x - mean;
+    d = (d > 32767) ? 32767 : ((d < -32768) ? -32768 : d);
+    return (d * w) >> WINDOW_SHIFT;
+}
+
+//  ========== spectral_process ============================================================
+void spectral_process(struct spectral *s, const int16_t *frame, struct spectral_payload_t *out)
+{
+    int32_t mean = dsp_mean_q15(frame, SPECTRAL_FFT_SIZE);
+
+    // even samples to the real part, odd samples to the imaginary part
+    for (int n = 0; n < HALF; n++) {
+        s->re[n] = windowed(frame[2 * n], mean, s->window[2 * n]);
+        s->im[n] = windowed(frame[2 * n + 1], mean, s->window[2 * n + 1]);
+    }
+    fft(s);
+
+    // split the HALF-point spectrum Z into the real spectrum X, k = 0 .. N/2:
+    // X[k] = (Z[k] + conj(Z[-k])) / 2 - i W^k (Z[k] - conj(Z[-k])) / 2
+    for (int k = 0; k <= HALF; k++) {
+        int a = k % HALF, b = (HALF - k) % HALF;
+        int64_t ar = (int64_t)s->re[a] + s->re[b];
+        int64_t ai = (int64_t)s->im[a] - s->im[b];
+        int64_t br = (int64_t)s->re[a] - s->re[b];
+        int64_t bi = (int64_t)s->im[a] + s->im[b];
+        int32_t c = (k < HALF) ? s->cos_tab[k] : -32768;
+        int32_t sn = (k < HALF) ? s->sin_tab[k] : 0;
+
+        float xr = (float)(ar + ((c * bi - sn * br) >> 15)) * 0.5f;
+        float xi = (float)(ai - ((c * br + sn * bi) >> 15)) * 0.5f;
+        float p = xr * xr + xi * xi;
+
+        // DC and Nyquist are not doubled in a one-sided spectrum
+        s->power[k] = (k == 0 || k == HALF) ? p * 0.5f : p;
+        s->average[k] += s->power[k];
+    }
+    s->frames++;
+
+    features(s, s->power, s->scale, out);
+}
+
+//  ========== spectral_take_average =======================================================
+uint32_t spectral_take_average(struct spectral *s, struct spectral_payload_t *out)
+{
+    uint32_t frames = s->frames;
+
+    memset(out, 0, sizeof(*out));
+    if (frames > 0) {
+        features(s, s->average, s->scale / frames, out);
+    }
+    memset(s->average, 0, sizeof(s->average));
+    s->frames = 0;
+    return frames;
+}
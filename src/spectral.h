@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+
+#include "data_types.h"
+
+//  ========== defines =====================================================================
+// frame length and hop, 50 % overlap as the offline spectrogram (nperseg=256)
+#define SPECTRAL_FFT_SIZE           256
+#define SPECTRAL_HOP                (SPECTRAL_FFT_SIZE / 2)
+#define SPECTRAL_BINS               (SPECTRAL_FFT_SIZE / 2 + 1)
+
+// band edges in Hz, SPECTRAL_BANDS bands from one edge to the next, the last one is
+// clamped to the Nyquist frequency
+#define SPECTRAL_BAND_EDGES_HZ      { 1, 4, 10, 20, 50 }
+
+//  ========== types =======================================================================
+/**
+ * @brief spectral features of a real signal, from a 256-point FFT
+ *
+ * The real FFT is computed as a 128-point complex FFT of the even/odd samples followed
+ * by a split step. Window and twiddles are Q15, butterflies are 32-bit, with enough
+ * headroom that no stage needs scaling. Power and band energies are in float.
+ */
+struct spectral {
+    uint32_t sampling_rate_ms;
+    int16_t window[SPECTRAL_FFT_SIZE];              // periodic Hann, Q15
+    int16_t cos_tab[SPECTRAL_FFT_SIZE / 2];         // cos(2 pi k / N), Q15
+    int16_t sin_tab[SPECTRAL_FFT_SIZE / 2];
+    int32_t re[SPECTRAL_FFT_SIZE / 2];
+    int32_t im[SPECTRAL_FFT_SIZE / 2];
+    float power[SPECTRAL_BINS];                     // mV^2, one-sided, last frame
+    float average[SPECTRAL_BINS];                   // sum of the frame powers
+    uint32_t frames;                                // frames in average
+    uint16_t band_lo[SPECTRAL_BANDS];               // first bin of each band
+    uint16_t band_hi[SPECTRAL_BANDS];               // bin after the band
+    float scale;                                    // power of a bin to mean square in mV^2
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief compute the window, the twiddles and the band bins for a sampling period
+ */
+void spectral_init(struct spectral *s, uint32_t sampling_rate_ms);
+
+/**
+ * @brief analyse one frame of SPECTRAL_FFT_SIZE samples and add it to the average
+ *
+ * The frame mean is removed first, as the offline spectrogram does (detrend='constant').
+ */
+void spectral_process(struct spectral *s, const int16_t *frame, struct spectral_payload_t *out);
+
+/**
+ * @brief features of the mean spectrum of the frames processed since the last call,
+ * then restart the average
+ *
+ * @return the number of frames averaged
+ */
+uint32_t spectral_take_average(struct spectral *s, struct spectral_payload_t *out);
+
+#endif /* SPECTRAL_H */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "sta_lta.h"
+
+#include <string.h>
+
+//  ========== energy ======================================================================
+static inline uint32_t energy(int16_t sample, int16_t offset)
+{
+    int32_t x = (int32_t)sample - offset;
+    uint32_t a = (uint32_t)(x < 0 ? -x : x);
+    return a * a;
+}
+
+//  ========== sta_lta_init ================================================================
+void sta_lta_init(struct sta_lta *d, uint8_t mode, int16_t *history,
+                  size_t sta_len, size_t lta_len, int16_t offset)
+{
+    memset(d, 0, sizeof(*d));
+    d->mode = mode;
+    d->offset = offset;
+    d->sta_len = sta_len;
+    d->lta_len = lta_len;
+    d->history = history;
+}
+
+//  ========== sta_lta_update ==============================================================
+float sta_lta_update(struct sta_lta *d, int16_t sample)
+{
+    uint32_t e = energy(sample, d->offset);
+
+    if (d->mode == STA_LTA_MODE_RECURSIVE) {
+        if (d->count == 0) {
+            // start from the first energy instead of zero to shorten the warm-up
+            d->sta = (float)e;
+            d->lta = (float)e;
+        } else {
+            d->sta += ((float)e - d->sta) / (float)d->sta_len;
+            d->lta += ((float)e - d->lta) / (float)d->lta_len;
+        }
+    } else {
+        // the sample leaving the STA window is sta_len samples behind the newest one
+        size_t sta_out = d->pos + d->lta_len - d->sta_len;
+        if (sta_out >= d->lta_len) {
+            sta_out -= d->lta_len;
+        }
+
+        if (d->count >= d->lta_len) {
+            d->lta_sum -= energy(d->history[d->pos], d->offset);
+        }
+        if (d->count >= d->sta_len) {
+            d->sta_sum -= energy(d->history[sta_out], d->offset);
+        }
+        d->sta_sum += e;
+        d->lta_sum += e;
+
+        d->history[d->pos] = sample;
+        if (++d->pos == d->lta_len) {
+            d->pos = 0;
+        }
+    }
+
+    if (d->count < d->lta_len) {
+        d->count++;
+    }
+    if (d->count < d->lta_len) {
+        return 0.0f;
+    }
+
+    float lta = sta_lta_get_lta(d);
+    return (lta > 0.0f) ? (sta_lta_get_sta(d) / lta) : 0.0f;
+}
+
+//  ========== sta_lta_get_sta =============================================================
+float sta_lta_get_sta(const struct sta_lta *d)
+{
+    if (d->mode == STA_LTA_MODE_RECURSIVE) {
+        return d->sta;
+    }
+    return (float)d->sta_sum / (float)d->sta_len;
+}
+
+//  ========== sta_lta_get_lta =============================================================
+float sta_lta_get_lta(const struct sta_lta *d)
+{
+    if (d->mode == STA_LTA_MODE_RECURSIVE) {
+        return d->lta;
+    }
+    return (float)d->lta_sum / (float)d->lta_len;
+}
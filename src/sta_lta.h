@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STA_LTA_H
+#define STA_LTA_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//  ========== defines =====================================================================
+// ways of computing the STA/LTA ratio, selected with STA_LTA_MODE in config.h
+#define STA_LTA_MODE_WINDOWED       0   // recompute both windows from the ADC ring (legacy)
+#define STA_LTA_MODE_RUNNING        1   // exact running sums over the same windows, O(1)
+#define STA_LTA_MODE_RECURSIVE      2   // classic recursive (exponential) STA/LTA, O(1), no history
+
+//  ========== types =======================================================================
+/**
+ * @brief streaming STA/LTA detector state
+ *
+ * The energy of a sample is (x - offset)^2, offset is 0 for DC-free input.
+ *
+ * In running mode the STA and LTA are the mean energies over the last sta_len and
+ * lta_len samples, exactly as the windowed computation. The integer sums are exact,
+ * the ratio stays within 1e-4 (relative) of the windowed float computation, whose
+ * own float accumulation is the main source of the difference.
+ *
+ * In recursive mode sta += (e - sta) / sta_len and lta += (e - lta) / lta_len.
+ * It reacts with an exponential instead of a boxcar response: on the recorded data
+ * the ratio differs from the windowed one by up to ~60% on the noise and through a
+ * burst, triggers a few samples later, and falls back much more slowly once the burst
+ * has left the STA window, so it is not a drop-in equivalent of the windowed ratio.
+ */
+struct sta_lta {
+    uint8_t mode;
+    int16_t offset;
+    size_t sta_len;
+    size_t lta_len;
+    int16_t *history;      // lta_len samples, running mode only
+    size_t pos;             // index of the oldest sample of history
+    uint32_t count;         // samples seen, saturates at lta_len
+    uint64_t sta_sum;
+    uint64_t lta_sum;
+    float sta;
+    float lta;
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief initialize a detector
+ *
+ * @param history buffer of @p lta_len samples, may be NULL in recursive mode
+ * @param offset DC offset removed before computing the energy
+ */
+void sta_lta_init(struct sta_lta *d, uint8_t mode, int16_t *history,
+                  size_t sta_len, size_t lta_len, int16_t offset);
+
+/**
+ * @brief feed one sample and return the updated STA/LTA ratio
+ *
+ * @return the ratio, 0 until lta_len samples have been seen
+ */
+float sta_lta_update(struct sta_lta *d, int16_t sample);
+
+/**
+ * @brief current mean energies of the short and long windows
+ */
+float sta_lta_get_sta(const struct sta_lta *d);
+float sta_lta_get_lta(const struct sta_lta *d);
+
+#endif /* STA_LTA_H */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "stats_engine.h"
+
+#include <math.h>
+#include <string.h>
+
+//  ========== globals =====================================================================
+// number of rollups of the level below in each level
+static const uint8_t rollup_span[STATS_ROLLUP_LEVELS] = { 1, 10, 6 };
+
+static const float percentile_p[STATS_PERCENTILES] = { 0.50f, 0.90f, 0.99f };
+
+//  ========== stats_acc ===================================================================
+void stats_acc_reset(struct stats_acc *acc)
+{
+    acc->count = 0;
+    acc->min = INT16_MAX;
+    acc->max = INT16_MIN;
+    acc->sum = 0;
+    acc->sum_sq = 0;
+}
+
+void stats_acc_add(struct stats_acc *acc, int16_t x)
+{
+    acc->count++;
+    acc->min = (x < acc->min) ? x : acc->min;
+    acc->max = (x > acc->max) ? x : acc->max;
+    acc->sum += x;
+    acc->sum_sq += (uint64_t)((int32_t)x * x);
+}
+
+void stats_acc_merge(struct stats_acc *acc, const struct stats_acc *other)
+{
+    acc->count += other->count;
+    acc->min = (other->min < acc->min) ? other->min : acc->min;
+    acc->max = (other->max > acc->max) ? other->max : acc->max;
+    acc->sum += other->sum;
+    acc->sum_sq += other->sum_sq;
+}
+
+static void summarize(const struct stats_acc *acc, struct stats_summary *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->count = acc->count;
+    if (acc->count == 0) {
+        return;
+    }
+    out->min = acc->min;
+    out->max = acc->max;
+    out->mean = (int16_t)lroundf((float)acc->sum / acc->count);
+    out->rms = (uint16_t)lroundf(sqrtf((float)acc->sum_sq / acc->count));
+    out->p2p = (uint16_t)(acc->max - acc->min);
+}
+
+//  ========== stats_hist ==================================================================
+void stats_hist_reset(struct stats_hist *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+void stats_hist_add(struct stats_hist *hist, int16_t x)
+{
+    uint32_t a = (uint32_t)((x < 0) ? -(int32_t)x : x);
+    uint32_t bin = a;
+
+    // above the exact range: octave from the leading bit, then its top sub-bits
+    if (a >= (1U << STATS_HIST_SUB_BITS)) {
+        uint32_t octave = 31 - __builtin_clz(a) - STATS_HIST_SUB_BITS;
+        uint32_t sub = (a >> octave) & ((1U << STATS_HIST_SUB_BITS) - 1);
+        bin = ((octave + 1) << STATS_HIST_SUB_BITS) + sub;
+    }
+    hist->bins[bin]++;
+    hist->count++;
+}
+
+// lowest amplitude of a bin and its width
+static void stats_hist_bin(uint32_t bin, uint32_t *low, uint32_t *width)
+{
+    uint32_t octave = bin >> STATS_HIST_SUB_BITS;
+
+    if (octave == 0) {
+        *low = bin;
+        *width = 1;
+        return;
+    }
+    *width = 1U << (octave - 1);
+    *low = ((1U << STATS_HIST_SUB_BITS) + (bin & ((1U << STATS_HIST_SUB_BITS) - 1))) * *width;
+}
+
+uint16_t stats_hist_quantile(const struct stats_hist *hist, float p)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)lroundf(p * (hist->count - 1));
+    uint32_t seen = 0, bin = 0;
+
+    while (seen + hist->bins[bin] <= rank) {
+        seen += hist->bins[bin++];
+    }
+    uint32_t low, width;
+    stats_hist_bin(bin, &low, &width);
+    return (uint16_t)(low + (width - 1) / 2);
+}
+
+//  ========== stats_engine_init ===========================================================
+void stats_engine_init(struct stats_engine *e, uint32_t sampling_rate_ms)
+{
+    memset(e, 0, sizeof(*e));
+    e->samples_per_min = 60000 / sampling_rate_ms;
+
+    for (int i = 0; i < STATS_ROLLUP_LEVELS; i++) {
+        stats_acc_reset(&e->rollup[i]);
+    }
+    stats_acc_reset(&e->period);
+    stats_hist_reset(&e->amplitude);
+}
+
+//  ========== stats_engine_update =========================================================
+void stats_engine_update(struct stats_engine *e, int16_t x)
+{
+    stats_acc_add(&e->rollup[STATS_ROLLUP_1MIN], x);
+    stats_acc_add(&e->period, x);
+
+    stats_hist_add(&e->amplitude, x);
+
+    if (e->rollup[STATS_ROLLUP_1MIN].count < e->samples_per_min) {
+        return;
+    }
+
+    // a minute is complete, push it up the levels
+    for (int level = 0; level < STATS_ROLLUP_LEVELS; level++) {
+        if (level > 0) {
+            stats_acc_merge(&e->rollup[level], &e->rollup[level - 1]);
+            stats_acc_reset(&e->rollup[level - 1]);
+            if (++e->merged[level] < rollup_span[level]) {
+                return;
+            }
+            e->merged[level] = 0;
+        }
+        summarize(&e->rollup[level], &e->last[level]);
+    }
+    stats_acc_reset(&e->rollup[STATS_ROLLUP_LEVELS - 1]);
+}
+
+//  ========== stats_engine_take_period ====================================================
+void stats_engine_take_period(struct stats_engine *e, struct stats_summary *out)
+{
+    summarize(&e->period, out);
+    for (int i = 0; i < STATS_PERCENTILES; i++) {
+        out->percentiles[i] = stats_hist_quantile(&e->amplitude, percentile_p[i]);
+    }
+    stats_acc_reset(&e->period);
+    stats_hist_reset(&e->amplitude);
+}
+
+//  ========== stats_engine_get_rollup =====================================================
+int stats_engine_get_rollup(const struct stats_engine *e, int level, struct stats_summary *out)
+{
+    if (level < 0 || level >= STATS_ROLLUP_LEVELS || e->last[level].count == 0) {
+        return -1;
+    }
+    *out = e->last[level];
+    return 0;
+}
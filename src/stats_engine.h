@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STATS_ENGINE_H
+#define STATS_ENGINE_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// rollup levels, each one made of a whole number of the level below
+#define STATS_ROLLUP_1MIN           0
+#define STATS_ROLLUP_10MIN          1
+#define STATS_ROLLUP_1H             2
+#define STATS_ROLLUP_LEVELS         3
+
+// percentiles estimated over the period, of the absolute amplitude
+#define STATS_PERCENTILES           3       // p50, p90, p99
+
+// amplitude histogram: exact below 2^(STATS_HIST_SUB_BITS + 1), then 2^STATS_HIST_SUB_BITS
+// bins per octave up to 2^15, their middle within 1.6 % of any amplitude they hold
+#define STATS_HIST_SUB_BITS         5
+#define STATS_HIST_BINS             ((16 - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+
+//  ========== types =======================================================================
+// exact moments of a set of samples, can be merged
+struct stats_acc {
+    uint32_t count;
+    int16_t min;
+    int16_t max;
+    int64_t sum;
+    uint64_t sum_sq;
+};
+
+/**
+ * @brief histogram of the absolute amplitude, log-linear bins
+ *
+ * O(1) per sample and fixed memory whatever the number of samples. Unlike a P-square
+ * estimator, it does not depend on the order of the samples: the bursts of an event do
+ * not drag the percentiles of the rest of the period.
+ */
+struct stats_hist {
+    uint32_t count;
+    uint32_t bins[STATS_HIST_BINS];
+};
+
+// summary of a rollup or of the period, in the sample unit
+struct stats_summary {
+    uint32_t count;
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+    uint16_t rms;
+    uint16_t p2p;           // peak to peak
+    uint16_t percentiles[STATS_PERCENTILES];
+};
+
+struct stats_engine {
+    uint32_t samples_per_min;
+    struct stats_acc rollup[STATS_ROLLUP_LEVELS];       // being filled
+    uint8_t merged[STATS_ROLLUP_LEVELS];                // lower level rollups merged in
+    struct stats_summary last[STATS_ROLLUP_LEVELS];     // last complete rollup
+    struct stats_acc period;
+    struct stats_hist amplitude;
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief initialize the engine for a sampling period
+ */
+void stats_engine_init(struct stats_engine *e, uint32_t sampling_rate_ms);
+
+/**
+ * @brief add one sample to the rollups and the period, O(1)
+ */
+void stats_engine_update(struct stats_engine *e, int16_t x);
+
+/**
+ * @brief summary of the period since the last call, then start a new period
+ */
+void stats_engine_take_period(struct stats_engine *e, struct stats_summary *out);
+
+/**
+ * @brief last complete rollup of a level
+ *
+ * @return 0 on success, -1 if no rollup of this level is complete yet
+ */
+int stats_engine_get_rollup(const struct stats_engine *e, int level, struct stats_summary *out);
+
+void stats_acc_reset(struct stats_acc *acc);
+void stats_acc_add(struct stats_acc *acc, int16_t x);
+void stats_acc_merge(struct stats_acc *acc, const struct stats_acc *other);
+
+void stats_hist_reset(struct stats_hist *hist);
+void stats_hist_add(struct stats_hist *hist, int16_t x);
+
+/**
+ * @brief amplitude of nearest rank p, the middle of its bin
+ *
+ * @return 0 without any sample
+ */
+uint16_t stats_hist_quantile(const struct stats_hist *hist, float p);
+
+#endif /* STATS_ENGINE_H */
@@ -0,0 +1,623 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "uplink.h"
+#include "uplink_log.h"
+#include "lorawan.h"
+#include "clock_discipline.h"
+#include "packet_codec.h"
+#include "health.h"
+
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(uplink);
+
+// the first byte of a v1 frame is its type, the one of a v2 frame holds the version
+BUILD_ASSERT(PACKET_TYPE_END <= 16, "packet types must fit the record type nibble");
+BUILD_ASSERT(PACKET_TYPE_END <= (PACKET_V2_VERSION << 4),
+             "a packet type collides with the v2 version nibble");
+
+//  ========== globals =====================================================================
+K_THREAD_STACK_DEFINE(uplink_stack, 3072);   // LittleFS calls for the uplink log
+struct k_thread uplink_thread_data;
+
+// one queued uplink
+struct uplink_msg {
+    uint32_t seq;               // in the uplink log, UPLINK_LOG_NONE if it is not there
+    uint64_t timestamp;
+    int64_t queued_ms;          // uptime when it was queued
+    uint8_t type;
+    uint8_t size;
+    uint8_t payload[PACKET_MAX_PAYLOAD];
+};
+
+K_MSGQ_DEFINE(uplink_anomaly_msgq, sizeof(struct uplink_msg), UPLINK_QUEUE_ANOMALY, 4);
+K_MSGQ_DEFINE(uplink_bth_msgq, sizeof(struct uplink_msg), UPLINK_QUEUE_BTH, 4);
+K_MSGQ_DEFINE(uplink_periodic_msgq, sizeof(struct uplink_msg), UPLINK_QUEUE_PERIODIC, 4);
+
+static struct k_msgq *const queues[UPLINK_PRIO_WAVEFORM] = {
+    [UPLINK_PRIO_ANOMALY] = &uplink_anomaly_msgq,
+    [UPLINK_PRIO_BTH] = &uplink_bth_msgq,
+    [UPLINK_PRIO_PERIODIC] = &uplink_periodic_msgq,
+};
+
+// samples of a captured event, still to be sent
+struct uplink_waveform {
+    uint8_t slot;
+    uint8_t seq;                // next fragment number
+    uint16_t next;              // next sample to send in slot->samples
+    uint16_t end;
+};
+
+// lowest priority, fragmented lazily from the event slot
+K_MSGQ_DEFINE(uplink_waveform_msgq, sizeof(struct uplink_waveform), UPLINK_QUEUE_WAVEFORM, 4);
+
+// given on each enqueue, wakes the scheduler while it waits for airtime
+K_SEM_DEFINE(uplink_sem, 0, 1);
+
+static atomic_t dropped = ATOMIC_INIT(0);
+
+// messages of a priority left in the uplink log because its queue was full, loaded back
+// by the scheduler from `offset` on. Until then the new ones queue in the log behind them.
+struct spill {
+    bool active;
+    uint32_t offset;
+};
+
+static struct spill spills[UPLINK_PRIO_WAVEFORM];
+static struct k_spinlock spill_lock;
+
+//  ========== duty cycle ==================================================================
+// EU868 sub-bands (ETSI EN 300 220), the duty cycle is 1/divisor.
+// The budget is a token bucket of airtime refilled at the duty-cycle rate and capped at
+// one averaging window, as the LoRaMAC band time credits.
+struct duty_band {
+    const char *name;
+    uint32_t divisor;
+    int64_t credit_us;          // airtime that can be sent right now
+    int64_t last_ms;            // uptime of the last refill
+};
+
+enum {
+    BAND_G = 0,                 // 865.0 - 868.0 MHz, 1 %
+    BAND_G1,                    // 868.0 - 868.6 MHz, 1 %
+    BAND_G2,                    // 868.7 - 869.2 MHz, 0.1 %
+    BAND_G3,                    // 869.4 - 869.65 MHz, 10 %
+    BAND_COUNT,
+};
+
+static struct duty_band bands[BAND_COUNT] = {
+    [BAND_G] = { .name = "g", .divisor = 100 },
+    [BAND_G1] = { .name = "g1", .divisor = 100 },
+    [BAND_G2] = { .name = "g2", .divisor = 1000 },
+    [BAND_G3] = { .name = "g3", .divisor = 10 },
+};
+
+// The stack picks the channel itself and does not report it. The three default join
+// channels (868.1, 868.3, 868.5 MHz) are all in g1, so every uplink is charged to g1.
+#define UPLINK_BAND                 BAND_G1
+
+static int64_t band_capacity_us(const struct duty_band *band)
+{
+    return (int64_t)UPLINK_DUTY_WINDOW_MS * 1000 / band->divisor;
+}
+
+static void band_refill(struct duty_band *band, int64_t now)
+{
+    band->credit_us += (now - band->last_ms) * 1000 / band->divisor;
+    band->credit_us = MIN(band->credit_us, band_capacity_us(band));
+    band->last_ms = now;
+}
+
+// milliseconds before `airtime_us` can be sent on the band
+static int64_t band_wait_ms(struct duty_band *band, uint32_t airtime_us, int64_t now)
+{
+    band_refill(band, now);
+    if (band->credit_us >= airtime_us) {
+        return 0;
+    }
+    return DIV_ROUND_UP((airtime_us - band->credit_us) * band->divisor, 1000);
+}
+
+static void band_charge(struct duty_band *band, uint32_t airtime_us)
+{
+    band->credit_us -= airtime_us;
+}
+
+//  ========== uplink_time_on_air_us =======================================================
+// Semtech AN1200.13 formula, explicit header, CRC on, coding rate 4/5, 8 preamble symbols
+uint32_t uplink_time_on_air_us(enum lorawan_datarate dr, size_t size)
+{
+    // EU868 DR0..DR5 are SF12..SF7 at 125 kHz
+    int sf = 12 - MIN((int)dr, 5);
+    int de = (sf >= 11) ? 1 : 0;                    // low data rate optimisation
+    uint32_t symbol_us = (1U << sf) * 8;            // 2^SF / 125 kHz
+    int pl = (int)size + UPLINK_MAC_OVERHEAD;
+
+    int num = 8 * pl - 4 * sf + 28 + 16;
+    int den = 4 * (sf - 2 * de);
+    int symbols = 8 + MAX(DIV_ROUND_UP(num, den) * 5, 0);
+
+    // 8 preamble symbols + 4.25 sync symbols
+    return symbol_us * symbols + symbol_us * 49 / 4;
+}
+
+//  ========== message_priority ============================================================
+static int message_priority(uint8_t type)
+{
+    switch (type) {
+    case ANOMALY:
+    case WINDOW:
+    case CONFIG:
+        // window and config records answer a downlink, they are not held for batching
+        return UPLINK_PRIO_ANOMALY;
+    case BTH:
+    case HEALTH:
+        return UPLINK_PRIO_BTH;
+    case PERIODIC_SAMPLE:
+        return UPLINK_PRIO_PERIODIC;
+    default:
+        // samples go through uplink_enqueue_waveform()
+        return -EINVAL;
+    }
+}
+
+//  ========== uplink_enqueue ==============================================================
+int uplink_enqueue(PACKET_TYPE type, uint64_t timestamp, const void *payload, size_t size,
+                   k_timeout_t timeout)
+{
+    struct uplink_msg msg;
+    uint32_t offset;
+    int prio = message_priority(type);
+
+    if (prio < 0 || size > sizeof(msg.payload)) {
+        return -EINVAL;
+    }
+
+    msg.timestamp = timestamp;
+    msg.queued_ms = k_uptime_get();
+    msg.type = type;
+    msg.size = size;
+    memcpy(msg.payload, payload, size);
+
+    k_spinlock_key_t key = k_spin_lock(&spill_lock);
+    if (uplink_log_append(type, timestamp, payload, size, &msg.seq, &offset) == 0) {
+        // kept on the flash: a full queue only means it is loaded from the log later
+        if (!spills[prio].active && k_msgq_put(queues[prio], &msg, K_NO_WAIT) != 0) {
+            LOG_DBG("uplink queue %d full, type %d waits in the log", prio, type);
+            spills[prio].active = true;
+            spills[prio].offset = offset;
+        }
+        k_spin_unlock(&spill_lock, key);
+    } else {
+        // log off or full, the message only lives in RAM
+        k_spin_unlock(&spill_lock, key);
+        msg.seq = UPLINK_LOG_NONE;
+        if (k_msgq_put(queues[prio], &msg, timeout) != 0) {
+            atomic_inc(&dropped);
+            LOG_WRN("uplink queue %d full, packet of type %d dropped", prio, type);
+            return -ENOMSG;
+        }
+    }
+    health_queue_level(HEALTH_QUEUE_ANOMALY + prio, queues[prio]);
+    k_sem_give(&uplink_sem);
+    return 0;
+}
+
+//  ========== uplink_enqueue_waveform =====================================================
+int uplink_enqueue_waveform(struct event_slot *slot, uint16_t first, uint16_t count)
+{
+    struct uplink_waveform waveform = {
+        .slot = event_capture_index(slot),
+        .seq = 0,
+        .next = first,
+        .end = first + count,
+    };
+
+    if (k_msgq_put(&uplink_waveform_msgq, &waveform, K_NO_WAIT) != 0) {
+        atomic_inc(&dropped);
+        LOG_WRN("uplink waveform queue full, event %u samples dropped", slot->id);
+        event_capture_release(slot);
+        return -ENOMSG;
+    }
+    health_queue_level(HEALTH_QUEUE_WAVEFORM, &uplink_waveform_msgq);
+    k_sem_give(&uplink_sem);
+    return 0;
+}
+
+//  ========== uplink_get_dropped ==========================================================
+uint32_t uplink_get_dropped(void)
+{
+    return (uint32_t)atomic_get(&dropped);
+}
+
+//  ========== build_fragment ==============================================================
+// cut the next fragment of a waveform to fit `max_payload` bytes
+static size_t build_fragment(uint8_t *frame, size_t max_payload, const struct uplink_waveform *waveform)
+{
+    const struct event_slot *slot = event_capture_get(waveform->slot);
+    size_t count = MIN((size_t)(waveform->end - waveform->next),
+                       (max_payload - sizeof(struct fragment_header_t)) / sizeof(int16_t));
+    struct fragment_header_t header = {
+        .type = EVENT_FRAGMENT,
+        .event_id = slot->id,
+        .seq = waveform->seq,
+        .offset = (int16_t)(waveform->next - slot->pre_samples),
+    };
+
+    if (waveform->next + count == waveform->end) {
+        header.seq |= FRAGMENT_LAST;
+    }
+    memcpy(frame, &header, sizeof(header));
+    memcpy(&frame[sizeof(header)], &slot->samples[waveform->next], count * sizeof(int16_t));
+    return sizeof(header) + count * sizeof(int16_t);
+}
+
+//  ========== build_batch =================================================================
+// pack the pending messages, highest priority first, as records of one v2 frame.
+// Each queue only gives its oldest messages, so they are still sent in order.
+// taken[i] is set to the number of messages packed from queues[i].
+static size_t build_batch(uint8_t *frame, size_t max_payload, const struct uplink_msg *first,
+                          int *taken)
+{
+    struct packet_writer writer;
+    struct uplink_msg msg;
+
+    packet_writer_init(&writer, frame, max_payload, first->timestamp);
+
+    for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+        taken[i] = 0;
+        while (k_msgq_peek_at(queues[i], &msg, taken[i]) == 0 &&
+               packet_writer_add(&writer, msg.type, msg.timestamp, msg.payload, msg.size) == 0) {
+            taken[i]++;
+        }
+    }
+    return packet_writer_size(&writer);
+}
+
+//  ========== message_frame_size ==========================================================
+// size of a frame carrying `msg` alone, SIZE_MAX if it cannot be carried
+static size_t message_frame_size(const struct uplink_msg *msg)
+{
+    struct packet_writer writer;
+    uint8_t buf[PACKET_V2_HEADER_SIZE + PACKET_V2_RECORD_OVERHEAD + PACKET_MAX_PAYLOAD];
+
+    if (PACKET_V2_ENABLE == 0) {
+        return LORA_HEADER_SIZE + msg->size;
+    }
+    packet_writer_init(&writer, buf, sizeof(buf), msg->timestamp);
+    if (packet_writer_add(&writer, msg->type, msg->timestamp, msg->payload, msg->size) != 0) {
+        return SIZE_MAX;
+    }
+    return packet_writer_size(&writer);
+}
+
+//  ========== drop_oversized ==============================================================
+// A message larger than the payload of the current datarate would stay at the head of
+// its queue, and block the messages behind it, until the datarate goes up: it is dropped.
+// The records the node sends fit DR0 (51 bytes) alone, so this only happens with a
+// payload grown past it.
+static void drop_oversized(size_t max_datarate)
+{
+    struct uplink_msg msg;
+
+    for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+        while (k_msgq_peek(queues[i], &msg) == 0) {
+            size_t size = message_frame_size(&msg);
+            if (size <= max_datarate) {
+                break;
+            }
+            k_msgq_get(queues[i], &msg, K_NO_WAIT);
+            uplink_log_ack(msg.seq);
+            atomic_inc(&dropped);
+            LOG_WRN("packet of type %d needs %zu bytes, DR%d carries %zu: dropped", msg.type,
+                    size, lora_get_datarate(), max_datarate);
+        }
+    }
+}
+
+//  ========== batch_wait_ms ===============================================================
+// BTH and periodic records are held so they share an uplink. They become ready when
+// their v2 records fill the payload of the current datarate, or when the oldest one
+// waited UPLINK_BATCH_LATENCY_MS. Returns 0 when ready, else the time left to the
+// deadline (-1 when nothing is held).
+static int64_t batch_wait_ms(size_t max_payload, int64_t now)
+{
+    struct uplink_msg msg;
+    size_t size = PACKET_V2_HEADER_SIZE;
+    int64_t oldest = INT64_MAX;
+    int records = 0;
+
+    if (PACKET_V2_ENABLE == 0) {
+        // v1 cannot batch, send right away
+        return 0;
+    }
+
+    for (int i = UPLINK_PRIO_BTH; i <= UPLINK_PRIO_PERIODIC; i++) {
+        for (uint32_t n = 0; k_msgq_peek_at(queues[i], &msg, n) == 0; n++) {
+            oldest = MIN(oldest, msg.queued_ms);
+            // record header and a typical 3-byte time delta
+            size += 1 + 3 + msg.size;
+            records++;
+        }
+    }
+
+    if (records == 0) {
+        return -1;
+    }
+    if (records >= PACKET_V2_MAX_RECORDS || size >= max_payload ||
+        now - oldest >= UPLINK_BATCH_LATENCY_MS) {
+        return 0;
+    }
+    return oldest + UPLINK_BATCH_LATENCY_MS - now;
+}
+
+//  ========== refill ======================================================================
+// load the messages of a priority left in the log while its queue has room, in order.
+// Once the end of the log is reached, the new messages go to the queue again.
+static void refill(int prio)
+{
+    struct uplink_log_reader reader;
+    struct uplink_log_record record;
+    struct uplink_msg msg;
+
+    if (!spills[prio].active || k_msgq_num_free_get(queues[prio]) == 0) {
+        return;
+    }
+
+    // the last ones may still be in the write buffer
+    uplink_log_flush();
+    int ret = uplink_log_open(&reader, spills[prio].offset);
+    if (ret == 0) {
+        while ((ret = uplink_log_next(&reader, &record)) == 0) {
+            if (message_priority(record.type) != prio) {
+                continue;
+            }
+            msg.seq = record.seq;
+            msg.timestamp = record.timestamp;
+            msg.queued_ms = 0;              // waited long enough, no batching delay
+            msg.type = record.type;
+            msg.size = record.size;
+            memcpy(msg.payload, record.payload, record.size);
+            if (k_msgq_put(queues[prio], &msg, K_NO_WAIT) != 0) {
+                spills[prio].offset = record.offset;
+                break;
+            }
+        }
+        uplink_log_close(&reader);
+    }
+
+    if (ret != 0) {
+        k_spinlock_key_t key = k_spin_lock(&spill_lock);
+        if (ret == -ENODATA && uplink_log_has_pending()) {
+            // appended meanwhile, read on from there
+            spills[prio].offset = reader.offset;
+        } else {
+            if (ret != -ENODATA) {
+                LOG_ERR("uplink log read failed (%d), queue %d not replayed", ret, prio);
+            }
+            spills[prio].active = false;
+        }
+        k_spin_unlock(&spill_lock, key);
+    }
+}
+
+//  ========== wait_event ==================================================================
+// wait for a new message, at most `ms` (-1 for no limit) and not past the next log write
+static void wait_event(int64_t ms)
+{
+    int64_t flush_ms = uplink_log_flush_wait_ms(k_uptime_get());
+
+    if (flush_ms >= 0 && (ms < 0 || flush_ms < ms)) {
+        ms = flush_ms;
+    }
+    k_sem_take(&uplink_sem, (ms < 0) ? K_FOREVER : K_MSEC(ms));
+}
+
+//  ========== uplink_thread ===============================================================
+static void uplink_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct uplink_msg msg;
+    struct uplink_waveform waveform;
+    bool waveform_active = false;
+    uint8_t frame[LORA_MAX_FRAME];
+    int64_t retry_ms = UPLINK_RETRY_MIN_MS;
+    int64_t retry_at = 0;           // no uplink before this uptime, after a failure
+    int64_t confirmed_ms = 0;       // uptime of the last acknowledged confirmed uplink
+    bool online = true;             // cleared when a confirmed uplink is not acknowledged
+    int failures = 0;
+
+    LOG_INF("uplink scheduler started");
+
+    int64_t now = k_uptime_get();
+    for (int i = 0; i < BAND_COUNT; i++) {
+        bands[i].credit_us = band_capacity_us(&bands[i]);
+        bands[i].last_ms = now;
+    }
+
+    while (1) {
+        now = k_uptime_get();
+        if (uplink_log_flush_wait_ms(now) == 0) {
+            uplink_log_flush();
+        }
+        for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+            refill(i);
+        }
+
+        if (now < retry_at) {
+            wait_event(retry_at - now);
+            continue;
+        }
+
+        if (!lora_is_joined()) {
+            // the join failed at startup or after repeated failures, the log keeps the messages
+            if (lora_joinnet() != 0) {
+                LOG_WRN("not joined, retrying in %lld ms", retry_ms);
+                retry_at = k_uptime_get() + retry_ms;
+                retry_ms = MIN(retry_ms * 2, UPLINK_RETRY_MAX_MS);
+                continue;
+            }
+            retry_ms = UPLINK_RETRY_MIN_MS;
+            // the network time could not be requested at startup either
+            clock_discipline_network(true);
+        }
+
+        size_t max_payload = MIN(lora_get_max_payload(), sizeof(frame));
+        size_t max_datarate = MIN(lora_get_datarate_max_payload(), sizeof(frame));
+        drop_oversized(max_datarate);
+        int64_t batch_ms = batch_wait_ms(max_payload, k_uptime_get());
+
+        // highest priority message, left in its queue until it is sent. The held BTH and
+        // periodic records still ride along in build_batch() when an anomaly goes out.
+        struct k_msgq *queue = NULL;
+        for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+            if (i != UPLINK_PRIO_ANOMALY && batch_ms != 0) {
+                break;
+            }
+            if (k_msgq_peek(queues[i], &msg) == 0) {
+                queue = queues[i];
+                break;
+            }
+        }
+        if (queue == NULL && !waveform_active) {
+            waveform_active = (k_msgq_get(&uplink_waveform_msgq, &waveform, K_NO_WAIT) == 0);
+        }
+        if (queue == NULL && !waveform_active) {
+            wait_event((batch_ms > 0) ? batch_ms : -1);
+            continue;
+        }
+        if (queue == NULL && !online) {
+            // unconfirmed fragments would be lost, the event is in its file on the flash
+            LOG_WRN("network unreachable, samples of event %u dropped",
+                    event_capture_get(waveform.slot)->id);
+            event_capture_release(event_capture_get(waveform.slot));
+            atomic_inc(&dropped);
+            waveform_active = false;
+            continue;
+        }
+
+        // build the frame now, fragments are sized for the current datarate
+        size_t size = 0;
+        int taken[ARRAY_SIZE(queues)] = { 0 };
+        if (queue != NULL && PACKET_V2_ENABLE != 0) {
+            size = build_batch(frame, max_payload, &msg, taken);
+            if (size == 0) {
+                // the head message fits the datarate but not next to the pending MAC
+                // commands: the stack flushes them with an empty uplink, then it is retried
+                size = build_batch(frame, max_datarate, &msg, taken);
+            }
+        } else if (queue != NULL) {
+            // v1, one message per frame, it fits the datarate (see drop_oversized())
+            struct packet_t *packet = (struct packet_t *)frame;
+            packet->type = msg.type;
+            packet->timestamp = msg.timestamp;
+            memcpy(packet->payload, msg.payload, msg.size);
+            size = LORA_HEADER_SIZE + msg.size;
+        } else {
+            // at least one sample: if pending MAC commands leave no room, the stack
+            // flushes them with an empty uplink and the fragment is retried
+            max_payload = MAX(max_payload, sizeof(struct fragment_header_t) + sizeof(int16_t));
+            size = build_fragment(frame, max_payload, &waveform);
+        }
+
+        uint32_t airtime_us = uplink_time_on_air_us(lora_get_datarate(), size);
+        int64_t wait_ms = band_wait_ms(&bands[UPLINK_BAND], airtime_us, k_uptime_get());
+        if (wait_ms > 0) {
+            // a higher priority message may arrive meanwhile
+            LOG_DBG("waiting %lld ms for the %s duty cycle", wait_ms, bands[UPLINK_BAND].name);
+            wait_event(wait_ms);
+            continue;
+        }
+
+        // An unconfirmed uplink succeeds even without a gateway. Anomalies are confirmed,
+        // status messages once per UPLINK_CONFIRM_PERIOD_MS, and everything while the
+        // network is unreachable, so the log keeps what did not arrive. Only the first
+        // transmission is charged, the retries of the stack are not known here.
+        bool anomaly = (queue == queues[UPLINK_PRIO_ANOMALY]) || taken[UPLINK_PRIO_ANOMALY] > 0;
+        bool confirmed = UPLINK_LOG_ENABLE != 0 && queue != NULL &&
+                         (anomaly || !online || k_uptime_get() - confirmed_ms >= UPLINK_CONFIRM_PERIOD_MS);
+
+        int ret = lora_send_frame(frame, size, confirmed);
+        band_charge(&bands[UPLINK_BAND], airtime_us);
+
+        if (ret == 0) {
+            if (confirmed) {
+                if (!online) {
+                    LOG_INF("network reachable again, replaying the uplink log");
+                }
+                confirmed_ms = k_uptime_get();
+                online = true;
+            }
+            if (queue != NULL) {
+                // drop what was packed in the frame, at least the head message
+                for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+                    int count = (queues[i] == queue) ? MAX(taken[i], 1) : taken[i];
+                    while (count-- > 0) {
+                        k_msgq_get(queues[i], &msg, K_NO_WAIT);
+                        uplink_log_ack(msg.seq);
+                    }
+                }
+            } else {
+                waveform.next += (size - sizeof(struct fragment_header_t)) / sizeof(int16_t);
+                waveform.seq++;
+                if (waveform.next == waveform.end) {
+                    event_capture_release(event_capture_get(waveform.slot));
+                    waveform_active = false;
+                }
+            }
+            retry_ms = UPLINK_RETRY_MIN_MS;
+            failures = 0;
+            continue;
+        }
+
+        if (confirmed && online) {
+            LOG_WRN("uplink not acknowledged, network unreachable");
+            online = false;
+        }
+        if (queue != NULL) {
+            int records = 0;
+            for (size_t i = 0; i < ARRAY_SIZE(queues); i++) {
+                records += taken[i];
+            }
+            LOG_WRN("uplink of %d record(s), type %d first, failed (%d), retrying in %lld ms",
+                    MAX(records, 1), msg.type, ret, retry_ms);
+        } else {
+            LOG_WRN("fragment %u of event %u failed (%d), retrying in %lld ms",
+                    waveform.seq, event_capture_get(waveform.slot)->id, ret, retry_ms);
+        }
+        if (++failures >= UPLINK_REJOIN_FAILURES) {
+            failures = 0;
+            if (lora_joinnet() != 0) {
+                LOG_ERR("Could not join LoRa network");
+            }
+        }
+        // the log keeps being written meanwhile, see wait_event()
+        retry_at = k_uptime_get() + retry_ms;
+        retry_ms = MIN(retry_ms * 2, UPLINK_RETRY_MAX_MS);
+    }
+}
+
+//  ========== uplink_start ================================================================
+void uplink_start(void)
+{
+    // what the previous run could not send goes first, loaded from the log as room allows
+    if (UPLINK_LOG_ENABLE != 0 && uplink_log_init() > 0) {
+        for (size_t i = 0; i < ARRAY_SIZE(spills); i++) {
+            spills[i].active = true;
+            spills[i].offset = 0;
+        }
+    }
+
+    k_thread_create(&uplink_thread_data, uplink_stack,
+                    K_THREAD_STACK_SIZEOF(uplink_stack),
+                    uplink_thread, NULL, NULL, NULL,
+                    PRIORITY_TTN, 0, K_NO_WAIT);
+    health_register_thread(HEALTH_THREAD_UPLINK, &uplink_thread_data);
+}
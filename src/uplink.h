@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UPLINK_H
+#define UPLINK_H
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/lorawan/lorawan.h>
+#include <stdint.h>
+
+#include "data_types.h"
+#include "event_capture.h"
+
+//  ========== defines =====================================================================
+// depth of each priority queue
+#define UPLINK_QUEUE_ANOMALY        4
+#define UPLINK_QUEUE_BTH            8
+#define UPLINK_QUEUE_PERIODIC       8
+#define UPLINK_QUEUE_WAVEFORM       EVENT_SLOTS
+
+// EU868 duty cycle is averaged over one hour, this is also the largest burst allowed
+#define UPLINK_DUTY_WINDOW_MS       (60 * 60 * 1000)
+
+// retry delays after a failed send, doubled on each failure, and failures before a re-join
+#define UPLINK_RETRY_MIN_MS         5000
+#define UPLINK_RETRY_MAX_MS         (5 * 60 * 1000)
+#define UPLINK_REJOIN_FAILURES      3
+
+// LoRaWAN MAC header, FHDR, FPort and MIC added to each application payload
+#define UPLINK_MAC_OVERHEAD         13
+
+//  ========== types =======================================================================
+// uplink priorities, the lowest value is sent first
+enum uplink_priority {
+    UPLINK_PRIO_ANOMALY = 0,
+    UPLINK_PRIO_BTH,
+    UPLINK_PRIO_PERIODIC,
+    UPLINK_PRIO_WAVEFORM,
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief start the uplink scheduler, the only thread using the radio
+ *
+ * Messages are sent highest priority first, as soon as the duty-cycle budget
+ * of the sub-band allows it. With UPLINK_LOG_ENABLE, the messages the previous
+ * run left in the uplink log are sent first. When the join failed at startup,
+ * the scheduler retries it.
+ */
+void uplink_start(void);
+
+/**
+ * @brief queue a message for the radio, its priority is given by its type
+ *
+ * The message is also appended to the uplink log (see uplink_log.h). When its
+ * queue is full, it waits in the log and is loaded back in order once the queue
+ * has room again.
+ *
+ * @param timeout K_NO_WAIT for periodic senders, which must never block. Only used
+ *        when the message cannot go to the log.
+ * @return 0 on success, -ENOMSG if neither the log nor the queue of this priority
+ *         could take it, -EINVAL if the payload does not fit a packet
+ */
+int uplink_enqueue(PACKET_TYPE type, uint64_t timestamp, const void *payload, size_t size,
+                   k_timeout_t timeout);
+
+/**
+ * @brief queue samples of a captured event, sent as EVENT_FRAGMENT packets
+ *
+ * The fragments are cut when they are sent, each one as large as the payload
+ * allowed by the current datarate. The scheduler takes over the caller's
+ * reference on the slot and releases it after the last fragment.
+ *
+ * @param first index of the first sample in slot->samples
+ * @return 0 on success, -ENOMSG if the waveform queue is full (the slot is released)
+ */
+int uplink_enqueue_waveform(struct event_slot *slot, uint16_t first, uint16_t count);
+
+/**
+ * @brief LoRa time on air of an application payload in microseconds (EU868, 125 kHz)
+ */
+uint32_t uplink_time_on_air_us(enum lorawan_datarate dr, size_t size);
+
+/**
+ * @brief number of messages dropped because their queue was full, and the log too
+ */
+uint32_t uplink_get_dropped(void);
+
+#endif /* UPLINK_H */
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "uplink_log.h"
+#include "fs_utils.h"
+
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(uplink_log);
+
+//  ========== globals =====================================================================
+// header of a record in the log file, the payload follows
+struct log_header {
+    uint16_t crc;               // CRC-16/CCITT of the rest of the header and the payload
+    uint8_t type;
+    uint8_t size;
+    uint32_t seq;
+    uint64_t timestamp;
+} __packed;
+
+// appends and acknowledgements not written yet, filled by any thread
+static struct k_spinlock lock;
+static uint8_t pending[UPLINK_LOG_BUFFER_SIZE];
+static size_t pending_fill;
+static uint32_t pending_acks[UPLINK_LOG_ACKS];
+static size_t pending_ack_count;
+static int64_t pending_since_ms = -1;   // uptime of the oldest one, -1 when empty
+
+// copies written by uplink_log_flush(), in the scheduler thread only
+static uint8_t flush_buf[UPLINK_LOG_BUFFER_SIZE];
+static uint32_t flush_acks[UPLINK_LOG_ACKS];
+
+// records [base_seq, next_seq) are in the log, acked[] is indexed by seq - base_seq
+static uint32_t base_seq;
+static uint32_t next_seq;
+static uint32_t acked[UPLINK_LOG_MAX_RECORDS / 32];
+static uint32_t acked_count;
+
+static uint32_t file_size;          // bytes in the log file, the buffer excluded
+static uint32_t ack_file_size;
+static bool ready;
+
+//  ========== acked bitmap ================================================================
+static bool is_acked(uint32_t n)
+{
+    return (acked[n / 32] & BIT(n % 32)) != 0;
+}
+
+static void set_acked(uint32_t n)
+{
+    acked[n / 32] |= BIT(n % 32);
+}
+
+//  ========== encode_record ===============================================================
+static uint16_t record_crc(const struct log_header *header, const uint8_t *payload)
+{
+    uint16_t crc = crc16_ccitt(0xffff, (const uint8_t *)header + sizeof(header->crc),
+                               sizeof(*header) - sizeof(header->crc));
+    return crc16_ccitt(crc, payload, header->size);
+}
+
+static size_t encode_record(uint8_t *dst, uint32_t seq, uint8_t type, uint64_t timestamp,
+                            const void *payload, size_t size)
+{
+    struct log_header header = {
+        .type = type,
+        .size = (uint8_t)size,
+        .seq = seq,
+        .timestamp = timestamp,
+    };
+
+    header.crc = record_crc(&header, payload);
+    memcpy(dst, &header, sizeof(header));
+    memcpy(&dst[sizeof(header)], payload, size);
+    return sizeof(header) + size;
+}
+
+//  ========== append_file =================================================================
+static int append_file(const char *path, const void *data, size_t size)
+{
+    struct fs_file_t file;
+
+    fs_file_t_init(&file);
+    int rc = fs_open(&file, path, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (rc < 0) {
+        return rc;
+    }
+    ssize_t written = fs_write(&file, data, size);
+    // fs_close() also syncs the file
+    rc = fs_close(&file);
+    if (written != (ssize_t)size) {
+        return (written < 0) ? (int)written : -EIO;
+    }
+    return rc;
+}
+
+//  ========== uplink_log_open =============================================================
+int uplink_log_open(struct uplink_log_reader *reader, uint32_t offset)
+{
+    fs_file_t_init(&reader->file);
+    int rc = fs_open(&reader->file, UPLINK_LOG_PATH, FS_O_READ);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = fs_seek(&reader->file, offset, FS_SEEK_SET);
+    if (rc < 0) {
+        fs_close(&reader->file);
+        return rc;
+    }
+    reader->offset = offset;
+    return 0;
+}
+
+//  ========== uplink_log_next =============================================================
+int uplink_log_next(struct uplink_log_reader *reader, struct uplink_log_record *record)
+{
+    struct log_header header;
+
+    ssize_t got = fs_read(&reader->file, &header, sizeof(header));
+    if (got == 0) {
+        return -ENODATA;
+    }
+    if (got != sizeof(header) || header.size > sizeof(record->payload)) {
+        return -EIO;
+    }
+    got = fs_read(&reader->file, record->payload, header.size);
+    if (got != header.size) {
+        return -EIO;
+    }
+
+    record->seq = header.seq;
+    record->offset = reader->offset;
+    record->timestamp = header.timestamp;
+    record->type = header.type;
+    record->size = header.size;
+    reader->offset += sizeof(header) + header.size;
+    // whole but altered, the reader is past it: the next one can still be read
+    if (record_crc(&header, record->payload) != header.crc) {
+        return -EBADMSG;
+    }
+    return 0;
+}
+
+//  ========== uplink_log_close ============================================================
+void uplink_log_close(struct uplink_log_reader *reader)
+{
+    fs_close(&reader->file);
+}
+
+//  ========== load_acks ===================================================================
+// mark the acknowledged records of a log starting at sequence number `first`
+static void load_acks(uint32_t first)
+{
+    struct fs_file_t file;
+    ssize_t got;
+
+    fs_file_t_init(&file);
+    if (fs_open(&file, UPLINK_LOG_ACK_PATH, FS_O_READ) < 0) {
+        return;
+    }
+    while ((got = fs_read(&file, flush_acks, sizeof(flush_acks))) > 0) {
+        for (size_t i = 0; i < got / sizeof(uint32_t); i++) {
+            uint32_t n = flush_acks[i] - first;
+            if (n < UPLINK_LOG_MAX_RECORDS) {
+                set_acked(n);
+            }
+        }
+    }
+    fs_close(&file);
+}
+
+//  ========== uplink_log_init =============================================================
+int uplink_log_init(void)
+{
+    struct uplink_log_reader reader;
+    struct uplink_log_record record;
+    struct fs_file_t out;
+    uint32_t first = 0, count = 0, bytes = 0, sent = 0, dropped = 0;
+    int rc;
+
+    if (!is_lfs_mounted() && (rc = mount_lfs()) < 0) {
+        LOG_ERR("could not mount %s, uplink log off. error: %d", LFS_MOUNT_POINT, rc);
+        return rc;
+    }
+
+    // what was buffered is lost with a reset, the log restarts from the flash
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    ready = false;
+    pending_fill = 0;
+    pending_ack_count = 0;
+    pending_since_ms = -1;
+    k_spin_unlock(&lock, key);
+
+    memset(acked, 0, sizeof(acked));
+    if (uplink_log_open(&reader, 0) == 0) {
+        // sequence number of the first readable record
+        do {
+            rc = uplink_log_next(&reader, &record);
+        } while (rc == -EBADMSG);
+        if (rc == 0) {
+            first = record.seq;
+        }
+        uplink_log_close(&reader);
+        load_acks(first);
+    }
+
+    // copy the records still to send, renumbered from 0
+    fs_file_t_init(&out);
+    rc = fs_open(&out, UPLINK_LOG_TMP_PATH, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (rc < 0) {
+        LOG_ERR("could not open %s. error: %d", UPLINK_LOG_TMP_PATH, rc);
+        return rc;
+    }
+    if (uplink_log_open(&reader, 0) == 0) {
+        while (count < UPLINK_LOG_MAX_RECORDS &&
+               ((rc = uplink_log_next(&reader, &record)) == 0 || rc == -EBADMSG)) {
+            if (rc == -EBADMSG) {
+                LOG_WRN("corrupt uplink log record at %u dropped", record.offset);
+                dropped++;
+                continue;
+            }
+            uint32_t n = record.seq - first;
+            if (n < UPLINK_LOG_MAX_RECORDS && is_acked(n)) {
+                sent++;
+                continue;
+            }
+            size_t size = encode_record(flush_buf, count, record.type, record.timestamp,
+                                        record.payload, record.size);
+            if (fs_write(&out, flush_buf, size) != (ssize_t)size) {
+                LOG_ERR("could not write %s, uplink log off", UPLINK_LOG_TMP_PATH);
+                uplink_log_close(&reader);
+                fs_close(&out);
+                fs_unlink(UPLINK_LOG_TMP_PATH);
+                return -EIO;
+            }
+            count++;
+            bytes += size;
+        }
+        if (rc == -EIO) {
+            // cut by a reset before it was synced
+            LOG_WRN("torn uplink log record at %u dropped", reader.offset);
+        }
+        uplink_log_close(&reader);
+    }
+    fs_close(&out);
+
+    // the acknowledgements go first: a reset in between sends the old log again
+    fs_unlink(UPLINK_LOG_ACK_PATH);
+    if (count > 0) {
+        rc = fs_rename(UPLINK_LOG_TMP_PATH, UPLINK_LOG_PATH);
+        if (rc < 0) {
+            LOG_ERR("could not rename %s. error: %d", UPLINK_LOG_TMP_PATH, rc);
+            return rc;
+        }
+    } else {
+        fs_unlink(UPLINK_LOG_TMP_PATH);
+        fs_unlink(UPLINK_LOG_PATH);
+    }
+
+    memset(acked, 0, sizeof(acked));
+    base_seq = 0;
+    next_seq = count;
+    acked_count = 0;
+    file_size = bytes;
+    ack_file_size = 0;
+    ready = true;
+
+    LOG_INF("uplink log: %u records to send, %u sent ones removed, %u corrupt ones dropped",
+            count, sent, dropped);
+    return (int)count;
+}
+
+//  ========== uplink_log_append ===========================================================
+int uplink_log_append(uint8_t type, uint64_t timestamp, const void *payload, size_t size,
+                      uint32_t *seq, uint32_t *offset)
+{
+    uint32_t limit = (type == ANOMALY) ? UPLINK_LOG_MAX_RECORDS : UPLINK_LOG_STATUS_RECORDS;
+    int ret = 0;
+
+    if (size > PACKET_MAX_PAYLOAD) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (!ready) {
+        ret = -ENODEV;
+    } else if (next_seq - base_seq >= limit) {
+        ret = -ENOSPC;
+    } else if (pending_fill + sizeof(struct log_header) + size > sizeof(pending)) {
+        ret = -ENOBUFS;
+    } else {
+        *seq = next_seq;
+        *offset = file_size + pending_fill;
+        pending_fill += encode_record(&pending[pending_fill], next_seq, type, timestamp, payload, size);
+        next_seq++;
+        if (pending_since_ms < 0) {
+            pending_since_ms = k_uptime_get();
+        }
+    }
+    k_spin_unlock(&lock, key);
+    return ret;
+}
+
+//  ========== uplink_log_ack ==============================================================
+void uplink_log_ack(uint32_t seq)
+{
+    if (seq == UPLINK_LOG_NONE) {
+        return;
+    }
+    // only this thread drains the acknowledgements
+    if (pending_ack_count >= UPLINK_LOG_ACKS) {
+        uplink_log_flush();
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t n = seq - base_seq;
+    if (ready && n < next_seq - base_seq && !is_acked(n)) {
+        set_acked(n);
+        acked_count++;
+        pending_acks[pending_ack_count++] = seq;
+        if (pending_since_ms < 0) {
+            pending_since_ms = k_uptime_get();
+        }
+    }
+    k_spin_unlock(&lock, key);
+}
+
+//  ========== uplink_log_flush ============================================================
+int uplink_log_flush(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (!ready) {
+        k_spin_unlock(&lock, key);
+        return -ENODEV;
+    }
+
+    size_t fill = pending_fill;
+    size_t acks = pending_ack_count;
+    bool all_acked = (acked_count == next_seq - base_seq);
+    uint32_t log_size = file_size;
+
+    memcpy(flush_buf, pending, fill);
+    memcpy(flush_acks, pending_acks, acks * sizeof(uint32_t));
+    pending_fill = 0;
+    pending_ack_count = 0;
+    pending_since_ms = -1;
+    if (all_acked) {
+        base_seq = next_seq;
+        acked_count = 0;
+        memset(acked, 0, sizeof(acked));
+        file_size = 0;
+    } else {
+        file_size += fill;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (all_acked) {
+        // everything was sent, the buffered records included: nothing to keep
+        if (log_size > 0) {
+            fs_unlink(UPLINK_LOG_PATH);
+        }
+        if (ack_file_size > 0) {
+            fs_unlink(UPLINK_LOG_ACK_PATH);
+            ack_file_size = 0;
+        }
+        return 0;
+    }
+
+    // records first, an acknowledgement never refers to a record missing from the file
+    int rc = 0;
+    if (fill > 0) {
+        rc = append_file(UPLINK_LOG_PATH, flush_buf, fill);
+    }
+    if (rc == 0 && acks > 0) {
+        rc = append_file(UPLINK_LOG_ACK_PATH, flush_acks, acks * sizeof(uint32_t));
+        ack_file_size += acks * sizeof(uint32_t);
+    }
+    if (rc < 0) {
+        // the offsets of the next records would be wrong, the log is compacted at startup
+        LOG_ERR("uplink log write failed, log off. error: %d", rc);
+        key = k_spin_lock(&lock);
+        ready = false;
+        k_spin_unlock(&lock, key);
+    }
+    return rc;
+}
+
+//  ========== uplink_log_flush_wait_ms ====================================================
+int64_t uplink_log_flush_wait_ms(int64_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t since = pending_since_ms;
+    bool full = pending_fill >= sizeof(pending) / 2 || pending_ack_count >= UPLINK_LOG_ACKS / 2;
+    k_spin_unlock(&lock, key);
+
+    if (since < 0) {
+        return -1;
+    }
+    if (full) {
+        return 0;
+    }
+    return MAX(since + UPLINK_LOG_FLUSH_MS - now, 0);
+}
+
+//  ========== uplink_log_has_pending ======================================================
+bool uplink_log_has_pending(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool has_pending = pending_fill > 0;
+    k_spin_unlock(&lock, key);
+    return has_pending;
+}
+
+//  ========== uplink_log_get_state ========================================================
+void uplink_log_get_state(uint32_t *records, uint32_t *acked_records, uint32_t *bytes)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *records = next_seq - base_seq;
+    *acked_records = acked_count;
+    *bytes = file_size + pending_fill;
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UPLINK_LOG_H
+#define UPLINK_LOG_H
+
+/*
+ * Store-and-forward log of the uplink messages, on the lfs_storage partition.
+ *
+ * Every message queued for the radio is appended to UPLINK_LOG_PATH with a sequence
+ * number, and its number is appended to UPLINK_LOG_ACK_PATH once it has been sent.
+ * Both appends are buffered in RAM and written together, at most UPLINK_LOG_FLUSH_MS
+ * after the first one. When every record of the log is acknowledged, both files are
+ * deleted instead. At startup the log is compacted: the acknowledged records, the ones
+ * whose CRC fails and a torn tail are left out, the others are renumbered from 0 and
+ * replayed, oldest first.
+ *
+ * On flash, each record is a header (CRC-16/CCITT of the rest, type, size, sequence
+ * number, timestamp) followed by the payload.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "data_types.h"
+
+//  ========== defines =====================================================================
+// records in the log, acknowledged or not, before the new ones are refused.
+// Above UPLINK_LOG_STATUS_RECORDS only the anomalies are still taken.
+#define UPLINK_LOG_MAX_RECORDS      4096
+#define UPLINK_LOG_STATUS_RECORDS   (UPLINK_LOG_MAX_RECORDS * 3 / 4)
+
+// RAM buffers of the appends and acknowledgements, written when half full
+#define UPLINK_LOG_BUFFER_SIZE      1024
+#define UPLINK_LOG_ACKS             64
+
+// sequence number of a message that is not in the log
+#define UPLINK_LOG_NONE             UINT32_MAX
+
+//  ========== types =======================================================================
+struct uplink_log_record {
+    uint32_t seq;
+    uint32_t offset;            // position of the record in the log file
+    uint64_t timestamp;
+    uint8_t type;
+    uint8_t size;
+    uint8_t payload[PACKET_MAX_PAYLOAD];
+};
+
+// sequential read of the log file
+struct uplink_log_reader {
+    struct fs_file_t file;
+    uint32_t offset;            // of the next record
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief mount /lfs if needed and compact the log left by the previous run
+ *
+ * @return number of records to replay, or a negative error code (the log stays off)
+ */
+int uplink_log_init(void);
+
+/**
+ * @brief append a message to the write buffer, never blocks
+ *
+ * @param seq set to the sequence number of the record
+ * @param offset set to the position the record will have in the log file
+ * @return 0 on success, -ENODEV if the log is off, -ENOSPC if the log is full,
+ *         -ENOBUFS if the write buffer is full
+ */
+int uplink_log_append(uint8_t type, uint64_t timestamp, const void *payload, size_t size,
+                      uint32_t *seq, uint32_t *offset);
+
+/**
+ * @brief mark a record as sent, UPLINK_LOG_NONE is ignored
+ *
+ * Writes to the flash when the acknowledgement buffer is full.
+ */
+void uplink_log_ack(uint32_t seq);
+
+/**
+ * @brief write the buffered records and acknowledgements to the flash, or delete the
+ * log when every record is acknowledged
+ */
+int uplink_log_flush(void);
+
+/**
+ * @brief time before uplink_log_flush() is due, 0 if it is, -1 if nothing is buffered
+ */
+int64_t uplink_log_flush_wait_ms(int64_t now);
+
+/**
+ * @brief true if records were appended since the last uplink_log_flush()
+ */
+bool uplink_log_has_pending(void);
+
+/**
+ * @brief read the log file from `offset`, which must be the start of a record
+ */
+int uplink_log_open(struct uplink_log_reader *reader, uint32_t offset);
+
+/**
+ * @brief read the next record
+ *
+ * @return 0 on success, -ENODATA at the end of the log, -EBADMSG on a record whose CRC
+ *         fails (the reader is past it), -EIO on a torn record
+ */
+int uplink_log_next(struct uplink_log_reader *reader, struct uplink_log_record *record);
+
+void uplink_log_close(struct uplink_log_reader *reader);
+
+/**
+ * @brief records in the log, acknowledged ones and its size in bytes, buffer included
+ */
+void uplink_log_get_state(uint32_t *records, uint32_t *acked_records, uint32_t *bytes);
+
+#endif /* UPLINK_LOG_H */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2025
+ * Hugo Reymond, Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "wave_codec.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+//  ========== types =======================================================================
+struct bit_writer {
+    uint8_t *buf;
+    size_t pos;         // in bits
+};
+
+struct bit_reader {
+    const uint8_t *buf;
+    size_t pos;         // in bits
+    size_t end;         // in bits
+};
+
+//  ========== bit helpers =================================================================
+static void put_bits(struct bit_writer *w, uint32_t value, unsigned int bits)
+{
+    while (bits > 0) {
+        unsigned int shift = w->pos & 7;
+        unsigned int room = 8 - shift;
+        unsigned int take = (bits < room) ? bits : room;
+        uint8_t *byte = &w->buf[w->pos >> 3];
+
+        if (shift == 0) {
+            *byte = 0;
+        }
+        *byte |= (uint8_t)((value & ((1u << take) - 1)) << shift);
+        value >>= take;
+        bits -= take;
+        w->pos += take;
+    }
+}
+
+static int get_bits(struct bit_reader *r, unsigned int bits, uint32_t *value)
+{
+    uint32_t v = 0;
+    unsigned int done = 0;
+
+    if (r->pos + bits > r->end) {
+        return -EINVAL;
+    }
+    while (done < bits) {
+        unsigned int shift = r->pos & 7;
+        unsigned int room = 8 - shift;
+        unsigned int take = (bits - done < room) ? bits - done : room;
+
+        v |= (uint32_t)((r->buf[r->pos >> 3] >> shift) & ((1u << take) - 1)) << done;
+        done += take;
+        r->pos += take;
+    }
+    *value = v;
+    return 0;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+//  ========== rice_cost ===================================================================
+// number of bits needed for a group with parameter k
+static size_t rice_cost(const uint32_t *v, size_t n, unsigned int k)
+{
+    size_t bits = 5;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t q = v[i] >> k;
+        bits += (q >= WAVE_CODEC_ESCAPE) ? (WAVE_CODEC_ESCAPE + 17) : (q + 1 + k);
+    }
+    return bits;
+}
+
+//  ========== wave_codec_encode ===========================================================
+size_t wave_codec_encode(const int16_t *samples, size_t count, uint64_t timestamp_ms, uint8_t *out)
+{
+    if (count == 0 || count > UINT16_MAX) {
+        return 0;
+    }
+
+    struct bit_writer w = { .buf = &out[WAVE_CODEC_HEADER_SIZE], .pos = 0 };
+    uint32_t group[WAVE_CODEC_GROUP];
+
+    // the Rice cost grows with the sum of the values: code the samples themselves when
+    // their sum is below the one of the deltas
+    uint64_t sum_deltas = 0, sum_values = 0;
+    for (size_t i = 1; i < count; i++) {
+        sum_deltas += zigzag((int32_t)samples[i] - samples[i - 1]);
+        sum_values += zigzag(samples[i]);
+    }
+    bool values = (sum_values < sum_deltas);
+
+    for (size_t i = 1; i < count; i += WAVE_CODEC_GROUP) {
+        size_t n = (count - i < WAVE_CODEC_GROUP) ? count - i : WAVE_CODEC_GROUP;
+        uint32_t sum = 0;
+
+        for (size_t j = 0; j < n; j++) {
+            group[j] = zigzag(values ? samples[i + j] : (int32_t)samples[i + j] - samples[i + j - 1]);
+            sum += group[j];
+        }
+
+        // k ~ log2 of the mean value, then keep the cheapest of its neighbours
+        unsigned int guess = 0;
+        while (guess < 15 && ((uint32_t)n << (guess + 1)) <= sum) {
+            guess++;
+        }
+        unsigned int k = guess;
+        size_t best = rice_cost(group, n, k);
+        for (unsigned int c = (guess > 0) ? guess - 1 : 0; c <= guess + 1 && c <= 16; c++) {
+            size_t cost = rice_cost(group, n, c);
+            if (cost < best) {
+                best = cost;
+                k = c;
+            }
+        }
+
+        put_bits(&w, k, 5);
+        for (size_t j = 0; j < n; j++) {
+            uint32_t q = group[j] >> k;
+            if (q >= WAVE_CODEC_ESCAPE) {
+                put_bits(&w, (1u << WAVE_CODEC_ESCAPE) - 1, WAVE_CODEC_ESCAPE);
+                put_bits(&w, group[j], 17);
+                continue;
+            }
+            // q ones then a zero
+            put_bits(&w, (1u << q) - 1, q + 1);
+            if (k > 0) {
+                put_bits(&w, group[j] & ((1u << k) - 1), k);
+            }
+        }
+    }
+
+    size_t payload = (w.pos + 7) / 8;
+    put_le16(&out[0], WAVE_CODEC_MAGIC);
+    out[2] = WAVE_CODEC_VERSION;
+    out[3] = values ? WAVE_CODEC_FLAG_VALUES : 0;
+    put_le16(&out[4], (uint16_t)count);
+    put_le16(&out[6], (uint16_t)payload);
+    for (int b = 0; b < 8; b++) {
+        out[8 + b] = (uint8_t)(timestamp_ms >> (8 * b));
+    }
+    put_le16(&out[16], (uint16_t)samples[0]);
+
+    return WAVE_CODEC_HEADER_SIZE + payload;
+}
+
+//  ========== wave_codec_decode ===========================================================
+int wave_codec_decode(const uint8_t *in, size_t size, int16_t *samples, size_t max_samples,
+                      size_t *count, uint64_t *timestamp_ms)
+{
+    if (size < WAVE_CODEC_HEADER_SIZE) {
+        return -EAGAIN;
+    }
+    if (get_le16(&in[0]) != WAVE_CODEC_MAGIC || in[2] < 1 || in[2] > WAVE_CODEC_VERSION) {
+        return -EINVAL;
+    }
+    // version 1 has no flags
+    uint8_t flags = in[3];
+    if ((in[2] == 1 && flags != 0) || (flags & ~WAVE_CODEC_FLAG_VALUES) != 0) {
+        return -EINVAL;
+    }
+    bool values = (flags & WAVE_CODEC_FLAG_VALUES) != 0;
+
+    size_t n = get_le16(&in[4]);
+    size_t payload = get_le16(&in[6]);
+    if (n == 0) {
+        return -EINVAL;
+    }
+    if (n > max_samples) {
+        return -ENOSPC;
+    }
+    if (size < WAVE_CODEC_HEADER_SIZE + payload) {
+        return -EAGAIN;
+    }
+
+    if (timestamp_ms != NULL) {
+        uint64_t ts = 0;
+        for (int b = 7; b >= 0; b--) {
+            ts = (ts << 8) | in[8 + b];
+        }
+        *timestamp_ms = ts;
+    }
+
+    struct bit_reader r = {
+        .buf = &in[WAVE_CODEC_HEADER_SIZE],
+        .pos = 0,
+        .end = payload * 8,
+    };
+    int32_t prev = (int16_t)get_le16(&in[16]);
+    samples[0] = (int16_t)prev;
+
+    for (size_t i = 1; i < n; i += WAVE_CODEC_GROUP) {
+        size_t group = (n - i < WAVE_CODEC_GROUP) ? n - i : WAVE_CODEC_GROUP;
+        uint32_t k;
+
+        if (get_bits(&r, 5, &k) < 0 || k > 16) {
+            return -EINVAL;
+        }
+        for (size_t j = 0; j < group; j++) {
+            uint32_t q = 0, bit = 1, v;
+
+            while (q < WAVE_CODEC_ESCAPE) {
+                if (get_bits(&r, 1, &bit) < 0) {
+                    return -EINVAL;
+                }
+                if (bit == 0) {
+                    break;
+                }
+                q++;
+            }
+            if (q == WAVE_CODEC_ESCAPE) {
+                if (get_bits(&r, 17, &v) < 0) {
+                    return -EINVAL;
+                }
+            } else {
+                uint32_t low = 0;
+                if (k > 0 && get_bits(&r, k, &low) < 0) {
+                    return -EINVAL;
+                }
+                v = (q << k) | low;
+            }
+            prev = values ? unzigzag(v) : prev + unzigzag(v);
+            samples[i + j] = (int16_t)prev;
+        }
+    }
+
+    *count = n;
+    return (int)(WAVE_CODEC_HEADER_SIZE + payload);
+}
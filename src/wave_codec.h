@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025
+ * Hugo Reymond, Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WAVE_CODEC_H
+#define WAVE_CODEC_H
+
+//  ========== includes ====================================================================
+#include <stdint.h>
+#include <stddef.h>
+
+//  ========== defines =====================================================================
+/*
+ * Compressed waveform frame, all fields little-endian:
+ *
+ *   0   u16  magic 0x5747 ("GW")
+ *   2   u8   version (2, 1 for frames without flags)
+ *   3   u8   flags: WAVE_CODEC_FLAG_VALUES
+ *   4   u16  number of samples
+ *   6   u16  number of payload bytes following the header
+ *   8   u64  timestamp of the first sample, unix ms
+ *   16  i16  first sample
+ *   18  payload: bit stream, LSB first, of the (n - 1) residuals in groups of 16:
+ *        - 5 bits: Rice parameter k of the group
+ *        - per residual, zigzag value v: (v >> k) ones, a zero, then the k low bits of v
+ *          if (v >> k) >= 16: 16 ones then v on 17 bits (escape)
+ *
+ * The residuals are the deltas between consecutive samples, or the samples themselves
+ * with WAVE_CODEC_FLAG_VALUES: the encoder keeps the smaller of the two for each frame.
+ * Deltas suit slow signals. Once the DC level is removed, a geophone on broadband noise
+ * gives samples nearly uncorrelated from one to the next, whose deltas are larger than
+ * the samples (by sqrt(2) for white noise).
+ *
+ * Raw int16 files never start with the magic (samples stay far below 0x5747 mV),
+ * so readers can tell both formats apart.
+ */
+#define WAVE_CODEC_MAGIC            0x5747
+#define WAVE_CODEC_VERSION          2
+#define WAVE_CODEC_FLAG_VALUES      0x01
+#define WAVE_CODEC_HEADER_SIZE      18
+#define WAVE_CODEC_GROUP            16
+#define WAVE_CODEC_ESCAPE           16
+
+// worst case size of a frame of n samples (every delta escaped)
+#define WAVE_CODEC_MAX_FRAME(n)     (WAVE_CODEC_HEADER_SIZE + \
+        (((((n) + WAVE_CODEC_GROUP - 1) / WAVE_CODEC_GROUP) * 5 + (n) * 33 + 7) / 8))
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief encode samples into one frame
+ *
+ * @param out buffer of at least WAVE_CODEC_MAX_FRAME(count) bytes
+ * @return size of the frame in bytes, 0 if count is 0 or too large for the header
+ */
+size_t wave_codec_encode(const int16_t *samples, size_t count, uint64_t timestamp_ms, uint8_t *out);
+
+/**
+ * @brief decode one frame
+ *
+ * @param max_samples capacity of @p samples
+ * @param timestamp_ms set to the frame timestamp, may be NULL
+ * @return number of bytes consumed (> 0), -EINVAL on a malformed frame,
+ *         -ENOSPC if the frame holds more than @p max_samples samples,
+ *         -EAGAIN if @p size does not hold the whole frame
+ */
+int wave_codec_decode(const uint8_t *in, size_t size, int16_t *samples, size_t max_samples,
+                      size_t *count, uint64_t *timestamp_ms);
+
+#endif /* WAVE_CODEC_H */
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//  ========== includes ====================================================================
+#include "wave_index.h"
+#include "fs_utils.h"
+
+#include <stdio.h>
+
+#include "config.h" // for log level
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(wave_index);
+
+//  ========== globals =====================================================================
+// index being written, only used by the recorder thread
+static struct fs_file_t index_file;
+static bool index_open;
+static struct wave_index_entry pending[WAVE_INDEX_BUFFER];
+static size_t pending_count;
+
+// range of data files a query looks at, [oldest_file, next_file)
+static atomic_t oldest_file = ATOMIC_INIT(0);
+static atomic_t next_file = ATOMIC_INIT(0);
+
+//  ========== paths =======================================================================
+static void index_path(char *path, size_t size, uint32_t number)
+{
+    snprintf(path, size, "%s_%03u%s", FILE_PREFIX, number, INDEX_EXT);
+}
+
+static void data_path(char *path, size_t size, uint32_t number)
+{
+    snprintf(path, size, "%s_%03u%s", FILE_PREFIX, number, FILE_EXT);
+}
+
+//  ========== write_pending ===============================================================
+static int write_pending(bool sync)
+{
+    if (!index_open || pending_count == 0) {
+        return 0;
+    }
+
+    size_t size = pending_count * sizeof(pending[0]);
+    ssize_t written = fs_write(&index_file, pending, size);
+    pending_count = 0;
+    if (written != (ssize_t)size) {
+        LOG_ERR("index write failed. error: %d", (int)written);
+        return -EIO;
+    }
+    return sync ? fs_sync(&index_file) : 0;
+}
+
+//  ========== wave_index_begin ============================================================
+int wave_index_begin(uint32_t file)
+{
+    char path[32];
+
+    wave_index_end();
+
+    index_path(path, sizeof(path), file);
+    fs_file_t_init(&index_file);
+    int rc = fs_open(&index_file, path, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (rc < 0) {
+        LOG_ERR("could not open %s. error: %d", path, rc);
+        return rc;
+    }
+    index_open = true;
+    return 0;
+}
+
+//  ========== wave_index_add ==============================================================
+int wave_index_add(uint32_t offset, uint64_t start_ms, uint16_t samples, uint16_t period_ms)
+{
+    if (!index_open) {
+        return -EBADF;
+    }
+
+    pending[pending_count++] = (struct wave_index_entry) {
+        .start_ms = start_ms,
+        .offset = offset,
+        .samples = samples,
+        .period_ms = period_ms,
+    };
+    return (pending_count == WAVE_INDEX_BUFFER) ? write_pending(false) : 0;
+}
+
+//  ========== wave_index_sync =============================================================
+int wave_index_sync(void)
+{
+    return write_pending(true);
+}
+
+//  ========== wave_index_end ==============================================================
+void wave_index_end(void)
+{
+    if (!index_open) {
+        return;
+    }
+
+    write_pending(false);
+    int rc = fs_close(&index_file);
+    if (rc < 0) {
+        LOG_ERR("index close failed. error: %d", rc);
+    }
+    index_open = false;
+}
+
+//  ========== wave_index_discard ==========================================================
+void wave_index_discard(void)
+{
+    pending_count = 0;
+}
+
+//  ========== wave_index_remove ===========================================================
+void wave_index_remove(uint32_t file)
+{
+    char path[32];
+
+    index_path(path, sizeof(path), file);
+    int rc = fs_unlink(path);
+    if (rc < 0 && rc != -ENOENT) {
+        LOG_ERR("could not delete %s. error: %d", path, rc);
+    }
+}
+
+//  ========== wave_index_set_files ========================================================
+void wave_index_set_files(uint32_t oldest, uint32_t next)
+{
+    atomic_set(&oldest_file, (atomic_val_t)oldest);
+    atomic_set(&next_file, (atomic_val_t)next);
+}
+
+//  ========== open_index ==================================================================
+// open the index of a data file for reading, `entries` is set to its number of entries
+static int open_index(uint32_t number, struct fs_file_t *file, uint32_t *entries)
+{
+    char path[32];
+    struct fs_dirent stat;
+
+    index_path(path, sizeof(path), number);
+    int rc = fs_stat(path, &stat);
+    if (rc < 0) {
+        return rc;
+    }
+    fs_file_t_init(file);
+    rc = fs_open(file, path, FS_O_READ);
+    if (rc < 0) {
+        return rc;
+    }
+    *entries = stat.size / sizeof(struct wave_index_entry);
+    return 0;
+}
+
+//  ========== read_entry ==================================================================
+static int read_entry(struct fs_file_t *file, uint32_t index, struct wave_index_entry *entry)
+{
+    int rc = fs_seek(file, (off_t)index * sizeof(*entry), FS_SEEK_SET);
+    if (rc < 0) {
+        return rc;
+    }
+    ssize_t got = fs_read(file, entry, sizeof(*entry));
+    return (got == sizeof(*entry)) ? 0 : -ENODATA;
+}
+
+//  ========== first_start =================================================================
+// time of the first block of a data file, -ENOENT without index or entry
+static int first_start(uint32_t number, uint64_t *start_ms)
+{
+    struct fs_file_t file;
+    struct wave_index_entry first;
+    uint32_t entries;
+
+    if (open_index(number, &file, &entries) < 0) {
+        return -ENOENT;
+    }
+    int rc = (entries > 0) ? read_entry(&file, 0, &first) : -ENOENT;
+    fs_close(&file);
+    if (rc == 0) {
+        *start_ms = first.start_ms;
+    }
+    return (rc == 0) ? 0 : -ENOENT;
+}
+
+//  ========== find_file ===================================================================
+// last indexed data file whose first block starts at or before `time_ms`, `oldest` if
+// none does. A file without index (recorded before it, or its index was lost) has no
+// block to report: the search compares the next indexed file instead.
+static uint32_t find_file(uint32_t oldest, uint32_t next, uint64_t time_ms)
+{
+    uint32_t lo = oldest, hi = next, found = oldest;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t probe = mid;
+        uint64_t start_ms;
+
+        while (probe < hi && first_start(probe, &start_ms) < 0) {
+            probe++;
+        }
+        if (probe < hi && start_ms <= time_ms) {
+            found = probe;
+            lo = probe + 1;
+        } else {
+            // [mid, probe) has no index, nothing to find there
+            hi = mid;
+        }
+    }
+    return found;
+}
+
+//  ========== find_block ==================================================================
+// last entry of the index starting at or before `time_ms`, 0 if none does
+static uint32_t find_block(struct fs_file_t *file, uint32_t entries, uint64_t time_ms)
+{
+    uint32_t lo = 0, hi = entries, found = 0;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        struct wave_index_entry entry;
+
+        if (read_entry(file, mid, &entry) < 0) {
+            break;
+        }
+        if (entry.start_ms <= time_ms) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return found;
+}
+
+//  ========== wave_index_query ============================================================
+int wave_index_query(uint64_t from_ms, uint64_t to_ms, wave_index_cb_t cb, void *user)
+{
+    uint32_t oldest = (uint32_t)atomic_get(&oldest_file);
+    uint32_t next = (uint32_t)atomic_get(&next_file);
+    struct wave_index_range range = { .blocks = 0 };
+    int count = 0;
+    bool done = false;
+
+    if (from_ms >= to_ms) {
+        return -EINVAL;
+    }
+
+    uint32_t first = find_file(oldest, next, from_ms);
+    for (uint32_t number = first; number < next && !done; number++) {
+        struct fs_file_t file;
+        struct fs_dirent data;
+        char path[32];
+        uint32_t entries;
+
+        data_path(path, sizeof(path), number);
+        if (fs_stat(path, &data) < 0 || open_index(number, &file, &entries) < 0) {
+            continue;
+        }
+
+        uint32_t index = (number == first) ? find_block(&file, entries, from_ms) : 0;
+        struct wave_index_entry entry, following;
+        bool more = index < entries && read_entry(&file, index, &entry) == 0;
+
+        while (more && entry.offset < data.size) {
+            // the entries are read in sequence from here
+            more = ++index < entries &&
+                   fs_read(&file, &following, sizeof(following)) == sizeof(following);
+            uint32_t end = more ? MIN(following.offset, data.size) : data.size;
+            uint64_t end_ms = entry.start_ms + (uint64_t)entry.samples * entry.period_ms;
+
+            if (entry.start_ms >= to_ms) {
+                done = true;
+                break;
+            }
+            if (end_ms > from_ms && end > entry.offset) {
+                if (range.blocks > 0 &&
+                    (range.file != number || range.offset + range.size != entry.offset)) {
+                    count++;
+                    if (cb(&range, user) != 0) {
+                        range.blocks = 0;
+                        done = true;
+                        break;
+                    }
+                    range.blocks = 0;
+                }
+                if (range.blocks == 0) {
+                    range = (struct wave_index_range) {
+                        .file = number,
+                        .offset = entry.offset,
+                        .start_ms = entry.start_ms,
+                    };
+                }
+                range.size = end - range.offset;
+                range.end_ms = end_ms;
+                range.samples += entry.samples;
+                range.blocks++;
+            }
+            entry = following;
+        }
+        fs_close(&file);
+    }
+
+    if (range.blocks > 0) {
+        count++;
+        cb(&range, user);
+    }
+    return count;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WAVE_INDEX_H
+#define WAVE_INDEX_H
+
+/*
+ * Time index of the recorded geophone files.
+ *
+ * Next to each geophone_NNN.dat, the recorder writes geophone_NNN.idx with one
+ * struct wave_index_entry per block (one frame of STORAGE_FRAME_SAMPLES samples), in the
+ * order of the data file. The entries are buffered in RAM and written when the data file
+ * is synced, so after a reset the index may run ahead of the data: the blocks past the
+ * end of the data file are left out of the answers. Both files are deleted together.
+ *
+ * A query finds the first file of the window with a binary search on the first entry of
+ * each file, the first block with a binary search on the entries of that file, then
+ * reads the entries forward until the end of the window: O(log files + log blocks)
+ * reads before the first block. The recorder starts a new file when the time goes back,
+ * so the blocks of a file are in order; a file recorded before a backward time step
+ * (the first network time of a node whose DS3231 was wrong) may not be found.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+//  ========== defines =====================================================================
+// entries buffered before they are written, without waiting for the next sync
+#define WAVE_INDEX_BUFFER           32
+
+//  ========== types =======================================================================
+// one block of samples in a data file, little-endian on the flash
+struct wave_index_entry {
+    uint64_t start_ms;          // unix time of the first sample
+    uint32_t offset;            // of the block in the data file
+    uint16_t samples;
+    uint16_t period_ms;         // sampling period when the block was recorded
+} __packed;
+
+// consecutive blocks of one data file overlapping the window of a query
+struct wave_index_range {
+    uint32_t file;              // number of the geophone file
+    uint32_t offset;
+    uint32_t size;              // bytes
+    uint64_t start_ms;          // first sample of the first block
+    uint64_t end_ms;            // end of the last block
+    uint32_t samples;
+    uint16_t blocks;
+};
+
+// called for each range of a query, in time order. A non-zero return ends the query.
+typedef int (*wave_index_cb_t)(const struct wave_index_range *range, void *user);
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief create the index of a new data file, the entries added next belong to it
+ */
+int wave_index_begin(uint32_t file);
+
+/**
+ * @brief add a block to the index of the current data file
+ *
+ * Written to the flash when WAVE_INDEX_BUFFER entries are waiting.
+ */
+int wave_index_add(uint32_t offset, uint64_t start_ms, uint16_t samples, uint16_t period_ms);
+
+/**
+ * @brief write the waiting entries, after the data file has been synced
+ */
+int wave_index_sync(void);
+
+/**
+ * @brief write the waiting entries and close the index of the current data file
+ */
+void wave_index_end(void);
+
+/**
+ * @brief forget the waiting entries, the blocks they point to were not written
+ */
+void wave_index_discard(void);
+
+/**
+ * @brief delete the index of a data file
+ */
+void wave_index_remove(uint32_t file);
+
+/**
+ * @brief range of data files on the partition, [oldest, next), set by the recorder
+ */
+void wave_index_set_files(uint32_t oldest, uint32_t next);
+
+/**
+ * @brief call `cb` for the blocks overlapping [from_ms, to_ms), merged per data file
+ *
+ * Can be called from any thread while the recorder runs.
+ *
+ * @return number of ranges passed to `cb`, or a negative error code
+ */
+int wave_index_query(uint64_t from_ms, uint64_t to_ms, wave_index_cb_t cb, void *user);
+
+#endif /* WAVE_INDEX_H */
@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host replay of the firmware signal processing on recorded geophone files.
+ *
+ * The samples go through the same code as on the device: DC removal, detector bank,
+ * statistics engine, spectral features and waveform codec. Triggers are printed with
+ * the anomaly payload the node would send, followed by the throughput and the time
+ * spent in each stage. A golden trigger list can be written and checked against.
+ */
+
+//  ========== includes ====================================================================
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "data_types.h"
+#include "dc_filter.h"
+#include "detection_params.h"
+#include "detectors.h"
+#include "dsp_kernels.h"
+#include "packet_codec.h"
+#include "spectral.h"
+#include "stats_engine.h"
+#include "wave_codec.h"
+
+//  ========== defines =====================================================================
+#define CODEC_FRAME_SAMPLES         512     // as STORAGE_FRAME_SAMPLES
+#define RATIO_TOLERANCE             1e-3
+
+enum stage {
+    STAGE_DC = 0,
+    STAGE_DETECT,
+    STAGE_STATS,
+    STAGE_SPECTRAL,
+    STAGE_CODEC,
+    STAGE_COUNT,
+};
+
+static const char *const stage_names[STAGE_COUNT] = {
+    "dc filter", "detectors", "statistics", "spectral", "codec",
+};
+
+struct trigger {
+    uint32_t index;
+    float ratio;
+};
+
+struct options {
+    uint32_t rate_ms;
+    int mode;
+    int er, mer, threshold;
+    int votes;
+    int repeat;
+    uint32_t holdoff_ms;
+    uint64_t start_ms;
+    const char *golden;
+    const char *write_golden;
+    int quiet;
+};
+
+//  ========== helpers =====================================================================
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+    p = realloc(p, size);
+    if (p == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+//  ========== load_file ===================================================================
+// raw int16 samples, or frames of the waveform codec (recorder with compression)
+static int16_t *load_file(const char *path, size_t *count)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *data = xrealloc(NULL, size > 0 ? size : 1);
+    if (fread(data, 1, size, f) != (size_t)size) {
+        perror(path);
+        fclose(f);
+        free(data);
+        return NULL;
+    }
+    fclose(f);
+
+    int16_t *samples;
+    if (size >= 2 && (data[0] | (data[1] << 8)) == WAVE_CODEC_MAGIC) {
+        size_t n = 0, capacity = 0, pos = 0;
+        samples = NULL;
+        while (pos < (size_t)size) {
+            size_t frame_count;
+            if (n + UINT16_MAX > capacity) {
+                capacity = 2 * capacity + UINT16_MAX;
+                samples = xrealloc(samples, capacity * sizeof(int16_t));
+            }
+            int used = wave_codec_decode(&data[pos], size - pos, &samples[n], capacity - n,
+                                         &frame_count, NULL);
+            if (used < 0) {
+                fprintf(stderr, "%s: bad frame at byte %zu (%d), stopping there\n", path, pos, used);
+                break;
+            }
+            pos += used;
+            n += frame_count;
+        }
+        *count = n;
+    } else {
+        *count = size / sizeof(int16_t);
+        samples = xrealloc(NULL, (*count ? *count : 1) * sizeof(int16_t));
+        for (size_t i = 0; i < *count; i++) {
+            samples[i] = (int16_t)(data[2 * i] | (data[2 * i + 1] << 8));
+        }
+    }
+    free(data);
+    return samples;
+}
+
+//  ========== golden ======================================================================
+static int write_golden(const char *path, const struct trigger *t, size_t n)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        fprintf(f, "%u %.6f\n", t[i].index, t[i].ratio);
+    }
+    fclose(f);
+    return 0;
+}
+
+// returns the number of differences, printed on stderr
+static int check_golden(const char *path, const struct trigger *t, size_t n)
+{
+    FILE *f = fopen(path, "r");
+    unsigned index;
+    float ratio;
+    size_t i = 0;
+    int diffs = 0;
+
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    while (fscanf(f, "%u %f", &index, &ratio) == 2) {
+        if (i >= n) {
+            fprintf(stderr, "golden: missing trigger at %u\n", index);
+            diffs++;
+        } else if (t[i].index != index ||
+                   fabs(t[i].ratio - ratio) > RATIO_TOLERANCE * fabs(ratio)) {
+            fprintf(stderr, "golden: trigger %zu is %u (%.4f), expected %u (%.4f)\n",
+                    i, t[i].index, t[i].ratio, index, ratio);
+            diffs++;
+        }
+        i++;
+    }
+    fclose(f);
+    for (; i < n; i++) {
+        fprintf(stderr, "golden: unexpected trigger at %u\n", t[i].index);
+        diffs++;
+    }
+    return diffs;
+}
+
+//  ========== usage =======================================================================
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options] file.dat [file.dat ...]\n"
+            "  --rate MS            sampling period (default %d)\n"
+            "  --mode N             STA/LTA mode, 1 running or 2 recursive (default %d)\n"
+            "  --er --mer --threshold  add a detector to the bank\n"
+            "  --votes K            detectors needed to trigger (default %d)\n"
+            "  --holdoff MS         no trigger during the first MS of signal (default 0)\n"
+            "  --repeat N           replay the signal N times, for benchmarks\n"
+            "  --start MS           unix time of the first sample, for the payloads\n"
+            "  --golden FILE        compare the triggers with FILE, exit 1 on mismatch\n"
+            "  --write-golden FILE  write the triggers to FILE\n"
+            "  --quiet              only print the summary\n",
+            name, 10, STA_LTA_MODE == 0 ? 1 : STA_LTA_MODE, DETECTOR_VOTES);
+}
+
+//  ========== main ========================================================================
+int main(int argc, char **argv)
+{
+    struct options opt = {
+        .rate_ms = 10,
+        .mode = (STA_LTA_MODE == 0) ? STA_LTA_MODE_RUNNING : STA_LTA_MODE,
+        .er = DETECTOR_ER_ENABLE,
+        .mer = DETECTOR_MER_ENABLE,
+        .threshold = DETECTOR_THRESHOLD_ENABLE,
+        .votes = DETECTOR_VOTES,
+        .repeat = 1,
+    };
+    static const struct option long_options[] = {
+        { "rate", required_argument, NULL, 'r' },
+        { "mode", required_argument, NULL, 'm' },
+        { "er", no_argument, NULL, 'e' },
+        { "mer", no_argument, NULL, 'M' },
+        { "threshold", no_argument, NULL, 't' },
+        { "votes", required_argument, NULL, 'v' },
+        { "holdoff", required_argument, NULL, 'h' },
+        { "repeat", required_argument, NULL, 'n' },
+        { "start", required_argument, NULL, 's' },
+        { "golden", required_argument, NULL, 'g' },
+        { "write-golden", required_argument, NULL, 'w' },
+        { "quiet", no_argument, NULL, 'q' },
+        { 0 },
+    };
+    int c;
+
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'r': opt.rate_ms = strtoul(optarg, NULL, 10); break;
+        case 'm': opt.mode = atoi(optarg); break;
+        case 'e': opt.er = 1; break;
+        case 'M': opt.mer = 1; break;
+        case 't': opt.threshold = 1; break;
+        case 'v': opt.votes = atoi(optarg); break;
+        case 'h': opt.holdoff_ms = strtoul(optarg, NULL, 10); break;
+        case 'n': opt.repeat = atoi(optarg); break;
+        case 's': opt.start_ms = strtoull(optarg, NULL, 10); break;
+        case 'g': opt.golden = optarg; break;
+        case 'w': opt.write_golden = optarg; break;
+        case 'q': opt.quiet = 1; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc || opt.rate_ms == 0 || opt.repeat < 1 ||
+        (opt.mode != STA_LTA_MODE_RUNNING && opt.mode != STA_LTA_MODE_RECURSIVE)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // the recorded files, one after the other, as a continuous signal
+    int16_t *raw = NULL;
+    size_t n = 0;
+    for (int i = optind; i < argc; i++) {
+        size_t count;
+        int16_t *part = load_file(argv[i], &count);
+        if (part == NULL) {
+            return 2;
+        }
+        raw = xrealloc(raw, (n + count * opt.repeat + 1) * sizeof(int16_t));
+        for (int r = 0; r < opt.repeat; r++) {
+            memcpy(&raw[n + r * count], part, count * sizeof(int16_t));
+        }
+        n += count * opt.repeat;
+        free(part);
+    }
+    if (n == 0) {
+        fprintf(stderr, "no samples\n");
+        return 2;
+    }
+
+    double stage_ns[STAGE_COUNT] = { 0 };
+    double t0;
+    int16_t *x = xrealloc(NULL, n * sizeof(int16_t));
+
+    // DC removal, as in the ADC thread
+    struct dc_filter dc;
+    dc_filter_init(&dc, DC_FILTER_CORNER_MHZ, 1000000 / opt.rate_ms);
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        x[i] = dc_filter_update(&dc, raw[i]);
+    }
+    stage_ns[STAGE_DC] = now_ns() - t0;
+
+    // detector bank, as in the streaming detector thread
+    size_t sta_len = STA_WINDOW_DURATION_MS / opt.rate_ms;
+    size_t lta_len = LTA_WINDOW_DURATION_MS / opt.rate_ms;
+    int16_t *lta_history = xrealloc(NULL, lta_len * sizeof(int16_t));
+    int16_t *er_history = xrealloc(NULL, 2 * sta_len * sizeof(int16_t));
+    int16_t *mer_history = xrealloc(NULL, 2 * sta_len * sizeof(int16_t));
+    struct detector detectors[4];
+    struct detector_bank bank;
+    size_t nd = 0;
+
+    detector_init_sta_lta(&detectors[nd++], opt.mode, lta_history, sta_len, lta_len,
+                          DETECTION_RATIO, DETECTION_RATIO_OFF);
+    if (opt.er) {
+        detector_init_energy_ratio(&detectors[nd++], er_history, sta_len, ER_ON, ER_OFF);
+    }
+    if (opt.mer) {
+        detector_init_mer(&detectors[nd++], mer_history, sta_len, MER_ON, MER_OFF);
+    }
+    if (opt.threshold) {
+        detector_init_threshold(&detectors[nd++], THRESHOLD_ON_MV, THRESHOLD_OFF_MV);
+    }
+    if (detector_bank_init(&bank, detectors, nd, opt.votes, sta_len) != 0) {
+        fprintf(stderr, "invalid voting: %d of %zu detectors\n", opt.votes, nd);
+        return 2;
+    }
+
+    struct trigger *triggers = NULL;
+    size_t nt = 0;
+    int64_t last_ms = -(int64_t)MINIMAL_DELAY_ANOMALY_MS;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        if (!detector_bank_update(&bank, x[i])) {
+            continue;
+        }
+        int64_t t_ms = (int64_t)i * opt.rate_ms;
+        if (t_ms < opt.holdoff_ms || t_ms - last_ms < MINIMAL_DELAY_ANOMALY_MS || i + 1 < sta_len) {
+            continue;
+        }
+        last_ms = t_ms;
+        triggers = xrealloc(triggers, (nt + 1) * sizeof(*triggers));
+        triggers[nt].index = i;
+        triggers[nt].ratio = detectors[0].value;
+        nt++;
+    }
+    stage_ns[STAGE_DETECT] = now_ns() - t0;
+
+    // statistics over the whole signal
+    static struct stats_engine stats;
+    struct stats_summary summary;
+    stats_engine_init(&stats, opt.rate_ms);
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        stats_engine_update(&stats, x[i]);
+    }
+    stats_engine_take_period(&stats, &summary);
+    stage_ns[STAGE_STATS] = now_ns() - t0;
+
+    // spectral frames with 50 % overlap
+    static struct spectral spectral;
+    struct spectral_payload_t features;
+    size_t frames = 0;
+    spectral_init(&spectral, opt.rate_ms);
+    t0 = now_ns();
+    for (size_t i = 0; i + SPECTRAL_FFT_SIZE <= n; i += SPECTRAL_HOP) {
+        spectral_process(&spectral, &x[i], &features);
+        frames++;
+    }
+    stage_ns[STAGE_SPECTRAL] = now_ns() - t0;
+
+    // waveform codec, as the recorder
+    static uint8_t frame[WAVE_CODEC_MAX_FRAME(CODEC_FRAME_SAMPLES)];
+    size_t encoded = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i += CODEC_FRAME_SAMPLES) {
+        size_t count = (n - i < CODEC_FRAME_SAMPLES) ? n - i : CODEC_FRAME_SAMPLES;
+        encoded += wave_codec_encode(&x[i], count, opt.start_ms + i * opt.rate_ms, frame);
+    }
+    stage_ns[STAGE_CODEC] = now_ns() - t0;
+
+    // triggers with the anomaly payload of the node, as a v2 frame
+    for (size_t k = 0; k < nt && !opt.quiet; k++) {
+        uint32_t i = triggers[k].index;
+        const int16_t *window = &x[i + 1 - sta_len];
+        struct anomaly_payload_t payload = { 0 };
+        uint64_t t_ms = opt.start_ms + (uint64_t)i * opt.rate_ms;
+
+        dsp_min_max_q15(window, sta_len, &payload.min, &payload.max);
+        payload.mean = dc_filter_baseline(&dc) + dsp_mean_q15(window, sta_len);
+        payload.stalta = (int16_t)fminf(triggers[k].ratio * 100.0f, 32767.0f);
+        payload.event_id = k;
+        payload.period_ms = (uint16_t)opt.rate_ms;
+        if (i + 1 >= SPECTRAL_FFT_SIZE) {
+            spectral_process(&spectral, &x[i + 1 - SPECTRAL_FFT_SIZE], &payload.spectral);
+        }
+
+        uint8_t buf[LORA_MAX_FRAME];
+        struct packet_writer writer;
+        packet_writer_init(&writer, buf, sizeof(buf), t_ms);
+        packet_writer_add(&writer, ANOMALY, t_ms, &payload, sizeof(payload));
+
+        printf("trigger %u t=%.2fs ratio=%.3f min=%d max=%d mean=%d dominant=%.1fHz payload=",
+               i, i * opt.rate_ms / 1000.0, triggers[k].ratio, payload.min, payload.max,
+               payload.mean, payload.spectral.dominant / 10.0);
+        for (size_t b = 0; b < packet_writer_size(&writer); b++) {
+            printf("%02x", buf[b]);
+        }
+        printf("\n");
+    }
+
+    // summary
+    double total_ns = 0;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        total_ns += stage_ns[s];
+    }
+    double seconds = n * opt.rate_ms / 1000.0;
+    printf("samples: %zu (%.1f s of signal), triggers: %zu\n", n, seconds, nt);
+    printf("throughput: %.3g samples/s, %.0fx real time\n",
+           n / (total_ns * 1e-9), seconds / (total_ns * 1e-9));
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        printf("  %-11s %8.1f ns/sample\n", stage_names[s], stage_ns[s] / n);
+    }
+    printf("spectral frames: %zu, %.2f us/frame\n", frames,
+           frames ? stage_ns[STAGE_SPECTRAL] / frames / 1000.0 : 0.0);
+    printf("codec: %zu -> %zu bytes, ratio %.2f\n", n * sizeof(int16_t), encoded,
+           encoded ? (double)(n * sizeof(int16_t)) / encoded : 0.0);
+    printf("statistics: min %d max %d rms %u p50 %u p90 %u p99 %u\n", summary.min, summary.max,
+           summary.rms, summary.percentiles[0], summary.percentiles[1], summary.percentiles[2]);
+
+    int status = 0;
+    if (opt.write_golden != NULL && write_golden(opt.write_golden, triggers, nt) != 0) {
+        status = 2;
+    }
+    if (opt.golden != NULL) {
+        int diffs = check_golden(opt.golden, triggers, nt);
+        printf("golden: %s\n", diffs ? "MISMATCH" : "ok");
+        status = diffs ? 1 : status;
+    }
+
+    free(raw);
+    free(x);
+    free(lta_history);
+    free(er_history);
+    free(mer_history);
+    free(triggers);
+    return status;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_CMSIS_CORE_H
+#define STUB_CMSIS_CORE_H
+
+/*
+ * The Cortex-M4 SIMD intrinsics used by dsp_kernels.c, in C, to run its DSP_KERNELS_SIMD
+ * path on the host. The GE flags of SSUB16 are kept in a global read by SEL.
+ */
+
+#include <stdint.h>
+
+static int ge_flags[2];
+
+static inline int32_t emul_sat_q15(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline int16_t emul_lo(uint32_t v)
+{
+    return (int16_t)(uint16_t)v;
+}
+
+static inline int16_t emul_hi(uint32_t v)
+{
+    return (int16_t)(uint16_t)(v >> 16);
+}
+
+static inline uint32_t emul_pack(int32_t lo, int32_t hi)
+{
+    return ((uint32_t)(uint16_t)hi << 16) | (uint16_t)lo;
+}
+
+static inline uint32_t __SMLAD(uint32_t a, uint32_t b, uint32_t acc)
+{
+    return acc + (uint32_t)(emul_lo(a) * emul_lo(b)) + (uint32_t)(emul_hi(a) * emul_hi(b));
+}
+
+static inline uint64_t __SMLALD(uint32_t a, uint32_t b, uint64_t acc)
+{
+    return acc + (uint64_t)((int64_t)emul_lo(a) * emul_lo(b) + (int64_t)emul_hi(a) * emul_hi(b));
+}
+
+static inline uint32_t __QSUB16(uint32_t a, uint32_t b)
+{
+    return emul_pack(emul_sat_q15(emul_lo(a) - emul_lo(b)), emul_sat_q15(emul_hi(a) - emul_hi(b)));
+}
+
+static inline uint32_t __SSUB16(uint32_t a, uint32_t b)
+{
+    int32_t lo = emul_lo(a) - emul_lo(b);
+    int32_t hi = emul_hi(a) - emul_hi(b);
+
+    ge_flags[0] = (lo >= 0);
+    ge_flags[1] = (hi >= 0);
+    return emul_pack(lo, hi);
+}
+
+static inline uint32_t __SEL(uint32_t a, uint32_t b)
+{
+    return (ge_flags[1] ? (a & 0xffff0000u) : (b & 0xffff0000u)) |
+           (ge_flags[0] ? (a & 0x0000ffffu) : (b & 0x0000ffffu));
+}
+
+#endif /* STUB_CMSIS_CORE_H */
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The Zephyr file system calls on POSIX files, LFS_MOUNT_POINT being a host directory.
+ * Errors are returned as negative errno values, as the file systems of Zephyr do.
+ */
+
+//  ========== includes ====================================================================
+#include "fs_utils.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//  ========== globals =====================================================================
+static char root[256];
+
+//  ========== helpers =====================================================================
+// host path of a path under LFS_MOUNT_POINT
+static const char *host_path(const char *path, char *buf, size_t size)
+{
+    size_t mount_len = strlen(LFS_MOUNT_POINT);
+
+    if (strncmp(path, LFS_MOUNT_POINT, mount_len) != 0) {
+        return NULL;
+    }
+    snprintf(buf, size, "%s%s", root, path + mount_len);
+    return buf;
+}
+
+//  ========== fs_stub_init ================================================================
+void fs_stub_init(const char *dir)
+{
+    snprintf(root, sizeof(root), "%s", dir);
+}
+
+//  ========== fs_utils ====================================================================
+int mount_lfs(void)
+{
+    return 0;
+}
+
+bool is_lfs_mounted(void)
+{
+    return true;
+}
+
+//  ========== files =======================================================================
+int fs_open(struct fs_file_t *zfp, const char *file_name, fs_mode_t flags)
+{
+    char buf[512];
+    const char *path = host_path(file_name, buf, sizeof(buf));
+    int oflags = ((flags & FS_O_RDWR) == FS_O_RDWR) ? O_RDWR
+                 : (flags & FS_O_WRITE) ? O_WRONLY : O_RDONLY;
+
+    if (path == NULL) {
+        return -ENOENT;
+    }
+    oflags |= (flags & FS_O_CREATE) ? O_CREAT : 0;
+    oflags |= (flags & FS_O_APPEND) ? O_APPEND : 0;
+    oflags |= (flags & FS_O_TRUNC) ? O_TRUNC : 0;
+    zfp->fd = open(path, oflags, 0644);
+    return (zfp->fd < 0) ? -errno : 0;
+}
+
+int fs_close(struct fs_file_t *zfp)
+{
+    int rc = close(zfp->fd);
+    zfp->fd = -1;
+    return (rc < 0) ? -errno : 0;
+}
+
+ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size)
+{
+    ssize_t got = read(zfp->fd, ptr, size);
+    return (got < 0) ? -errno : got;
+}
+
+ssize_t fs_write(struct fs_file_t *zfp, const void *ptr, size_t size)
+{
+    ssize_t written = write(zfp->fd, ptr, size);
+    return (written < 0) ? -errno : written;
+}
+
+int fs_seek(struct fs_file_t *zfp, off_t offset, int whence)
+{
+    int host = (whence == FS_SEEK_END) ? SEEK_END : (whence == FS_SEEK_CUR) ? SEEK_CUR : SEEK_SET;
+    return (lseek(zfp->fd, offset, host) < 0) ? -errno : 0;
+}
+
+off_t fs_tell(struct fs_file_t *zfp)
+{
+    off_t pos = lseek(zfp->fd, 0, SEEK_CUR);
+    return (pos < 0) ? -errno : pos;
+}
+
+int fs_truncate(struct fs_file_t *zfp, off_t length)
+{
+    return (ftruncate(zfp->fd, length) < 0) ? -errno : 0;
+}
+
+int fs_sync(struct fs_file_t *zfp)
+{
+    return (fsync(zfp->fd) < 0) ? -errno : 0;
+}
+
+//  ========== paths =======================================================================
+int fs_unlink(const char *path)
+{
+    char buf[512];
+    const char *host = host_path(path, buf, sizeof(buf));
+    return (host == NULL || unlink(host) < 0) ? -ENOENT : 0;
+}
+
+int fs_rename(const char *from, const char *to)
+{
+    char buf_from[512], buf_to[512];
+    const char *host_from = host_path(from, buf_from, sizeof(buf_from));
+    const char *host_to = host_path(to, buf_to, sizeof(buf_to));
+
+    if (host_from == NULL || host_to == NULL) {
+        return -ENOENT;
+    }
+    return (rename(host_from, host_to) < 0) ? -errno : 0;
+}
+
+int fs_stat(const char *path, struct fs_dirent *entry)
+{
+    char buf[512];
+    const char *host = host_path(path, buf, sizeof(buf));
+    struct stat st;
+
+    if (host == NULL || stat(host, &st) < 0) {
+        return -ENOENT;
+    }
+    const char *name = strrchr(path, '/');
+    snprintf(entry->name, sizeof(entry->name), "%s", name ? name + 1 : path);
+    entry->type = S_ISDIR(st.st_mode) ? FS_DIR_ENTRY_DIR : FS_DIR_ENTRY_FILE;
+    entry->size = (size_t)st.st_size;
+    return 0;
+}
+
+//  ========== directories =================================================================
+int fs_opendir(struct fs_dir_t *zdp, const char *path)
+{
+    char buf[512];
+    const char *host = host_path(path, buf, sizeof(buf));
+
+    zdp->dir = (host != NULL) ? opendir(host) : NULL;
+    return (zdp->dir == NULL) ? -ENOENT : 0;
+}
+
+// an empty name at the end, as Zephyr
+int fs_readdir(struct fs_dir_t *zdp, struct fs_dirent *entry)
+{
+    struct dirent *d;
+
+    do {
+        d = readdir(zdp->dir);
+    } while (d != NULL && d->d_name[0] == '.');
+
+    entry->name[0] = '\0';
+    entry->size = 0;
+    entry->type = FS_DIR_ENTRY_FILE;
+    if (d != NULL) {
+        snprintf(entry->name, sizeof(entry->name), "%s", d->d_name);
+        entry->type = (d->d_type == DT_DIR) ? FS_DIR_ENTRY_DIR : FS_DIR_ENTRY_FILE;
+    }
+    return 0;
+}
+
+int fs_closedir(struct fs_dir_t *zdp)
+{
+    closedir(zdp->dir);
+    zdp->dir = NULL;
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The settings subsystem on a few keys in RAM, each handed to the static handler of
+ * its subtree by settings_load_subtree(), as NVS does at boot.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/settings/settings.h>
+
+//  ========== defines =====================================================================
+#define STUB_KEYS                   8
+#define STUB_HANDLERS               4
+#define STUB_NAME_SIZE              32
+#define STUB_VALUE_SIZE             64
+
+//  ========== globals =====================================================================
+struct stub_key {
+    char name[STUB_NAME_SIZE];
+    uint8_t value[STUB_VALUE_SIZE];
+    size_t len;
+};
+
+static struct stub_key keys[STUB_KEYS];
+static const struct settings_handler_static *handlers[STUB_HANDLERS];
+
+// read position of the value being loaded
+struct stub_read {
+    const struct stub_key *key;
+    size_t pos;
+};
+
+//  ========== helpers =====================================================================
+static struct stub_key *find(const char *name)
+{
+    for (size_t i = 0; i < STUB_KEYS; i++) {
+        if (keys[i].len != 0 && strcmp(keys[i].name, name) == 0) {
+            return &keys[i];
+        }
+    }
+    return NULL;
+}
+
+static ssize_t read_value(void *cb_arg, void *data, size_t len)
+{
+    struct stub_read *read = cb_arg;
+    size_t count = MIN(len, read->key->len - read->pos);
+
+    memcpy(data, &read->key->value[read->pos], count);
+    read->pos += count;
+    return (ssize_t)count;
+}
+
+//  ========== settings_stub ===============================================================
+void settings_stub_register(const struct settings_handler_static *handler)
+{
+    for (size_t i = 0; i < STUB_HANDLERS; i++) {
+        if (handlers[i] == NULL) {
+            handlers[i] = handler;
+            return;
+        }
+    }
+}
+
+ssize_t settings_stub_get(const char *name, void *value, size_t size)
+{
+    const struct stub_key *key = find(name);
+
+    if (key == NULL) {
+        return -ENOENT;
+    }
+    memcpy(value, key->value, MIN(size, key->len));
+    return (ssize_t)key->len;
+}
+
+//  ========== settings ====================================================================
+int settings_subsys_init(void)
+{
+    return 0;
+}
+
+int settings_name_steq(const char *name, const char *key, const char **next)
+{
+    size_t len = strlen(key);
+
+    if (next != NULL) {
+        *next = NULL;
+    }
+    if (strncmp(name, key, len) != 0) {
+        return 0;
+    }
+    if (name[len] == '/' && next != NULL) {
+        *next = &name[len + 1];
+    }
+    return name[len] == '\0' || name[len] == '=' || name[len] == '/';
+}
+
+int settings_load_subtree(const char *subtree)
+{
+    size_t len = strlen(subtree);
+
+    for (size_t i = 0; i < STUB_KEYS; i++) {
+        if (keys[i].len == 0 || strncmp(keys[i].name, subtree, len) != 0 ||
+            keys[i].name[len] != '/') {
+            continue;
+        }
+        for (size_t h = 0; h < STUB_HANDLERS && handlers[h] != NULL; h++) {
+            if (strcmp(handlers[h]->name, subtree) != 0 || handlers[h]->h_set == NULL) {
+                continue;
+            }
+            struct stub_read read = { .key = &keys[i] };
+            int rc = handlers[h]->h_set(&keys[i].name[len + 1], keys[i].len, read_value, &read);
+            if (rc != 0 && rc != -ENOENT) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+    struct stub_key *key = find(name);
+
+    if (val_len == 0) {
+        return settings_delete(name);
+    }
+    if (val_len > STUB_VALUE_SIZE || strlen(name) >= STUB_NAME_SIZE) {
+        return -ENOMEM;
+    }
+    for (size_t i = 0; key == NULL && i < STUB_KEYS; i++) {
+        if (keys[i].len == 0) {
+            key = &keys[i];
+        }
+    }
+    if (key == NULL) {
+        return -ENOSPC;
+    }
+    strcpy(key->name, name);
+    memcpy(key->value, value, val_len);
+    key->len = val_len;
+    return 0;
+}
+
+int settings_delete(const char *name)
+{
+    struct stub_key *key = find(name);
+
+    if (key != NULL) {
+        key->len = 0;
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_DEVICE_H
+#define STUB_ZEPHYR_DEVICE_H
+
+/*
+ * Only declared by the headers of the tested modules, no device exists on the host.
+ */
+
+//  ========== types =======================================================================
+struct device {
+    const char *name;
+};
+
+#endif /* STUB_ZEPHYR_DEVICE_H */
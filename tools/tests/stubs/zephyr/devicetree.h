@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_DEVICETREE_H
+#define STUB_ZEPHYR_DEVICETREE_H
+
+/*
+ * Included by the headers of the tested modules, no node is looked up on the host.
+ */
+
+#endif /* STUB_ZEPHYR_DEVICETREE_H */
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_DRIVERS_ADC_H
+#define STUB_ZEPHYR_DRIVERS_ADC_H
+
+/*
+ * Included by the headers of the tested modules, the driver itself is not called.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/device.h>
+
+#endif /* STUB_ZEPHYR_DRIVERS_ADC_H */
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_FS_FS_H
+#define STUB_ZEPHYR_FS_FS_H
+
+/*
+ * The Zephyr file system API on the host files, see stubs/fs.c: the paths under
+ * LFS_MOUNT_POINT are looked up in the directory given to fs_stub_init().
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+
+//  ========== defines =====================================================================
+#define FS_O_READ                   0x01
+#define FS_O_WRITE                  0x02
+#define FS_O_RDWR                   (FS_O_READ | FS_O_WRITE)
+#define FS_O_CREATE                 0x10
+#define FS_O_APPEND                 0x20
+#define FS_O_TRUNC                  0x40
+
+#define FS_SEEK_SET                 0
+#define FS_SEEK_CUR                 1
+#define FS_SEEK_END                 2
+
+#define MAX_FILE_NAME               255
+
+//  ========== types =======================================================================
+typedef uint8_t fs_mode_t;
+
+struct fs_file_t {
+    int fd;
+};
+
+struct fs_dir_t {
+    void *dir;
+};
+
+enum fs_dir_entry_type {
+    FS_DIR_ENTRY_FILE = 0,
+    FS_DIR_ENTRY_DIR,
+};
+
+struct fs_dirent {
+    enum fs_dir_entry_type type;
+    char name[MAX_FILE_NAME + 1];
+    size_t size;
+};
+
+//  ========== prototypes ==================================================================
+/**
+ * @brief host directory standing for LFS_MOUNT_POINT
+ */
+void fs_stub_init(const char *root);
+
+static inline void fs_file_t_init(struct fs_file_t *zfp)
+{
+    zfp->fd = -1;
+}
+
+static inline void fs_dir_t_init(struct fs_dir_t *zdp)
+{
+    zdp->dir = NULL;
+}
+
+int fs_open(struct fs_file_t *zfp, const char *file_name, fs_mode_t flags);
+int fs_close(struct fs_file_t *zfp);
+ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size);
+ssize_t fs_write(struct fs_file_t *zfp, const void *ptr, size_t size);
+int fs_seek(struct fs_file_t *zfp, off_t offset, int whence);
+off_t fs_tell(struct fs_file_t *zfp);
+int fs_truncate(struct fs_file_t *zfp, off_t length);
+int fs_sync(struct fs_file_t *zfp);
+int fs_unlink(const char *path);
+int fs_rename(const char *from, const char *to);
+int fs_stat(const char *path, struct fs_dirent *entry);
+int fs_opendir(struct fs_dir_t *zdp, const char *path);
+int fs_readdir(struct fs_dir_t *zdp, struct fs_dirent *entry);
+int fs_closedir(struct fs_dir_t *zdp);
+
+#endif /* STUB_ZEPHYR_FS_FS_H */
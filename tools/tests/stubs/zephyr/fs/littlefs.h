@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_FS_LITTLEFS_H
+#define STUB_ZEPHYR_FS_LITTLEFS_H
+
+#include <zephyr/fs/fs.h>
+
+#endif /* STUB_ZEPHYR_FS_LITTLEFS_H */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_KERNEL_H
+#define STUB_ZEPHYR_KERNEL_H
+
+/*
+ * The part of the Zephyr kernel API the tested modules use, on the host C library.
+ */
+
+//  ========== includes ====================================================================
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <zephyr/sys/atomic.h>
+
+//  ========== defines =====================================================================
+#define MIN(a, b)                   (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)                   (((a) > (b)) ? (a) : (b))
+#define CLAMP(v, lo, hi)            MIN(MAX(v, lo), hi)
+#define BIT(n)                      (1UL << (n))
+#define ARRAY_SIZE(a)               (sizeof(a) / sizeof((a)[0]))
+#define __packed                    __attribute__((packed))
+#define __ASSERT(cond, msg)         assert(cond)
+#define __ASSERT_NO_MSG(cond)       assert(cond)
+#define BUILD_ASSERT(cond, msg)     _Static_assert(cond, msg)
+#define ARG_UNUSED(x)               (void)(x)
+
+#define printk                      printf
+
+#define MSEC_PER_SEC                1000
+#define USEC_PER_SEC                1000000
+#define USEC_PER_MSEC               1000
+#define NSEC_PER_USEC               1000
+#define NSEC_PER_MSEC               1000000
+
+//  ========== types =======================================================================
+typedef struct {
+    int64_t ticks;
+} k_timeout_t;
+
+#define K_NO_WAIT                   ((k_timeout_t){ 0 })
+#define K_FOREVER                   ((k_timeout_t){ -1 })
+
+// the tests using spinlocks drive their module from a single thread
+struct k_spinlock {
+    int unused;
+};
+
+typedef int k_spinlock_key_t;
+
+// k_thread_create() starts nothing, the tests call the work of the threads directly
+struct k_thread {
+    int unused;
+};
+
+typedef struct k_thread *k_tid_t;
+typedef void (*k_thread_entry_t)(void *p1, void *p2, void *p3);
+
+#define K_THREAD_STACK_DEFINE(name, size)   char name[size]
+#define K_THREAD_STACK_SIZEOF(name)         sizeof(name)
+
+struct k_mutex {
+    int unused;
+};
+
+#define K_MUTEX_DEFINE(name)        struct k_mutex name
+
+struct k_condvar {
+    int unused;
+};
+
+#define K_CONDVAR_DEFINE(name)      struct k_condvar name
+
+// a message queue never blocks: a single thread would wait forever
+struct k_msgq {
+    char *buffer;
+    size_t msg_size;
+    uint32_t max_msgs;
+    uint32_t read;
+    uint32_t used;
+};
+
+#define K_MSGQ_DEFINE(name, size, max, align)                                               \
+    static char _k_msgq_buf_##name[(size) * (max)];                                         \
+    struct k_msgq name = { _k_msgq_buf_##name, (size), (max), 0, 0 }
+
+//  ========== functions ===================================================================
+static inline k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
+{
+    (void)l;
+    return 0;
+}
+
+static inline void k_spin_unlock(struct k_spinlock *l, k_spinlock_key_t key)
+{
+    (void)l;
+    (void)key;
+}
+
+static inline k_tid_t k_thread_create(struct k_thread *new_thread, char *stack, size_t stack_size,
+                                      k_thread_entry_t entry, void *p1, void *p2, void *p3,
+                                      int prio, uint32_t options, k_timeout_t delay)
+{
+    (void)stack;
+    (void)stack_size;
+    (void)entry;
+    (void)p1;
+    (void)p2;
+    (void)p3;
+    (void)prio;
+    (void)options;
+    (void)delay;
+    return new_thread;
+}
+
+static inline int k_thread_name_set(k_tid_t thread, const char *name)
+{
+    (void)thread;
+    (void)name;
+    return 0;
+}
+
+static inline int k_mutex_lock(struct k_mutex *mutex, k_timeout_t timeout)
+{
+    (void)mutex;
+    (void)timeout;
+    return 0;
+}
+
+static inline int k_mutex_unlock(struct k_mutex *mutex)
+{
+    (void)mutex;
+    return 0;
+}
+
+static inline int k_condvar_broadcast(struct k_condvar *condvar)
+{
+    (void)condvar;
+    return 0;
+}
+
+// nothing else runs to signal it
+static inline int k_condvar_wait(struct k_condvar *condvar, struct k_mutex *mutex,
+                                 k_timeout_t timeout)
+{
+    (void)condvar;
+    (void)mutex;
+    (void)timeout;
+    return -EAGAIN;
+}
+
+static inline int k_msgq_put(struct k_msgq *q, const void *data, k_timeout_t timeout)
+{
+    (void)timeout;
+    if (q->used == q->max_msgs) {
+        return -ENOMSG;
+    }
+    memcpy(&q->buffer[((q->read + q->used) % q->max_msgs) * q->msg_size], data, q->msg_size);
+    q->used++;
+    return 0;
+}
+
+static inline int k_msgq_get(struct k_msgq *q, void *data, k_timeout_t timeout)
+{
+    (void)timeout;
+    if (q->used == 0) {
+        return -ENOMSG;
+    }
+    memcpy(data, &q->buffer[q->read * q->msg_size], q->msg_size);
+    q->read = (q->read + 1) % q->max_msgs;
+    q->used--;
+    return 0;
+}
+
+static inline uint32_t k_msgq_num_used_get(struct k_msgq *q)
+{
+    return q->used;
+}
+
+static inline void k_msgq_purge(struct k_msgq *q)
+{
+    q->read = 0;
+    q->used = 0;
+}
+
+static inline int64_t k_uptime_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+}
+
+#endif /* STUB_ZEPHYR_KERNEL_H */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_LOGGING_LOG_H
+#define STUB_ZEPHYR_LOGGING_LOG_H
+
+/*
+ * The warnings and errors of the tested modules go to the test output, the rest is
+ * dropped.
+ */
+
+//  ========== includes ====================================================================
+#include <stdio.h>
+
+//  ========== defines =====================================================================
+#define LOG_MODULE_REGISTER(...)
+#define LOG_MODULE_DECLARE(...)
+
+#define LOG_ERR(fmt, ...)           printf("<err> " fmt "\n", ##__VA_ARGS__)
+#define LOG_WRN(fmt, ...)           printf("<wrn> " fmt "\n", ##__VA_ARGS__)
+#define LOG_INF(fmt, ...)           do { } while (0)
+#define LOG_DBG(fmt, ...)           do { } while (0)
+
+#endif /* STUB_ZEPHYR_LOGGING_LOG_H */
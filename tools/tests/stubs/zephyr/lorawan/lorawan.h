@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_LORAWAN_LORAWAN_H
+#define STUB_ZEPHYR_LORAWAN_LORAWAN_H
+
+/*
+ * The types of the LoRaWAN API in the prototypes of uplink.h, the stack is not called.
+ */
+
+//  ========== types =======================================================================
+enum lorawan_datarate {
+    LORAWAN_DR_0 = 0,
+    LORAWAN_DR_1,
+    LORAWAN_DR_2,
+    LORAWAN_DR_3,
+    LORAWAN_DR_4,
+    LORAWAN_DR_5,
+    LORAWAN_DR_6,
+    LORAWAN_DR_7,
+};
+
+#endif /* STUB_ZEPHYR_LORAWAN_LORAWAN_H */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_SETTINGS_SETTINGS_H
+#define STUB_ZEPHYR_SETTINGS_SETTINGS_H
+
+/*
+ * The settings subsystem on a store in RAM, see stubs/settings.c. It outlives the
+ * module being tested, so calling its init again stands for a reboot.
+ */
+
+//  ========== includes ====================================================================
+#include <zephyr/kernel.h>
+
+//  ========== types =======================================================================
+typedef ssize_t (*settings_read_cb)(void *cb_arg, void *data, size_t len);
+
+struct settings_handler_static {
+    const char *name;
+    int (*h_get)(const char *key, char *val, int val_len_max);
+    int (*h_set)(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg);
+    int (*h_commit)(void);
+    int (*h_export)(int (*export_func)(const char *name, const void *val, size_t val_len));
+};
+
+//  ========== defines =====================================================================
+// registered before main() instead of in an iterable section
+#define SETTINGS_STATIC_HANDLER_DEFINE(_hname, _tree, _get, _set, _commit, _export)         \
+    static const struct settings_handler_static settings_handler_##_hname = {               \
+        _tree, _get, _set, _commit, _export                                                 \
+    };                                                                                      \
+    __attribute__((constructor)) static void settings_register_##_hname(void)               \
+    {                                                                                       \
+        settings_stub_register(&settings_handler_##_hname);                                 \
+    }
+
+//  ========== prototypes ==================================================================
+int settings_subsys_init(void);
+int settings_load_subtree(const char *subtree);
+int settings_save_one(const char *name, const void *value, size_t val_len);
+int settings_delete(const char *name);
+int settings_name_steq(const char *name, const char *key, const char **next);
+
+/**
+ * @brief handler of SETTINGS_STATIC_HANDLER_DEFINE
+ */
+void settings_stub_register(const struct settings_handler_static *handler);
+
+/**
+ * @brief value saved under `name`
+ *
+ * @return its size, -ENOENT if none
+ */
+ssize_t settings_stub_get(const char *name, void *value, size_t size);
+
+#endif /* STUB_ZEPHYR_SETTINGS_SETTINGS_H */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_SYS_ATOMIC_H
+#define STUB_ZEPHYR_SYS_ATOMIC_H
+
+// sequentially consistent, as the Zephyr atomics on the Cortex-M4
+typedef long atomic_t;
+typedef long atomic_val_t;
+
+#define ATOMIC_INIT(v)              (v)
+
+static inline atomic_val_t atomic_get(const atomic_t *a)
+{
+    return __atomic_load_n(a, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *a, atomic_val_t v)
+{
+    return __atomic_exchange_n(a, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_clear(atomic_t *a)
+{
+    return atomic_set(a, 0);
+}
+
+static inline atomic_val_t atomic_add(atomic_t *a, atomic_val_t v)
+{
+    return __atomic_fetch_add(a, v, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_inc(atomic_t *a)
+{
+    return atomic_add(a, 1);
+}
+
+static inline atomic_val_t atomic_dec(atomic_t *a)
+{
+    return atomic_add(a, -1);
+}
+
+#endif /* STUB_ZEPHYR_SYS_ATOMIC_H */
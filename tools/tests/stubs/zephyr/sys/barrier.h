@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_SYS_BARRIER_H
+#define STUB_ZEPHYR_SYS_BARRIER_H
+
+#define barrier_dmem_fence_full()   __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif /* STUB_ZEPHYR_SYS_BARRIER_H */
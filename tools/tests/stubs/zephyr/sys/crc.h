@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STUB_ZEPHYR_SYS_CRC_H
+#define STUB_ZEPHYR_SYS_CRC_H
+
+//  ========== includes ====================================================================
+#include <stddef.h>
+#include <stdint.h>
+
+//  ========== crc16_ccitt =================================================================
+// same as lib/crc/crc16_sw.c: polynomial 0x1021, reflected, no final XOR
+static inline uint16_t crc16_ccitt(uint16_t seed, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t e = (uint8_t)(seed ^ src[i]);
+        uint8_t f = (uint8_t)(e ^ (e << 4));
+
+        seed = (uint16_t)((seed >> 8) ^ ((uint16_t)f << 8) ^ ((uint16_t)f << 3) ^ (f >> 4));
+    }
+    return seed;
+}
+
+#endif /* STUB_ZEPHYR_SYS_CRC_H */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+/*
+ * Checks of the host tests: a failed check is printed and counted, the test goes on and
+ * main() returns TEST_RESULT() for ctest. The timings they print are for information,
+ * no check depends on the speed of the host.
+ */
+
+//  ========== includes ====================================================================
+#include <stdio.h>
+#include <time.h>
+
+//  ========== defines =====================================================================
+static int test_failures;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                   \
+    do {                                                                             \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);              \
+        if (a_ != e_) {                                                              \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                    #actual, a_, e_);                                                \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                      \
+    do {                                                                             \
+        double a_ = (double)(actual), e_ = (double)(expected);                       \
+        if (!(a_ - e_ <= (tolerance) && e_ - a_ <= (tolerance))) {                   \
+            fprintf(stderr, "%s:%d: %s is %g, expected %g +- %g\n", __FILE__,        \
+                    __LINE__, #actual, a_, e_, (double)(tolerance));                 \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+#define TEST_RESULT()                                                                \
+    (printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "passed"), test_failures != 0)
+
+//  ========== test_now_ns =================================================================
+static inline double test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#endif /* TEST_H */
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * clock_model: a RTC2 clock 40 ppm fast, with or without a daily temperature swing,
+ * observed through DS3231 second edges dated within their uncertainty, at the intervals
+ * clock_discipline picks from the prediction errors. The fit must find the frequency,
+ * predict each edge within CLOCK_TARGET_US once settled and never make the time go
+ * back. Then the slew of a correction, a step, and the fits it refuses.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "clock_model.h"
+#include "clock_discipline.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define UNIX_START_US               (1741785632LL * USEC_PER_SEC)
+#define DAY_S                       86400
+
+//  ========== simulated oscillator ========================================================
+struct oscillator {
+    double ppm;                 // constant frequency error
+    double swing_ppm;           // daily temperature swing on top of it
+};
+
+// local clock reading at a true time since the start, in us
+static double local_at(const struct oscillator *o, double t_s)
+{
+    // integral of 1 + (ppm + swing sin(2 pi t / day)) 1e-6
+    double swing = o->swing_ppm * DAY_S / (2 * M_PI) * (1 - cos(2 * M_PI * t_s / DAY_S));
+    return (t_s + (o->ppm * t_s + swing) * 1e-6) * USEC_PER_SEC;
+}
+
+// true time of a local clock reading, by Newton on local_at()
+static double true_at(const struct oscillator *o, double local_us)
+{
+    double t = local_us / USEC_PER_SEC;
+    for (int i = 0; i < 4; i++) {
+        double rate = 1 + (o->ppm + o->swing_ppm * sin(2 * M_PI * t / DAY_S)) * 1e-6;
+        t -= (local_at(o, t) - local_us) / USEC_PER_SEC / rate;
+    }
+    return t;
+}
+
+// DS3231 edge at a whole second, dated on the local clock within its uncertainty
+static struct clock_obs edge(const struct oscillator *o, int64_t t_s, unsigned int *seed)
+{
+    double jitter = ((double)rand_r(seed) / RAND_MAX * 2 - 1) * CLOCK_DS3231_SIGMA_US;
+    struct clock_obs obs = {
+        .local_us = llround(local_at(o, (double)t_s) + jitter),
+        .unix_us = UNIX_START_US + t_s * USEC_PER_SEC,
+        .sigma_us = 2 * CLOCK_DS3231_SIGMA_US,
+    };
+    return obs;
+}
+
+//  ========== discipline ==================================================================
+struct run {
+    int observations;
+    int misses;                 // predictions off by more than CLOCK_TARGET_US once settled
+    int64_t worst_us;           // of the output against the true time, once settled
+    uint32_t max_interval_s;
+    int back;                   // readings of the output going back in time
+};
+
+// a few days of the observe_ds3231() loop, the output read every 10 s in between
+static struct run discipline(const struct oscillator *o, struct clock_model *m, int days)
+{
+    struct run r = { 0 };
+    unsigned int seed = 20;
+    uint32_t interval_s = CLOCK_SYNC_MIN_S;
+    int64_t last_out = 0;
+    int64_t t = 1;
+
+    clock_model_init(m, CLOCK_SLEW_PPM);
+    struct clock_obs obs = edge(o, t, &seed);
+    clock_model_step(m, &obs);
+
+    while (t < (int64_t)days * DAY_S) {
+        int64_t next = t + interval_s;
+        bool settled = t > 2 * 3600;
+
+        for (int64_t s = t + 10; s < next; s += 10) {
+            int64_t local = llround(local_at(o, (double)s));
+            int64_t out = clock_model_unix_us(m, local);
+            int64_t truth = UNIX_START_US + llround(true_at(o, (double)local) * USEC_PER_SEC);
+            r.back += (out <= last_out);
+            last_out = out;
+            if (settled && llabs(out - truth) > r.worst_us) {
+                r.worst_us = llabs(out - truth);
+            }
+        }
+
+        t = next;
+        obs = edge(o, t, &seed);
+        int64_t error = clock_model_add(m, &obs);
+        r.observations++;
+        if (settled && llabs(error) > CLOCK_TARGET_US) {
+            r.misses++;
+        }
+        // the interval policy of observe_ds3231()
+        if (llabs(error) * 2 <= CLOCK_TARGET_US) {
+            interval_s = MIN(interval_s * 2, CLOCK_SYNC_MAX_S);
+        } else if (llabs(error) > CLOCK_TARGET_US) {
+            interval_s = MAX(interval_s / 2, CLOCK_SYNC_MIN_S);
+        }
+        r.max_interval_s = MAX(r.max_interval_s, interval_s);
+    }
+    return r;
+}
+
+static void test_convergence(void)
+{
+    struct clock_model m;
+    const struct oscillator steady = { .ppm = 40 };
+    const struct oscillator swinging = { .ppm = 40, .swing_ppm = 2 };
+
+    struct run r = discipline(&steady, &m, 3);
+    // unix - local against local: 1 / (1 + 40e-6) - 1
+    double truth_ppb = (1 / (1 + 40e-6) - 1) * 1e9;
+    printf("40 ppm: %d observations, interval up to %u s, frequency %d ppb (%.0f), worst %lld us\n",
+           r.observations, r.max_interval_s, m.freq_ppb, truth_ppb, (long long)r.worst_us);
+    CHECK_NEAR(m.freq_ppb, truth_ppb, 20);
+    CHECK_EQ(r.max_interval_s, CLOCK_SYNC_MAX_S);
+    CHECK_EQ(r.misses, 0);
+    CHECK(r.worst_us < CLOCK_TARGET_US);
+    CHECK_EQ(r.back, 0);
+
+    // a daily swing of 2 ppm: the fit of the last observations lags the frequency and the
+    // interval only shrinks after a miss, so the time drifts by a few targets between two
+    // reads (5.2 ms at worst here) but keeps being pulled back
+    r = discipline(&swinging, &m, 3);
+    printf("40 +- 2 ppm: %d observations, interval up to %u s, %d misses, worst %lld us\n",
+           r.observations, r.max_interval_s, r.misses, (long long)r.worst_us);
+    CHECK(r.worst_us < 8 * CLOCK_TARGET_US);
+    CHECK(r.max_interval_s < CLOCK_SYNC_MAX_S);
+    CHECK(r.misses < r.observations / 2);
+    CHECK_EQ(r.back, 0);
+}
+
+//  ========== slew ========================================================================
+static void test_slew(void)
+{
+    struct clock_model m;
+    struct clock_obs obs = { .local_us = 0, .unix_us = UNIX_START_US, .sigma_us = 100 };
+
+    // 0 before the first observation, then the offset alone
+    clock_model_init(&m, CLOCK_SLEW_PPM);
+    CHECK_EQ(clock_model_unix_us(&m, 1000), 0);
+    clock_model_step(&m, &obs);
+    CHECK_EQ(clock_model_unix_us(&m, 1000), UNIX_START_US + 1000);
+    CHECK_EQ(m.freq_ppb, 0);
+
+    // an observation 10 ms ahead: no step, the output catches up at CLOCK_SLEW_PPM
+    obs.local_us = 100 * USEC_PER_SEC;
+    obs.unix_us = UNIX_START_US + obs.local_us + 10000;
+    int64_t before = clock_model_unix_us(&m, obs.local_us);
+    CHECK_EQ(clock_model_add(&m, &obs), 10000);
+    CHECK_EQ(clock_model_unix_us(&m, obs.local_us), before);
+
+    // a two-point fit closer than CLOCK_MODEL_MIN_SPAN_US keeps the frequency, the offset
+    // is their weighted mean
+    int64_t fit = UNIX_START_US + 5000;
+    int64_t slew_us = 10000LL * USEC_PER_SEC / CLOCK_SLEW_PPM;   // 20 s
+    CHECK_EQ(m.freq_ppb, 0);
+    for (int64_t dt = 0; dt <= 2 * slew_us; dt += slew_us / 4) {
+        int64_t local = obs.local_us + dt;
+        int64_t remaining = MAX(m.slew_us - dt * CLOCK_SLEW_PPM / USEC_PER_SEC, 0);
+        CHECK_EQ(clock_model_unix_us(&m, local), fit + local - remaining);
+    }
+
+    // a step forgets the observations and keeps the frequency
+    m.freq_ppb = -40000;
+    obs.local_us = 200 * USEC_PER_SEC;
+    obs.unix_us = UNIX_START_US + 5 * USEC_PER_SEC;
+    clock_model_step(&m, &obs);
+    CHECK_EQ(m.count, 1);
+    CHECK_EQ(m.freq_ppb, -40000);
+    CHECK_EQ(clock_model_unix_us(&m, obs.local_us), obs.unix_us);
+
+    // observations far enough apart but 2500 ppm off: the fit keeps the frequency
+    obs.local_us += 400 * USEC_PER_SEC;
+    obs.unix_us += 401 * USEC_PER_SEC;
+    clock_model_add(&m, &obs);
+    CHECK_EQ(m.freq_ppb, -40000);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_convergence();
+    test_slew();
+    return TEST_RESULT();
+}
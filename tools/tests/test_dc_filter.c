@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * dc_filter: the integer tracker against the same recurrence in double, on a geophone-like
+ * signal over a drifting DC level, then its behaviour (priming, step response at the corner
+ * time constant, gain above the corner) and its cost per sample.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "dc_filter.h"
+
+#include <zephyr/kernel.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define RATE_MHZ                    100000      // 10 ms sampling period
+#define RATE_HZ                     (RATE_MHZ / 1000)
+#define BENCH_SAMPLES               (10 * 1000 * 1000)
+
+//  ========== helpers =====================================================================
+// 1770 mV of DC drifting by 100 mV over the run, a 5 Hz wave and some noise
+static int32_t signal_mv(int i, unsigned int *seed)
+{
+    double t = (double)i / RATE_HZ;
+
+    return (int32_t)lround(1770 + 100 * sin(2 * M_PI * t / 3600) + 40 * sin(2 * M_PI * 5 * t)) +
+           (int32_t)(rand_r(seed) % 9) - 4;
+}
+
+//  ========== tests =======================================================================
+static void test_reference(void)
+{
+    struct dc_filter f;
+    unsigned int seed = 1;
+    int worst = 0;
+
+    dc_filter_init(&f, DC_FILTER_CORNER_MHZ, RATE_MHZ);
+    double alpha = f.alpha / 65536.0;
+    double baseline = 0;
+
+    for (int i = 0; i < 200000; i++) {
+        int32_t x = signal_mv(i, &seed);
+        if (i == 0) {
+            baseline = x;
+        }
+        int y = dc_filter_update(&f, x);
+        int expected = (int)lround(x - baseline);
+        baseline += alpha * (x - baseline);
+
+        worst = MAX(worst, abs(y - expected));
+    }
+    printf("largest difference with the double recurrence: %d mV\n", worst);
+    CHECK(worst <= 1);
+}
+
+static void test_behaviour(void)
+{
+    struct dc_filter f;
+
+    // alpha = 2*pi*fc/fs
+    dc_filter_init(&f, DC_FILTER_CORNER_MHZ, RATE_MHZ);
+    CHECK_NEAR(f.alpha / 65536.0, 2 * M_PI * DC_FILTER_CORNER_MHZ / RATE_MHZ, 1.0 / 65536);
+
+    // the first sample primes the baseline: no start-up transient
+    CHECK_EQ(dc_filter_update(&f, 1770), 0);
+    CHECK_EQ(dc_filter_baseline(&f), 1770);
+    for (int i = 0; i < 1000; i++) {
+        CHECK_EQ(dc_filter_update(&f, 1770), 0);
+    }
+
+    // a 100 mV step decays by e after the time constant 1 / (2*pi*fc)
+    int tau = (int)lround(RATE_HZ / (2 * M_PI * DC_FILTER_CORNER_MHZ / 1000.0));
+    CHECK_EQ(dc_filter_update(&f, 1870), 100);
+    for (int i = 1; i < tau; i++) {
+        dc_filter_update(&f, 1870);
+    }
+    CHECK_NEAR(dc_filter_update(&f, 1870), 100 / M_E, 1);
+    for (int i = 0; i < 20 * tau; i++) {
+        dc_filter_update(&f, 1870);
+    }
+    CHECK_EQ(dc_filter_update(&f, 1870), 0);
+    CHECK_EQ(dc_filter_baseline(&f), 1870);
+
+    // a 5 Hz wave, 100 times the corner, goes through at full amplitude
+    int16_t lo = 0, hi = 0;
+    for (int i = 0; i < 10 * RATE_HZ; i++) {
+        int16_t y = dc_filter_update(&f, 1870 + (int32_t)lround(500 * sin(2 * M_PI * 5 * i / RATE_HZ)));
+        if (i >= 9 * RATE_HZ) {
+            lo = MIN(lo, y);
+            hi = MAX(hi, y);
+        }
+    }
+    CHECK_NEAR(hi, 500, 10);
+    CHECK_NEAR(lo, -500, 10);
+
+    // the output saturates instead of wrapping
+    dc_filter_init(&f, DC_FILTER_CORNER_MHZ, RATE_MHZ);
+    dc_filter_update(&f, -20000);
+    CHECK_EQ(dc_filter_update(&f, 20000), INT16_MAX);
+
+    // a new sampling rate keeps the baseline
+    int16_t baseline = dc_filter_baseline(&f);
+    dc_filter_set_corner(&f, DC_FILTER_CORNER_MHZ, RATE_MHZ / 2);
+    CHECK_EQ(dc_filter_baseline(&f), baseline);
+    CHECK_NEAR(f.alpha / 65536.0, 2 * M_PI * DC_FILTER_CORNER_MHZ / (RATE_MHZ / 2), 1.0 / 65536);
+}
+
+static void bench(void)
+{
+    static int16_t x[4096];
+    struct dc_filter f;
+    unsigned int seed = 2;
+    int32_t sink = 0;
+
+    for (size_t i = 0; i < (size_t)ARRAY_SIZE(x); i++) {
+        x[i] = (int16_t)signal_mv((int)i, &seed);
+    }
+    dc_filter_init(&f, DC_FILTER_CORNER_MHZ, RATE_MHZ);
+
+    double t0 = test_now_ns();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        sink += dc_filter_update(&f, x[i % ARRAY_SIZE(x)]);
+    }
+    double ns = (test_now_ns() - t0) / BENCH_SAMPLES;
+    printf("dc_filter_update: %.2f ns per sample (%d)\n", ns, (int)(sink & 1));
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_reference();
+    test_behaviour();
+    bench();
+    return TEST_RESULT();
+}
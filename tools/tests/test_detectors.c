@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * detectors: the ER against the two windows summed again at each sample and the MER
+ * against (ER * |x|)^3, over many turns of the history for a few window lengths, then the
+ * edges of the on/off hysteresis and of the voting: a detector turning on within
+ * `coincidence` samples of another one still adds its vote, one sample later it does not.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "detectors.h"
+
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define MAX_LEN                     64
+#define SIGNAL_LEN                  4000
+
+// the background of the voting tests: +/-10 mV, an energy of 100
+#define QUIET_MV                    10
+
+//  ========== globals =====================================================================
+static int16_t signal_buf[SIGNAL_LEN];
+static int16_t er_history[2 * MAX_LEN];
+static int16_t mer_history[2 * MAX_LEN];
+
+//  ========== helpers =====================================================================
+// noise whose level changes every few hundred samples, so the ER moves both ways
+static void noise(int16_t *x, size_t len)
+{
+    unsigned int seed = 7;
+    int level = 10;
+
+    for (size_t i = 0; i < len; i++) {
+        if (i % 300 == 0) {
+            level = 1 + (int)(rand_r(&seed) % 2000);
+        }
+        x[i] = (int16_t)((int)(rand_r(&seed) % (2 * level + 1)) - level);
+    }
+}
+
+static double window_energy(const int16_t *x, size_t len)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        sum += (double)x[i] * x[i];
+    }
+    return sum;
+}
+
+// index of the first sample where the detector is on, from a fresh start over x
+static size_t first_on(struct detector *d, const int16_t *x, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (detector_update(d, x[i])) {
+            return i;
+        }
+    }
+    return len;
+}
+
+// index of the last sample where the detector is on, len if it never is
+static size_t last_on(struct detector *d, const int16_t *x, size_t len)
+{
+    size_t last = len;
+
+    for (size_t i = 0; i < len; i++) {
+        if (detector_update(d, x[i])) {
+            last = i;
+        }
+    }
+    return last;
+}
+
+//  ========== tests =======================================================================
+static void test_energy_ratio(void)
+{
+    static const size_t lens[] = { 1, 5, 8, MAX_LEN };
+
+    for (size_t l = 0; l < ARRAY_SIZE(lens); l++) {
+        size_t len = lens[l];
+        struct detector er, mer;
+        double worst_er = 0, worst_mer = 0;
+        int early = 0;
+
+        // on and off out of reach, only the values count here
+        detector_init_energy_ratio(&er, er_history, len, INFINITY, INFINITY);
+        detector_init_mer(&mer, mer_history, len, INFINITY, INFINITY);
+
+        for (size_t i = 0; i < SIGNAL_LEN; i++) {
+            detector_update(&er, signal_buf[i]);
+            detector_update(&mer, signal_buf[i]);
+            if (i + 1 < 2 * len) {
+                early += (er.value != 0.0f) + (mer.value != 0.0f);
+                continue;
+            }
+            double post = window_energy(&signal_buf[i + 1 - len], len);
+            double pre = window_energy(&signal_buf[i + 1 - 2 * len], len);
+            if (pre == 0) {
+                continue;
+            }
+            double ratio = post / pre;
+            double mer_ref = pow(ratio * abs(signal_buf[i + 1 - len]), 3);
+            worst_er = fmax(worst_er, fabs(er.value - ratio) / ratio);
+            if (mer_ref > 0) {
+                worst_mer = fmax(worst_mer, fabs(mer.value - mer_ref) / mer_ref);
+            } else {
+                CHECK_EQ(mer.value, 0);
+            }
+        }
+        printf("len %zu: largest relative difference ER %.2g, MER %.2g\n",
+               len, worst_er, worst_mer);
+        CHECK_EQ(early, 0);
+        CHECK(worst_er <= 1e-6);
+        CHECK(worst_mer <= 1e-5);
+    }
+}
+
+static void test_hysteresis(void)
+{
+    struct detector d;
+
+    detector_init_threshold(&d, 500, 250);
+    CHECK(!detector_update(&d, 499));
+    CHECK(detector_update(&d, -500));       // on at `on`, on the absolute amplitude
+    CHECK(detector_update(&d, 300));
+    CHECK(detector_update(&d, 250));        // still on at `off`
+    CHECK(!detector_update(&d, 249));       // off below it
+    CHECK(!detector_update(&d, 400));       // and stays off between both
+    CHECK(detector_update(&d, 500));
+
+    // an off above on is brought down to on: a single threshold
+    detector_init_threshold(&d, 500, 800);
+    CHECK_EQ(d.off, 500);
+    CHECK(detector_update(&d, 500));
+    CHECK(!detector_update(&d, 499));
+}
+
+/*
+ * A threshold detector on a single spike, then an ER detector on a step of the noise
+ * level `gap` samples later: they are never on together, only the coincidence makes
+ * them vote together.
+ */
+static size_t voting_signal(int16_t *x, size_t gap)
+{
+    size_t n = 0;
+
+    for (int i = 0; i < 40; i++) {
+        x[n++] = (i & 1) ? QUIET_MV : -QUIET_MV;
+    }
+    x[n++] = 3 * QUIET_MV;
+    for (size_t i = 0; i < gap; i++) {
+        x[n++] = (i & 1) ? QUIET_MV : -QUIET_MV;
+    }
+    for (int i = 0; i < 40; i++) {
+        x[n++] = (i & 1) ? 2 * QUIET_MV : -2 * QUIET_MV;
+    }
+    return n;
+}
+
+static void voting_detectors(struct detector *d)
+{
+    // the spike alone, and an energy 4 times the background over a whole window of 8
+    detector_init_threshold(&d[0], 2.5f * QUIET_MV, 2.5f * QUIET_MV);
+    detector_init_energy_ratio(&d[1], er_history, 8, 4.f, 2.f);
+}
+
+static void test_voting(void)
+{
+    struct detector d[2];
+    struct detector_bank bank;
+    size_t n = voting_signal(signal_buf, 20);
+
+    // where each one is on, on its own
+    voting_detectors(d);
+    size_t spike = last_on(&d[0], signal_buf, n);
+    size_t step = first_on(&d[1], signal_buf, n);
+    CHECK_EQ(first_on(&d[0], signal_buf, n), spike);
+    CHECK(spike < step && step < n);
+    uint32_t delay = (uint32_t)(step - spike);
+
+    for (uint32_t coincidence = delay - 1; coincidence <= delay + 1; coincidence++) {
+        size_t triggers = 0, at = n;
+
+        voting_detectors(d);
+        CHECK_EQ(detector_bank_init(&bank, d, 2, 2, coincidence), 0);
+        for (size_t i = 0; i < n; i++) {
+            if (detector_bank_update(&bank, signal_buf[i])) {
+                triggers++;
+                at = i;
+            }
+        }
+        if (coincidence < delay) {
+            CHECK_EQ(triggers, 0);
+        } else {
+            CHECK_EQ(triggers, 1);
+            CHECK_EQ(at, step);
+        }
+    }
+
+    // one vote: triggers on the spike, releases once its coincidence is over, again on the step
+    size_t triggers = 0, first = n;
+    voting_detectors(d);
+    CHECK_EQ(detector_bank_init(&bank, d, 2, 1, 3), 0);
+    for (size_t i = 0; i < n; i++) {
+        bool trigger = detector_bank_update(&bank, signal_buf[i]);
+        if (trigger && triggers++ == 0) {
+            first = i;
+        }
+        if (i > spike && i <= spike + 3) {
+            CHECK(bank.active);
+        }
+        if (i > spike + 3 && i < step) {
+            CHECK(!bank.active);
+        }
+    }
+    CHECK_EQ(first, spike);
+    CHECK_EQ(triggers, 2);
+
+    // the votes needed are within 1 and the number of detectors
+    CHECK_EQ(detector_bank_init(&bank, d, 2, 0, 0), -EINVAL);
+    CHECK_EQ(detector_bank_init(&bank, d, 2, 3, 0), -EINVAL);
+    CHECK_EQ(detector_bank_init(&bank, d, 0, 1, 0), -EINVAL);
+    CHECK_EQ(detector_bank_init(&bank, d, DETECTOR_BANK_MAX + 1, 1, 0), -EINVAL);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    noise(signal_buf, SIGNAL_LEN);
+    test_energy_ratio();
+    test_hysteresis();
+    test_voting();
+    return TEST_RESULT();
+}
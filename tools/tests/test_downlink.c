@@ -0,0 +1,521 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * downlink, config_codec and node_config: the parameter lists of config_parse() cut
+ * short, with unknown or repeated parameters, config_check() on both sides of each
+ * limit, then the payloads of the network through downlink_receive() and
+ * downlink_handle() up to their CONFIG and WINDOW answers, the configuration in effect
+ * and the one saved in the settings (stubs/settings.c) across a reboot.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "config_codec.h"
+#include "downlink.h"
+#include "node_config.h"
+#include "uplink.h"
+#include "wave_index.h"
+
+#include <zephyr/settings/settings.h>
+
+//  ========== defines =====================================================================
+#define MAX_RANGES                  3
+
+//  ========== globals =====================================================================
+// answers queued by the module, the last one is kept
+static int replies;
+static PACKET_TYPE reply_type;
+static uint8_t reply[64];
+static size_t reply_size;
+
+static uint32_t adc_rate_ms = SAMPLING_RATE_MS;
+
+// window of the last wave_index_query() and the ranges it finds
+static uint64_t query_from, query_to;
+static struct wave_index_range query_ranges[MAX_RANGES];
+static int query_count;
+
+extern struct k_msgq downlink_msgq;
+
+// a configuration within every limit, each case changes one field
+static const struct node_config_t valid = {
+    .sampling_rate_ms = 10,
+    .sta_window_ms = 1000,
+    .lta_window_ms = 10000,
+    .ratio_on = 300,
+    .ratio_off = 150,
+    .anomaly_delay_ms = 0,
+    .bth_period_s = 3600,
+    .send_samples = 1,
+    .detectors = 0,
+    .votes = 1,
+};
+
+//  ========== fakes =======================================================================
+int uplink_enqueue(PACKET_TYPE type, uint64_t timestamp, const void *payload, size_t size,
+                   k_timeout_t timeout)
+{
+    (void)timestamp;
+    (void)timeout;
+    replies++;
+    reply_type = type;
+    reply_size = MIN(size, sizeof(reply));
+    memcpy(reply, payload, reply_size);
+    return 0;
+}
+
+uint64_t app_get_timestamp(void)
+{
+    return 1741785700000ULL;
+}
+
+uint32_t app_adc_get_sampling_rate(void)
+{
+    return adc_rate_ms;
+}
+
+void app_adc_set_sampling_rate(uint32_t rate_ms)
+{
+    adc_rate_ms = rate_ms;
+}
+
+int wave_index_query(uint64_t from_ms, uint64_t to_ms, wave_index_cb_t cb, void *user)
+{
+    query_from = from_ms;
+    query_to = to_ms;
+    for (int i = 0; i < query_count; i++) {
+        if (cb(&query_ranges[i], user) != 0) {
+            return i + 1;
+        }
+    }
+    return query_count;
+}
+
+//  ========== helpers =====================================================================
+static bool same_config(const struct node_config_t *a, const struct node_config_t *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+// the CONFIG answer of the last request, false without one
+static bool config_reply(struct config_payload_t *payload)
+{
+    if (replies == 0 || reply_type != CONFIG || reply_size != sizeof(*payload)) {
+        return false;
+    }
+    memcpy(payload, reply, sizeof(*payload));
+    return true;
+}
+
+// handle a request, then check its CONFIG answer and the configuration in effect
+static void check_request(const uint8_t *data, size_t len, int status, uint8_t param,
+                          const struct node_config_t *expected)
+{
+    struct config_payload_t payload;
+    struct node_config_t config;
+
+    replies = 0;
+    downlink_handle(data, len);
+    CHECK_EQ(replies, 1);
+    CHECK(config_reply(&payload));
+    CHECK_EQ(payload.status, status);
+    CHECK_EQ(payload.param, param);
+    node_config_get(&config);
+    CHECK(same_config(&payload.config, expected));
+    CHECK(same_config(&config, expected));
+}
+
+static size_t put_param(uint8_t *out, uint8_t param, uint32_t value)
+{
+    size_t size = config_param_size(param);
+
+    out[0] = param;
+    for (size_t i = 0; i < size; i++) {
+        out[1 + i] = (uint8_t)(value >> (8 * i));
+    }
+    return 1 + size;
+}
+
+//  ========== test_parse ==================================================================
+static void test_parse(void)
+{
+    struct node_config_t config = valid;
+    uint8_t data[64];
+    uint8_t param;
+    size_t len = 0;
+
+    // every parameter, little-endian at its size
+    len += put_param(&data[len], PARAM_SAMPLING_RATE, 20);
+    len += put_param(&data[len], PARAM_STA_WINDOW, 0x0102);
+    len += put_param(&data[len], PARAM_LTA_WINDOW, 0xa0b0);
+    len += put_param(&data[len], PARAM_RATIO_ON, 450);
+    len += put_param(&data[len], PARAM_RATIO_OFF, 120);
+    len += put_param(&data[len], PARAM_ANOMALY_DELAY, 0x01020304);
+    len += put_param(&data[len], PARAM_BTH_PERIOD, 0xfedcba98);
+    len += put_param(&data[len], PARAM_SEND_SAMPLES, 0);
+    len += put_param(&data[len], PARAM_DETECTORS, PARAM_DETECTORS_ALL);
+    len += put_param(&data[len], PARAM_VOTES, 3);
+    CHECK_EQ(len, 10 + 5 * 2 + 2 * 4 + 3 * 1);
+    CHECK_EQ(config_parse(data, len, &config, &param), 0);
+    CHECK_EQ(param, 0);
+    CHECK_EQ(config.sampling_rate_ms, 20);
+    CHECK_EQ(config.sta_window_ms, 0x0102);
+    CHECK_EQ(config.lta_window_ms, 0xa0b0);
+    CHECK_EQ(config.ratio_on, 450);
+    CHECK_EQ(config.ratio_off, 120);
+    CHECK_EQ(config.anomaly_delay_ms, 0x01020304);
+    CHECK_EQ(config.bth_period_s, 0xfedcba98);
+    CHECK_EQ(config.send_samples, 0);
+    CHECK_EQ(config.detectors, PARAM_DETECTORS_ALL);
+    CHECK_EQ(config.votes, 3);
+
+    // nothing to change
+    config = valid;
+    CHECK_EQ(config_parse(data, 0, &config, &param), 0);
+    CHECK_EQ(param, 0);
+    CHECK(same_config(&config, &valid));
+
+    // a repeated parameter keeps its last value
+    len = put_param(data, PARAM_RATIO_ON, 400);
+    len += put_param(&data[len], PARAM_VOTES, 2);
+    len += put_param(&data[len], PARAM_RATIO_ON, 500);
+    CHECK_EQ(config_parse(data, len, &config, &param), 0);
+    CHECK_EQ(config.ratio_on, 500);
+    CHECK_EQ(config.votes, 2);
+
+    // unknown parameters, alone or after a valid one
+    static const uint8_t unknown[] = { 0x00, PARAM_VOTES + 1, 0x7f, 0x80, 0xff };
+    for (size_t i = 0; i < ARRAY_SIZE(unknown); i++) {
+        CHECK_EQ(config_param_size(unknown[i]), 0);
+        data[0] = unknown[i];
+        CHECK_EQ(config_parse(data, 1, &config, &param), -EINVAL);
+        CHECK_EQ(param, unknown[i]);
+
+        len = put_param(data, PARAM_SEND_SAMPLES, 1);
+        data[len++] = unknown[i];
+        data[len++] = 0;
+        CHECK_EQ(config_parse(data, len, &config, &param), -EINVAL);
+        CHECK_EQ(param, unknown[i]);
+    }
+
+    // each value cut short, after a valid parameter or alone
+    for (uint8_t id = PARAM_SAMPLING_RATE; id <= PARAM_VOTES; id++) {
+        size_t size = config_param_size(id);
+
+        CHECK(size == 1 || size == 2 || size == 4);
+        for (size_t cut = 1; cut <= size; cut++) {
+            len = put_param(data, PARAM_RATIO_OFF, 110);
+            len += put_param(&data[len], id, UINT32_MAX);
+            config = valid;
+            CHECK_EQ(config_parse(data, len - cut, &config, &param), -EMSGSIZE);
+            CHECK_EQ(param, id);
+            CHECK_EQ(config_parse(&data[3], len - 3 - cut, &config, &param), -EMSGSIZE);
+            CHECK_EQ(param, id);
+        }
+    }
+}
+
+//  ========== test_check ==================================================================
+struct check_case {
+    const char *name;
+    void (*change)(struct node_config_t *config);
+    uint8_t param;              // refused, 0 if valid
+};
+
+static void rate_0(struct node_config_t *c) { c->sampling_rate_ms = PARAM_RATE_MIN_MS - 1; }
+static void rate_max(struct node_config_t *c) { c->sampling_rate_ms = PARAM_RATE_MAX_MS; }
+static void rate_over(struct node_config_t *c) { c->sampling_rate_ms = PARAM_RATE_MAX_MS + 1; }
+static void rate_min(struct node_config_t *c)
+{
+    c->sampling_rate_ms = PARAM_RATE_MIN_MS;
+    c->sta_window_ms = PARAM_STA_MAX_SAMPLES * PARAM_RATE_MIN_MS;
+    c->lta_window_ms = PARAM_LTA_MAX_SAMPLES * PARAM_RATE_MIN_MS;
+}
+static void sta_short(struct node_config_t *c) { c->sta_window_ms = c->sampling_rate_ms - 1; }
+static void sta_one(struct node_config_t *c) { c->sta_window_ms = c->sampling_rate_ms; }
+static void sta_max(struct node_config_t *c)
+{
+    c->sta_window_ms = PARAM_STA_MAX_SAMPLES * c->sampling_rate_ms;
+    c->lta_window_ms = PARAM_LTA_MAX_SAMPLES * c->sampling_rate_ms;
+}
+static void sta_over(struct node_config_t *c)
+{
+    c->sta_window_ms = (PARAM_STA_MAX_SAMPLES + 1) * c->sampling_rate_ms;
+    c->lta_window_ms = PARAM_LTA_MAX_SAMPLES * c->sampling_rate_ms;
+}
+static void lta_equal(struct node_config_t *c) { c->lta_window_ms = c->sta_window_ms + 9; }
+static void lta_longer(struct node_config_t *c) { c->lta_window_ms = c->sta_window_ms + 10; }
+static void lta_over(struct node_config_t *c)
+{
+    c->sampling_rate_ms = PARAM_RATE_MIN_MS;
+    c->sta_window_ms = PARAM_STA_MAX_SAMPLES * PARAM_RATE_MIN_MS;
+    c->lta_window_ms = (PARAM_LTA_MAX_SAMPLES + 1) * PARAM_RATE_MIN_MS;
+}
+static void on_min(struct node_config_t *c) { c->ratio_on = PARAM_RATIO_MIN; }
+static void on_above(struct node_config_t *c) { c->ratio_on = PARAM_RATIO_MIN + 1; c->ratio_off = PARAM_RATIO_MIN; }
+static void off_low(struct node_config_t *c) { c->ratio_off = PARAM_RATIO_MIN - 1; }
+static void off_on(struct node_config_t *c) { c->ratio_off = c->ratio_on; }
+static void off_above(struct node_config_t *c) { c->ratio_off = c->ratio_on + 1; }
+static void delay_max(struct node_config_t *c) { c->anomaly_delay_ms = PARAM_DELAY_MAX_MS; }
+static void delay_over(struct node_config_t *c) { c->anomaly_delay_ms = PARAM_DELAY_MAX_MS + 1; }
+static void bth_low(struct node_config_t *c) { c->bth_period_s = PARAM_BTH_MIN_S - 1; }
+static void bth_min(struct node_config_t *c) { c->bth_period_s = PARAM_BTH_MIN_S; }
+static void bth_max(struct node_config_t *c) { c->bth_period_s = PARAM_BTH_MAX_S; }
+static void bth_over(struct node_config_t *c) { c->bth_period_s = PARAM_BTH_MAX_S + 1; }
+static void send_2(struct node_config_t *c) { c->send_samples = 2; }
+static void det_all(struct node_config_t *c) { c->detectors = PARAM_DETECTORS_ALL; c->votes = 4; }
+static void det_unknown(struct node_config_t *c) { c->detectors = PARAM_DETECTORS_ALL + 1; }
+static void votes_0(struct node_config_t *c) { c->votes = 0; }
+static void votes_alone(struct node_config_t *c) { c->votes = 2; }
+static void votes_two(struct node_config_t *c)
+{
+    c->detectors = PARAM_DETECTOR_ER | PARAM_DETECTOR_THRESHOLD;
+    c->votes = 3;
+}
+static void votes_over(struct node_config_t *c)
+{
+    c->detectors = PARAM_DETECTOR_ER | PARAM_DETECTOR_THRESHOLD;
+    c->votes = 4;
+}
+static void votes_all_over(struct node_config_t *c) { c->detectors = PARAM_DETECTORS_ALL; c->votes = 5; }
+// the first rule in error is named
+static void two_wrong(struct node_config_t *c) { c->sampling_rate_ms = 0; c->votes = 0; }
+
+static void test_check(void)
+{
+    static const struct check_case cases[] = {
+        { "rate below the minimum", rate_0, PARAM_SAMPLING_RATE },
+        { "rate at the minimum", rate_min, 0 },
+        { "rate at the maximum", rate_max, 0 },
+        { "rate over the maximum", rate_over, PARAM_SAMPLING_RATE },
+        { "STA shorter than a sample", sta_short, PARAM_STA_WINDOW },
+        { "STA of one sample", sta_one, 0 },
+        { "STA at the maximum", sta_max, 0 },
+        { "STA over the maximum", sta_over, PARAM_STA_WINDOW },
+        { "LTA of the STA samples", lta_equal, PARAM_LTA_WINDOW },
+        { "LTA one sample longer", lta_longer, 0 },
+        { "LTA over the maximum", lta_over, PARAM_LTA_WINDOW },
+        { "ratio on at the minimum", on_min, PARAM_RATIO_ON },
+        { "ratio on above the minimum", on_above, 0 },
+        { "ratio off below the minimum", off_low, PARAM_RATIO_OFF },
+        { "ratio off at ratio on", off_on, 0 },
+        { "ratio off above ratio on", off_above, PARAM_RATIO_OFF },
+        { "delay at the maximum", delay_max, 0 },
+        { "delay over the maximum", delay_over, PARAM_ANOMALY_DELAY },
+        { "BTH below the minimum", bth_low, PARAM_BTH_PERIOD },
+        { "BTH at the minimum", bth_min, 0 },
+        { "BTH at the maximum", bth_max, 0 },
+        { "BTH over the maximum", bth_over, PARAM_BTH_PERIOD },
+        { "send samples 2", send_2, PARAM_SEND_SAMPLES },
+        { "every detector", det_all, 0 },
+        { "unknown detector", det_unknown, PARAM_DETECTORS },
+        { "no vote", votes_0, PARAM_VOTES },
+        { "2 votes of the STA/LTA alone", votes_alone, PARAM_VOTES },
+        { "3 votes of 3 detectors", votes_two, 0 },
+        { "4 votes of 3 detectors", votes_over, PARAM_VOTES },
+        { "5 votes of 4 detectors", votes_all_over, PARAM_VOTES },
+        { "rate and votes wrong", two_wrong, PARAM_SAMPLING_RATE },
+    };
+    uint8_t param = 0xff;
+
+    CHECK_EQ(config_check(&valid, &param), 0);
+    CHECK_EQ(param, 0);
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        struct node_config_t config = valid;
+
+        cases[i].change(&config);
+        int rc = config_check(&config, &param);
+        if (rc != (cases[i].param ? -ERANGE : 0) || param != cases[i].param) {
+            printf("%s: %d, parameter 0x%02x\n", cases[i].name, rc, param);
+        }
+        CHECK_EQ(rc, cases[i].param ? -ERANGE : 0);
+        CHECK_EQ(param, cases[i].param);
+    }
+}
+
+//  ========== test_receive ================================================================
+static void test_receive(void)
+{
+    uint8_t data[DOWNLINK_MAX_SIZE + 1] = { DOWNLINK_CONFIG_GET };
+
+    k_msgq_purge(&downlink_msgq);
+    downlink_receive(DOWNLINK_PORT + 1, data, 1);
+    downlink_receive(DOWNLINK_PORT, data, 0);
+    downlink_receive(DOWNLINK_PORT, data, DOWNLINK_MAX_SIZE + 1);
+    CHECK_EQ(k_msgq_num_used_get(&downlink_msgq), 0);
+
+    // the largest downlink is kept, the queue drops what it can not hold
+    downlink_receive(DOWNLINK_PORT, data, DOWNLINK_MAX_SIZE);
+    CHECK_EQ(k_msgq_num_used_get(&downlink_msgq), 1);
+    for (int i = 0; i < DOWNLINK_QUEUE; i++) {
+        downlink_receive(DOWNLINK_PORT, data, 1);
+    }
+    CHECK_EQ(k_msgq_num_used_get(&downlink_msgq), DOWNLINK_QUEUE);
+    k_msgq_purge(&downlink_msgq);
+}
+
+//  ========== test_config =================================================================
+static void test_config(void)
+{
+    struct node_config_t defaults, config, saved;
+    uint8_t data[DOWNLINK_MAX_SIZE];
+    size_t len;
+
+    // first boot, nothing saved
+    node_config_init();
+    uint32_t gen = node_config_get(&defaults);
+    CHECK_EQ(defaults.sampling_rate_ms, SAMPLING_RATE_MS);
+    CHECK_EQ(adc_rate_ms, SAMPLING_RATE_MS);
+    data[0] = DOWNLINK_CONFIG_GET;
+    check_request(data, 1, 0, 0, &defaults);
+
+    // the example of the README: 20 ms, ER and MER next to the STA/LTA, 2 votes
+    data[0] = DOWNLINK_CONFIG_SET;
+    len = 1 + put_param(&data[1], PARAM_SAMPLING_RATE, 20);
+    len += put_param(&data[len], PARAM_DETECTORS, PARAM_DETECTOR_ER | PARAM_DETECTOR_MER);
+    len += put_param(&data[len], PARAM_VOTES, 2);
+    struct node_config_t applied = defaults;
+    applied.sampling_rate_ms = 20;
+    applied.detectors = PARAM_DETECTOR_ER | PARAM_DETECTOR_MER;
+    applied.votes = 2;
+    check_request(data, len, 0, 0, &applied);
+    CHECK_EQ(adc_rate_ms, 20);
+    CHECK(node_config_get(&config) != gen);
+    gen = node_config_get(&config);
+    CHECK_EQ(settings_stub_get(NODE_CONFIG_KEY, &saved, sizeof(saved)), sizeof(saved));
+    CHECK(same_config(&saved, &applied));
+
+    // refused as a whole: the valid parameters before the wrong one do not apply either
+    len = 1 + put_param(&data[1], PARAM_RATIO_ON, 500);
+    len += put_param(&data[len], PARAM_BTH_PERIOD, PARAM_BTH_MIN_S - 1);
+    check_request(data, len, -ERANGE, PARAM_BTH_PERIOD, &applied);
+    len = 1 + put_param(&data[1], PARAM_RATIO_ON, 500);
+    len += put_param(&data[len], 0x42, 0);
+    check_request(data, len, -EINVAL, 0x42, &applied);
+    len = 1 + put_param(&data[1], PARAM_RATIO_ON, 500);
+    len += put_param(&data[len], PARAM_ANOMALY_DELAY, 0);
+    check_request(data, len - 2, -EMSGSIZE, PARAM_ANOMALY_DELAY, &applied);
+
+    // the votes are checked against the detectors of the whole configuration
+    len = 1 + put_param(&data[1], PARAM_DETECTORS, 0);
+    check_request(data, len, -ERANGE, PARAM_VOTES, &applied);
+    len = 1 + put_param(&data[1], PARAM_VOTES, 4);
+    check_request(data, len, -ERANGE, PARAM_VOTES, &applied);
+    CHECK_EQ(node_config_get(&config), gen);
+    CHECK_EQ(adc_rate_ms, 20);
+    CHECK_EQ(settings_stub_get(NODE_CONFIG_KEY, &saved, sizeof(saved)), sizeof(saved));
+    CHECK(same_config(&saved, &applied));
+
+    // a downlink of the largest size, the last of the repeated values counts
+    len = 1;
+    while (len + 3 <= DOWNLINK_MAX_SIZE) {
+        len += put_param(&data[len], PARAM_RATIO_ON, 200 + len);
+    }
+    while (len + 2 <= DOWNLINK_MAX_SIZE) {
+        len += put_param(&data[len], PARAM_SEND_SAMPLES, 0);
+    }
+    CHECK_EQ(len, DOWNLINK_MAX_SIZE);
+    applied.ratio_on = 200 + 46;
+    applied.send_samples = 0;
+    check_request(data, len, 0, 0, &applied);
+
+    // reboot, the saved configuration is loaded
+    adc_rate_ms = SAMPLING_RATE_MS;
+    node_config_init();
+    node_config_get(&config);
+    CHECK(same_config(&config, &applied));
+    CHECK_EQ(adc_rate_ms, 20);
+
+    // back to the defaults, also after the next reboot
+    data[0] = DOWNLINK_CONFIG_RESET;
+    check_request(data, 1, 0, 0, &defaults);
+    CHECK_EQ(settings_stub_get(NODE_CONFIG_KEY, &saved, sizeof(saved)), -ENOENT);
+    CHECK_EQ(adc_rate_ms, SAMPLING_RATE_MS);
+    node_config_init();
+    node_config_get(&config);
+    CHECK(same_config(&config, &defaults));
+
+    // a saved configuration out of range or of another layout is ignored at boot
+    saved = applied;
+    saved.votes = 0;
+    CHECK_EQ(settings_save_one(NODE_CONFIG_KEY, &saved, sizeof(saved)), 0);
+    node_config_init();
+    node_config_get(&config);
+    CHECK(same_config(&config, &defaults));
+    CHECK_EQ(settings_save_one(NODE_CONFIG_KEY, &applied, sizeof(applied) - 1), 0);
+    node_config_init();
+    node_config_get(&config);
+    CHECK(same_config(&config, &defaults));
+    settings_delete(NODE_CONFIG_KEY);
+}
+
+//  ========== test_commands ===============================================================
+static void test_commands(void)
+{
+    // 30 s from 1741785632, as in the README
+    static const uint8_t request[] = { DOWNLINK_WINDOW, 0x20, 0x8a, 0xd1, 0x67, 0x1e, 0x00 };
+    struct window_payload_t payload;
+
+    for (int i = 0; i < MAX_RANGES; i++) {
+        query_ranges[i] = (struct wave_index_range) {
+            .file = 12 + i,
+            .offset = 4096 * i,
+            .size = 1000 + i,
+            .samples = 512 * (i + 1),
+            .blocks = i + 1,
+        };
+    }
+    query_count = MAX_RANGES;
+    replies = 0;
+    downlink_handle(request, sizeof(request));
+    CHECK_EQ(query_from, 1741785632000ULL);
+    CHECK_EQ(query_to, 1741785662000ULL);
+    CHECK_EQ(replies, 1);
+    CHECK_EQ(reply_type, WINDOW);
+    CHECK_EQ(reply_size, sizeof(payload));
+    memcpy(&payload, reply, sizeof(payload));
+    CHECK_EQ(payload.from, 1741785632);
+    CHECK_EQ(payload.duration, 30);
+    CHECK_EQ(payload.ranges, MAX_RANGES);
+    CHECK_EQ(payload.blocks, 1 + 2 + 3);
+    CHECK_EQ(payload.samples, 512 * (1 + 2 + 3));
+    CHECK_EQ(payload.range[0].file, 12);
+    CHECK_EQ(payload.range[WINDOW_PAYLOAD_RANGES - 1].offset, 4096 * (WINDOW_PAYLOAD_RANGES - 1));
+
+    // longer arguments are ignored, shorter ones are not answered
+    static const uint8_t longer[] = { DOWNLINK_WINDOW, 0, 0, 0, 0, 0xff, 0xff, 0x55 };
+    query_count = 0;
+    replies = 0;
+    downlink_handle(longer, sizeof(longer));
+    CHECK_EQ(replies, 1);
+    CHECK_EQ(query_to - query_from, 65535ULL * MSEC_PER_SEC);
+    for (size_t len = 0; len < sizeof(request); len++) {
+        replies = 0;
+        downlink_handle(request, len);
+        CHECK_EQ(replies, 0);
+    }
+
+    // unknown commands are not answered
+    static const uint8_t unknown[] = { 0x00, DOWNLINK_CONFIG_RESET + 1, 0xff };
+    for (size_t i = 0; i < ARRAY_SIZE(unknown); i++) {
+        replies = 0;
+        downlink_handle(&unknown[i], 1);
+        CHECK_EQ(replies, 0);
+    }
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_parse();
+    test_check();
+    test_receive();
+    test_config();
+    test_commands();
+    return TEST_RESULT();
+}
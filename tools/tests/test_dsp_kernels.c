@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * dsp_kernels: each kernel against a plain scalar reference, on random blocks of every
+ * length (odd lengths leave a tail to the scalar loop), full-scale samples and offsets
+ * that saturate. Built twice: the portable path, and the SIMD path on the intrinsics of
+ * stubs/cmsis_core.h (test_dsp_kernels_simd).
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "dsp_kernels.h"
+
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define MAX_LEN                     1001
+#define CASES                       3000
+
+//  ========== reference ===================================================================
+struct reference {
+    int32_t sum;
+    uint64_t sum_sq;
+    int16_t min;
+    int16_t max;
+};
+
+static struct reference reference(const int16_t *x, size_t n, int16_t offset)
+{
+    struct reference r = { .min = x[0], .max = x[0] };
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t d = x[i] - offset;
+        d = d > INT16_MAX ? INT16_MAX : (d < INT16_MIN ? INT16_MIN : d);
+        r.sum += x[i];
+        r.sum_sq += (uint64_t)((int64_t)d * d);
+        r.min = x[i] < r.min ? x[i] : r.min;
+        r.max = x[i] > r.max ? x[i] : r.max;
+    }
+    return r;
+}
+
+static void check_block(const int16_t *x, size_t n, int16_t offset)
+{
+    struct reference r = reference(x, n, offset);
+    int16_t min, max;
+
+    dsp_min_max_q15(x, n, &min, &max);
+    CHECK_EQ(dsp_sum_q15(x, n), r.sum);
+    CHECK_EQ(dsp_sum_sq_q15(x, n, offset), r.sum_sq);
+    CHECK_EQ(min, r.min);
+    CHECK_EQ(max, r.max);
+}
+
+//  ========== tests =======================================================================
+static void test_random(void)
+{
+    static int16_t x[MAX_LEN];
+    unsigned int seed = 3;
+
+    for (int t = 0; t < CASES; t++) {
+        size_t n = 1 + rand_r(&seed) % MAX_LEN;
+        for (size_t i = 0; i < n; i++) {
+            // full scale, or a geophone around its DC level
+            x[i] = (t % 2) ? (int16_t)(rand_r(&seed) % 65536 - 32768)
+                           : (int16_t)(1500 + rand_r(&seed) % 600);
+        }
+        int16_t offset = (t % 3 == 0) ? -20000 : (int16_t)(t % 3 == 1 ? 1770 : 0);
+        check_block(x, n, offset);
+        if (test_failures) {
+            printf("case %d, %zu samples\n", t, n);
+            return;
+        }
+    }
+}
+
+static void test_edges(void)
+{
+    static int16_t x[MAX_LEN];
+
+    // extremes in either half of a word, at the start, the end and in the odd tail
+    for (size_t n = 1; n <= 9; n++) {
+        for (size_t at = 0; at < n; at++) {
+            for (size_t i = 0; i < n; i++) {
+                x[i] = 0;
+            }
+            x[at] = INT16_MIN;
+            x[n - 1 - at] = INT16_MAX;
+            check_block(x, n, INT16_MIN);
+            check_block(x, n, INT16_MAX);
+        }
+    }
+
+    // equal halves: SEL must not mix the halves of two words
+    for (size_t i = 0; i < 64; i++) {
+        x[i] = (int16_t)((i % 4 < 2) ? -7 : 7);
+    }
+    check_block(x, 64, 0);
+
+    CHECK_EQ(dsp_mean_q15(x, 0), 0);
+    int16_t three[] = { 1, 2, 2 };
+    CHECK_EQ(dsp_mean_q15(three, 3), 2);
+    int16_t minus[] = { -1, -2, -2 };
+    CHECK_EQ(dsp_mean_q15(minus, 3), -2);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    printf("DSP_KERNELS_SIMD %d\n", DSP_KERNELS_SIMD);
+    test_random();
+    test_edges();
+    return TEST_RESULT();
+}
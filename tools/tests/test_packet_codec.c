@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * packet_codec: the v2 frames of packet_vectors.txt rebuilt record by record with
+ * packet_writer_add(), byte for byte, then the records the writer refuses.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "packet_codec.h"
+#include "data_types.h"
+
+#include <zephyr/kernel.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  ========== defines =====================================================================
+#define LINE_SIZE                   2048
+
+//  ========== helpers =====================================================================
+static size_t from_hex(const char *hex, uint8_t *out, size_t capacity)
+{
+    size_t n = 0;
+
+    while (hex[0] != '\0' && hex[1] != '\0' && n < capacity) {
+        unsigned int byte;
+        if (sscanf(hex, "%2x", &byte) != 1) {
+            break;
+        }
+        out[n++] = (uint8_t)byte;
+        hex += 2;
+    }
+    return n;
+}
+
+// builds the frame of one line, returns its size, 0 on a refused record
+static size_t build(char *records, uint8_t *frame, size_t capacity)
+{
+    struct packet_writer writer;
+    bool first = true;
+
+    for (char *rec = strtok(records, " \n"); rec != NULL; rec = strtok(NULL, " \n")) {
+        uint8_t payload[LORA_MAX_FRAME];
+        unsigned int type;
+        unsigned long long ms;
+        int used = 0;
+
+        if (sscanf(rec, "%u@%llu:%n", &type, &ms, &used) != 2 || used == 0) {
+            fprintf(stderr, "bad record %s\n", rec);
+            return 0;
+        }
+        size_t size = from_hex(rec + used, payload, sizeof(payload));
+        if (first) {
+            packet_writer_init(&writer, frame, capacity, ms);
+            first = false;
+        }
+        int rc = packet_writer_add(&writer, (uint8_t)type, ms, payload, size);
+        if (rc != 0) {
+            fprintf(stderr, "record %s refused: %d\n", rec, rc);
+            return 0;
+        }
+    }
+    return first ? 0 : packet_writer_size(&writer);
+}
+
+//  ========== tests =======================================================================
+static void test_vectors(void)
+{
+    char line[LINE_SIZE];
+    int vectors = 0;
+    FILE *f = fopen(VECTORS_FILE, "r");
+
+    CHECK(f != NULL);
+    if (f == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[32], hex[2 * LORA_MAX_FRAME + 2];
+        uint8_t expected[LORA_MAX_FRAME], frame[LORA_MAX_FRAME];
+        int used = 0;
+
+        if (line[0] == '#' || sscanf(line, "%31s %485s %n", name, hex, &used) != 2) {
+            continue;
+        }
+        size_t expected_size = from_hex(hex, expected, sizeof(expected));
+        size_t size = build(&line[used], frame, sizeof(frame));
+
+        CHECK_EQ(size, expected_size);
+        if (size != expected_size || memcmp(frame, expected, size) != 0) {
+            fprintf(stderr, "vector %s differs\n", name);
+            test_failures++;
+        }
+        // the first byte tells v2 frames from v1 packet types
+        CHECK_EQ(frame[0] >> 4, PACKET_V2_VERSION);
+        vectors++;
+    }
+    fclose(f);
+    CHECK(vectors >= 8);
+}
+
+static void test_refused(void)
+{
+    struct packet_writer writer;
+    struct bth_payload_t bth = { 3600, 2150, 4520 };
+    struct anomaly_payload_t anomaly = { 0 };
+    int16_t samples[4] = { 0 };
+    uint8_t frame[LORA_MAX_FRAME];
+    const uint64_t base = 1741785632000ull;
+
+    packet_writer_init(&writer, frame, sizeof(frame), base);
+    CHECK_EQ(packet_writer_size(&writer), 0);
+
+    // wrong sizes and types a v2 frame does not carry
+    CHECK_EQ(packet_writer_add(&writer, BTH, base, &bth, sizeof(bth) - 1), -EINVAL);
+    CHECK_EQ(packet_writer_add(&writer, EVENT_FRAGMENT, base, samples, sizeof(samples)), -EINVAL);
+    CHECK_EQ(packet_writer_add(&writer, 0, base, &bth, sizeof(bth)), -EINVAL);
+    // more than 24 days from the previous record
+    CHECK_EQ(packet_writer_add(&writer, BTH, base + (uint64_t)INT32_MAX + 1, &bth, sizeof(bth)), -EINVAL);
+    CHECK_EQ(packet_writer_size(&writer), 0);
+
+    // 15 records at most, the count is the low nibble of the first byte
+    for (int i = 0; i < PACKET_V2_MAX_RECORDS; i++) {
+        CHECK_EQ(packet_writer_add(&writer, BTH, base + i, &bth, sizeof(bth)), 0);
+    }
+    CHECK_EQ(frame[0], (PACKET_V2_VERSION << 4) | PACKET_V2_MAX_RECORDS);
+    size_t size = packet_writer_size(&writer);
+    CHECK_EQ(packet_writer_add(&writer, BTH, base, &bth, sizeof(bth)), -ENOSPC);
+    CHECK_EQ(packet_writer_size(&writer), size);
+
+    // a record that does not fit leaves the frame as it was: header, type, delta, payload
+    const size_t needed = PACKET_V2_HEADER_SIZE + 1 + 1 + sizeof(anomaly);
+    packet_writer_init(&writer, frame, needed - 1, base);
+    CHECK_EQ(packet_writer_add(&writer, ANOMALY, base, &anomaly, sizeof(anomaly)), -ENOSPC);
+    CHECK_EQ(packet_writer_size(&writer), 0);
+    packet_writer_init(&writer, frame, needed, base);
+    CHECK_EQ(packet_writer_add(&writer, ANOMALY, base, &anomaly, sizeof(anomaly)), 0);
+    CHECK_EQ(packet_writer_size(&writer), needed);
+
+    // nothing after the samples, which run to the end of the frame
+    packet_writer_init(&writer, frame, sizeof(frame), base);
+    CHECK_EQ(packet_writer_add(&writer, SAMPLES, base, samples, sizeof(samples)), 0);
+    CHECK_EQ(packet_writer_add(&writer, BTH, base, &bth, sizeof(bth)), -ENOSPC);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_vectors();
+    test_refused();
+    return TEST_RESULT();
+}
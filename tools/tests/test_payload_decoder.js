@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * payload_decoder.js on the v2 frames of packet_vectors.txt: the number of records, their
+ * type and time, and their fields against the v1 frame of the same payload. Then frames
+ * the decoder must refuse.
+ *
+ *   node test_payload_decoder.js <payload_decoder.js> <packet_vectors.txt>
+ */
+
+const fs = require("fs");
+const assert = require("assert");
+
+const decodeUplink = new Function(fs.readFileSync(process.argv[2], "utf8") + "\nreturn decodeUplink;")();
+let failures = 0;
+
+function check(what, fn) {
+  try {
+    fn();
+  } catch (e) {
+    console.error(what + ": " + e.message);
+    failures++;
+  }
+}
+
+function decode(hex) {
+  return decodeUplink({ bytes: Array.from(Buffer.from(hex, "hex")) });
+}
+
+// v1 frame of one record: type, u64 time in ms, payload
+function v1(type, ms, payload) {
+  const header = Buffer.alloc(9);
+  header[0] = type;
+  header.writeBigUInt64LE(BigInt(ms), 1);
+  return header.toString("hex") + payload;
+}
+
+//  ========== golden frames ===============================================================
+let vectors = 0;
+for (const line of fs.readFileSync(process.argv[3], "utf8").split("\n")) {
+  if (line.startsWith("#") || line.trim() === "") {
+    continue;
+  }
+  const [name, hex, ...records] = line.trim().split(/\s+/);
+  vectors++;
+  check(name, () => {
+    const out = decode(hex);
+    assert.ok(!out.errors, JSON.stringify(out.errors));
+    assert.strictEqual(out.data.Version, 2);
+    assert.strictEqual(out.data.Records.length, records.length);
+    records.forEach((text, i) => {
+      const [, type, ms, payload] = text.match(/^(\d+)@(\d+):([0-9a-f]*)$/);
+      const record = out.data.Records[i];
+      assert.strictEqual(record.ID, Number(type), "record " + i + " type");
+      assert.strictEqual(record.Timestamp, Number(ms), "record " + i + " time");
+      // the same fields as the v1 frame, which reads them at fixed offsets
+      if (type !== "3") {
+        const single = decode(v1(Number(type), ms, payload));
+        assert.ok(!single.errors, JSON.stringify(single.errors));
+        assert.deepStrictEqual(record, single.data, "record " + i + " fields");
+      }
+    });
+  });
+}
+
+// the frame of a vector by name
+function frameOf(name) {
+  const line = fs.readFileSync(process.argv[3], "utf8").split("\n").find((l) => l.startsWith(name + " "));
+  return line.split(/\s+/)[1];
+}
+
+// a few fields by value, so that a shared mistake of both paths shows up
+check("anomaly fields", () => {
+  const record = decode(frameOf("anomaly")).data.Records[0];
+  assert.deepStrictEqual(
+    [record.Timestamp, record.MinSTA, record.MaxSTA, record.STALTA, record.Mean, record.EventID,
+     record.Spectral.DominantHz, record.Spectral.BandsMV, record.TimeUs, record.RatePpm,
+     record.PeriodMs],
+    [200010, -512, 640, 3.5, 1771, 7, 5.2, [1.2, 0.8, 0.3, 0.05], 250, -12, 20]);
+});
+check("samples record", () => {
+  assert.deepStrictEqual(decode(frameOf("samples")).data.Records[1].Samples, [-3, 12, -40, 7]);
+});
+
+//  ========== refused frames ==============================================================
+for (const [what, hex] of [
+  ["no record", "20c8000000"],
+  ["short header", "21c80000"],
+  ["truncated payload", frameOf("anomaly").slice(0, -2)],
+  ["missing record", "22" + frameOf("anomaly").slice(2)],
+  ["unknown type", "21c8000000f01400"],
+]) {
+  check(what, () => assert.ok(decode(hex).errors, "accepted"));
+}
+
+console.log(vectors + " vectors, " + (failures ? "FAILED" : "passed"));
+process.exit(failures ? 1 : 0);
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * sample_ring: the bounds of sample_ring_read(), then a producer thread pushing blocks of
+ * every size against readers of the newest samples, readers that get lapped and
+ * sequential readers like the detector. Each sample holds the low 16 bits of its
+ * absolute index, so a torn, stale or duplicated copy does not match its range. The
+ * indexes start just below 2^32 to cross their wrap as well as the buffer's.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "sample_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define RING_SIZE                   1024
+#define READERS                     4
+#define PRODUCED                    (16 * 1024 * 1024)
+#define START_INDEX                 (UINT32_MAX - 4 * 1024 * 1024)
+#define MAX_BLOCK                   37
+#define MAX_READ                    300
+
+//  ========== globals =====================================================================
+static int16_t buffer[RING_SIZE];
+static struct sample_ring ring;
+static atomic_t producing;
+
+struct reader_stats {
+    unsigned int seed;
+    long ok;
+    long out_of_range;
+    long again;
+    long bad;
+    long skipped;       // samples a sequential reader lost when lapped
+};
+
+//  ========== helpers =====================================================================
+static int16_t sample(uint32_t index)
+{
+    return (int16_t)(uint16_t)index;
+}
+
+// first index of `dest` that does not hold its sample, -1 if all do
+static long mismatch(const int16_t *dest, size_t count, uint32_t start)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (dest[i] != sample(start + (uint32_t)i)) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+static void ring_start(uint32_t index)
+{
+    sample_ring_init(&ring, buffer, RING_SIZE);
+    atomic_set(&ring.head, (atomic_val_t)index);
+    atomic_set(&ring.claim, (atomic_val_t)index);
+}
+
+static void push(uint32_t *next, size_t count)
+{
+    int16_t block[2 * RING_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        block[i] = sample(*next + (uint32_t)i);
+    }
+    sample_ring_write(&ring, block, count);
+    *next += (uint32_t)count;
+}
+
+//  ========== bounds ======================================================================
+static void test_bounds(void)
+{
+    int16_t dest[RING_SIZE];
+    uint32_t next = UINT32_MAX - 100;
+
+    ring_start(next);
+    CHECK_EQ(sample_ring_read(&ring, dest, 1, next), -ERANGE);
+
+    // across the index wrap
+    push(&next, 300);
+    CHECK_EQ(sample_ring_head(&ring), (uint32_t)(UINT32_MAX - 100 + 300));
+    CHECK_EQ(sample_ring_read(&ring, dest, 300, next - 300), 0);
+    CHECK_EQ(mismatch(dest, 300, next - 300), -1);
+    CHECK_EQ(sample_ring_read(&ring, dest, 301, next - 300), -ERANGE);
+    CHECK_EQ(sample_ring_read(&ring, dest, 1, next), -ERANGE);
+
+    // a whole ring is readable, one sample older is overwritten
+    push(&next, RING_SIZE + 5);
+    CHECK_EQ(sample_ring_read(&ring, dest, RING_SIZE, next - RING_SIZE), 0);
+    CHECK_EQ(mismatch(dest, RING_SIZE, next - RING_SIZE), -1);
+    CHECK_EQ(sample_ring_read(&ring, dest, 1, next - RING_SIZE - 1), -ERANGE);
+
+    // a block larger than the ring keeps its newest samples
+    push(&next, RING_SIZE + RING_SIZE / 2);
+    CHECK_EQ(sample_ring_read(&ring, dest, RING_SIZE, next - RING_SIZE), 0);
+    CHECK_EQ(mismatch(dest, RING_SIZE, next - RING_SIZE), -1);
+
+    // a writer stopped between its claim and its head: the claimed slots are refused
+    // while they are copied, the others still read
+    atomic_set(&ring.claim, (atomic_val_t)(next + 10));
+    CHECK_EQ(sample_ring_read(&ring, dest, 20, next - RING_SIZE), -EAGAIN);
+    CHECK_EQ(sample_ring_read(&ring, dest, 20, next - RING_SIZE + 10), 0);
+    CHECK_EQ(mismatch(dest, 20, next - RING_SIZE + 10), -1);
+    atomic_set(&ring.claim, (atomic_val_t)next);
+}
+
+//  ========== readers =====================================================================
+static void check_read(struct reader_stats *s, int16_t *dest, size_t count, uint32_t start)
+{
+    int rc = sample_ring_read(&ring, dest, count, start);
+
+    if (rc == 0) {
+        s->ok++;
+        if (mismatch(dest, count, start) >= 0) {
+            s->bad++;
+        }
+    } else if (rc == -ERANGE) {
+        s->out_of_range++;
+    } else if (rc == -EAGAIN) {
+        s->again++;
+    } else {
+        s->bad++;
+    }
+}
+
+// newest samples, or old ones the producer is about to overwrite
+static void *random_reader(void *arg)
+{
+    struct reader_stats *s = arg;
+    int16_t dest[MAX_READ];
+
+    while (atomic_get(&producing)) {
+        size_t count = 1 + rand_r(&s->seed) % MAX_READ;
+        uint32_t head = sample_ring_head(&ring);
+        uint32_t age = (rand_r(&s->seed) & 1) ? (uint32_t)count
+                                              : (uint32_t)(RING_SIZE - rand_r(&s->seed) % 8);
+
+        check_read(s, dest, count, head - age);
+    }
+    return NULL;
+}
+
+// in order from where the previous read ended, like the streaming detector
+static void *sequential_reader(void *arg)
+{
+    struct reader_stats *s = arg;
+    int16_t dest[MAX_READ];
+    uint32_t next = sample_ring_head(&ring);
+
+    while (atomic_get(&producing)) {
+        uint32_t head = sample_ring_head(&ring);
+        if (head - next > RING_SIZE) {
+            // lapped, restart half a ring behind the writer
+            s->skipped += head - next - RING_SIZE / 2;
+            next = head - RING_SIZE / 2;
+        }
+        size_t count = MIN(head - next, 1 + (uint32_t)rand_r(&s->seed) % MAX_READ);
+        if (count == 0) {
+            continue;
+        }
+        int rc = sample_ring_read(&ring, dest, count, next);
+        if (rc == 0) {
+            s->ok++;
+            // continuity: the range follows the previous one, nothing read twice
+            if (mismatch(dest, count, next) >= 0) {
+                s->bad++;
+            }
+            next += (uint32_t)count;
+        } else if (rc == -ERANGE) {
+            s->out_of_range++;
+        } else if (rc == -EAGAIN) {
+            s->again++;
+        } else {
+            s->bad++;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    pthread_t threads[READERS];
+    struct reader_stats stats[READERS] = { 0 };
+    uint32_t next = START_INDEX;
+    unsigned int seed = 1;
+
+    // a whole ring written first: the ring does not know where the acquisition started,
+    // a read in the last capacity before the head always succeeds
+    ring_start(next - RING_SIZE);
+    next -= RING_SIZE;
+    push(&next, RING_SIZE);
+    atomic_set(&producing, 1);
+    for (int i = 0; i < READERS; i++) {
+        stats[i].seed = 100 + i;
+        pthread_create(&threads[i], NULL, (i % 2) ? sequential_reader : random_reader, &stats[i]);
+    }
+
+    for (uint32_t produced = 0, blocks = 0; produced < PRODUCED; blocks++) {
+        size_t count = 1 + rand_r(&seed) % MAX_BLOCK;
+        push(&next, count);
+        produced += count;
+        // lets the readers in between the blocks on a single core as well
+        if (blocks % 1024 == 0) {
+            sched_yield();
+        }
+    }
+    atomic_set(&producing, 0);
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(threads[i], NULL);
+        printf("reader %d (%s): %ld ok, %ld out of range, %ld retried out, %ld torn, "
+               "%ld skipped\n", i, (i % 2) ? "sequential" : "random", stats[i].ok,
+               stats[i].out_of_range, stats[i].again, stats[i].bad, stats[i].skipped);
+        CHECK_EQ(stats[i].bad, 0);
+        CHECK(stats[i].ok > 0);
+    }
+    // the old ranges were overwritten under the random readers at least once
+    CHECK(stats[0].out_of_range + stats[0].again > 0);
+    // the absolute index wrapped
+    CHECK(sample_ring_head(&ring) < START_INDEX);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_bounds();
+    test_concurrent();
+    return TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * spectral: the fixed-point FFT band energies against a direct DFT in double with the same
+ * window and scaling as the offline spectrogram, then tones in each band (their RMS in
+ * their band, nothing in the others, the dominant frequency within a bin), Parseval on
+ * the average of white noise, the DC level removed and the bands at another sampling
+ * period.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "spectral.h"
+
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define N                           SPECTRAL_FFT_SIZE
+
+//  ========== globals =====================================================================
+static struct spectral s;
+static const double band_edges_hz[SPECTRAL_BANDS + 1] = SPECTRAL_BAND_EDGES_HZ;
+
+//  ========== helpers =====================================================================
+static double gaussian(unsigned int *seed)
+{
+    double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static void tone(int16_t *x, size_t len, double hz, double amplitude, uint32_t rate_ms,
+                 double offset)
+{
+    for (size_t n = 0; n < len; n++) {
+        x[n] = (int16_t)lround(offset + amplitude * sin(2 * M_PI * hz * n * rate_ms / 1000.0 + 0.3));
+    }
+}
+
+// band RMS in 10 uV of one frame: periodic Hann, mean removed, one-sided mean square per bin
+static void reference(const int16_t *frame, uint32_t rate_ms, double *bands)
+{
+    double mean = 0, energy = 0, power[N / 2 + 1];
+
+    for (int n = 0; n < N; n++) {
+        mean += frame[n];
+    }
+    mean /= N;
+    for (int n = 0; n < N; n++) {
+        double w = 0.5 - 0.5 * cos(2 * M_PI * n / N);
+        energy += w * w;
+    }
+    for (int k = 0; k <= N / 2; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < N; n++) {
+            double w = 0.5 - 0.5 * cos(2 * M_PI * n / N);
+            re += (frame[n] - mean) * w * cos(2 * M_PI * k * n / N);
+            im -= (frame[n] - mean) * w * sin(2 * M_PI * k * n / N);
+        }
+        power[k] = (re * re + im * im) / (N * energy) * ((k == 0 || k == N / 2) ? 1 : 2);
+    }
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        double sum = 0;
+        for (int k = 0; k <= N / 2; k++) {
+            double hz = k * 1000.0 / (N * rate_ms);
+            if (hz >= band_edges_hz[b] && hz < band_edges_hz[b + 1]) {
+                sum += power[k];
+            }
+        }
+        bands[b] = sqrt(sum) * 100;
+    }
+}
+
+//  ========== tests =======================================================================
+static void test_reference(void)
+{
+    int16_t frame[N];
+    struct spectral_payload_t out;
+    double bands[SPECTRAL_BANDS];
+    unsigned int seed = 14;
+
+    // noise, a loud event, a quiet signal near the quantization, and one above the 655 mV
+    // the payload holds
+    static const double sigmas[] = { 80, 400, 2, 3000 };
+    for (size_t i = 0; i < ARRAY_SIZE(sigmas); i++) {
+        spectral_init(&s, 10);
+        for (int n = 0; n < N; n++) {
+            frame[n] = (int16_t)lround(200 + sigmas[i] * gaussian(&seed));
+        }
+        spectral_process(&s, frame, &out);
+        reference(frame, 10, bands);
+        for (int b = 0; b < SPECTRAL_BANDS; b++) {
+            CHECK_NEAR(out.bands[b], MIN(bands[b], UINT16_MAX), bands[b] * 0.005 + 2);
+        }
+    }
+}
+
+static void test_tones(void)
+{
+    static const double tones_hz[SPECTRAL_BANDS] = { 2.5, 7.0, 15.0, 35.0 };
+    int16_t frame[N];
+    struct spectral_payload_t out;
+
+    spectral_init(&s, 10);
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        // 100 mV of amplitude is 70.7 mV RMS, on a DC level the frame mean removes
+        tone(frame, N, tones_hz[b], 100, 10, 1500);
+        spectral_process(&s, frame, &out);
+        printf("%4.1f Hz: dominant %u, bands %u %u %u %u\n", tones_hz[b], out.dominant,
+               out.bands[0], out.bands[1], out.bands[2], out.bands[3]);
+        CHECK_NEAR(out.dominant, tones_hz[b] * 10, 1000.0 / (N * 10) * 10);
+        for (int o = 0; o < SPECTRAL_BANDS; o++) {
+            if (o == b) {
+                CHECK_NEAR(out.bands[o], 7071, 7071 * 0.02);
+            } else {
+                CHECK(out.bands[o] < 7071 / 100);
+            }
+        }
+    }
+    CHECK_EQ(spectral_take_average(&s, &out), SPECTRAL_BANDS);
+    CHECK_EQ(spectral_take_average(&s, &out), 0);
+    CHECK_EQ(out.bands[0], 0);
+}
+
+static void test_white_noise(void)
+{
+    static int16_t x[N / 2 * 401];
+    struct spectral_payload_t out;
+    unsigned int seed = 15;
+    double sigma = 80, covered = 0, measured = 0;
+
+    for (size_t n = 0; n < ARRAY_SIZE(x); n++) {
+        x[n] = (int16_t)lround(sigma * gaussian(&seed));
+    }
+    spectral_init(&s, 10);
+    for (size_t n = 0; n + N <= ARRAY_SIZE(x); n += SPECTRAL_HOP) {
+        spectral_process(&s, &x[n], &out);
+    }
+    CHECK_EQ(spectral_take_average(&s, &out), 400);
+
+    // flat spectrum: each band holds the share of sigma^2 of its bins
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        double share = (double)(s.band_hi[b] - s.band_lo[b]) / (N / 2);
+        double expected = sigma * sqrt(share) * 100;
+        CHECK_NEAR(out.bands[b], expected, expected * 0.05);
+        covered += share;
+        measured += (double)out.bands[b] * out.bands[b];
+    }
+    printf("white noise %.0f mV: %.1f mV in %.0f %% of the spectrum\n", sigma,
+           sqrt(measured) / 100, covered * 100);
+    CHECK_NEAR(sqrt(measured) / 100, sigma * sqrt(covered), sigma * sqrt(covered) * 0.03);
+}
+
+static void test_rates(void)
+{
+    int16_t frame[N];
+    struct spectral_payload_t out;
+    double bands[SPECTRAL_BANDS];
+
+    // 20 ms: the last band stops at the 25 Hz Nyquist frequency, which it does not hold
+    spectral_init(&s, 20);
+    CHECK_EQ(s.band_lo[0], 6);      // 1.17 Hz
+    CHECK_EQ(s.band_hi[3], N / 2 + 1);
+    tone(frame, N, 22, 100, 20, 0);
+    spectral_process(&s, frame, &out);
+    CHECK_NEAR(out.dominant, 220, 1000.0 / (N * 20) * 10);
+    CHECK_NEAR(out.bands[3], 7071, 7071 * 0.02);
+    reference(frame, 20, bands);
+    for (int b = 0; b < SPECTRAL_BANDS; b++) {
+        CHECK_NEAR(out.bands[b], bands[b], bands[b] * 0.005 + 2);
+    }
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_reference();
+    test_tones();
+    test_white_noise();
+    test_rates();
+    return TEST_RESULT();
+}
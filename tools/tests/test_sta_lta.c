@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * sta_lta: the streaming modes against the windowed computation of mode 0, on
+ * lfs/geophone_000.dat tiled past three LTA windows with a burst injected in the last one.
+ * The running mode stays within the 1e-4 (relative) of sta_lta.h at every sample, the
+ * recursive one within the ~60% it states until the end of the burst, and triggers on
+ * the burst no earlier.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "sta_lta.h"
+
+#include <zephyr/kernel.h>
+#include <math.h>
+
+//  ========== defines =====================================================================
+// the default windows at 10 ms, and the DC level the legacy computation removed
+#define STA_LEN                     (1024 / 10)
+#define LTA_LEN                     (16384 / 10)
+#define OFFSET_MV                   1770
+#define SIGNAL_LEN                  (3 * LTA_LEN)
+
+// the burst: 2 s of the recorded noise amplified 6 times, in the third LTA window
+#define BURST_START                 (2 * LTA_LEN + LTA_LEN / 2)
+#define BURST_LEN                   200
+#define BURST_GAIN                  6
+
+#define RATIO_ON                    3.f
+#define RUNNING_TOLERANCE           1e-4
+#define RECURSIVE_TOLERANCE         0.6
+
+//  ========== globals =====================================================================
+static int16_t signal_buf[SIGNAL_LEN];
+static float windowed[SIGNAL_LEN];
+static int16_t history[LTA_LEN];
+
+//  ========== signals =====================================================================
+// lfs/geophone_000.dat repeated, with the burst around its DC level
+static size_t geophone(int16_t *x, size_t len)
+{
+    int16_t raw[4096];
+    FILE *f = fopen(LFS_DIR "/geophone_000.dat", "rb");
+    if (f == NULL) {
+        return 0;
+    }
+    size_t n = fread(raw, sizeof(raw[0]), ARRAY_SIZE(raw), f);
+    fclose(f);
+    if (n == 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        x[i] = raw[i % n];
+        if (i >= BURST_START && i < BURST_START + BURST_LEN) {
+            x[i] = (int16_t)(OFFSET_MV + BURST_GAIN * (x[i] - OFFSET_MV));
+        }
+    }
+    return len;
+}
+
+// mode 0: both windows summed again in float at each sample, 0 before a full LTA window
+static float mean_energy(const int16_t *x, size_t len)
+{
+    float sum = 0.0f;
+
+    for (size_t i = 0; i < len; i++) {
+        float v = (float)(x[i] - OFFSET_MV);
+        sum += v * v;
+    }
+    return sum / len;
+}
+
+static void compute_windowed(void)
+{
+    for (size_t i = 0; i < SIGNAL_LEN; i++) {
+        windowed[i] = 0.0f;
+        if (i + 1 >= LTA_LEN) {
+            float sta = mean_energy(&signal_buf[i + 1 - STA_LEN], STA_LEN);
+            float lta = mean_energy(&signal_buf[i + 1 - LTA_LEN], LTA_LEN);
+            windowed[i] = (lta > 0.0f) ? (sta / lta) : 0.0f;
+        }
+    }
+}
+
+// first sample from the burst on whose ratio reaches the trigger, SIGNAL_LEN without one
+static size_t first_trigger(const float *ratio)
+{
+    for (size_t i = BURST_START; i < SIGNAL_LEN; i++) {
+        if (ratio[i] >= RATIO_ON) {
+            return i;
+        }
+    }
+    return SIGNAL_LEN;
+}
+
+//  ========== tests =======================================================================
+static void test_running(void)
+{
+    static float ratio[SIGNAL_LEN];
+    struct sta_lta d;
+    double worst = 0;
+
+    sta_lta_init(&d, STA_LTA_MODE_RUNNING, history, STA_LEN, LTA_LEN, OFFSET_MV);
+    for (size_t i = 0; i < SIGNAL_LEN; i++) {
+        ratio[i] = sta_lta_update(&d, signal_buf[i]);
+        if (i + 1 < LTA_LEN) {
+            CHECK_EQ(ratio[i], 0);
+            continue;
+        }
+        worst = fmax(worst, fabs(ratio[i] - windowed[i]) / windowed[i]);
+    }
+    printf("running: largest relative difference %.2g, trigger at %zu, windowed at %zu\n",
+           worst, first_trigger(ratio), first_trigger(windowed));
+    CHECK(worst <= RUNNING_TOLERANCE);
+    CHECK_EQ(first_trigger(ratio), first_trigger(windowed));
+}
+
+static void test_recursive(void)
+{
+    static float ratio[SIGNAL_LEN];
+    struct sta_lta d;
+    double worst = 0;
+
+    sta_lta_init(&d, STA_LTA_MODE_RECURSIVE, NULL, STA_LEN, LTA_LEN, OFFSET_MV);
+    for (size_t i = 0; i < SIGNAL_LEN; i++) {
+        ratio[i] = sta_lta_update(&d, signal_buf[i]);
+        // the exponential LTA settles over a few windows, compare on the last one. After
+        // the burst the windowed STA drops at once and the exponential one decays slowly
+        if (i >= 2 * LTA_LEN && i < BURST_START + BURST_LEN) {
+            worst = fmax(worst, fabs(ratio[i] - windowed[i]) / windowed[i]);
+        }
+    }
+    size_t trigger = first_trigger(ratio);
+    printf("recursive: largest relative difference %.2g, trigger at %zu, windowed at %zu\n",
+           worst, trigger, first_trigger(windowed));
+    CHECK(worst <= RECURSIVE_TOLERANCE);
+    CHECK(trigger < SIGNAL_LEN);
+    CHECK(trigger >= first_trigger(windowed));
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    if (geophone(signal_buf, SIGNAL_LEN) == 0) {
+        fprintf(stderr, "no %s/geophone_000.dat\n", LFS_DIR);
+        return 1;
+    }
+    compute_windowed();
+    // the burst must trigger the reference, or the trigger checks hold on nothing
+    CHECK(first_trigger(windowed) < BURST_START + BURST_LEN);
+
+    test_running();
+    test_recursive();
+    return TEST_RESULT();
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * stats_engine: the amplitude percentiles against the exact quantiles of the sorted
+ * samples, on several distributions, over a day of samples and with the bursts of events
+ * in order or shuffled, then the period summary and the rollups against the same
+ * statistics computed directly.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "stats_engine.h"
+
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <stdlib.h>
+
+//  ========== defines =====================================================================
+#define RATE_MS                     10
+#define PER_MIN                     (60000 / RATE_MS)
+
+//  ========== helpers =====================================================================
+static double gaussian(unsigned int *seed)
+{
+    double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static int compare_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// exact quantile of sorted values, nearest rank
+static float exact_quantile(const float *sorted, size_t n, float p)
+{
+    return sorted[(size_t)lroundf(p * (n - 1))];
+}
+
+// geophone-like amplitudes in mV: noise, and a rare event ten times louder
+static int16_t sample(size_t i, unsigned int *seed)
+{
+    double sigma = ((i / 5000) % 50 == 7) ? 800 : 80;
+    return (int16_t)lround(sigma * gaussian(seed));
+}
+
+//  ========== stats_hist ==================================================================
+static const float ps[STATS_PERCENTILES] = { 0.5f, 0.9f, 0.99f };
+static int16_t signal[24 * 60 * PER_MIN / 10];
+static float values[ARRAY_SIZE(signal)];
+
+// the exact quantile within half a bin: 1/64 of the amplitude, rounding apart
+static void check_quantiles(const char *name, const struct stats_hist *hist, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        values[i] = fabsf((float)signal[i]);
+    }
+    qsort(values, n, sizeof(values[0]), compare_float);
+
+    for (int k = 0; k < STATS_PERCENTILES; k++) {
+        float exact = exact_quantile(values, n, ps[k]);
+        uint16_t got = stats_hist_quantile(hist, ps[k]);
+        printf("%-10s %zu samples, p%02d: %u, exact %.0f\n", name, n, (int)lroundf(ps[k] * 100),
+               got, exact);
+        CHECK_NEAR(got, exact, exact / 64 + 1);
+    }
+}
+
+static void check_distribution(const char *name, size_t n, int16_t (*draw)(size_t, unsigned int *))
+{
+    struct stats_hist hist, shuffled;
+    unsigned int seed = 11;
+
+    stats_hist_reset(&hist);
+    for (size_t i = 0; i < n; i++) {
+        signal[i] = draw(i, &seed);
+        stats_hist_add(&hist, signal[i]);
+    }
+    check_quantiles(name, &hist, n);
+
+    // the order of the samples does not matter
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = (size_t)rand_r(&seed) % (i + 1);
+        int16_t t = signal[i];
+        signal[i] = signal[j];
+        signal[j] = t;
+    }
+    stats_hist_reset(&shuffled);
+    for (size_t i = 0; i < n; i++) {
+        stats_hist_add(&shuffled, signal[i]);
+    }
+    for (int k = 0; k < STATS_PERCENTILES; k++) {
+        CHECK_EQ(stats_hist_quantile(&shuffled, ps[k]), stats_hist_quantile(&hist, ps[k]));
+    }
+}
+
+static int16_t draw_gaussian(size_t i, unsigned int *seed)
+{
+    (void)i;
+    return (int16_t)lround(80 * gaussian(seed));
+}
+
+static int16_t draw_uniform(size_t i, unsigned int *seed)
+{
+    (void)i;
+    return (int16_t)(rand_r(seed) % 65536 - 32768);
+}
+
+// the bursts that dragged a P-square estimate up for the rest of the period
+static int16_t draw_events(size_t i, unsigned int *seed)
+{
+    return sample(i, seed);
+}
+
+// slow drift of the amplitude over a day
+static int16_t draw_drift(size_t i, unsigned int *seed)
+{
+    return (int16_t)lround((40 + 80.0 * i / ARRAY_SIZE(signal)) * gaussian(seed));
+}
+
+static void test_hist(void)
+{
+    struct stats_hist hist;
+
+    stats_hist_reset(&hist);
+    CHECK_EQ(stats_hist_quantile(&hist, 0.5f), 0);
+
+    // exact on few samples and small amplitudes, by nearest rank
+    stats_hist_add(&hist, 30);
+    stats_hist_add(&hist, -10);
+    stats_hist_add(&hist, 20);
+    CHECK_EQ(stats_hist_quantile(&hist, 0.5f), 20);
+    CHECK_EQ(stats_hist_quantile(&hist, 0.0f), 10);
+    CHECK_EQ(stats_hist_quantile(&hist, 1.0f), 30);
+
+    // the extremes, each in the middle of its bin
+    stats_hist_reset(&hist);
+    stats_hist_add(&hist, INT16_MIN);
+    stats_hist_add(&hist, INT16_MAX);
+    CHECK_EQ(stats_hist_quantile(&hist, 0.0f), 32256 + 255);
+    CHECK_EQ(stats_hist_quantile(&hist, 1.0f), 32768 + 511);
+
+    check_distribution("gaussian", 100000, draw_gaussian);
+    check_distribution("uniform", 100000, draw_uniform);
+    check_distribution("events", 100000, draw_events);
+    check_distribution("drift", ARRAY_SIZE(signal), draw_drift);
+}
+
+//  ========== stats_engine ================================================================
+struct exact {
+    uint32_t count;
+    int16_t min, max;
+    double sum, sum_sq;
+};
+
+static void exact_add(struct exact *x, int16_t v)
+{
+    x->min = (x->count == 0 || v < x->min) ? v : x->min;
+    x->max = (x->count == 0 || v > x->max) ? v : x->max;
+    x->count++;
+    x->sum += v;
+    x->sum_sq += (double)v * v;
+}
+
+static void check_summary(const struct stats_summary *s, const struct exact *x)
+{
+    CHECK_EQ(s->count, x->count);
+    CHECK_EQ(s->min, x->min);
+    CHECK_EQ(s->max, x->max);
+    CHECK_EQ(s->p2p, x->max - x->min);
+    CHECK_NEAR(s->mean, x->sum / x->count, 0.5);
+    CHECK_NEAR(s->rms, sqrt(x->sum_sq / x->count), 0.51);
+}
+
+static void test_engine(void)
+{
+    static struct stats_engine e;
+    struct exact period = { 0 }, minute = { 0 }, ten = { 0 }, hour = { 0 };
+    struct stats_summary s;
+    unsigned int seed = 12;
+
+    stats_engine_init(&e, RATE_MS);
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_1MIN, &s), -1);
+
+    // one hour: every rollup is complete at the end
+    size_t n = 60 * PER_MIN;
+    for (size_t i = 0; i < n; i++) {
+        int16_t v = sample(i, &seed);
+        stats_engine_update(&e, v);
+        exact_add(&period, v);
+        exact_add(&hour, v);
+        if (i >= n - 10 * PER_MIN) {
+            exact_add(&ten, v);
+        }
+        if (i >= n - PER_MIN) {
+            exact_add(&minute, v);
+        }
+        signal[i] = v;
+    }
+
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_1MIN, &s), 0);
+    check_summary(&s, &minute);
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_10MIN, &s), 0);
+    check_summary(&s, &ten);
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_1H, &s), 0);
+    check_summary(&s, &hour);
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_LEVELS, &s), -1);
+
+    stats_engine_take_period(&e, &s);
+    check_summary(&s, &period);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = fabsf((float)signal[i]);
+    }
+    qsort(values, n, sizeof(values[0]), compare_float);
+    for (int k = 0; k < STATS_PERCENTILES; k++) {
+        float exact = exact_quantile(values, n, ps[k]);
+        CHECK_NEAR(s.percentiles[k], exact, exact / 64 + 1);
+    }
+
+    // a new period starts empty, the rollups stay
+    stats_engine_take_period(&e, &s);
+    CHECK_EQ(s.count, 0);
+    CHECK_EQ(s.percentiles[0], 0);
+    CHECK_EQ(stats_engine_get_rollup(&e, STATS_ROLLUP_1H, &s), 0);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_hist();
+    test_engine();
+    return TEST_RESULT();
+}
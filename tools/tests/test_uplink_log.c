@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * uplink_log: the log on host files (stubs/fs.c). Records and acknowledgements are
+ * written and read back, then the node is reset: after a clean flush, with buffered
+ * records and acknowledgements lost, with a torn tail and with records whose CRC fails.
+ * Each time uplink_log_init() must keep exactly the records not acknowledged on the
+ * flash, in order, renumbered from 0, with their contents. Then the deletion once all are
+ * sent and the limits of the log.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "uplink_log.h"
+#include "fs_utils.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//  ========== defines =====================================================================
+#define LFS_DIR                     "test_uplink_log.lfs"
+#define RECORDS                     12
+#define HEADER_SIZE                 16
+
+//  ========== helpers =====================================================================
+static uint8_t payload_size(uint32_t id)
+{
+    return (uint8_t)(1 + id * 7 % PACKET_MAX_PAYLOAD);
+}
+
+// record `id` of the test: its type, timestamp and payload follow from it
+static int append(uint32_t id, uint32_t *seq, uint32_t *offset)
+{
+    uint8_t payload[PACKET_MAX_PAYLOAD];
+
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)(id * 31 + i);
+    }
+    return uplink_log_append((id % 3 == 0) ? ANOMALY : HEALTH, 1741785632000ULL + id,
+                             payload, payload_size(id), seq, offset);
+}
+
+static bool is_record(const struct uplink_log_record *r, uint32_t id)
+{
+    if (r->timestamp != 1741785632000ULL + id || r->size != payload_size(id) ||
+        r->type != ((id % 3 == 0) ? ANOMALY : HEALTH)) {
+        return false;
+    }
+    for (size_t i = 0; i < r->size; i++) {
+        if (r->payload[i] != (uint8_t)(id * 31 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the log holds exactly `ids`, numbered from `first`, with their contents
+static void check_log(const uint32_t *ids, size_t count, uint32_t first)
+{
+    struct uplink_log_reader reader;
+    struct uplink_log_record record;
+    uint32_t offset = 0;
+    size_t n = 0;
+    int rc;
+
+    if (count == 0) {
+        CHECK(uplink_log_open(&reader, 0) < 0);
+        return;
+    }
+    CHECK_EQ(uplink_log_open(&reader, 0), 0);
+    while ((rc = uplink_log_next(&reader, &record)) == 0) {
+        CHECK(n < count && is_record(&record, ids[n]));
+        CHECK_EQ(record.seq, first + n);
+        CHECK_EQ(record.offset, offset);
+        offset += HEADER_SIZE + record.size;
+        n++;
+    }
+    CHECK_EQ(rc, -ENODATA);
+    CHECK_EQ(n, count);
+    uplink_log_close(&reader);
+}
+
+// flip one byte of the log file, as a bit error of the flash
+static void corrupt(uint32_t offset)
+{
+    FILE *f = fopen(LFS_DIR "/uplink.log", "r+b");
+    fseek(f, (long)offset, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, (long)offset, SEEK_SET);
+    fputc(c ^ 0x10, f);
+    fclose(f);
+}
+
+static long file_size(const char *path)
+{
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long)st.st_size : -1;
+}
+
+//  ========== tests =======================================================================
+static void test_write_read(void)
+{
+    uint32_t seq, offset, expected = 0;
+    uint32_t ids[RECORDS];
+
+    CHECK_EQ(uplink_log_init(), 0);
+    for (uint32_t id = 0; id < RECORDS; id++) {
+        CHECK_EQ(append(id, &seq, &offset), 0);
+        CHECK_EQ(seq, id);
+        CHECK_EQ(offset, expected);
+        expected += HEADER_SIZE + payload_size(id);
+        ids[id] = id;
+    }
+    // more than half of the write buffer: the flush is due at once
+    CHECK(uplink_log_has_pending());
+    CHECK_EQ(uplink_log_flush_wait_ms(k_uptime_get()), 0);
+
+    // nothing on the flash before the flush
+    CHECK_EQ(file_size(LFS_DIR "/uplink.log"), -1);
+    CHECK_EQ(uplink_log_flush(), 0);
+    CHECK_EQ(file_size(LFS_DIR "/uplink.log"), expected);
+    CHECK_EQ(uplink_log_flush_wait_ms(k_uptime_get()), -1);
+    check_log(ids, RECORDS, 0);
+
+    // a reader from the offset of a record, as the scheduler replays a queue
+    struct uplink_log_reader reader;
+    struct uplink_log_record record;
+    uint32_t third = 2 * HEADER_SIZE + payload_size(0) + payload_size(1);
+    CHECK_EQ(uplink_log_open(&reader, third), 0);
+    CHECK_EQ(uplink_log_next(&reader, &record), 0);
+    CHECK(is_record(&record, 2));
+    CHECK_EQ(record.offset, third);
+    uplink_log_close(&reader);
+
+    // a single acknowledgement waits up to UPLINK_LOG_FLUSH_MS
+    uplink_log_ack(1);
+    int64_t wait = uplink_log_flush_wait_ms(k_uptime_get());
+    CHECK(wait > UPLINK_LOG_FLUSH_MS - 1000 && wait <= UPLINK_LOG_FLUSH_MS);
+
+    // unknown or repeated acknowledgements are ignored
+    uplink_log_ack(UPLINK_LOG_NONE);
+    uplink_log_ack(RECORDS + 5);
+    uplink_log_ack(1);
+    uint32_t records, acked, bytes;
+    uplink_log_get_state(&records, &acked, &bytes);
+    CHECK_EQ(records, RECORDS);
+    CHECK_EQ(acked, 1);
+    CHECK_EQ(bytes, expected);
+    CHECK_EQ(uplink_log_flush(), 0);
+    CHECK_EQ(file_size(LFS_DIR "/uplink.ack"), sizeof(uint32_t));
+}
+
+static void test_reset(void)
+{
+    uint32_t seq, offset;
+
+    // 0 .. 11 on the flash, 1 acknowledged. The acknowledgements of 4 and 7 and the
+    // records 12 and 13 are still buffered when the node resets: they are lost, 4 and 7
+    // are sent again
+    uplink_log_ack(4);
+    uplink_log_ack(7);
+    CHECK_EQ(append(12, &seq, &offset), 0);
+    CHECK_EQ(append(13, &seq, &offset), 0);
+
+    static const uint32_t after_reset[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(after_reset));
+    CHECK(!uplink_log_has_pending());
+    CHECK_EQ(file_size(LFS_DIR "/uplink.ack"), -1);
+    CHECK_EQ(file_size(LFS_DIR "/uplink.tmp"), -1);
+    check_log(after_reset, ARRAY_SIZE(after_reset), 0);
+
+    // the new records follow the compacted ones
+    CHECK_EQ(append(12, &seq, &offset), 0);
+    CHECK_EQ(seq, ARRAY_SIZE(after_reset));
+    CHECK_EQ(offset, file_size(LFS_DIR "/uplink.log"));
+    uplink_log_ack(0);                  // record 0
+    uplink_log_ack(3);                  // record 4
+    CHECK_EQ(uplink_log_flush(), 0);
+
+    // a second reset with nothing buffered
+    static const uint32_t compacted[] = { 2, 3, 5, 6, 7, 8, 9, 10, 11, 12 };
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(compacted));
+    check_log(compacted, ARRAY_SIZE(compacted), 0);
+}
+
+static void test_corrupt(void)
+{
+    uint32_t offsets[10], offset = 0;
+    static const uint32_t ids[] = { 2, 3, 5, 6, 7, 8, 9, 10, 11, 12 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+        offsets[i] = offset;
+        offset += HEADER_SIZE + payload_size(ids[i]);
+    }
+
+    // a bit error in the payload of the third record and in the sequence number of the
+    // sixth: both are dropped, the records after them are kept
+    corrupt(offsets[2] + HEADER_SIZE + 1);
+    corrupt(offsets[5] + 4);
+    struct uplink_log_reader reader;
+    struct uplink_log_record record;
+    CHECK_EQ(uplink_log_open(&reader, offsets[2]), 0);
+    CHECK_EQ(uplink_log_next(&reader, &record), -EBADMSG);
+    CHECK_EQ(reader.offset, offsets[3]);
+    CHECK_EQ(uplink_log_next(&reader, &record), 0);
+    CHECK(is_record(&record, 6));
+    uplink_log_close(&reader);
+
+    // with an acknowledgement of record 12 (seq 9), which keeps its meaning
+    uplink_log_ack(9);
+    CHECK_EQ(uplink_log_flush(), 0);
+    static const uint32_t kept[] = { 2, 3, 6, 7, 9, 10, 11 };
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(kept));
+    check_log(kept, ARRAY_SIZE(kept), 0);
+
+    // the first record altered: the acknowledgements are matched from the next one
+    uplink_log_ack(1);                  // record 3
+    CHECK_EQ(uplink_log_flush(), 0);
+    corrupt(HEADER_SIZE);
+    static const uint32_t first_lost[] = { 6, 7, 9, 10, 11 };
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(first_lost));
+    check_log(first_lost, ARRAY_SIZE(first_lost), 0);
+
+    // a reset in the middle of a write: the torn record is dropped
+    uint32_t seq;
+    CHECK_EQ(append(13, &seq, &offset), 0);
+    CHECK_EQ(uplink_log_flush(), 0);
+    CHECK_EQ(truncate(LFS_DIR "/uplink.log", offset + HEADER_SIZE + 3), 0);
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(first_lost));
+    check_log(first_lost, ARRAY_SIZE(first_lost), 0);
+    CHECK_EQ(truncate(LFS_DIR "/uplink.log", offset + 5), 0);
+    CHECK_EQ(uplink_log_init(), ARRAY_SIZE(first_lost));
+    check_log(first_lost, ARRAY_SIZE(first_lost), 0);
+}
+
+static void test_all_sent(void)
+{
+    uint32_t seq, offset, records, acked, bytes;
+
+    // every record sent, the buffered one too: both files go
+    CHECK_EQ(append(14, &seq, &offset), 0);
+    for (uint32_t s = 0; s <= seq; s++) {
+        uplink_log_ack(s);
+    }
+    CHECK_EQ(uplink_log_flush(), 0);
+    CHECK_EQ(file_size(LFS_DIR "/uplink.log"), -1);
+    CHECK_EQ(file_size(LFS_DIR "/uplink.ack"), -1);
+    uplink_log_get_state(&records, &acked, &bytes);
+    CHECK_EQ(records, 0);
+    CHECK_EQ(bytes, 0);
+
+    // the numbers go on, the file starts over
+    CHECK_EQ(append(15, &seq, &offset), 0);
+    CHECK_EQ(seq, 6);
+    CHECK_EQ(offset, 0);
+    CHECK_EQ(uplink_log_flush(), 0);
+    static const uint32_t last[] = { 15 };
+    check_log(last, 1, 6);
+    CHECK_EQ(uplink_log_init(), 1);
+    check_log(last, 1, 0);
+}
+
+static void test_limits(void)
+{
+    uint32_t seq, offset, accepted = 1;
+    int rc;
+
+    // status records up to UPLINK_LOG_STATUS_RECORDS, then only anomalies
+    for (uint32_t id = 1; (rc = append(id * 3 + 1, &seq, &offset)) != -ENOSPC; id++) {
+        if (rc == -ENOBUFS) {
+            CHECK_EQ(uplink_log_flush_wait_ms(k_uptime_get()), 0);
+            CHECK_EQ(uplink_log_flush(), 0);
+            continue;
+        }
+        CHECK_EQ(rc, 0);
+        accepted++;
+    }
+    CHECK_EQ(accepted, UPLINK_LOG_STATUS_RECORDS);
+    for (uint32_t id = 1; (rc = append(id * 3, &seq, &offset)) != -ENOSPC; id++) {
+        if (rc == -ENOBUFS) {
+            CHECK_EQ(uplink_log_flush(), 0);
+            continue;
+        }
+        accepted++;
+    }
+    CHECK_EQ(accepted, UPLINK_LOG_MAX_RECORDS);
+    uint8_t big[PACKET_MAX_PAYLOAD + 1] = { 0 };
+    CHECK_EQ(uplink_log_append(ANOMALY, 0, big, sizeof(big), &seq, &offset), -EINVAL);
+
+    CHECK_EQ(uplink_log_flush(), 0);
+    CHECK_EQ(uplink_log_init(), UPLINK_LOG_MAX_RECORDS);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    mkdir(LFS_DIR, 0755);
+    fs_stub_init(LFS_DIR);
+    fs_unlink(UPLINK_LOG_PATH);
+    fs_unlink(UPLINK_LOG_ACK_PATH);
+    fs_unlink(UPLINK_LOG_TMP_PATH);
+
+    test_write_read();
+    test_reset();
+    test_corrupt();
+    test_all_sent();
+    test_limits();
+    return TEST_RESULT();
+}
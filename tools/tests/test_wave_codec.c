@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * wave_codec: bit-exact round trips of frames of every length on the recorded geophone
+ * file and on synthetic signals, the errors of the decoder, then the compression ratio and
+ * the cost per sample of each signal next to the bound of any lossless coder.
+ *
+ * The bound is the entropy of the samples. A Gaussian noise of standard deviation s
+ * quantized to 1 mV carries log2(s * sqrt(2 * pi * e)) bits per sample: 8.4 bits for the
+ * 79 mV of lfs/geophone_000.dat once its DC level is removed, so no lossless coding of it
+ * goes beyond 16 / 8.4 = 1.9x. Its samples are nearly uncorrelated (lag-1 correlation
+ * -0.04), no predictor lowers that. Ratios of 3x and more need a quiet site (3.8x on
+ * +/-4 mV of noise) or a slow signal.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "wave_codec.h"
+#include "dc_filter.h"
+
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  ========== defines =====================================================================
+#define FRAME                       512
+#define SIGNAL_LEN                  (64 * FRAME)
+#define BENCH_ROUNDS                20
+
+//  ========== globals =====================================================================
+static int16_t signal_buf[SIGNAL_LEN];
+static int16_t decoded[FRAME];
+static uint8_t frame_buf[WAVE_CODEC_MAX_FRAME(FRAME)];
+
+//  ========== signals =====================================================================
+// lfs/geophone_000.dat with its DC level removed, repeated
+static size_t geophone(int16_t *x, size_t len)
+{
+    int16_t raw[4096];
+    FILE *f = fopen(LFS_DIR "/geophone_000.dat", "rb");
+    if (f == NULL) {
+        return 0;
+    }
+    size_t n = fread(raw, sizeof(raw[0]), ARRAY_SIZE(raw), f);
+    fclose(f);
+    if (n == 0) {
+        return 0;
+    }
+
+    struct dc_filter dc;
+    dc_filter_init(&dc, DC_FILTER_CORNER_MHZ, 100000);
+    for (size_t i = 0; i < len; i++) {
+        x[i] = dc_filter_update(&dc, raw[i % n]);
+    }
+    return len;
+}
+
+static double gaussian(unsigned int *seed)
+{
+    double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static size_t noise(int16_t *x, size_t len, double sigma)
+{
+    unsigned int seed = 7;
+
+    for (size_t i = 0; i < len; i++) {
+        x[i] = (int16_t)lround(sigma * gaussian(&seed));
+    }
+    return len;
+}
+
+static size_t quiet(int16_t *x, size_t len)
+{
+    unsigned int seed = 8;
+
+    for (size_t i = 0; i < len; i++) {
+        x[i] = (int16_t)(rand_r(&seed) % 9 - 4);
+    }
+    return len;
+}
+
+// 2 Hz at 10 ms with a little noise, where the deltas win
+static size_t slow(int16_t *x, size_t len)
+{
+    unsigned int seed = 9;
+
+    for (size_t i = 0; i < len; i++) {
+        x[i] = (int16_t)(lround(800 * sin(2 * M_PI * 2 * i / 100.0)) + rand_r(&seed) % 3 - 1);
+    }
+    return len;
+}
+
+static size_t full_scale(int16_t *x, size_t len)
+{
+    unsigned int seed = 10;
+
+    for (size_t i = 0; i < len; i++) {
+        x[i] = (i % 7 == 0) ? ((i % 14) ? INT16_MIN : INT16_MAX)
+                            : (int16_t)(rand_r(&seed) % 65536 - 32768);
+    }
+    return len;
+}
+
+//  ========== helpers =====================================================================
+static bool round_trip(const int16_t *x, size_t n, uint64_t timestamp)
+{
+    size_t size = wave_codec_encode(x, n, timestamp, frame_buf);
+    size_t count = 0;
+    uint64_t ts = 0;
+
+    CHECK(size > WAVE_CODEC_HEADER_SIZE || (n == 1 && size == WAVE_CODEC_HEADER_SIZE));
+    CHECK(size <= WAVE_CODEC_MAX_FRAME(n));
+    int used = wave_codec_decode(frame_buf, size, decoded, FRAME, &count, &ts);
+    CHECK_EQ(used, size);
+    CHECK_EQ(count, n);
+    CHECK_EQ(ts, timestamp);
+    bool same = (memcmp(decoded, x, n * sizeof(x[0])) == 0);
+    CHECK(same);
+    return same;
+}
+
+//  ========== tests =======================================================================
+static void test_round_trip(void)
+{
+    size_t (*signals[])(int16_t *, size_t) = { quiet, slow, full_scale };
+
+    for (size_t s = 0; s < ARRAY_SIZE(signals); s++) {
+        signals[s](signal_buf, SIGNAL_LEN);
+        for (size_t n = 1; n <= FRAME; n++) {
+            if (!round_trip(&signal_buf[n * 37 % (SIGNAL_LEN - FRAME)], n, 1741785632000ull + n)) {
+                printf("signal %zu, %zu samples\n", s, n);
+                return;
+            }
+        }
+    }
+    noise(signal_buf, SIGNAL_LEN, 79);
+    round_trip(signal_buf, FRAME, 0);
+    if (geophone(signal_buf, SIGNAL_LEN) != 0) {
+        round_trip(signal_buf, FRAME, UINT64_MAX);
+    }
+}
+
+static void test_predictor(void)
+{
+    // the samples themselves on noise, the deltas on a slow signal
+    noise(signal_buf, FRAME, 79);
+    wave_codec_encode(signal_buf, FRAME, 0, frame_buf);
+    CHECK_EQ(frame_buf[2], WAVE_CODEC_VERSION);
+    CHECK_EQ(frame_buf[3], WAVE_CODEC_FLAG_VALUES);
+
+    slow(signal_buf, FRAME);
+    wave_codec_encode(signal_buf, FRAME, 0, frame_buf);
+    CHECK_EQ(frame_buf[3], 0);
+
+    // a delta frame of version 1, as recorded before the flags, still decodes
+    size_t count;
+    frame_buf[2] = 1;
+    CHECK(wave_codec_decode(frame_buf, sizeof(frame_buf), decoded, FRAME, &count, NULL) > 0);
+    CHECK_EQ(memcmp(decoded, signal_buf, sizeof(decoded)), 0);
+    frame_buf[3] = WAVE_CODEC_FLAG_VALUES;
+    CHECK_EQ(wave_codec_decode(frame_buf, sizeof(frame_buf), decoded, FRAME, &count, NULL), -EINVAL);
+}
+
+static void test_errors(void)
+{
+    size_t count;
+
+    quiet(signal_buf, FRAME);
+    size_t size = wave_codec_encode(signal_buf, FRAME, 0, frame_buf);
+
+    CHECK_EQ(wave_codec_encode(signal_buf, 0, 0, frame_buf), 0);
+    CHECK_EQ(wave_codec_decode(frame_buf, WAVE_CODEC_HEADER_SIZE - 1, decoded, FRAME, &count, NULL), -EAGAIN);
+    CHECK_EQ(wave_codec_decode(frame_buf, size - 1, decoded, FRAME, &count, NULL), -EAGAIN);
+    CHECK_EQ(wave_codec_decode(frame_buf, size, decoded, FRAME - 1, &count, NULL), -ENOSPC);
+
+    frame_buf[3] = 0x80;
+    CHECK_EQ(wave_codec_decode(frame_buf, size, decoded, FRAME, &count, NULL), -EINVAL);
+    frame_buf[3] = 0;
+    frame_buf[2] = WAVE_CODEC_VERSION + 1;
+    CHECK_EQ(wave_codec_decode(frame_buf, size, decoded, FRAME, &count, NULL), -EINVAL);
+    frame_buf[2] = WAVE_CODEC_VERSION;
+    frame_buf[0] ^= 1;
+    CHECK_EQ(wave_codec_decode(frame_buf, size, decoded, FRAME, &count, NULL), -EINVAL);
+    frame_buf[0] ^= 1;
+
+    // a payload cut short in its header field: the bit stream ends before the samples
+    frame_buf[6] = 4;
+    frame_buf[7] = 0;
+    CHECK_EQ(wave_codec_decode(frame_buf, size, decoded, FRAME, &count, NULL), -EINVAL);
+}
+
+//  ========== bench =======================================================================
+static double entropy_bits(const int16_t *x, size_t len)
+{
+    static uint32_t histogram[65536];
+    double bits = 0;
+
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < len; i++) {
+        histogram[(uint16_t)x[i]]++;
+    }
+    for (size_t v = 0; v < ARRAY_SIZE(histogram); v++) {
+        if (histogram[v] != 0) {
+            double p = (double)histogram[v] / len;
+            bits -= p * log2(p);
+        }
+    }
+    return bits;
+}
+
+static void bench(const char *name, size_t (*make)(int16_t *, size_t))
+{
+    size_t len = make(signal_buf, SIGNAL_LEN);
+    if (len == 0) {
+        printf("%-12s no lfs/geophone_000.dat\n", name);
+        return;
+    }
+
+    size_t encoded = 0;
+    double t0 = test_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        encoded = 0;
+        for (size_t i = 0; i < len; i += FRAME) {
+            encoded += wave_codec_encode(&signal_buf[i], FRAME, i, frame_buf);
+        }
+    }
+    double encode_ns = (test_now_ns() - t0) / (BENCH_ROUNDS * (double)len);
+
+    size_t count;
+    wave_codec_encode(signal_buf, FRAME, 0, frame_buf);
+    t0 = test_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS * (int)(len / FRAME); r++) {
+        wave_codec_decode(frame_buf, sizeof(frame_buf), decoded, FRAME, &count, NULL);
+    }
+    double decode_ns = (test_now_ns() - t0) / (BENCH_ROUNDS * (double)len);
+
+    // entropy of the samples or of their deltas, the lower. The geophone file only holds
+    // 150 samples, as many values as samples: its histogram says less than its 8.4 bits.
+    static int16_t deltas[SIGNAL_LEN];
+    for (size_t i = 1; i < len; i++) {
+        deltas[i - 1] = (int16_t)(signal_buf[i] - signal_buf[i - 1]);
+    }
+    double bits = MIN(entropy_bits(signal_buf, len), entropy_bits(deltas, len - 1));
+    printf("%-12s ratio %.2fx, entropy %.2fx, encode %.1f ns, decode %.1f ns per sample\n", name,
+           (double)(len * sizeof(int16_t)) / encoded, 16 / bits, encode_ns, decode_ns);
+}
+
+static size_t noise_79(int16_t *x, size_t len)
+{
+    return noise(x, len, 79);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    test_round_trip();
+    test_predictor();
+    test_errors();
+
+    bench("geophone", geophone);
+    bench("noise 79 mV", noise_79);
+    bench("quiet", quiet);
+    bench("slow", slow);
+    return TEST_RESULT();
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2025
+ * Regis Rousseau
+ * Univ Lyon, INSA Lyon, Inria, CITI, EA3720
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * wave_index: recorded files on host files (stubs/fs.c), with a time gap between two of
+ * them, the oldest one evicted, the last one torn in the middle of a block with its index
+ * running ahead, then one without its index. The ranges of windows on and around the
+ * block edges, and of random windows, are compared with a brute force over the blocks.
+ */
+
+//  ========== includes ====================================================================
+#include "test.h"
+#include "wave_index.h"
+#include "fs_utils.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//  ========== defines =====================================================================
+#define LFS_DIR                     "test_wave_index.lfs"
+#define FILES                       6
+#define BLOCKS                      150
+#define BLOCK_SAMPLES               512
+#define PERIOD_MS                   10
+#define BLOCK_MS                    (BLOCK_SAMPLES * PERIOD_MS)
+#define GAP_FILE                    3           // starts a minute after the end of file 2
+#define TORN_BLOCK                  100         // the last file stops in this block
+#define MAX_RANGES                  64
+
+//  ========== globals =====================================================================
+static uint64_t block_start[FILES][BLOCKS];
+static uint32_t block_offset[FILES][BLOCKS + 1];
+static uint32_t data_size[FILES];
+static bool indexed[FILES];
+static uint32_t oldest;
+
+struct ranges {
+    struct wave_index_range r[MAX_RANGES];
+    int count;
+    int stop_after;             // the callback ends the query after this many, 0 never
+};
+
+//  ========== helpers =====================================================================
+static void data_file(char *path, size_t size, uint32_t file)
+{
+    snprintf(path, size, LFS_DIR "/geophone_%03u.dat", file);
+}
+
+static int collect(const struct wave_index_range *range, void *user)
+{
+    struct ranges *s = user;
+
+    if (s->count < MAX_RANGES) {
+        s->r[s->count] = *range;
+    }
+    s->count++;
+    return s->stop_after != 0 && s->count >= s->stop_after;
+}
+
+// the blocks of the files on the partition overlapping [from, to), up to the end of
+// their data, merged when consecutive in one file
+static void brute_force(uint64_t from, uint64_t to, struct ranges *e)
+{
+    e->count = 0;
+    for (uint32_t f = oldest; f < FILES; f++) {
+        for (int b = 0; b < BLOCKS && indexed[f]; b++) {
+            uint32_t end = MIN(block_offset[f][b + 1], data_size[f]);
+            uint64_t start_ms = block_start[f][b];
+
+            if (block_offset[f][b] >= data_size[f] || start_ms >= to ||
+                start_ms + BLOCK_MS <= from) {
+                continue;
+            }
+            struct wave_index_range *r = (e->count > 0) ? &e->r[e->count - 1] : NULL;
+            if (r != NULL && r->file == f && r->offset + r->size == block_offset[f][b]) {
+                r->size = end - r->offset;
+                r->end_ms = start_ms + BLOCK_MS;
+                r->samples += BLOCK_SAMPLES;
+                r->blocks++;
+            } else {
+                e->r[e->count++] = (struct wave_index_range) {
+                    .file = f,
+                    .offset = block_offset[f][b],
+                    .size = end - block_offset[f][b],
+                    .start_ms = start_ms,
+                    .end_ms = start_ms + BLOCK_MS,
+                    .samples = BLOCK_SAMPLES,
+                    .blocks = 1,
+                };
+            }
+        }
+    }
+}
+
+// the query gives the ranges of the brute force, false on the first difference
+static bool check_query(uint64_t from, uint64_t to)
+{
+    struct ranges got = { .count = 0 }, expected;
+
+    brute_force(from, to, &expected);
+    int n = wave_index_query(from, to, collect, &got);
+    bool same = n == got.count && got.count == expected.count;
+    for (int i = 0; same && i < got.count; i++) {
+        const struct wave_index_range *a = &got.r[i], *b = &expected.r[i];
+        same = a->file == b->file && a->offset == b->offset && a->size == b->size &&
+               a->start_ms == b->start_ms && a->end_ms == b->end_ms &&
+               a->samples == b->samples && a->blocks == b->blocks;
+    }
+    if (!same) {
+        printf("window %llu .. %llu: %d ranges, expected %d\n", (unsigned long long)from,
+               (unsigned long long)to, n, expected.count);
+    }
+    CHECK(same);
+    return same;
+}
+
+//  ========== recording ===================================================================
+// the files as the recorder writes them: the index entries synced with the data
+static void record(void)
+{
+    uint64_t t = 1741773600000ULL;
+
+    for (uint32_t f = 0; f < FILES; f++) {
+        char path[64];
+        data_file(path, sizeof(path), f);
+        FILE *data = fopen(path, "wb");
+        uint32_t offset = 0;
+
+        CHECK_EQ(wave_index_begin(f), 0);
+        for (int b = 0; b < BLOCKS; b++) {
+            if (f == GAP_FILE && b == 0) {
+                t += 60000;
+            }
+            // compressed blocks of different sizes
+            uint32_t size = 100 + b % 7;
+            block_start[f][b] = t;
+            block_offset[f][b] = offset;
+            CHECK_EQ(wave_index_add(offset, t, BLOCK_SAMPLES, PERIOD_MS), 0);
+            for (uint32_t i = 0; i < size; i++) {
+                fputc(b, data);
+            }
+            offset += size;
+            t += BLOCK_MS;
+            if (b % 20 == 19) {
+                fflush(data);
+                CHECK_EQ(wave_index_sync(), 0);
+            }
+        }
+        block_offset[f][BLOCKS] = offset;
+        data_size[f] = offset;
+        indexed[f] = true;
+        fclose(data);
+        wave_index_end();
+    }
+
+    // a reset in the middle of a block of the last file, its index is ahead of the data
+    char path[64];
+    data_file(path, sizeof(path), FILES - 1);
+    data_size[FILES - 1] = block_offset[FILES - 1][TORN_BLOCK] + 10;
+    CHECK_EQ(truncate(path, data_size[FILES - 1]), 0);
+
+    // the oldest file is evicted
+    data_file(path, sizeof(path), 0);
+    unlink(path);
+    wave_index_remove(0);
+    oldest = 1;
+    wave_index_set_files(oldest, FILES);
+}
+
+//  ========== tests =======================================================================
+static void test_edges(void)
+{
+    uint64_t first = block_start[1][0];
+    uint64_t b = block_start[2][40];
+
+    CHECK_EQ(wave_index_query(b, b, collect, &(struct ranges){ .count = 0 }), -EINVAL);
+    CHECK_EQ(wave_index_query(b + 1, b, collect, &(struct ranges){ .count = 0 }), -EINVAL);
+
+    // one block: its first ms, its last ms, the whole of it
+    check_query(b, b + 1);
+    check_query(b + BLOCK_MS - 1, b + BLOCK_MS);
+    check_query(b, b + BLOCK_MS);
+    // ending on the start of a block leaves it out, starting on its end too
+    check_query(b - 1, b);
+    check_query(b + BLOCK_MS, b + BLOCK_MS + 1);
+    // the first and last blocks of a file, across two files
+    check_query(block_start[2][0], block_start[2][0] + 1);
+    check_query(block_start[2][BLOCKS - 1], block_start[2][BLOCKS - 1] + BLOCK_MS);
+    check_query(block_start[1][BLOCKS - 1] + 1, block_start[2][0] + 1);
+
+    // before the oldest file left, after the end, in the gap: nothing
+    struct ranges none = { .count = 0 };
+    CHECK_EQ(wave_index_query(block_start[0][0], first, collect, &none), 0);
+    CHECK_EQ(wave_index_query(first - 1000000, first, collect, &none), 0);
+    uint64_t gap = block_start[GAP_FILE - 1][BLOCKS - 1] + BLOCK_MS;
+    CHECK_EQ(wave_index_query(gap, block_start[GAP_FILE][0], collect, &none), 0);
+    check_query(gap - 1, block_start[GAP_FILE][0] + 1);
+
+    // the torn file: up to its end, the partial block cut to the data
+    uint64_t torn = block_start[FILES - 1][TORN_BLOCK];
+    struct ranges got = { .count = 0 };
+    CHECK_EQ(wave_index_query(torn - 1, UINT64_MAX, collect, &got), 1);
+    CHECK_EQ(got.r[0].offset, block_offset[FILES - 1][TORN_BLOCK - 1]);
+    CHECK_EQ(got.r[0].size, block_offset[FILES - 1][TORN_BLOCK] - got.r[0].offset + 10);
+    CHECK_EQ(got.r[0].blocks, 2);
+    CHECK_EQ(wave_index_query(torn + BLOCK_MS, UINT64_MAX, collect, &none), 0);
+
+    // the callback ends the query
+    got = (struct ranges){ .count = 0, .stop_after = 1 };
+    CHECK_EQ(wave_index_query(first, UINT64_MAX, collect, &got), 1);
+    CHECK_EQ(got.count, 1);
+
+    // the whole recording, one range per file
+    check_query(0, UINT64_MAX);
+}
+
+static void test_random(const char *name)
+{
+    unsigned int seed = 24;
+    uint64_t t0 = block_start[0][0];
+    uint64_t span = block_start[FILES - 1][BLOCKS - 1] + BLOCK_MS - t0;
+    int failed = 0;
+
+    for (int k = 0; k < 20000 && failed < 5; k++) {
+        uint64_t from = t0 - 50000 + (uint64_t)rand_r(&seed) % (span + 100000);
+        uint64_t to = from + 1 + (uint64_t)rand_r(&seed) % ((rand_r(&seed) & 1) ? 30000 : 2000000);
+        failed += !check_query(from, to);
+    }
+    printf("%s: 20000 random windows\n", name);
+}
+
+//  ========== main ========================================================================
+int main(void)
+{
+    mkdir(LFS_DIR, 0755);
+    fs_stub_init(LFS_DIR);
+
+    record();
+    test_edges();
+    test_random("6 files");
+
+    // a file without its index, as those recorded before it: left out, the query still
+    // finds the files after it
+    char path[64];
+    snprintf(path, sizeof(path), LFS_DIR "/geophone_%03u.idx", 2);
+    unlink(path);
+    indexed[2] = false;
+    test_random("file 2 without index");
+    check_query(block_start[2][10], block_start[GAP_FILE][10]);
+    return TEST_RESULT();
+}
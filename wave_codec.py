@@ -0,0 +1,92 @@
+"""
+Decoder of the geophone files recorded by the sensor (see src/wave_codec.h).
+
+Files are either raw little-endian int16 samples, or a sequence of compressed frames:
+a header (magic "GW", version, sample count, payload size, timestamp in ms, first sample)
+followed by the Rice-coded sample deltas, or the samples themselves (FLAG_VALUES).
+"""
+
+import struct
+
+import numpy as np
+
+MAGIC = 0x5747
+VERSION = 2
+FLAG_VALUES = 0x01
+HEADER = struct.Struct("<HBBHHQh")
+GROUP = 16
+ESCAPE = 16
+
+
+def is_compressed(head: bytes) -> bool:
+    """Tell a compressed file from a raw int16 one by its first bytes."""
+    return len(head) >= 2 and struct.unpack_from("<H", head)[0] == MAGIC
+
+
+def decode_frame(payload: bytes, count: int, first: int, flags: int = 0) -> np.ndarray:
+    """Decode the Rice-coded deltas, or samples with FLAG_VALUES, of one frame."""
+    bits = int.from_bytes(payload, "little")
+    pos = 0
+    out = np.empty(count, dtype=np.int16)
+    out[0] = prev = first
+
+    def take(n):
+        nonlocal pos
+        v = (bits >> pos) & ((1 << n) - 1)
+        pos += n
+        return v
+
+    i = 1
+    while i < count:
+        k = take(5)
+        for _ in range(min(GROUP, count - i)):
+            q = 0
+            while q < ESCAPE and take(1):
+                q += 1
+            v = take(17) if q == ESCAPE else (q << k) | take(k)
+            r = (v >> 1) ^ -(v & 1)
+            prev = r if flags & FLAG_VALUES else prev + r
+            out[i] = prev
+            i += 1
+    return out
+
+
+class FrameDecoder:
+    """
+    Streaming decoder: feed bytes as they arrive, get (timestamp_ms, samples) per complete frame.
+    """
+
+    def __init__(self):
+        self.pending = b""
+
+    def feed(self, data: bytes):
+        self.pending += data
+        frames = []
+        while len(self.pending) >= HEADER.size:
+            magic, version, flags, count, size, timestamp, first = HEADER.unpack_from(self.pending)
+            if magic != MAGIC or not 1 <= version <= VERSION or flags & ~FLAG_VALUES:
+                raise ValueError("not a geophone frame (magic {:#x}, version {}, flags {:#x})".format(
+                    magic, version, flags))
+            end = HEADER.size + size
+            if len(self.pending) < end:
+                break
+            frames.append((timestamp, decode_frame(self.pending[HEADER.size:end], count, first, flags)))
+            self.pending = self.pending[end:]
+        return frames
+
+
+def read_frames(path: str):
+    """Return the list of (timestamp_ms, samples) of a file, a single frame without timestamp for raw files."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not is_compressed(data):
+        return [(None, np.frombuffer(data[: len(data) // 2 * 2], dtype="<i2"))]
+    return FrameDecoder().feed(data)
+
+
+def read_samples(path: str) -> np.ndarray:
+    """Return all the samples of a raw or compressed geophone file."""
+    frames = read_frames(path)
+    if not frames:
+        return np.empty(0, dtype=np.int16)
+    return np.concatenate([samples for _, samples in frames])